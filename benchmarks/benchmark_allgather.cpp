@@ -30,6 +30,7 @@
 #define VERBOSE 0
 #endif
 
+#include "nvcomp/cascaded.hpp"
 #include "nvcomp/lz4.hpp"
 #include "nvcomp/nvcompManager.hpp"
 
@@ -62,7 +63,7 @@ static void print_usage()
       "  %-35s *If Cascaded* Bitpacking enabled (default 1)\n",
       "-b, --bitpack");
   printf(
-      "  %-35s *If Cascaded* Datatype (int or long, default int)\n",
+      "  %-35s *If Cascaded* Datatype (int, long or int8, default int)\n",
       "-t, --type");
 }
 
@@ -83,9 +84,9 @@ check_output(T*** outputs, T* h_data, int gpus, int chunks, size_t* chunk_sizes)
           cudaMemcpyDeviceToHost));
       for (size_t j = 0; j < chunk_sizes[chunkId]; ++j) {
         if (result_buffer[j] != h_data[idx + j]) {
-          std::cout << "Incorrect result, elemenet number:" << j
-                    << " - expected:" << h_data[j]
-                    << ", found:" << result_buffer[j] << std::endl;
+          std::cout << "Incorrect result on GPU " << i << ", element number:"
+                    << idx + j << " - expected:" << +h_data[idx + j]
+                    << ", found:" << +result_buffer[j] << std::endl;
           exit(1);
         }
       }
@@ -164,11 +165,12 @@ void copy_to_all(
     const std::vector<std::vector<cudaStream_t>>& streams,
     int STREAMS_PER_GPU)
 {
-  //  int chunks_per_gpu = chunks/gpus;
+  const int chunks_per_gpu = chunks / gpus;
 
+  // Chunk i is on GPU i / chunks_per_gpu, see load_chunks_to_devices
   for (int i = 0; i < chunks; ++i) {
     for (int j = 0; j < gpus; ++j) {
-      if (i != j) {
+      if (i / chunks_per_gpu != j) {
         CUDA_CHECK(cudaMemcpyAsync(
             dest_ptrs[j][i],
             dev_ptrs[i],
@@ -225,10 +227,15 @@ static void run_uncompressed_benchmark(
   std::vector<std::vector<cudaStream_t>> streams;
   create_gpu_streams(&streams, gpus, STREAMS_PER_GPU);
 
+  std::vector<size_t> chunk_bytes(chunks, 0);
+  for (int chunkIdx = 0; chunkIdx < chunks; ++chunkIdx) {
+    chunk_bytes[chunkIdx] = chunk_sizes[chunkIdx] * sizeof(T);
+  }
+
   std::vector<std::vector<T*>> dest_ptrs(gpus);
   for (int i = 0; i < gpus; ++i) { // Allocate full data size on each GPU
     CUDA_CHECK(cudaSetDevice(i));
-    dest_ptrs[i].resize(gpus);
+    dest_ptrs[i].resize(chunks);
     for (int j = 0; j < chunks; ++j) {
       CUDA_CHECK(cudaMalloc(&dest_ptrs[i][j], chunk_sizes[j] * sizeof(T)));
     }
@@ -240,17 +247,20 @@ static void run_uncompressed_benchmark(
       gpus,
       chunks,
       dev_ptrs,
-      chunk_sizes,
+      chunk_bytes.data(),
       dest_ptrs.data(),
       streams,
       STREAMS_PER_GPU);
   for (int gpu = 0; gpu < gpus; ++gpu) {
-    CUDA_CHECK(cudaMemcpyAsync(
-        dest_ptrs[gpu][gpu],
-        dev_ptrs[gpu],
-        chunk_sizes[gpu] * sizeof(T),
-        cudaMemcpyDeviceToDevice,
-        streams[gpu][gpu % STREAMS_PER_GPU]));
+    for (int chunkIdx = 0; chunkIdx < chunks_per_gpu; ++chunkIdx) {
+      const int idx = gpu * chunks_per_gpu + chunkIdx;
+      CUDA_CHECK(cudaMemcpyAsync(
+          dest_ptrs[gpu][idx],
+          dev_ptrs[idx],
+          chunk_bytes[idx],
+          cudaMemcpyDeviceToDevice,
+          streams[gpu][idx % STREAMS_PER_GPU]));
+    }
   }
 
   sync_all_streams(&streams, gpus, STREAMS_PER_GPU);
@@ -361,7 +371,7 @@ static void run_nvcomp_benchmark(
     for (int chunkIdx = 0; chunkIdx < chunks_per_gpu; ++chunkIdx) {
       const int idx = gpu * chunks_per_gpu + chunkIdx;
       managers[idx]->compress(
-          dev_ptrs[idx],
+          reinterpret_cast<const uint8_t*>(dev_ptrs[idx]),
           d_comp_out[idx],
           comp_configs[idx]);
     }
@@ -369,8 +379,10 @@ static void run_nvcomp_benchmark(
 
   sync_all_streams(&streams, gpus, STREAMS_PER_GPU);
 
+  // Only send the compressed bytes of each chunk
   size_t total_comp_bytes = 0;
   for (int i = 0; i < gpus * chunks_per_gpu; ++i) {
+    comp_out_bytes[i] = managers[i]->get_compressed_output_size(d_comp_out[i]);
     total_comp_bytes += comp_out_bytes[i];
   }
 
@@ -384,15 +396,19 @@ static void run_nvcomp_benchmark(
       streams,
       STREAMS_PER_GPU);
   for (int gpu = 0; gpu < gpus; ++gpu) {
-    CUDA_CHECK(cudaMemcpyAsync(
-        d_decomp_out[gpu][gpu],
-        dev_ptrs[gpu],
-        chunk_bytes[gpu],
-        cudaMemcpyDeviceToDevice,
-        streams[gpu][gpu % STREAMS_PER_GPU]));
+    for (int chunkIdx = 0; chunkIdx < chunks_per_gpu; ++chunkIdx) {
+      const int idx = gpu * chunks_per_gpu + chunkIdx;
+      CUDA_CHECK(cudaMemcpyAsync(
+          d_decomp_out[gpu][idx],
+          dev_ptrs[idx],
+          chunk_bytes[idx],
+          cudaMemcpyDeviceToDevice,
+          streams[gpu][idx % STREAMS_PER_GPU]));
+    }
   }
 
-  // Create decompressors for each chunk on each gpu
+  // Create decompressors for each chunk on each gpu, using the managers of
+  // the receiving gpu
   std::vector<DecompressionConfig> decomp_configs;
   decomp_configs.reserve(chunks * gpus);
 
@@ -400,13 +416,21 @@ static void run_nvcomp_benchmark(
     CUDA_CHECK(cudaSetDevice(gpu));
     for (int chunkIdx = 0; chunkIdx < chunks; ++chunkIdx) {
       const int idx = gpu * chunks + chunkIdx;
-      auto decomp_config = managers[idx]->configure_decompression(dest_ptrs[gpu][chunkIdx]);
-      decomp_configs.push_back(decomp_config);
+      nvcompManagerBase* const manager
+          = managers[gpu * chunks_per_gpu + chunkIdx % chunks_per_gpu];
 
-      if (gpu != chunkIdx) {
+      if (chunkIdx / chunks_per_gpu != gpu) {
+        auto decomp_config
+            = manager->configure_decompression(
+                reinterpret_cast<const uint8_t*>(dest_ptrs[gpu][chunkIdx]));
         decomp_out_bytes[idx] = decomp_config.decomp_data_size;
+        decomp_configs.push_back(decomp_config);
       } else {
+        // Local chunks were copied above, and were never sent
+        auto decomp_config
+            = manager->configure_decompression(comp_configs[chunkIdx]);
         decomp_out_bytes[idx] = chunk_bytes[chunkIdx];
+        decomp_configs.push_back(decomp_config);
       }
     }
   }
@@ -415,11 +439,13 @@ static void run_nvcomp_benchmark(
   for (int gpu = 0; gpu < gpus; ++gpu) {
     CUDA_CHECK(cudaSetDevice(gpu));
     for (int chunkIdx = 0; chunkIdx < chunks; ++chunkIdx) {
-      if (gpu != chunkIdx) {
+      if (chunkIdx / chunks_per_gpu != gpu) {
         const int idx = gpu * chunks + chunkIdx;
-        managers[idx]->decompress(
-            d_decomp_out[gpu][chunkIdx],
-            dest_ptrs[gpu][chunkIdx],
+        nvcompManagerBase* const manager
+            = managers[gpu * chunks_per_gpu + chunkIdx % chunks_per_gpu];
+        manager->decompress(
+            reinterpret_cast<uint8_t*>(d_decomp_out[gpu][chunkIdx]),
+            reinterpret_cast<const uint8_t*>(dest_ptrs[gpu][chunkIdx]),
             decomp_configs[idx]);
       }
     }
@@ -493,7 +519,11 @@ static void run_lz4_benchmark(
     // Create compressor each chunk
     for (int chunkIdx = 0; chunkIdx < chunks_per_gpu; ++chunkIdx) {
       const int idx = gpu * chunks_per_gpu + chunkIdx;
-      managers[idx] = new LZ4Manager{1 << 16, nvcompBatchedLZ4Opts_t{NVCOMP_TYPE_CHAR}, streams[gpu][chunkIdx]};
+      managers[idx] = new LZ4Manager{
+          1 << 16,
+          nvcompBatchedLZ4Opts_t{NVCOMP_TYPE_CHAR},
+          streams[gpu][chunkIdx % STREAMS_PER_GPU],
+          gpu};
     }
   }
 
@@ -509,60 +539,52 @@ static void run_lz4_benchmark(
   delete[] managers;
 }
 
-// Benchmark the performance of the All-gather operation using LZ4
+// Benchmark the performance of the All-gather operation using Cascaded
 // compression/decompression to reduce data transfers
-// template <typename T>
-// static void run_cascaded_benchmark(
-//     int gpus,
-//     int chunks,
-//     T** dev_ptrs,
-//     size_t* chunk_sizes,
-//     std::vector<T>* h_data,
-//     int RLEs,
-//     int deltas,
-//     int bitPacking)
-// {
-//   const int chunks_per_gpu = chunks / gpus;
-
-//   Compressor** compressors = new Compressor*[gpus];
-//   for (int gpu = 0; gpu < gpus; ++gpu) {
-//     for (int chunkIdx = 0; chunkIdx < chunks_per_gpu; ++chunkIdx) {
-//       const int idx = gpu * chunks_per_gpu + chunkIdx;
-//       compressors[idx] = new CascadedCompressor(
-//           nvcomp::TypeOf<T>(), RLEs, deltas, bitPacking);
-//     }
-//   }
-
-//   // Create decompressors for each chunk on each gpu
-//   Decompressor** decompressors = new Decompressor*[chunks * gpus];
-//   for (int gpu = 0; gpu < gpus; ++gpu) {
-//     for (int chunkIdx = 0; chunkIdx < chunks; ++chunkIdx) {
-//       const int idx = gpu * chunks + chunkIdx;
-//       if (gpu != chunkIdx) {
-//         // Create compressor for the chunk and allocate necessary memory
-//         decompressors[idx] = new CascadedDecompressor;
-//       }
-//     }
-//   }
-
-//   run_nvcomp_benchmark<T>(
-//       gpus, chunks, dev_ptrs, chunk_sizes, h_data, compressors, decompressors);
-
-//   for (int gpu = 0; gpu < gpus; ++gpu) {
-//     for (int chunkIdx = 0; chunkIdx < chunks_per_gpu; ++chunkIdx) {
-//       const int idx = gpu * chunks_per_gpu + chunkIdx;
-//       delete compressors[idx];
-//     }
-//     for (int chunkIdx = 0; chunkIdx < chunks; ++chunkIdx) {
-//       const int idx = gpu * chunks + chunkIdx;
-//       if (gpu != chunkIdx) {
-//         delete decompressors[idx];
-//       }
-//     }
-//   }
-//   delete[] compressors;
-//   delete[] decompressors;
-// }
+template <typename T>
+static void run_cascaded_benchmark(
+    const int gpus,
+    const int chunks,
+    T** dev_ptrs,
+    size_t* chunk_sizes,
+    std::vector<T>* h_data,
+    const int RLEs,
+    const int deltas,
+    const int bitPacking)
+{
+  const int chunks_per_gpu = chunks / gpus;
+  const int STREAMS_PER_GPU = std::min(chunks_per_gpu, MAX_STREAMS);
+
+  std::vector<std::vector<cudaStream_t>> streams;
+  create_gpu_streams(&streams, gpus, STREAMS_PER_GPU);
+
+  nvcompBatchedCascadedOpts_t opts = nvcompBatchedCascadedDefaultOpts;
+  opts.type = TypeOf<T>();
+  opts.num_RLEs = RLEs;
+  opts.num_deltas = deltas;
+  opts.use_bp = bitPacking;
+
+  nvcompManagerBase** managers = new nvcompManagerBase*[gpus * chunks_per_gpu];
+  for (int gpu = 0; gpu < gpus; ++gpu) {
+    // Create compressor each chunk
+    for (int chunkIdx = 0; chunkIdx < chunks_per_gpu; ++chunkIdx) {
+      const int idx = gpu * chunks_per_gpu + chunkIdx;
+      managers[idx] = new CascadedManager{
+          1 << 16, opts, streams[gpu][chunkIdx % STREAMS_PER_GPU], gpu};
+    }
+  }
+
+  run_nvcomp_benchmark<T>(
+      gpus, chunks, dev_ptrs, chunk_sizes, h_data, managers, streams);
+
+  for (int gpu = 0; gpu < gpus; ++gpu) {
+    for (int chunkIdx = 0; chunkIdx < chunks_per_gpu; ++chunkIdx) {
+      const int idx = gpu * chunks_per_gpu + chunkIdx;
+      delete managers[idx];
+    }
+  }
+  delete[] managers;
+}
 
 static void enable_nvlink(int gpus)
 {
@@ -619,7 +641,8 @@ int main(int argc, char* argv[])
       chunks = atoi(optarg);
       continue;
     }
-    if (strcmp(arg, "--comp") == 0 || strcmp(arg, "-c") == 0) {
+    if (strcmp(arg, "--compression") == 0 || strcmp(arg, "--comp") == 0
+        || strcmp(arg, "-c") == 0) {
       comp_type = optarg;
       continue;
     }
@@ -664,80 +687,84 @@ int main(int argc, char* argv[])
   if (comp_type == "lz4" || comp_type == "LZ4" || comp_type == "none"
       || comp_type == "None") {
     dtype = "uint8"; // LZ4 only works on byte-level
+  } else if (comp_type != "cascaded" && comp_type != "Cascaded") {
+    std::cerr << "Invalid compression benchmark selected." << std::endl;
+    print_usage();
+    return 1;
   }
 
   enable_nvlink(gpu_num);
 
   int rv = 0;
   if (dtype == "int") {
-    // std::vector<int32_t*> data_ptrs(chunks);
-    // std::vector<size_t> data_sizes(chunks);
-    // std::vector<int32_t> h_data;
-    // load_chunks_to_devices<int32_t>(
-    //     fname,
-    //     gpu_num,
-    //     chunks,
-    //     data_ptrs.data(),
-    //     data_sizes.data(),
-    //     &h_data);
-    // run_cascaded_benchmark<int32_t>(
-    //     gpu_num,
-    //     chunks,
-    //     data_ptrs.data(),
-    //     data_sizes.data(),
-    //     &h_data,
-    //     RLEs,
-    //     deltas,
-    //     bitPacking);
-    // for (int chunk = 0; chunk < chunks; ++chunk) {
-    //   CUDA_CHECK(cudaFree(data_ptrs[chunk]));
-    // }
+    std::vector<int32_t*> data_ptrs(chunks);
+    std::vector<size_t> data_sizes(chunks);
+    std::vector<int32_t> h_data;
+    load_chunks_to_devices<int32_t>(
+        fname,
+        gpu_num,
+        chunks,
+        data_ptrs.data(),
+        data_sizes.data(),
+        &h_data);
+    run_cascaded_benchmark<int32_t>(
+        gpu_num,
+        chunks,
+        data_ptrs.data(),
+        data_sizes.data(),
+        &h_data,
+        RLEs,
+        deltas,
+        bitPacking);
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+      CUDA_CHECK(cudaFree(data_ptrs[chunk]));
+    }
   } else if (dtype == "long") {
-    // std::vector<int64_t*> data_ptrs(chunks);
-    // std::vector<size_t> data_sizes(chunks);
-    // std::vector<int64_t> h_data;
-    // load_chunks_to_devices<int64_t>(
-    //     fname,
-    //     gpu_num,
-    //     chunks,
-    //     data_ptrs.data(),
-    //     data_sizes.data(),
-    //     &h_data);
-    // run_cascaded_benchmark<int64_t>(
-    //     gpu_num,
-    //     chunks,
-    //     data_ptrs.data(),
-    //     data_sizes.data(),
-    //     &h_data,
-    //     RLEs,
-    //     deltas,
-    //     bitPacking);
-    // for (int chunk = 0; chunk < chunks; ++chunk) {
-    //   CUDA_CHECK(cudaFree(data_ptrs[chunk]));
-    // }
+    std::vector<int64_t*> data_ptrs(chunks);
+    std::vector<size_t> data_sizes(chunks);
+    std::vector<int64_t> h_data;
+    load_chunks_to_devices<int64_t>(
+        fname,
+        gpu_num,
+        chunks,
+        data_ptrs.data(),
+        data_sizes.data(),
+        &h_data);
+    run_cascaded_benchmark<int64_t>(
+        gpu_num,
+        chunks,
+        data_ptrs.data(),
+        data_sizes.data(),
+        &h_data,
+        RLEs,
+        deltas,
+        bitPacking);
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+      CUDA_CHECK(cudaFree(data_ptrs[chunk]));
+    }
   } else if (dtype == "int8") {
-    // std::vector<int8_t*> data_ptrs(chunks);
-    // std::vector<size_t> data_sizes(chunks);
-    // std::vector<int8_t> h_data;
-    // load_chunks_to_devices<int8_t>(
-    //     fname,
-    //     gpu_num,
-    //     chunks,
-    //     data_ptrs.data(),
-    //     data_sizes.data(),
-    //     &h_data);
-    // run_cascaded_benchmark<int8_t>(
-    //     gpu_num,
-    //     chunks,
-    //     data_ptrs.data(),
-    //     data_sizes.data(),
-    //     &h_data,
-    //     RLEs,
-    //     deltas,
-    //     bitPacking);
-    // for (int chunk = 0; chunk < chunks; ++chunk) {
-    //   CUDA_CHECK(cudaFree(data_ptrs[chunk]));
-    // }
+    std::vector<int8_t*> data_ptrs(chunks);
+    std::vector<size_t> data_sizes(chunks);
+    std::vector<int8_t> h_data;
+    load_chunks_to_devices<int8_t>(
+        fname,
+        gpu_num,
+        chunks,
+        data_ptrs.data(),
+        data_sizes.data(),
+        &h_data);
+    run_cascaded_benchmark<int8_t>(
+        gpu_num,
+        chunks,
+        data_ptrs.data(),
+        data_sizes.data(),
+        &h_data,
+        RLEs,
+        deltas,
+        bitPacking);
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+      CUDA_CHECK(cudaFree(data_ptrs[chunk]));
+    }
   } else if (dtype == "byte" || dtype == "uint8") {
     std::vector<uint8_t*> data_ptrs(chunks);
     std::vector<size_t> data_sizes(chunks);
@@ -0,0 +1,410 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Simulate the allgather of benchmark_allgather.cpp on the CPU: one thread
+// per rank, over links with a modelled bandwidth and latency, with the
+// shards optionally compressed by a host codec before they are sent. With
+// --type, the input is a column of integers and the shards hold whole
+// elements, so that Cascaded compression sees aligned values.
+
+#include "host/collective_sim.h"
+#include "host/file_io.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace nvcomp::host;
+
+static void print_usage()
+{
+  printf("Usage: benchmark_allgather_host [OPTIONS]\n");
+  printf("  %-35s Binary dataset filename (required).\n", "-f, --filename");
+  printf("  %-35s Number(s) of ranks, comma separated (default 4).\n", "-g, --ranks");
+  printf("  %-35s Algorithm(s): naive, ring, rd, tree, pipelined or all (default all).\n", "-a, --algorithm");
+  printf("  %-35s Topology: full, ring or switch (default full).\n", "-t, --topology");
+  printf("  %-35s Codec(s): none, lz4, deflate, cascaded, rle, dict, pfor or all (default all).\n", "-c, --compression");
+  printf("  %-35s Datatype: byte, int8, int or long (default byte).\n", "-y, --type");
+  printf("  %-35s *If Cascaded* Number of RLEs (default 1).\n", "-r, --rles");
+  printf("  %-35s *If Cascaded* Number of Deltas (default 0).\n", "-d, --deltas");
+  printf("  %-35s *If Cascaded* Bitpacking enabled (default 1).\n", "-b, --bitpack");
+  printf("  %-35s Link bandwidth in GB/s, 0 for unlimited (default 10).\n", "-w, --bandwidth");
+  printf("  %-35s Link latency in microseconds (default 10).\n", "-l, --latency");
+  printf("  %-35s Compression chunk size (default 64 kB).\n", "-p, --chunk_size");
+  printf("  %-35s *If pipelined* Bytes per sub-chunk of a shard (default 1 MB).\n", "-s, --pipeline_chunk_size");
+  printf("  %-35s *If pipelined* Write the stage timelines as CSV to this file.\n", "-o, --timeline");
+  printf("  %-35s Number of recorded iterations (default 3).\n", "-i, --iteration_count");
+  printf("  %-35s Output in CSV format.\n", "-x, --csv");
+}
+
+static std::vector<std::string> split_list(const std::string& text)
+{
+  std::vector<std::string> items;
+  std::istringstream list(text);
+  std::string item;
+  while (std::getline(list, item, ',')) {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+// Size of the elements of the --type option, or 0 if unknown.
+static size_t type_size(const std::string& type)
+{
+  if (type == "byte" || type == "uint8" || type == "int8" || type == "char") {
+    return 1;
+  }
+  if (type == "int") {
+    return 4;
+  }
+  if (type == "long") {
+    return 8;
+  }
+  return 0;
+}
+
+// Split the input into one shard of whole elements per rank, as
+// load_chunks_to_devices does. A partial element at the end of the input is
+// dropped, as in load_dataset_from_binary.
+static std::vector<std::vector<uint8_t>> make_shards(
+    const std::vector<char>& data, const size_t ranks, const size_t elt_size)
+{
+  const size_t elements = data.size() / elt_size;
+  const size_t shard_size = (elements + ranks - 1) / ranks * elt_size;
+  const size_t total = elements * elt_size;
+  std::vector<std::vector<uint8_t>> shards(ranks);
+  for (size_t r = 0; r < ranks; ++r) {
+    const size_t begin = std::min(total, r * shard_size);
+    const size_t end = std::min(total, begin + shard_size);
+    shards[r].assign(data.begin() + begin, data.begin() + end);
+  }
+  return shards;
+}
+
+int main(int argc, char* argv[])
+{
+  char* fname = NULL;
+  std::string ranks_list = "4";
+  std::string algorithm_list = "all";
+  std::string topology_name = "full";
+  std::string codec_list = "all";
+  double bandwidth_gbs = 10;
+  double latency_us = 10;
+  size_t chunk_size = 1 << 16;
+  size_t pipeline_chunk_size = 1 << 20;
+  char* timeline_fname = NULL;
+  int iterations = 3;
+  bool csv = false;
+  std::string dtype = "byte";
+  int RLEs = 1;
+  int deltas = 0;
+  int bitPacking = 1;
+
+  char** argv_end = argv + argc;
+  argv += 1;
+  while (argv != argv_end) {
+    char* arg = *argv++;
+    if (strcmp(arg, "--help") == 0 || strcmp(arg, "-?") == 0) {
+      print_usage();
+      return 1;
+    }
+    if (strcmp(arg, "--csv") == 0 || strcmp(arg, "-x") == 0) {
+      csv = true;
+      continue;
+    }
+
+    // all arguments below require at least a second value in argv
+    if (argv >= argv_end) {
+      print_usage();
+      return 1;
+    }
+
+    char* optarg = *argv++;
+    if (strcmp(arg, "--filename") == 0 || strcmp(arg, "-f") == 0) {
+      fname = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--ranks") == 0 || strcmp(arg, "-g") == 0) {
+      ranks_list = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--algorithm") == 0 || strcmp(arg, "-a") == 0) {
+      algorithm_list = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--topology") == 0 || strcmp(arg, "-t") == 0) {
+      topology_name = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--compression") == 0 || strcmp(arg, "-c") == 0) {
+      codec_list = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--type") == 0 || strcmp(arg, "-y") == 0) {
+      dtype = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--rles") == 0 || strcmp(arg, "-r") == 0) {
+      RLEs = atoi(optarg);
+      continue;
+    }
+    if (strcmp(arg, "--deltas") == 0 || strcmp(arg, "-d") == 0) {
+      deltas = atoi(optarg);
+      continue;
+    }
+    if (strcmp(arg, "--bitpack") == 0 || strcmp(arg, "-b") == 0) {
+      bitPacking = atoi(optarg);
+      continue;
+    }
+    if (strcmp(arg, "--bandwidth") == 0 || strcmp(arg, "-w") == 0) {
+      bandwidth_gbs = atof(optarg);
+      continue;
+    }
+    if (strcmp(arg, "--latency") == 0 || strcmp(arg, "-l") == 0) {
+      latency_us = atof(optarg);
+      continue;
+    }
+    if (strcmp(arg, "--chunk_size") == 0 || strcmp(arg, "-p") == 0) {
+      chunk_size = strtoull(optarg, nullptr, 10);
+      continue;
+    }
+    if (strcmp(arg, "--pipeline_chunk_size") == 0 || strcmp(arg, "-s") == 0) {
+      pipeline_chunk_size = strtoull(optarg, nullptr, 10);
+      continue;
+    }
+    if (strcmp(arg, "--timeline") == 0 || strcmp(arg, "-o") == 0) {
+      timeline_fname = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--iteration_count") == 0 || strcmp(arg, "-i") == 0) {
+      iterations = atoi(optarg);
+      continue;
+    }
+    print_usage();
+    return 1;
+  }
+
+  if (fname == NULL) {
+    std::cerr << "Missing filename." << std::endl;
+    print_usage();
+    return 1;
+  }
+  const size_t elt_size = type_size(dtype);
+  if (elt_size == 0) {
+    std::cerr << "Invalid datatype selected." << std::endl;
+    print_usage();
+    return 1;
+  }
+  if (chunk_size == 0 || chunk_size % elt_size != 0 || iterations <= 0
+      || pipeline_chunk_size == 0 || pipeline_chunk_size % elt_size != 0) {
+    print_usage();
+    return 1;
+  }
+
+  std::vector<size_t> rank_counts;
+  for (const std::string& item : split_list(ranks_list)) {
+    const size_t ranks = strtoull(item.c_str(), nullptr, 10);
+    if (ranks < 2) {
+      std::cerr << "The number of ranks must be at least 2." << std::endl;
+      return 1;
+    }
+    rank_counts.push_back(ranks);
+  }
+
+  std::vector<AllgatherAlgorithm> algorithms;
+  if (algorithm_list == "all") {
+    algorithms = {AllgatherAlgorithm::Naive,
+                  AllgatherAlgorithm::Ring,
+                  AllgatherAlgorithm::RecursiveDoubling,
+                  AllgatherAlgorithm::Tree,
+                  AllgatherAlgorithm::Pipelined};
+  } else {
+    for (const std::string& item : split_list(algorithm_list)) {
+      algorithms.push_back(parse_algorithm(item));
+    }
+  }
+
+  HostCascadedOptions cascaded_opts = HostCascadedDefaultOpts;
+  cascaded_opts.type_size = elt_size;
+  cascaded_opts.num_RLEs = RLEs;
+  cascaded_opts.num_deltas = deltas;
+  cascaded_opts.use_bp = bitPacking != 0;
+
+  // A null codec sends the shards uncompressed.
+  std::vector<std::shared_ptr<const HostCodec>> codecs;
+  if (codec_list == "all") {
+    codecs.push_back(nullptr);
+    for (const HostCodecId id : {HostCodecId::LZ4, HostCodecId::Deflate}) {
+      if (host_codec_available(id)) {
+        codecs.push_back(make_host_codec(id));
+      }
+    }
+    codecs.push_back(std::make_shared<CascadedCodec>(cascaded_opts));
+  } else {
+    for (const std::string& item : split_list(codec_list)) {
+      if (item == "none") {
+        codecs.push_back(nullptr);
+      } else if (item == "cascaded") {
+        codecs.push_back(std::make_shared<CascadedCodec>(cascaded_opts));
+      } else if (item == "rle") {
+        codecs.push_back(std::make_shared<RleCodec>(HostRleOptions{elt_size}));
+      } else if (item == "dict") {
+        HostDictionaryOptions dict_opts = HostDictionaryDefaultOpts;
+        dict_opts.type_size = elt_size;
+        codecs.push_back(std::make_shared<DictionaryCodec>(dict_opts));
+      } else if (item == "pfor") {
+        HostPforOptions pfor_opts = HostPforDefaultOpts;
+        pfor_opts.type_size = elt_size;
+        codecs.push_back(std::make_shared<PforCodec>(pfor_opts));
+      } else {
+        codecs.push_back(make_host_codec(item));
+      }
+    }
+  }
+
+  std::ofstream timeline;
+  if (timeline_fname != NULL) {
+    timeline.open(timeline_fname);
+    if (!timeline) {
+      std::cerr << "Cannot open " << timeline_fname << "." << std::endl;
+      return 1;
+    }
+    timeline << "ranks,codec,rank,stage,chunk,begin (us),end (us)"
+             << std::endl;
+  }
+
+  const std::vector<char> data = readFile(fname);
+  const LinkModel link = {bandwidth_gbs * 1e9, latency_us * 1e-6};
+
+  std::cout << "----------" << std::endl;
+  std::cout << "uncompressed (B): " << data.size() << ", type: " << dtype
+            << std::endl;
+  std::cout << "topology: " << topology_name << ", link bandwidth (GB/s): "
+            << bandwidth_gbs << ", latency (us): " << latency_us << std::endl;
+
+  const char sep = ',';
+  if (csv) {
+    std::cout << "ranks" << sep << "algorithm" << sep << "codec" << sep
+              << "time (ms)" << sep << "per-rank throughput (GB/s)" << sep
+              << "compress (ms)" << sep << "exchange (ms)" << sep
+              << "decompress (ms)" << sep << "overlap" << sep << "ratio"
+              << sep << "link bytes (B)" << sep << "messages" << std::endl;
+  } else {
+    std::cout << std::setw(6) << "ranks" << std::setw(10) << "algorithm"
+              << std::setw(9) << "codec" << std::setw(11) << "time(ms)"
+              << std::setw(10) << "GB/s" << std::setw(12) << "comp(ms)"
+              << std::setw(12) << "xchg(ms)" << std::setw(12) << "decomp(ms)"
+              << std::setw(9) << "overlap" << std::setw(8) << "ratio"
+              << std::setw(14) << "link(MB)" << std::setw(7) << "msgs"
+              << std::endl;
+  }
+
+  bool all_correct = true;
+  for (const size_t ranks : rank_counts) {
+    const std::vector<std::vector<uint8_t>> shards = make_shards(data, ranks, elt_size);
+    const std::unique_ptr<Topology> topology
+        = make_topology(topology_name, ranks, link);
+
+    for (const AllgatherAlgorithm algorithm : algorithms) {
+      if (algorithm == AllgatherAlgorithm::RecursiveDoubling
+          && (ranks & (ranks - 1)) != 0) {
+        continue;
+      }
+      for (const std::shared_ptr<const HostCodec>& codec : codecs) {
+        AllgatherOptions options;
+        options.codec = codec;
+        options.chunk_size = chunk_size;
+        options.pipeline_chunk_size = pipeline_chunk_size;
+
+        // One warmup run, then report the fastest recorded run.
+        AllgatherStats best = run_allgather(*topology, algorithm, shards, options);
+        for (int i = 0; i < iterations; ++i) {
+          const AllgatherStats stats
+              = run_allgather(*topology, algorithm, shards, options);
+          all_correct = all_correct && stats.correct;
+          if (i == 0 || stats.seconds < best.seconds) {
+            best = stats;
+          }
+        }
+
+        // Per rank, as in benchmark_allgather: the data each rank receives.
+        const double received = static_cast<double>(best.uncompressed_bytes)
+                                * (ranks - 1.0) / static_cast<double>(ranks);
+        const double throughput = received / best.seconds * 1e-9;
+        const double ratio = static_cast<double>(best.uncompressed_bytes)
+                             / best.shard_bytes;
+        const char* const codec_name = codec ? codec->name() : "none";
+
+        if (csv) {
+          std::cout << ranks << sep << algorithm_name(algorithm) << sep
+                    << codec_name << sep << best.seconds * 1e3 << sep
+                    << throughput << sep << best.compress_seconds * 1e3 << sep
+                    << best.exchange_seconds * 1e3 << sep
+                    << best.decompress_seconds * 1e3 << sep
+                    << best.overlap_fraction << sep << ratio << sep
+                    << best.link_bytes << sep << best.messages << std::endl;
+        } else {
+          std::cout << std::fixed << std::setprecision(2) << std::setw(6)
+                    << ranks << std::setw(10) << algorithm_name(algorithm)
+                    << std::setw(9) << codec_name << std::setw(11)
+                    << best.seconds * 1e3 << std::setw(10) << throughput
+                    << std::setw(12) << best.compress_seconds * 1e3
+                    << std::setw(12) << best.exchange_seconds * 1e3
+                    << std::setw(12) << best.decompress_seconds * 1e3
+                    << std::setw(9) << best.overlap_fraction << std::setw(8)
+                    << ratio << std::setw(14) << best.link_bytes * 1e-6
+                    << std::setw(7) << best.messages << std::endl;
+        }
+
+        if (timeline.is_open()) {
+          for (const PipelineInterval& interval : best.timeline) {
+            timeline << ranks << sep << codec_name << sep << interval.rank
+                     << sep << stage_name(interval.stage) << sep
+                     << interval.chunk << sep << interval.begin * 1e6 << sep
+                     << interval.end * 1e6 << std::endl;
+          }
+        }
+      }
+    }
+  }
+
+  if (!all_correct) {
+    std::cout << "Incorrect result: a rank did not receive every shard intact."
+              << std::endl;
+    return 1;
+  }
+  return 0;
+}
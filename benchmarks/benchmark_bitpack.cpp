@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Measure the host bit packing kernels for every element type and bit
+// width, in values per cycle, for packing and for unpacking with each
+// kernel the CPU supports.
+
+#include "host/bitpack.h"
+#include "host/perf_counters.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define NVCOMP_BENCHMARK_HAVE_TSC
+#endif
+
+using namespace nvcomp::host;
+
+static void print_usage()
+{
+  printf("Usage: benchmark_bitpack [OPTIONS]\n");
+  printf("  %-35s Values per run (default 65536).\n", "-n, --count");
+  printf("  %-35s Element size(s) in bits: 8, 16, 32, 64 or all (default all).\n", "-t, --types");
+  printf("  %-35s Number of measurement iterations (default 3).\n", "-i, --iteration_count");
+  printf("  %-35s Output in CSV format.\n", "-x, --csv");
+}
+
+// Cycles of a region, from the hardware counter when perf_event_open is
+// allowed, and otherwise from the time stamp counter, which counts at a
+// fixed reference frequency rather than the core clock.
+class CycleCounter
+{
+public:
+  CycleCounter() : m_perf(), m_start(0)
+  {
+  }
+
+  const char* source() const
+  {
+    if (m_perf.available()) {
+      return "perf";
+    }
+#ifdef NVCOMP_BENCHMARK_HAVE_TSC
+    return "tsc";
+#else
+    return "unavailable";
+#endif
+  }
+
+  void start()
+  {
+    m_perf.start();
+#ifdef NVCOMP_BENCHMARK_HAVE_TSC
+    m_start = __rdtsc();
+#endif
+  }
+
+  // The cycles since start(), or 0 if they can't be counted.
+  uint64_t stop()
+  {
+#ifdef NVCOMP_BENCHMARK_HAVE_TSC
+    const uint64_t tsc = __rdtsc() - m_start;
+#else
+    const uint64_t tsc = 0;
+#endif
+    const PerfSample sample = m_perf.stop();
+    return sample.has(PerfCounterId::Cycles) ? sample.get(PerfCounterId::Cycles)
+                                             : tsc;
+  }
+
+private:
+  PerfCounters m_perf;
+  uint64_t m_start;
+};
+
+// The fastest of several runs of one phase.
+struct PhaseResult
+{
+  double seconds;
+  uint64_t cycles;
+
+  PhaseResult() : seconds(std::numeric_limits<double>::max()), cycles(0)
+  {
+  }
+
+  void update(const double run_seconds, const uint64_t run_cycles)
+  {
+    if (run_seconds < seconds) {
+      seconds = run_seconds;
+      cycles = run_cycles;
+    }
+  }
+};
+
+static void print_header(const bool csv)
+{
+  if (csv) {
+    std::cout << "type,bits,phase,kernel,Mvalues/s,values/cycle" << std::endl;
+    return;
+  }
+  std::cout << std::setw(6) << "type" << std::setw(6) << "bits"
+            << std::setw(9) << "phase" << std::setw(9) << "kernel"
+            << std::setw(11) << "Mvalues/s" << std::setw(14)
+            << "values/cycle" << std::endl;
+}
+
+static void print_row(
+    const bool csv,
+    const size_t type_bits,
+    const size_t bits,
+    const char* const phase,
+    const char* const kernel,
+    const PhaseResult& result,
+    const size_t values)
+{
+  const double mvalues = values / result.seconds * 1e-6;
+  const bool has_cycles = result.cycles > 0;
+  const double per_cycle = has_cycles ? double(values) / result.cycles : 0.0;
+  if (csv) {
+    std::cout << "uint" << type_bits << "," << bits << "," << phase << ","
+              << kernel << "," << mvalues << ",";
+    if (has_cycles) {
+      std::cout << per_cycle;
+    }
+    std::cout << std::endl;
+    return;
+  }
+  std::cout << std::fixed << std::setw(6) << ("u" + std::to_string(type_bits))
+            << std::setw(6) << bits << std::setw(9) << phase << std::setw(9)
+            << kernel << std::setprecision(1) << std::setw(11) << mvalues
+            << std::setprecision(3) << std::setw(14);
+  if (has_cycles) {
+    std::cout << per_cycle;
+  } else {
+    std::cout << "-";
+  }
+  std::cout << std::endl;
+}
+
+template <typename T>
+static int run_type(
+    const size_t count,
+    const int iterations,
+    const bool csv,
+    CycleCounter& cycles)
+{
+  typedef std::chrono::steady_clock clock;
+
+  // Repeat short runs so that each takes long enough to time.
+  const size_t repeats = std::max<size_t>(1, (size_t(1) << 24) / count);
+  const size_t values = repeats * count;
+  std::mt19937_64 rng(8 * sizeof(T));
+  std::vector<T> in(count);
+  std::vector<T> out(count);
+  for (size_t bits = 1; bits <= 8 * sizeof(T); ++bits) {
+    const uint64_t mask = bits == 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+    for (T& v : in) {
+      v = static_cast<T>(rng() & mask);
+    }
+    std::vector<uint64_t> words(bitpack_words(count, bits));
+
+    PhaseResult pack;
+    for (int it = 0; it < iterations; ++it) {
+      const clock::time_point start = clock::now();
+      cycles.start();
+      for (size_t r = 0; r < repeats; ++r) {
+        bitpack(in.data(), count, bits, T(0), words.data());
+      }
+      const uint64_t run_cycles = cycles.stop();
+      pack.update(
+          std::chrono::duration<double>(clock::now() - start).count(),
+          run_cycles);
+    }
+    print_row(csv, 8 * sizeof(T), bits, "pack", "scalar", pack, values);
+
+    for (const BitpackKernel kernel :
+         {BitpackKernel::Scalar,
+          BitpackKernel::SSE41,
+          BitpackKernel::AVX2,
+          BitpackKernel::AVX512}) {
+      if (!bitpack_kernel_supported(kernel)) {
+        continue;
+      }
+      PhaseResult unpack;
+      for (int it = 0; it < iterations; ++it) {
+        const clock::time_point start = clock::now();
+        cycles.start();
+        for (size_t r = 0; r < repeats; ++r) {
+          bitunpack(words.data(), count, bits, T(0), out.data(), kernel);
+        }
+        const uint64_t run_cycles = cycles.stop();
+        unpack.update(
+            std::chrono::duration<double>(clock::now() - start).count(),
+            run_cycles);
+      }
+      if (out != in) {
+        std::cerr << "Unpacking uint" << 8 * sizeof(T) << " at " << bits
+                  << " bits with " << bitpack_kernel_name(kernel)
+                  << " gave wrong values." << std::endl;
+        return 1;
+      }
+      print_row(
+          csv,
+          8 * sizeof(T),
+          bits,
+          "unpack",
+          bitpack_kernel_name(kernel),
+          unpack,
+          values);
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  size_t count = 65536;
+  std::string type_list = "all";
+  int iterations = 3;
+  bool csv = false;
+
+  char** argv_end = argv + argc;
+  argv += 1;
+  while (argv != argv_end) {
+    char* arg = *argv++;
+    if (strcmp(arg, "--help") == 0 || strcmp(arg, "-?") == 0) {
+      print_usage();
+      return 1;
+    }
+    if (strcmp(arg, "--csv") == 0 || strcmp(arg, "-x") == 0) {
+      csv = true;
+      continue;
+    }
+
+    // all arguments below require at least a second value in argv
+    if (argv >= argv_end) {
+      print_usage();
+      return 1;
+    }
+
+    char* optarg = *argv++;
+    if (strcmp(arg, "--count") == 0 || strcmp(arg, "-n") == 0) {
+      count = strtoull(optarg, nullptr, 10);
+      continue;
+    }
+    if (strcmp(arg, "--types") == 0 || strcmp(arg, "-t") == 0) {
+      type_list = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--iteration_count") == 0 || strcmp(arg, "-i") == 0) {
+      iterations = atoi(optarg);
+      continue;
+    }
+    print_usage();
+    return 1;
+  }
+
+  if (count == 0 || iterations <= 0) {
+    print_usage();
+    return 1;
+  }
+
+  std::vector<size_t> types;
+  if (type_list == "all") {
+    types = {8, 16, 32, 64};
+  } else {
+    std::istringstream list(type_list);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+      const size_t type_bits = strtoull(item.c_str(), nullptr, 10);
+      if (type_bits != 8 && type_bits != 16 && type_bits != 32
+          && type_bits != 64) {
+        std::cerr << "Element sizes must be 8, 16, 32 or 64 bits."
+                  << std::endl;
+        return 1;
+      }
+      types.push_back(type_bits);
+    }
+  }
+
+  CycleCounter cycles;
+  std::cout << "----------" << std::endl;
+  std::cout << "values: " << count << std::endl;
+  std::cout << "cycles: " << cycles.source() << std::endl;
+  std::cout << "default unpack kernel: "
+            << bitpack_kernel_name(bitpack_default_kernel()) << std::endl;
+  print_header(csv);
+
+  for (const size_t type_bits : types) {
+    int status = 0;
+    switch (type_bits) {
+    case 8:
+      status = run_type<uint8_t>(count, iterations, csv, cycles);
+      break;
+    case 16:
+      status = run_type<uint16_t>(count, iterations, csv, cycles);
+      break;
+    case 32:
+      status = run_type<uint32_t>(count, iterations, csv, cycles);
+      break;
+    default:
+      status = run_type<uint64_t>(count, iterations, csv, cycles);
+      break;
+    }
+    if (status != 0) {
+      return status;
+    }
+  }
+  return 0;
+}
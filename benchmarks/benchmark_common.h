@@ -32,6 +32,7 @@
 #define VERBOSE 0
 #endif
 
+#include "host/perf_counters.h"
 #include "nvcomp.hpp"
 #include "nvcomp/cascaded.h"
 
@@ -124,6 +125,51 @@ average_gbs(
   return (double)s / 1e9 / avg_duration;
 }
 
+// Hardware counters of a host phase of a benchmark that processed `bytes`,
+// e.g. a CPU codec loop, printed with the other results. Counters the
+// platform doesn't allow are left out of the text output, and their CSV
+// fields are left empty, so that the columns don't change.
+inline void print_perf_result(
+    const std::string& phase, const host::PerfSample& sample, size_t bytes)
+{
+  host::print_perf_sample(std::cout, phase.c_str(), sample, bytes);
+}
+
+// The CSV columns of print_perf_csv_values(), prefixed with `phase` unless
+// it is empty.
+inline void
+print_perf_csv_header(const std::string& separator, const std::string& phase)
+{
+  const std::string prefix = phase.empty() ? phase : phase + " ";
+  std::cout << separator << prefix << "IPC";
+  std::cout << separator << prefix << "bytes per cycle";
+  std::cout << separator << prefix << "LLC misses per kB";
+  std::cout << separator << prefix << "branch misses per kB";
+}
+
+inline void print_perf_csv_values(
+    const std::string& separator, const host::PerfSample& sample, size_t bytes)
+{
+  using host::PerfCounterId;
+  const bool cycles = sample.has(PerfCounterId::Cycles);
+  std::cout << separator;
+  if (cycles && sample.has(PerfCounterId::Instructions)) {
+    std::cout << sample.ipc();
+  }
+  std::cout << separator;
+  if (cycles) {
+    std::cout << sample.bytes_per_cycle(bytes);
+  }
+  std::cout << separator;
+  if (sample.has(PerfCounterId::LLCMisses)) {
+    std::cout << sample.per_kb(PerfCounterId::LLCMisses, bytes);
+  }
+  std::cout << separator;
+  if (sample.has(PerfCounterId::BranchMisses)) {
+    std::cout << sample.per_kb(PerfCounterId::BranchMisses, bytes);
+  }
+}
+
 #ifdef __GNUC__
 #pragma GCC diagnostic pop
 #endif
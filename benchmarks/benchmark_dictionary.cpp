@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Dictionary encode one column of a file on the CPU, and report how fast
+// the dictionary is built and decoded, and how small the dictionary and
+// codes are with the codes bit packed or compressed with host Cascaded.
+
+#include "host/bitpack.h"
+#include "host/dictionary.h"
+#include "host/file_io.h"
+#include "host/host_cascaded.h"
+#include "host/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace nvcomp::host;
+
+static void print_usage()
+{
+  printf("Usage: benchmark_dictionary [OPTIONS]\n");
+  printf("  %-35s Binary input file (required).\n", "-f, --input_file");
+  printf("  %-35s Column type: int8, short, int, long or text (default int).\n", "-t, --type");
+  printf("  %-35s Code order: first, sorted or all (default all).\n", "-o, --order");
+  printf("  %-35s Chunk size in bytes for Cascaded codes (default 65536).\n", "-p, --chunk_size");
+  printf("  %-35s Worker threads (default one per CPU).\n", "-n, --threads");
+  printf("  %-35s Number of measurement iterations (default 3).\n", "-i, --iteration_count");
+  printf("  %-35s Output in CSV format.\n", "-x, --csv");
+  printf("Text columns hold one value per line, as written by text_to_binary.py\n");
+  printf("with the 'text' data type.\n");
+}
+
+static size_t value_bytes(const std::string& value)
+{
+  // With its line separator.
+  return value.size() + 1;
+}
+
+template <typename K>
+static size_t value_bytes(const K&)
+{
+  return sizeof(K);
+}
+
+// Bytes of the codes compressed with host Cascaded in chunks of
+// `chunk_size`, at the narrowest fixed width that holds them.
+static size_t cascaded_code_bytes(
+    ThreadPool& pool,
+    const std::vector<uint32_t>& codes,
+    const size_t num_values,
+    const size_t chunk_size)
+{
+  const size_t code_bytes = dictionary_code_bytes(num_values);
+  std::vector<uint8_t> narrow(codes.size() * code_bytes);
+  for (size_t i = 0; i < codes.size(); ++i) {
+    std::memcpy(&narrow[i * code_bytes], &codes[i], code_bytes);
+  }
+  HostCascadedOptions options = HostCascadedDefaultOpts;
+  options.type_size = code_bytes;
+  const CascadedCodec codec(options);
+
+  const size_t chunk_bytes = std::max(code_bytes, chunk_size);
+  const size_t num_chunks = (narrow.size() + chunk_bytes - 1) / chunk_bytes;
+  std::atomic<size_t> total(0);
+  pool.parallel_for(num_chunks, [&](const size_t c) {
+    const size_t offset = c * chunk_bytes;
+    const size_t bytes = std::min(chunk_bytes, narrow.size() - offset);
+    std::vector<uint8_t> out(codec.max_compressed_size(bytes));
+    total += codec.compress(&narrow[offset], bytes, out.data(), out.size());
+  });
+  return total;
+}
+
+static void print_header(const bool csv)
+{
+  if (csv) {
+    std::cout << "order,values,distinct,code bits,build MB/s,decode MB/s,"
+                 "packed ratio,cascaded ratio"
+              << std::endl;
+    return;
+  }
+  std::cout << std::setw(8) << "order" << std::setw(12) << "values"
+            << std::setw(10) << "distinct" << std::setw(6) << "bits"
+            << std::setw(12) << "build MB/s" << std::setw(13) << "decode MB/s"
+            << std::setw(8) << "packed" << std::setw(10) << "cascaded"
+            << std::endl;
+}
+
+template <typename K>
+static int run(
+    ThreadPool& pool,
+    const std::vector<K>& column,
+    const size_t raw_bytes,
+    const bool sorted,
+    const size_t chunk_size,
+    const int iterations,
+    const bool csv)
+{
+  typedef std::chrono::steady_clock clock;
+  double build_seconds = std::numeric_limits<double>::max();
+  double decode_seconds = std::numeric_limits<double>::max();
+  Dictionary<K> dict;
+  std::vector<K> decoded(column.size());
+  for (int it = 0; it < iterations; ++it) {
+    clock::time_point start = clock::now();
+    dict = build_dictionary(pool, column.data(), column.size(), sorted);
+    build_seconds = std::min(
+        build_seconds,
+        std::chrono::duration<double>(clock::now() - start).count());
+
+    start = clock::now();
+    const bool ok = dictionary_decode(
+        pool,
+        dict.values.data(),
+        dict.values.size(),
+        dict.codes.data(),
+        dict.codes.size(),
+        decoded.data());
+    decode_seconds = std::min(
+        decode_seconds,
+        std::chrono::duration<double>(clock::now() - start).count());
+    if (!ok || decoded != column) {
+      std::cerr << "Dictionary decoding gave wrong values." << std::endl;
+      return 1;
+    }
+  }
+
+  size_t dictionary_bytes = 0;
+  for (const K& value : dict.values) {
+    dictionary_bytes += value_bytes(value);
+  }
+  const size_t bits = dictionary_code_bits(dict.values.size());
+  const size_t packed_bytes
+      = bitpack_words(column.size(), bits) * sizeof(uint64_t);
+  const size_t cascaded_bytes = cascaded_code_bytes(
+      pool, dict.codes, dict.values.size(), chunk_size);
+  const double packed_ratio
+      = double(raw_bytes) / (dictionary_bytes + packed_bytes);
+  const double cascaded_ratio
+      = double(raw_bytes) / (dictionary_bytes + cascaded_bytes);
+  const double build_mbs = raw_bytes / build_seconds * 1e-6;
+  const double decode_mbs = raw_bytes / decode_seconds * 1e-6;
+  const char* const order = sorted ? "sorted" : "first";
+
+  if (csv) {
+    std::cout << order << "," << column.size() << "," << dict.values.size()
+              << "," << bits << "," << build_mbs << "," << decode_mbs << ","
+              << packed_ratio << "," << cascaded_ratio << std::endl;
+    return 0;
+  }
+  std::cout << std::fixed << std::setw(8) << order << std::setw(12)
+            << column.size() << std::setw(10) << dict.values.size()
+            << std::setw(6) << bits << std::setprecision(1) << std::setw(12)
+            << build_mbs << std::setw(13) << decode_mbs << std::setprecision(2)
+            << std::setw(8) << packed_ratio << std::setw(10) << cascaded_ratio
+            << std::endl;
+  return 0;
+}
+
+template <typename K>
+static std::vector<K> load_integers(const std::vector<char>& data)
+{
+  std::vector<K> column(data.size() / sizeof(K));
+  if (!column.empty()) {
+    std::memcpy(column.data(), data.data(), column.size() * sizeof(K));
+  }
+  return column;
+}
+
+template <typename K>
+static int run_orders(
+    ThreadPool& pool,
+    const std::vector<K>& column,
+    const size_t raw_bytes,
+    const std::string& order,
+    const size_t chunk_size,
+    const int iterations,
+    const bool csv)
+{
+  print_header(csv);
+  for (const bool sorted : {false, true}) {
+    if (order != "all" && (order == "sorted") != sorted) {
+      continue;
+    }
+    const int status
+        = run(pool, column, raw_bytes, sorted, chunk_size, iterations, csv);
+    if (status != 0) {
+      return status;
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  char* fname = nullptr;
+  std::string type = "int";
+  std::string order = "all";
+  size_t chunk_size = 65536;
+  size_t num_threads = 0;
+  int iterations = 3;
+  bool csv = false;
+
+  char** argv_end = argv + argc;
+  argv += 1;
+  while (argv != argv_end) {
+    char* arg = *argv++;
+    if (strcmp(arg, "--help") == 0 || strcmp(arg, "-?") == 0) {
+      print_usage();
+      return 1;
+    }
+    if (strcmp(arg, "--csv") == 0 || strcmp(arg, "-x") == 0) {
+      csv = true;
+      continue;
+    }
+
+    // all arguments below require at least a second value in argv
+    if (argv >= argv_end) {
+      print_usage();
+      return 1;
+    }
+
+    char* optarg = *argv++;
+    if (strcmp(arg, "--input_file") == 0 || strcmp(arg, "-f") == 0) {
+      fname = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--type") == 0 || strcmp(arg, "-t") == 0) {
+      type = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--order") == 0 || strcmp(arg, "-o") == 0) {
+      order = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--chunk_size") == 0 || strcmp(arg, "-p") == 0) {
+      chunk_size = strtoull(optarg, nullptr, 10);
+      continue;
+    }
+    if (strcmp(arg, "--threads") == 0 || strcmp(arg, "-n") == 0) {
+      num_threads = strtoull(optarg, nullptr, 10);
+      continue;
+    }
+    if (strcmp(arg, "--iteration_count") == 0 || strcmp(arg, "-i") == 0) {
+      iterations = atoi(optarg);
+      continue;
+    }
+    print_usage();
+    return 1;
+  }
+
+  if (fname == nullptr || iterations <= 0 || chunk_size == 0
+      || (order != "first" && order != "sorted" && order != "all")) {
+    print_usage();
+    return 1;
+  }
+
+  const std::vector<char> data = readFile(fname);
+  ThreadPool pool(num_threads);
+  std::cout << "----------" << std::endl;
+  std::cout << "file: " << fname << std::endl;
+  std::cout << "type: " << type << std::endl;
+  std::cout << "threads: " << pool.num_threads() << std::endl;
+  std::cout << "uncompressed (B): " << data.size() << std::endl;
+
+  if (type == "text") {
+    const std::vector<std::string> column
+        = split_dictionary_strings(data.data(), data.size());
+    return run_orders(
+        pool, column, data.size(), order, chunk_size, iterations, csv);
+  }
+  if (type == "int8") {
+    return run_orders(
+        pool,
+        load_integers<uint8_t>(data),
+        data.size(),
+        order,
+        chunk_size,
+        iterations,
+        csv);
+  }
+  if (type == "short") {
+    return run_orders(
+        pool,
+        load_integers<uint16_t>(data),
+        data.size(),
+        order,
+        chunk_size,
+        iterations,
+        csv);
+  }
+  if (type == "int") {
+    return run_orders(
+        pool,
+        load_integers<uint32_t>(data),
+        data.size(),
+        order,
+        chunk_size,
+        iterations,
+        csv);
+  }
+  if (type == "long") {
+    return run_orders(
+        pool,
+        load_integers<uint64_t>(data),
+        data.size(),
+        order,
+        chunk_size,
+        iterations,
+        csv);
+  }
+  std::cerr << "Type must be int8, short, int, long or text." << std::endl;
+  return 1;
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Index an existing gzip, zlib or raw deflate file on the CPU, and report
+// how fast the index is built, how large it is, how fast the file
+// decompresses with one thread and with all of them, and how long random
+// reads take. Optionally write the index to a side file.
+
+#include "host/file_io.h"
+#include "host/thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef NVCOMP_HOST_HAVE_ZLIB
+
+#include "host/gzip_index.h"
+
+using namespace nvcomp::host;
+
+static void print_usage()
+{
+  printf("Usage: benchmark_gzip_index [OPTIONS]\n");
+  printf("  %-35s Gzip, zlib or raw deflate input file (required).\n", "-f, --input_file");
+  printf("  %-35s Uncompressed bytes between checkpoints (default 1048576).\n", "-s, --span");
+  printf("  %-35s Worker threads (default one per CPU).\n", "-n, --threads");
+  printf("  %-35s Number of random reads (default 1000).\n", "-r, --reads");
+  printf("  %-35s Bytes per random read (default 4096).\n", "-b, --read_size");
+  printf("  %-35s Write the index to this file.\n", "-o, --index_file");
+  printf("  %-35s Number of measurement iterations (default 3).\n", "-i, --iteration_count");
+}
+
+static const char* format_name(const GzipIndexFormat format)
+{
+  switch (format) {
+  case GzipIndexFormat::Gzip:
+    return "gzip";
+  case GzipIndexFormat::Zlib:
+    return "zlib";
+  default:
+    return "raw deflate";
+  }
+}
+
+// Best time of `iterations` parallel decompressions on `pool`.
+static double time_decompress(
+    ThreadPool& pool,
+    const std::vector<char>& data,
+    const GzipIndex& index,
+    std::vector<char>& out,
+    const int iterations)
+{
+  typedef std::chrono::steady_clock clock;
+  double seconds = std::numeric_limits<double>::max();
+  for (int it = 0; it < iterations; ++it) {
+    const clock::time_point start = clock::now();
+    const nvcompStatus_t status = gzip_index_decompress(
+        pool, data.data(), data.size(), index, out.data(), out.size());
+    seconds = std::min(
+        seconds, std::chrono::duration<double>(clock::now() - start).count());
+    if (status != nvcompSuccess) {
+      throw std::runtime_error("Indexed decompression failed.");
+    }
+  }
+  return seconds;
+}
+
+int main(int argc, char* argv[])
+{
+  char* fname = nullptr;
+  char* index_file = nullptr;
+  size_t span = GZIP_INDEX_DEFAULT_SPAN;
+  size_t num_threads = 0;
+  size_t num_reads = 1000;
+  size_t read_size = 4096;
+  int iterations = 3;
+
+  char** argv_end = argv + argc;
+  argv += 1;
+  while (argv != argv_end) {
+    char* arg = *argv++;
+    if (strcmp(arg, "--help") == 0 || strcmp(arg, "-?") == 0) {
+      print_usage();
+      return 1;
+    }
+
+    // all arguments below require at least a second value in argv
+    if (argv >= argv_end) {
+      print_usage();
+      return 1;
+    }
+
+    char* optarg = *argv++;
+    if (strcmp(arg, "--input_file") == 0 || strcmp(arg, "-f") == 0) {
+      fname = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--span") == 0 || strcmp(arg, "-s") == 0) {
+      span = strtoull(optarg, nullptr, 10);
+      continue;
+    }
+    if (strcmp(arg, "--threads") == 0 || strcmp(arg, "-n") == 0) {
+      num_threads = strtoull(optarg, nullptr, 10);
+      continue;
+    }
+    if (strcmp(arg, "--reads") == 0 || strcmp(arg, "-r") == 0) {
+      num_reads = strtoull(optarg, nullptr, 10);
+      continue;
+    }
+    if (strcmp(arg, "--read_size") == 0 || strcmp(arg, "-b") == 0) {
+      read_size = strtoull(optarg, nullptr, 10);
+      continue;
+    }
+    if (strcmp(arg, "--index_file") == 0 || strcmp(arg, "-o") == 0) {
+      index_file = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--iteration_count") == 0 || strcmp(arg, "-i") == 0) {
+      iterations = atoi(optarg);
+      continue;
+    }
+    print_usage();
+    return 1;
+  }
+
+  if (fname == nullptr || iterations <= 0 || span == 0) {
+    print_usage();
+    return 1;
+  }
+
+  typedef std::chrono::steady_clock clock;
+  const std::vector<char> data = readFile(fname);
+  ThreadPool pool(num_threads);
+  ThreadPool serial_pool(1);
+
+  const clock::time_point start = clock::now();
+  const GzipIndex index = build_gzip_index(data.data(), data.size(), span);
+  const double build_seconds
+      = std::chrono::duration<double>(clock::now() - start).count();
+  if (index_file != nullptr) {
+    write_gzip_index(index_file, index);
+  }
+  size_t index_bytes = sizeof(detail::GzipIndexHeader);
+  for (const GzipCheckpoint& point : index.checkpoints) {
+    index_bytes += sizeof(detail::GzipCheckpointHeader) + point.window.size();
+  }
+
+  std::vector<char> decompressed(index.uncompressed_bytes);
+  const double serial_seconds
+      = time_decompress(serial_pool, data, index, decompressed, iterations);
+  const std::vector<char> reference = decompressed;
+  const double parallel_seconds
+      = time_decompress(pool, data, index, decompressed, iterations);
+  if (decompressed != reference) {
+    std::cerr << "Parallel decompression gave wrong data." << std::endl;
+    return 1;
+  }
+
+  // Random reads, checked against the whole file.
+  std::mt19937_64 rng(42);
+  std::vector<char> buffer(read_size);
+  double read_seconds = 0;
+  const size_t size = std::min<size_t>(read_size, index.uncompressed_bytes);
+  for (size_t r = 0; r < num_reads; ++r) {
+    const uint64_t offset = rng() % (index.uncompressed_bytes - size + 1);
+    const clock::time_point read_start = clock::now();
+    const nvcompStatus_t status = gzip_index_read(
+        data.data(), data.size(), index, offset, buffer.data(), size);
+    read_seconds
+        += std::chrono::duration<double>(clock::now() - read_start).count();
+    if (status != nvcompSuccess
+        || !std::equal(
+            buffer.begin(),
+            buffer.begin() + size,
+            reference.begin() + offset)) {
+      std::cerr << "Random read gave wrong data." << std::endl;
+      return 1;
+    }
+  }
+
+  const double bytes = static_cast<double>(index.uncompressed_bytes);
+  std::cout << "----------" << std::endl;
+  std::cout << "file: " << fname << std::endl;
+  std::cout << "format: " << format_name(index.format) << std::endl;
+  std::cout << "compressed (B): " << data.size() << std::endl;
+  std::cout << "uncompressed (B): " << index.uncompressed_bytes << std::endl;
+  std::cout << "checkpoints: " << index.checkpoints.size() << std::endl;
+  std::cout << "index (B): " << index_bytes << std::endl;
+  std::cout << "index build throughput (MB/s): " << bytes / build_seconds * 1e-6
+            << std::endl;
+  std::cout << "decompression throughput, 1 thread (MB/s): "
+            << bytes / serial_seconds * 1e-6 << std::endl;
+  std::cout << "decompression throughput, " << pool.num_threads()
+            << " threads (MB/s): " << bytes / parallel_seconds * 1e-6
+            << std::endl;
+  if (num_reads > 0) {
+    std::cout << "random read of " << size
+              << " B, average (us): " << read_seconds / num_reads * 1e6
+              << std::endl;
+  }
+  return 0;
+}
+
+#else
+
+int main()
+{
+  std::cerr << "benchmark_gzip_index was built without zlib." << std::endl;
+  return 1;
+}
+
+#endif
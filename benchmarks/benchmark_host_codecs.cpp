@@ -0,0 +1,772 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Measure the single-threaded host codecs per chunk size, with hardware
+// counters around each compression and decompression loop, to show how
+// efficiently each codec uses the core rather than only how fast it is.
+
+#include "benchmark_common.h"
+#include "host/file_io.h"
+#include "host/host_allocator.h"
+#include "host/host_codecs.h"
+#include "host/numa.h"
+#include "host/perf_counters.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace nvcomp::host;
+
+static void print_usage()
+{
+  printf("Usage: benchmark_host_codecs [OPTIONS]\n");
+  printf("  %-35s Binary dataset filename(s) (required).\n", "-f, --input_file");
+  printf("  %-35s Chunk sizes to split the input into (default 16384,65536,262144).\n", "-p, --chunk_sizes");
+  printf("  %-35s Codec(s): lz4, deflate, cascaded, ans, float, double, rle, dict, pfor, stored or all (default all).\n", "-c, --codecs");
+  printf("  %-35s Element type of the integer codecs: byte, short, int or long (default each codec's own).\n", "-y, --type");
+  printf("  %-35s *If Cascaded* Number of RLEs (default 2).\n", "-r, --rles");
+  printf("  %-35s *If Cascaded* Number of Deltas (default 1).\n", "-d, --deltas");
+  printf("  %-35s *If Cascaded* Bitpacking enabled (default 1).\n", "-b, --bitpack");
+  printf("  %-35s Number of measurement iterations (default 3).\n", "-i, --iteration_count");
+  printf("  %-35s Also compare output buffers with and without huge pages.\n", "-g, --huge_pages");
+  printf("  %-35s Also run on all NUMA nodes with chunk placement none, local or interleave.\n", "-n, --numa");
+  printf("  %-35s Worker threads per NUMA node (default one per CPU).\n", "-t, --threads_per_node");
+  printf("  %-35s Output in CSV format.\n", "-x, --csv");
+}
+
+// Size of the elements of the --type option, or 0 if unknown.
+static size_t type_size(const std::string& type)
+{
+  if (type == "byte" || type == "int8" || type == "char") {
+    return 1;
+  }
+  if (type == "short") {
+    return 2;
+  }
+  if (type == "int") {
+    return 4;
+  }
+  if (type == "long") {
+    return 8;
+  }
+  return 0;
+}
+
+// A codec by name, with the element size of --type, if given, applied to
+// the integer codecs, and the Cascaded options to Cascaded.
+static std::shared_ptr<const HostCodec> make_codec(
+    const std::string& name,
+    const size_t elt_size,
+    const HostCascadedOptions& cascaded_opts)
+{
+  if (name == "cascaded") {
+    return std::make_shared<CascadedCodec>(cascaded_opts);
+  }
+  if (elt_size == 0) {
+    return make_host_codec(name);
+  }
+  if (name == "rle") {
+    return std::make_shared<RleCodec>(HostRleOptions{elt_size});
+  }
+  if (name == "dict") {
+    HostDictionaryOptions options = HostDictionaryDefaultOpts;
+    options.type_size = elt_size;
+    return std::make_shared<DictionaryCodec>(options);
+  }
+  if (name == "pfor") {
+    HostPforOptions options = HostPforDefaultOpts;
+    options.type_size = elt_size;
+    return std::make_shared<PforCodec>(options);
+  }
+  return make_host_codec(name);
+}
+
+static std::vector<std::string> split_list(const std::string& text)
+{
+  std::vector<std::string> items;
+  std::istringstream list(text);
+  std::string item;
+  while (std::getline(list, item, ',')) {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+// The fastest of several runs of one phase, with its counters.
+struct PhaseResult
+{
+  double seconds;
+  PerfSample counters;
+
+  PhaseResult() : seconds(std::numeric_limits<double>::max()), counters()
+  {
+  }
+
+  void update(const double run_seconds, const PerfSample& run_counters)
+  {
+    if (run_seconds < seconds) {
+      seconds = run_seconds;
+      counters = run_counters;
+    }
+  }
+};
+
+// A way of allocating the compression output of a batch: one slot of the
+// maximum compressed size per chunk, as in BatchDataCPU.
+struct OutputAllocation
+{
+  const char* name;
+  HugePages huge_pages;
+  bool zero;
+};
+
+static const OutputAllocation OUTPUT_ALLOCATIONS[]
+    = {{"zeroed", HugePages::None, true},
+       {"uninitialized", HugePages::None, false},
+       {"transparent", HugePages::Transparent, false},
+       {"explicit", HugePages::Explicit, false}};
+
+// Allocate the output and compress every chunk into it, averaged over
+// `iterations` runs, and print the time and the page faults taken. Heap
+// memory freed by one run may be reused by the next, so the heap-backed
+// allocations can show fewer faults than a fresh process would.
+static void measure_output_allocation(
+    std::ostream& out,
+    const bool csv,
+    const HostCodec& codec,
+    const size_t chunk_size,
+    const std::vector<std::vector<uint8_t>>& chunks,
+    const size_t total_bytes,
+    const OutputAllocation& alloc,
+    const int iterations)
+{
+  typedef std::chrono::steady_clock clock;
+
+  const size_t slot_bytes = codec.max_compressed_size(chunk_size);
+  double seconds = 0;
+  uint64_t faults = 0;
+  HugePages backing = HugePages::None;
+  for (int it = 0; it < iterations; ++it) {
+    const uint64_t start_faults = page_fault_count();
+    const clock::time_point start = clock::now();
+    HostBuffer output(slot_bytes * chunks.size(), alloc.huge_pages, alloc.zero);
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      codec.compress(
+          chunks[i].data(),
+          chunks[i].size(),
+          output.data() + i * slot_bytes,
+          slot_bytes);
+    }
+    seconds += std::chrono::duration<double>(clock::now() - start).count();
+    faults += page_fault_count() - start_faults;
+    backing = output.huge_pages();
+  }
+  seconds /= iterations;
+  faults /= iterations;
+
+  const char sep = ',';
+  if (csv) {
+    out << codec.name() << sep << chunk_size << sep << alloc.name << sep
+        << huge_pages_name(backing) << sep << faults << sep
+        << total_bytes / seconds * 1e-9 << std::endl;
+  } else {
+    out << std::fixed << std::setprecision(3) << std::setw(9) << codec.name()
+        << std::setw(8) << chunk_size << std::setw(15) << alloc.name
+        << std::setw(13) << huge_pages_name(backing) << std::setw(12)
+        << faults << std::setw(8) << total_bytes / seconds * 1e-9
+        << std::endl;
+  }
+}
+
+// The fastest parallel run of one phase over all NUMA nodes, with the time
+// each node took to finish its chunks.
+struct NumaPhaseResult
+{
+  double seconds;
+  std::vector<double> node_seconds;
+
+  NumaPhaseResult() :
+      seconds(std::numeric_limits<double>::max()), node_seconds()
+  {
+  }
+};
+
+// Run `fn(i)` for every chunk on the node that holds it, and keep the run if
+// it is the fastest so far.
+template <typename F>
+static void run_numa_phase(
+    NumaThreadPool& pool,
+    const NumaChunkBuffer& batch,
+    NumaPhaseResult& result,
+    F fn)
+{
+  typedef std::chrono::steady_clock clock;
+
+  std::vector<std::atomic<int64_t>> node_end_ns(pool.num_nodes());
+  for (std::atomic<int64_t>& end : node_end_ns) {
+    end = 0;
+  }
+  const clock::time_point start = clock::now();
+  pool.parallel_for(
+      batch.size(),
+      [&batch](const size_t i) { return batch.node_of(i); },
+      [&](const size_t i) {
+        fn(i);
+        const int64_t end_ns
+            = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  clock::now() - start)
+                  .count();
+        std::atomic<int64_t>& node_end = node_end_ns[batch.node_of(i)];
+        int64_t seen = node_end;
+        while (seen < end_ns
+               && !node_end.compare_exchange_weak(seen, end_ns)) {
+        }
+      });
+  const double seconds
+      = std::chrono::duration<double>(clock::now() - start).count();
+  if (seconds < result.seconds) {
+    result.seconds = seconds;
+    result.node_seconds.clear();
+    for (const std::atomic<int64_t>& end : node_end_ns) {
+      result.node_seconds.push_back(end * 1e-9);
+    }
+  }
+}
+
+static void print_numa_phase(
+    std::ostream& out,
+    const bool csv,
+    const char* const codec,
+    const size_t chunk_size,
+    const char* const phase,
+    const NumaChunkBuffer& batch,
+    const size_t total_bytes,
+    const NumaPhaseResult& result)
+{
+  const char sep = ',';
+  for (size_t node = 0; node <= result.node_seconds.size(); ++node) {
+    const bool all = node == result.node_seconds.size();
+    const size_t bytes = all ? total_bytes : batch.node_bytes(node);
+    const double seconds = all ? result.seconds : result.node_seconds[node];
+    if (bytes == 0) {
+      continue;
+    }
+    const std::string name = all ? "all" : std::to_string(node);
+    if (csv) {
+      out << codec << sep << chunk_size << sep << phase << sep << name << sep
+          << bytes << sep << bytes / seconds * 1e-9 << std::endl;
+    } else {
+      out << std::fixed << std::setprecision(3) << std::setw(9) << codec
+          << std::setw(8) << chunk_size << std::setw(12) << phase
+          << std::setw(6) << name << std::setw(14) << bytes << std::setw(8)
+          << bytes / seconds * 1e-9 << std::endl;
+    }
+  }
+}
+
+static void print_header(const bool csv)
+{
+  const char sep = ',';
+  if (csv) {
+    std::cout << "codec" << sep << "chunk size (B)" << sep << "phase" << sep
+              << "ratio" << sep << "throughput (GB/s)";
+    nvcomp::print_perf_csv_header(std::string(1, sep), "");
+    std::cout << std::endl;
+  } else {
+    std::cout << std::setw(9) << "codec" << std::setw(8) << "chunk"
+              << std::setw(12) << "phase" << std::setw(8) << "ratio"
+              << std::setw(8) << "GB/s" << std::setw(7) << "IPC"
+              << std::setw(9) << "B/cycle" << std::setw(10) << "LLC/kB"
+              << std::setw(12) << "brmiss/kB" << std::endl;
+  }
+}
+
+static void print_phase(
+    const bool csv,
+    const char* const codec,
+    const size_t chunk_size,
+    const char* const phase,
+    const double ratio,
+    const size_t bytes,
+    const PhaseResult& result)
+{
+  const char sep = ',';
+  const PerfSample& c = result.counters;
+  const bool has_ipc = c.has(PerfCounterId::Cycles)
+                       && c.has(PerfCounterId::Instructions);
+  const bool has_cycles = c.has(PerfCounterId::Cycles);
+  const bool has_llc = c.has(PerfCounterId::LLCMisses);
+  const bool has_branch = c.has(PerfCounterId::BranchMisses);
+  const double gbs = bytes / result.seconds * 1e-9;
+
+  // Unavailable counters are left empty in CSV and shown as "-" otherwise.
+  if (csv) {
+    std::cout << codec << sep << chunk_size << sep << phase << sep << ratio
+              << sep << gbs;
+    nvcomp::print_perf_csv_values(std::string(1, sep), c, bytes);
+    std::cout << std::endl;
+    return;
+  }
+
+  std::cout << std::fixed << std::setprecision(3) << std::setw(9) << codec
+            << std::setw(8) << chunk_size << std::setw(12) << phase
+            << std::setw(8) << ratio << std::setw(8) << gbs
+            << std::setprecision(2) << std::setw(7);
+  if (has_ipc) {
+    std::cout << c.ipc();
+  } else {
+    std::cout << "-";
+  }
+  std::cout << std::setprecision(3) << std::setw(9);
+  if (has_cycles) {
+    std::cout << c.bytes_per_cycle(bytes);
+  } else {
+    std::cout << "-";
+  }
+  std::cout << std::setprecision(2) << std::setw(10);
+  if (has_llc) {
+    std::cout << c.per_kb(PerfCounterId::LLCMisses, bytes);
+  } else {
+    std::cout << "-";
+  }
+  std::cout << std::setw(12);
+  if (has_branch) {
+    std::cout << c.per_kb(PerfCounterId::BranchMisses, bytes);
+  } else {
+    std::cout << "-";
+  }
+  std::cout << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  typedef std::chrono::steady_clock clock;
+
+  std::vector<std::string> filenames;
+  std::string chunk_size_list = "16384,65536,262144";
+  std::string codec_list = "all";
+  std::string dtype;
+  HostCascadedOptions cascaded_opts = HostCascadedDefaultOpts;
+  int iterations = 3;
+  bool csv = false;
+  std::string numa_name;
+  size_t threads_per_node = 0;
+  bool compare_huge_pages = false;
+
+  char** argv_end = argv + argc;
+  argv += 1;
+  while (argv != argv_end) {
+    char* arg = *argv++;
+    if (strcmp(arg, "--help") == 0 || strcmp(arg, "-?") == 0) {
+      print_usage();
+      return 1;
+    }
+    if (strcmp(arg, "--csv") == 0 || strcmp(arg, "-x") == 0) {
+      csv = true;
+      continue;
+    }
+    if (strcmp(arg, "--huge_pages") == 0 || strcmp(arg, "-g") == 0) {
+      compare_huge_pages = true;
+      continue;
+    }
+
+    // all arguments below require at least a second value in argv
+    if (argv >= argv_end) {
+      print_usage();
+      return 1;
+    }
+
+    if (strcmp(arg, "--input_file") == 0 || strcmp(arg, "-f") == 0) {
+      // read all following arguments until a new flag is found
+      while (argv != argv_end && (*argv)[0] != '-') {
+        filenames.emplace_back(*argv++);
+      }
+      continue;
+    }
+
+    char* optarg = *argv++;
+    if (strcmp(arg, "--chunk_sizes") == 0 || strcmp(arg, "-p") == 0) {
+      chunk_size_list = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--codecs") == 0 || strcmp(arg, "-c") == 0) {
+      codec_list = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--type") == 0 || strcmp(arg, "-y") == 0) {
+      dtype = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--rles") == 0 || strcmp(arg, "-r") == 0) {
+      cascaded_opts.num_RLEs = atoi(optarg);
+      continue;
+    }
+    if (strcmp(arg, "--deltas") == 0 || strcmp(arg, "-d") == 0) {
+      cascaded_opts.num_deltas = atoi(optarg);
+      continue;
+    }
+    if (strcmp(arg, "--bitpack") == 0 || strcmp(arg, "-b") == 0) {
+      cascaded_opts.use_bp = atoi(optarg) != 0;
+      continue;
+    }
+    if (strcmp(arg, "--iteration_count") == 0 || strcmp(arg, "-i") == 0) {
+      iterations = atoi(optarg);
+      continue;
+    }
+    if (strcmp(arg, "--numa") == 0 || strcmp(arg, "-n") == 0) {
+      numa_name = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--threads_per_node") == 0 || strcmp(arg, "-t") == 0) {
+      threads_per_node = strtoull(optarg, nullptr, 10);
+      continue;
+    }
+    print_usage();
+    return 1;
+  }
+
+  if (filenames.empty() || iterations <= 0) {
+    print_usage();
+    return 1;
+  }
+
+  const size_t elt_size = dtype.empty() ? 0 : type_size(dtype);
+  if (!dtype.empty() && elt_size == 0) {
+    std::cerr << "Invalid datatype selected." << std::endl;
+    print_usage();
+    return 1;
+  }
+  if (elt_size != 0) {
+    cascaded_opts.type_size = elt_size;
+  }
+
+  std::vector<size_t> chunk_sizes;
+  for (const std::string& item : split_list(chunk_size_list)) {
+    const size_t chunk_size = strtoull(item.c_str(), nullptr, 10);
+    if (chunk_size == 0) {
+      std::cerr << "Chunk sizes must be positive." << std::endl;
+      return 1;
+    }
+    chunk_sizes.push_back(chunk_size);
+  }
+
+  std::vector<std::shared_ptr<const HostCodec>> codecs;
+  if (codec_list == "all") {
+    for (const HostCodecId id :
+         {HostCodecId::LZ4,
+          HostCodecId::Deflate,
+          HostCodecId::Cascaded,
+          HostCodecId::ANS,
+          HostCodecId::Float,
+          HostCodecId::RLE,
+          HostCodecId::Dictionary,
+          HostCodecId::PFOR}) {
+      if (host_codec_available(id)) {
+        codecs.push_back(
+            make_codec(make_host_codec(id)->name(), elt_size, cascaded_opts));
+      }
+    }
+  } else {
+    for (const std::string& item : split_list(codec_list)) {
+      codecs.push_back(make_codec(item, elt_size, cascaded_opts));
+    }
+  }
+  if (codecs.empty()) {
+    std::cerr << "No host codecs are available in this build." << std::endl;
+    return 1;
+  }
+
+  NumaPolicy numa_policy = NumaPolicy::None;
+  if (!numa_name.empty()) {
+    try {
+      numa_policy = numa_policy_from_name(numa_name);
+    } catch (const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+  }
+  // The 'none' policy keeps the same per-node pools, but unpinned.
+  std::unique_ptr<NumaThreadPool> numa_pool;
+  if (!numa_name.empty()) {
+    numa_pool.reset(new NumaThreadPool(
+        detect_numa_topology(),
+        threads_per_node,
+        numa_policy != NumaPolicy::None));
+  }
+  std::ostringstream numa_rows;
+  std::ostringstream allocation_rows;
+
+  PerfCounters perf;
+
+  std::cout << "----------" << std::endl;
+  std::cout << "files: " << filenames.size() << std::endl;
+  if (!perf.error().empty()) {
+    std::cout << "hardware counters: "
+              << (perf.available() ? "partial" : "unavailable") << " ("
+              << perf.error() << ")" << std::endl;
+  }
+  print_header(csv);
+
+  for (const size_t chunk_size : chunk_sizes) {
+    const std::vector<std::vector<char>> data
+        = multi_file(filenames, chunk_size, false, 0);
+    std::vector<std::vector<uint8_t>> chunks;
+    size_t total_bytes = 0;
+    for (const std::vector<char>& chunk : data) {
+      chunks.emplace_back(chunk.begin(), chunk.end());
+      total_bytes += chunk.size();
+    }
+    std::unique_ptr<NumaChunkBuffer> numa_batch;
+    if (numa_pool) {
+      numa_batch.reset(new NumaChunkBuffer(*numa_pool, data, numa_policy));
+    }
+
+    for (const std::shared_ptr<const HostCodec>& codec : codecs) {
+      std::vector<std::vector<uint8_t>> compressed(chunks.size());
+      for (std::vector<uint8_t>& out : compressed) {
+        out.resize(codec->max_compressed_size(chunk_size));
+      }
+      std::vector<uint8_t> decompressed(chunk_size);
+      std::vector<size_t> sizes(chunks.size());
+
+      PhaseResult compress;
+      PhaseResult decompress;
+      for (int it = 0; it < iterations; ++it) {
+        clock::time_point start = clock::now();
+        perf.start();
+        for (size_t i = 0; i < chunks.size(); ++i) {
+          sizes[i] = codec->compress(
+              chunks[i].data(),
+              chunks[i].size(),
+              compressed[i].data(),
+              compressed[i].size());
+        }
+        PerfSample counters = perf.stop();
+        compress.update(
+            std::chrono::duration<double>(clock::now() - start).count(),
+            counters);
+
+        // Every chunk goes to the same buffer, so its content is checked
+        // right after it is decompressed, in the last iteration only.
+        const bool validate = it + 1 == iterations;
+        start = clock::now();
+        perf.start();
+        for (size_t i = 0; i < chunks.size(); ++i) {
+          size_t out_bytes = 0;
+          if (codec->decompress(
+                  compressed[i].data(),
+                  sizes[i],
+                  decompressed.data(),
+                  decompressed.size(),
+                  &out_bytes)
+                  != nvcompSuccess
+              || out_bytes != chunks[i].size()) {
+            std::cerr << "Failed to decompress a " << codec->name()
+                      << " chunk." << std::endl;
+            return 1;
+          }
+          if (validate
+              && std::memcmp(decompressed.data(), chunks[i].data(), out_bytes)
+                     != 0) {
+            std::cerr << "Decompressed " << codec->name()
+                      << " chunk doesn't match the input." << std::endl;
+            return 1;
+          }
+        }
+        counters = perf.stop();
+        decompress.update(
+            std::chrono::duration<double>(clock::now() - start).count(),
+            counters);
+      }
+
+      size_t compressed_bytes = 0;
+      for (const size_t size : sizes) {
+        compressed_bytes += size;
+      }
+      const double ratio
+          = compressed_bytes > 0
+                ? static_cast<double>(total_bytes) / compressed_bytes
+                : 1.0;
+
+      print_phase(
+          csv,
+          codec->name(),
+          chunk_size,
+          "compress",
+          ratio,
+          total_bytes,
+          compress);
+      print_phase(
+          csv,
+          codec->name(),
+          chunk_size,
+          "decompress",
+          ratio,
+          total_bytes,
+          decompress);
+
+      if (compare_huge_pages) {
+        for (const OutputAllocation& alloc : OUTPUT_ALLOCATIONS) {
+          measure_output_allocation(
+              allocation_rows,
+              csv,
+              *codec,
+              chunk_size,
+              chunks,
+              total_bytes,
+              alloc,
+              iterations);
+        }
+      }
+
+      if (!numa_batch) {
+        continue;
+      }
+      // Output buffers are allocated by the workers, so that they are also
+      // first touched on the node of their chunk.
+      const NumaChunkBuffer& batch = *numa_batch;
+      std::vector<std::vector<uint8_t>> numa_compressed(batch.size());
+      std::vector<std::vector<uint8_t>> numa_decompressed(batch.size());
+      std::vector<size_t> numa_sizes(batch.size());
+      NumaPhaseResult numa_compress;
+      NumaPhaseResult numa_decompress;
+      for (int it = 0; it < iterations; ++it) {
+        run_numa_phase(*numa_pool, batch, numa_compress, [&](const size_t i) {
+          std::vector<uint8_t>& out = numa_compressed[i];
+          out.resize(codec->max_compressed_size(batch.chunk_bytes(i)));
+          numa_sizes[i] = codec->compress(
+              batch.data(i), batch.chunk_bytes(i), out.data(), out.size());
+        });
+        run_numa_phase(
+            *numa_pool, batch, numa_decompress, [&](const size_t i) {
+              std::vector<uint8_t>& out = numa_decompressed[i];
+              out.resize(batch.chunk_bytes(i));
+              size_t out_bytes = 0;
+              if (codec->decompress(
+                      numa_compressed[i].data(),
+                      numa_sizes[i],
+                      out.data(),
+                      out.size(),
+                      &out_bytes)
+                      != nvcompSuccess
+                  || out_bytes != out.size()) {
+                throw std::runtime_error(
+                    std::string("Failed to decompress a ") + codec->name()
+                    + " chunk.");
+              }
+            });
+      }
+      // Every chunk has its own output, so the last iteration's is checked
+      // after the timing.
+      for (size_t i = 0; i < batch.size(); ++i) {
+        if (std::memcmp(
+                numa_decompressed[i].data(),
+                batch.data(i),
+                batch.chunk_bytes(i))
+            != 0) {
+          throw std::runtime_error(
+              std::string("Decompressed ") + codec->name()
+              + " chunk doesn't match the input.");
+        }
+      }
+
+      print_numa_phase(
+          numa_rows,
+          csv,
+          codec->name(),
+          chunk_size,
+          "compress",
+          batch,
+          total_bytes,
+          numa_compress);
+      print_numa_phase(
+          numa_rows,
+          csv,
+          codec->name(),
+          chunk_size,
+          "decompress",
+          batch,
+          total_bytes,
+          numa_decompress);
+    }
+  }
+
+  if (compare_huge_pages) {
+    std::cout << std::endl;
+    if (csv) {
+      std::cout << "codec,chunk size (B),output,backing,page faults,"
+                   "compression throughput (GB/s)"
+                << std::endl;
+    } else {
+      std::cout << std::setw(9) << "codec" << std::setw(8) << "chunk"
+                << std::setw(15) << "output" << std::setw(13) << "backing"
+                << std::setw(12) << "faults" << std::setw(8) << "GB/s"
+                << std::endl;
+    }
+    std::cout << allocation_rows.str();
+  }
+
+  if (numa_pool) {
+    const NumaTopology& topology = numa_pool->topology();
+    std::cout << std::endl;
+    std::cout << "numa policy: " << numa_policy_name(numa_policy) << std::endl;
+    for (size_t node = 0; node < topology.num_nodes(); ++node) {
+      std::cout << "node " << node << ": id " << topology.node_ids[node]
+                << ", " << numa_pool->node_pool(node).num_threads()
+                << " threads" << std::endl;
+    }
+    if (numa_policy != NumaPolicy::None && !numa_pool->pinned()) {
+      std::cout << "WARNING: Unable to pin the workers to their nodes."
+                << std::endl;
+    }
+    if (csv) {
+      std::cout << "codec,chunk size (B),phase,node,bytes,throughput (GB/s)"
+                << std::endl;
+    } else {
+      std::cout << std::setw(9) << "codec" << std::setw(8) << "chunk"
+                << std::setw(12) << "phase" << std::setw(6) << "node"
+                << std::setw(14) << "bytes" << std::setw(8) << "GB/s"
+                << std::endl;
+    }
+    std::cout << numa_rows.str();
+  }
+
+  return 0;
+}
@@ -0,0 +1,872 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "benchmark_template_chunked.cuh"
+#include "host/mixed_batch.h"
+#include "host/store_raw.h"
+#include "nvcomp/ans.h"
+#include "nvcomp/bitcomp.h"
+#include "nvcomp/cascaded.h"
+#include "nvcomp/deflate.h"
+#include "nvcomp/gdeflate.h"
+#include "nvcomp/lz4.h"
+#include "nvcomp/snappy.h"
+#include "nvcomp/zstd.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static const std::vector<std::string> mixedKnownFormats{
+    "lz4", "snappy", "cascaded", "bitcomp", "ans", "deflate", "gdeflate", "zstd"};
+
+static std::vector<std::string> mixedAllowedFormats = mixedKnownFormats;
+static double mixedMinRatio = 1.05;
+
+static bool handleCommandLineArgument(
+    const std::string& arg,
+    const char* const* additionalArgs,
+    size_t& additionalArgsUsed)
+{
+  if (arg == "--codecs" || arg == "-a") {
+    std::istringstream list(*additionalArgs);
+    additionalArgsUsed = 1;
+    mixedAllowedFormats.clear();
+    std::string format;
+    while (std::getline(list, format, ',')) {
+      if (std::find(mixedKnownFormats.begin(), mixedKnownFormats.end(), format)
+          == mixedKnownFormats.end()) {
+        std::cerr << "ERROR: Unknown codec \"" << format << "\"" << std::endl;
+        return false;
+      }
+      mixedAllowedFormats.push_back(format);
+    }
+    if (mixedAllowedFormats.empty()) {
+      std::cerr << "ERROR: At least one codec must be allowed" << std::endl;
+      return false;
+    }
+    return true;
+  }
+  if (arg == "--min_ratio" || arg == "-m") {
+    mixedMinRatio = atof(*additionalArgs);
+    additionalArgsUsed = 1;
+    if (mixedMinRatio < 1.0) {
+      std::cerr << "ERROR: min_ratio must be at least 1, but it is "
+                << mixedMinRatio << std::endl;
+      return false;
+    }
+    return true;
+  }
+  return false;
+}
+
+namespace
+{
+
+// The batched low level API of one format, with its format options bound.
+struct BatchedCodec
+{
+  std::function<nvcompStatus_t(size_t, size_t, size_t*)> compress_temp_size;
+  std::function<nvcompStatus_t(size_t, size_t*)> max_output_chunk_size;
+  std::function<nvcompStatus_t(
+      const void* const*,
+      const size_t*,
+      size_t,
+      size_t,
+      void*,
+      size_t,
+      void* const*,
+      size_t*,
+      cudaStream_t)>
+      compress;
+  std::function<nvcompStatus_t(size_t, size_t, size_t*)> decompress_temp_size;
+  std::function<nvcompStatus_t(
+      const void* const*,
+      const size_t*,
+      const size_t*,
+      size_t*,
+      size_t,
+      void*,
+      size_t,
+      void* const*,
+      nvcompStatus_t*,
+      cudaStream_t)>
+      decompress;
+};
+
+template <
+    typename CompGetTempT,
+    typename CompGetSizeT,
+    typename CompAsyncT,
+    typename DecompGetTempT,
+    typename DecompAsyncT,
+    typename FormatOptsT>
+BatchedCodec make_batched_codec(
+    CompGetTempT BatchedCompressGetTempSize,
+    CompGetSizeT BatchedCompressGetMaxOutputChunkSize,
+    CompAsyncT BatchedCompressAsync,
+    DecompGetTempT BatchedDecompressGetTempSize,
+    DecompAsyncT BatchedDecompressAsync,
+    const FormatOptsT format_opts)
+{
+  BatchedCodec codec;
+  codec.compress_temp_size
+      = [=](size_t batch_size, size_t max_chunk_size, size_t* temp_bytes) {
+          return BatchedCompressGetTempSize(
+              batch_size, max_chunk_size, format_opts, temp_bytes);
+        };
+  codec.max_output_chunk_size
+      = [=](size_t max_chunk_size, size_t* max_out_bytes) {
+          return BatchedCompressGetMaxOutputChunkSize(
+              max_chunk_size, format_opts, max_out_bytes);
+        };
+  codec.compress = [=](
+                       const void* const* uncompressed_ptrs,
+                       const size_t* uncompressed_sizes,
+                       size_t max_chunk_size,
+                       size_t batch_size,
+                       void* temp,
+                       size_t temp_bytes,
+                       void* const* compressed_ptrs,
+                       size_t* compressed_sizes,
+                       cudaStream_t stream) {
+    return BatchedCompressAsync(
+        uncompressed_ptrs,
+        uncompressed_sizes,
+        max_chunk_size,
+        batch_size,
+        temp,
+        temp_bytes,
+        compressed_ptrs,
+        compressed_sizes,
+        format_opts,
+        stream);
+  };
+  codec.decompress_temp_size = BatchedDecompressGetTempSize;
+  codec.decompress = BatchedDecompressAsync;
+  return codec;
+}
+
+BatchedCodec make_codec(const std::string& key)
+{
+  const host::CodecKey codec = host::parse_codec_key(key);
+  bool valid;
+  const nvcompType_t type = string_to_data_type(codec.data_type.c_str(), valid);
+  benchmark_assert(valid, "Invalid data type in codec " + key);
+
+  if (codec.format == "lz4") {
+    const nvcompBatchedLZ4Opts_t opts{NVCOMP_TYPE_CHAR};
+    return make_batched_codec(
+        nvcompBatchedLZ4CompressGetTempSize,
+        nvcompBatchedLZ4CompressGetMaxOutputChunkSize,
+        nvcompBatchedLZ4CompressAsync,
+        nvcompBatchedLZ4DecompressGetTempSize,
+        nvcompBatchedLZ4DecompressAsync,
+        opts);
+  }
+  if (codec.format == "snappy") {
+    return make_batched_codec(
+        nvcompBatchedSnappyCompressGetTempSize,
+        nvcompBatchedSnappyCompressGetMaxOutputChunkSize,
+        nvcompBatchedSnappyCompressAsync,
+        nvcompBatchedSnappyDecompressGetTempSize,
+        nvcompBatchedSnappyDecompressAsync,
+        nvcompBatchedSnappyDefaultOpts);
+  }
+  if (codec.format == "cascaded") {
+    const nvcompBatchedCascadedOpts_t opts
+        = {4096, type, codec.num_RLEs, codec.num_deltas, codec.use_bp};
+    return make_batched_codec(
+        nvcompBatchedCascadedCompressGetTempSize,
+        nvcompBatchedCascadedCompressGetMaxOutputChunkSize,
+        nvcompBatchedCascadedCompressAsync,
+        nvcompBatchedCascadedDecompressGetTempSize,
+        nvcompBatchedCascadedDecompressAsync,
+        opts);
+  }
+  if (codec.format == "bitcomp") {
+    const nvcompBatchedBitcompFormatOpts opts = {0, type};
+    return make_batched_codec(
+        nvcompBatchedBitcompCompressGetTempSize,
+        nvcompBatchedBitcompCompressGetMaxOutputChunkSize,
+        nvcompBatchedBitcompCompressAsync,
+        nvcompBatchedBitcompDecompressGetTempSize,
+        nvcompBatchedBitcompDecompressAsync,
+        opts);
+  }
+  if (codec.format == "ans") {
+    const nvcompBatchedANSOpts_t opts = {};
+    return make_batched_codec(
+        nvcompBatchedANSCompressGetTempSize,
+        nvcompBatchedANSCompressGetMaxOutputChunkSize,
+        nvcompBatchedANSCompressAsync,
+        nvcompBatchedANSDecompressGetTempSize,
+        nvcompBatchedANSDecompressAsync,
+        opts);
+  }
+  if (codec.format == "deflate") {
+    const nvcompBatchedDeflateOpts_t opts = {0};
+    return make_batched_codec(
+        nvcompBatchedDeflateCompressGetTempSize,
+        nvcompBatchedDeflateCompressGetMaxOutputChunkSize,
+        nvcompBatchedDeflateCompressAsync,
+        nvcompBatchedDeflateDecompressGetTempSize,
+        nvcompBatchedDeflateDecompressAsync,
+        opts);
+  }
+  if (codec.format == "gdeflate") {
+    const nvcompBatchedGdeflateOpts_t opts = {0};
+    return make_batched_codec(
+        nvcompBatchedGdeflateCompressGetTempSize,
+        nvcompBatchedGdeflateCompressGetMaxOutputChunkSize,
+        nvcompBatchedGdeflateCompressAsync,
+        nvcompBatchedGdeflateDecompressGetTempSize,
+        nvcompBatchedGdeflateDecompressAsync,
+        opts);
+  }
+  if (codec.format == "zstd") {
+    const nvcompBatchedZstdOpts_t opts{};
+    return make_batched_codec(
+        nvcompBatchedZstdCompressGetTempSize,
+        nvcompBatchedZstdCompressGetMaxOutputChunkSize,
+        nvcompBatchedZstdCompressAsync,
+        nvcompBatchedZstdDecompressGetTempSize,
+        nvcompBatchedZstdDecompressAsync,
+        opts);
+  }
+  throw std::runtime_error("Unknown codec '" + key + "'.");
+}
+
+// Device arrays for the chunks of one codec, which are compressed or
+// decompressed with a single batched call.
+struct SubBatch
+{
+  bool stored;
+  BatchedCodec codec;
+  size_t size;
+  nvcomp::thrust::device_vector<void*> uncompressed_ptrs;
+  nvcomp::thrust::device_vector<size_t> uncompressed_sizes;
+  nvcomp::thrust::device_vector<void*> compressed_ptrs;
+  nvcomp::thrust::device_vector<size_t> compressed_sizes;
+};
+
+std::vector<SubBatch> make_sub_batches(
+    const host::MixedBatchLayout& layout,
+    const std::vector<void*>& uncompressed_ptrs,
+    const std::vector<void*>& compressed_ptrs)
+{
+  std::vector<size_t> uncompressed_sizes(layout.num_chunks());
+  std::vector<size_t> compressed_sizes(layout.num_chunks());
+  for (size_t i = 0; i < layout.num_chunks(); ++i) {
+    uncompressed_sizes[i] = layout.uncompressed_size(i);
+    compressed_sizes[i] = layout.compressed_size(i);
+  }
+
+  const std::vector<std::vector<size_t>> groups = layout.chunks_by_codec();
+  std::vector<SubBatch> batches(groups.size());
+  for (size_t c = 0; c < groups.size(); ++c) {
+    SubBatch& batch = batches[c];
+    batch.stored = layout.codec_name(c) == host::MIXED_STORED_CODEC;
+    if (!batch.stored) {
+      batch.codec = make_codec(layout.codec_name(c));
+    }
+    batch.size = groups[c].size();
+    batch.uncompressed_ptrs = nvcomp::thrust::device_vector<void*>(
+        gather(uncompressed_ptrs, groups[c]));
+    batch.uncompressed_sizes = nvcomp::thrust::device_vector<size_t>(
+        gather(uncompressed_sizes, groups[c]));
+    batch.compressed_ptrs = nvcomp::thrust::device_vector<void*>(
+        gather(compressed_ptrs, groups[c]));
+    // Stored chunks keep their size, the others are filled in by the
+    // compressor.
+    batch.compressed_sizes = nvcomp::thrust::device_vector<size_t>(
+        gather(batch.stored ? uncompressed_sizes : compressed_sizes, groups[c]));
+  }
+  return batches;
+}
+
+struct MixedResult
+{
+  size_t container_bytes;
+  double comp_time;
+  double decomp_time;
+};
+
+/**
+ * @brief Compress each chunk with the codec the layout assigns to it, pack
+ * the payloads into a mixed batch container, and decompress the container
+ * using only its header.
+ *
+ * The compression time includes packing the payloads, so that single codec
+ * layouts, which go through the same path, are comparable.
+ */
+MixedResult run_mixed_batch(
+    host::MixedBatchLayout& layout,
+    BatchData& input_data,
+    const size_t max_chunk_size,
+    const bool verify,
+    cudaStream_t stream)
+{
+  const size_t batch_size = layout.num_chunks();
+  nvcompStatus_t status;
+
+  std::vector<void*> h_input_ptrs(batch_size);
+  CUDA_CHECK(cudaMemcpy(
+      h_input_ptrs.data(),
+      input_data.ptrs(),
+      sizeof(void*) * batch_size,
+      cudaMemcpyDeviceToHost));
+
+  // Each chunk gets a slot large enough for the worst case of any codec.
+  size_t slot_bytes = max_chunk_size;
+  for (size_t c = 0; c < layout.num_codecs(); ++c) {
+    if (layout.codec_name(c) == host::MIXED_STORED_CODEC) {
+      continue;
+    }
+    size_t max_out_bytes;
+    status = make_codec(layout.codec_name(c))
+                 .max_output_chunk_size(max_chunk_size, &max_out_bytes);
+    benchmark_assert(
+        status == nvcompSuccess, "BatchedGetMaxOutputChunkSize() failed.");
+    slot_bytes = std::max(slot_bytes, max_out_bytes);
+  }
+  slot_bytes = roundUpTo(slot_bytes, host::MIXED_BATCH_ALIGNMENT);
+
+  nvcomp::thrust::device_vector<uint8_t> slots(slot_bytes * batch_size);
+  std::vector<void*> h_slot_ptrs(batch_size);
+  for (size_t i = 0; i < batch_size; ++i) {
+    h_slot_ptrs[i] = slots.data().get() + slot_bytes * i;
+  }
+
+  std::vector<SubBatch> batches
+      = make_sub_batches(layout, h_input_ptrs, h_slot_ptrs);
+
+  size_t comp_temp_bytes = 0;
+  for (const SubBatch& batch : batches) {
+    if (batch.stored || batch.size == 0) {
+      continue;
+    }
+    size_t temp_bytes;
+    status = batch.codec.compress_temp_size(
+        batch.size, max_chunk_size, &temp_bytes);
+    benchmark_assert(
+        status == nvcompSuccess, "BatchedCompressGetTempSize() failed.");
+    comp_temp_bytes = std::max(comp_temp_bytes, temp_bytes);
+  }
+  nvcomp::thrust::device_vector<uint8_t> comp_temp(comp_temp_bytes);
+
+  cudaEvent_t start, end;
+  CUDA_CHECK(cudaEventCreate(&start));
+  CUDA_CHECK(cudaEventCreate(&end));
+  CUDA_CHECK(cudaEventRecord(start, stream));
+
+  for (SubBatch& batch : batches) {
+    if (batch.size == 0) {
+      continue;
+    }
+    if (batch.stored) {
+      copy_chunks_async(
+          batch.uncompressed_ptrs.data().get(),
+          batch.uncompressed_sizes.data().get(),
+          batch.compressed_ptrs.data().get(),
+          batch.size,
+          stream);
+      continue;
+    }
+    status = batch.codec.compress(
+        batch.uncompressed_ptrs.data().get(),
+        batch.uncompressed_sizes.data().get(),
+        max_chunk_size,
+        batch.size,
+        comp_temp.data().get(),
+        comp_temp_bytes,
+        batch.compressed_ptrs.data().get(),
+        batch.compressed_sizes.data().get(),
+        stream);
+    benchmark_assert(status == nvcompSuccess, "BatchedCompressAsync() failed.");
+  }
+
+  // Fill in the compressed sizes, then pack the payloads behind the header.
+  const std::vector<std::vector<size_t>> groups = layout.chunks_by_codec();
+  for (size_t c = 0; c < groups.size(); ++c) {
+    std::vector<size_t> sizes(groups[c].size());
+    CUDA_CHECK(cudaMemcpyAsync(
+        sizes.data(),
+        batches[c].compressed_sizes.data().get(),
+        sizeof(size_t) * sizes.size(),
+        cudaMemcpyDeviceToHost,
+        stream));
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+    for (size_t i = 0; i < sizes.size(); ++i) {
+      layout.set_compressed_size(groups[c][i], sizes[i]);
+    }
+  }
+
+  std::vector<uint8_t> header(layout.header_size());
+  layout.write_header(header.data());
+  const std::vector<size_t> offsets = layout.payload_offsets();
+
+  nvcomp::thrust::device_vector<uint8_t> container(layout.total_size());
+  std::vector<void*> h_payload_ptrs(batch_size);
+  std::vector<size_t> h_compressed_sizes(batch_size);
+  for (size_t i = 0; i < batch_size; ++i) {
+    h_payload_ptrs[i] = container.data().get() + offsets[i];
+    h_compressed_sizes[i] = layout.compressed_size(i);
+  }
+  const nvcomp::thrust::device_vector<void*> d_slot_ptrs(h_slot_ptrs);
+  const nvcomp::thrust::device_vector<void*> d_payload_ptrs(h_payload_ptrs);
+  const nvcomp::thrust::device_vector<size_t> d_compressed_sizes(
+      h_compressed_sizes);
+  CUDA_CHECK(cudaMemcpyAsync(
+      container.data().get(),
+      header.data(),
+      header.size(),
+      cudaMemcpyHostToDevice,
+      stream));
+  copy_chunks_async(
+      d_slot_ptrs.data().get(),
+      d_compressed_sizes.data().get(),
+      d_payload_ptrs.data().get(),
+      batch_size,
+      stream);
+
+  CUDA_CHECK(cudaEventRecord(end, stream));
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  float compress_ms;
+  CUDA_CHECK(cudaEventElapsedTime(&compress_ms, start, end));
+
+  // Decompression starts from the container alone: the header is read
+  // back, and every codec's chunks become one sub-batch.
+  std::vector<uint8_t> h_header(header.size());
+  CUDA_CHECK(cudaMemcpy(
+      h_header.data(),
+      container.data().get(),
+      h_header.size(),
+      cudaMemcpyDeviceToHost));
+  const host::MixedBatchLayout parsed
+      = host::MixedBatchLayout::read_header(h_header.data(), h_header.size());
+  const std::vector<size_t> parsed_offsets = parsed.payload_offsets();
+
+  std::vector<size_t> output_offsets(batch_size + 1, 0);
+  for (size_t i = 0; i < batch_size; ++i) {
+    output_offsets[i + 1] = roundUpTo(
+        output_offsets[i] + parsed.uncompressed_size(i),
+        host::MIXED_BATCH_ALIGNMENT);
+  }
+  nvcomp::thrust::device_vector<uint8_t> output(output_offsets.back());
+  std::vector<void*> h_output_ptrs(batch_size);
+  std::vector<void*> h_parsed_payload_ptrs(batch_size);
+  for (size_t i = 0; i < batch_size; ++i) {
+    h_output_ptrs[i] = output.data().get() + output_offsets[i];
+    h_parsed_payload_ptrs[i] = container.data().get() + parsed_offsets[i];
+  }
+
+  // For decompression, the compressed side of each sub-batch is the
+  // container payload and the uncompressed side the output buffer.
+  std::vector<SubBatch> decomp_batches
+      = make_sub_batches(parsed, h_output_ptrs, h_parsed_payload_ptrs);
+
+  size_t decomp_temp_bytes = 0;
+  for (const SubBatch& batch : decomp_batches) {
+    if (batch.stored || batch.size == 0) {
+      continue;
+    }
+    size_t temp_bytes;
+    status = batch.codec.decompress_temp_size(
+        batch.size, max_chunk_size, &temp_bytes);
+    benchmark_assert(
+        status == nvcompSuccess, "BatchedDecompressGetTempSize() failed.");
+    decomp_temp_bytes = std::max(decomp_temp_bytes, temp_bytes);
+  }
+  nvcomp::thrust::device_vector<uint8_t> decomp_temp(decomp_temp_bytes);
+  nvcomp::thrust::device_vector<size_t> d_decomp_sizes(batch_size);
+  nvcomp::thrust::device_vector<nvcompStatus_t> d_decomp_statuses(
+      batch_size, nvcompSuccess);
+
+  CUDA_CHECK(cudaEventRecord(start, stream));
+  size_t first = 0;
+  for (SubBatch& batch : decomp_batches) {
+    if (batch.size == 0) {
+      continue;
+    }
+    if (batch.stored) {
+      copy_chunks_async(
+          batch.compressed_ptrs.data().get(),
+          batch.compressed_sizes.data().get(),
+          batch.uncompressed_ptrs.data().get(),
+          batch.size,
+          stream);
+      CUDA_CHECK(cudaMemcpyAsync(
+          d_decomp_sizes.data().get() + first,
+          batch.compressed_sizes.data().get(),
+          sizeof(size_t) * batch.size,
+          cudaMemcpyDeviceToDevice,
+          stream));
+    } else {
+      status = batch.codec.decompress(
+          batch.compressed_ptrs.data().get(),
+          batch.compressed_sizes.data().get(),
+          batch.uncompressed_sizes.data().get(),
+          d_decomp_sizes.data().get() + first,
+          batch.size,
+          decomp_temp.data().get(),
+          decomp_temp_bytes,
+          batch.uncompressed_ptrs.data().get(),
+          d_decomp_statuses.data().get() + first,
+          stream);
+      benchmark_assert(
+          status == nvcompSuccess, "BatchedDecompressAsync() not successful");
+    }
+    first += batch.size;
+  }
+  CUDA_CHECK(cudaEventRecord(end, stream));
+  CUDA_CHECK(cudaStreamSynchronize(stream));
+
+  float decompress_ms;
+  CUDA_CHECK(cudaEventElapsedTime(&decompress_ms, start, end));
+  CUDA_CHECK(cudaEventDestroy(start));
+  CUDA_CHECK(cudaEventDestroy(end));
+
+  // Statuses and sizes are in sub-batch order.
+  const std::vector<std::vector<size_t>> parsed_groups
+      = parsed.chunks_by_codec();
+  std::vector<size_t> order;
+  for (const std::vector<size_t>& group : parsed_groups) {
+    order.insert(order.end(), group.begin(), group.end());
+  }
+  std::vector<size_t> h_decomp_sizes(batch_size);
+  std::vector<nvcompStatus_t> h_decomp_statuses(batch_size);
+  CUDA_CHECK(cudaMemcpy(
+      h_decomp_sizes.data(),
+      d_decomp_sizes.data().get(),
+      sizeof(size_t) * batch_size,
+      cudaMemcpyDeviceToHost));
+  CUDA_CHECK(cudaMemcpy(
+      h_decomp_statuses.data(),
+      d_decomp_statuses.data().get(),
+      sizeof(nvcompStatus_t) * batch_size,
+      cudaMemcpyDeviceToHost));
+  for (size_t i = 0; i < batch_size; ++i) {
+    const size_t chunk = order[i];
+    benchmark_assert(
+        h_decomp_statuses[i] == nvcompSuccess,
+        "Batch item not successfuly decompressed: i=" + std::to_string(chunk)
+            + ": status=" + std::to_string(h_decomp_statuses[i]));
+    benchmark_assert(
+        h_decomp_sizes[i] == parsed.uncompressed_size(chunk),
+        "Batch item of wrong size: i=" + std::to_string(chunk)
+            + ": act_size=" + std::to_string(h_decomp_sizes[i])
+            + " exp_size=" + std::to_string(parsed.uncompressed_size(chunk)));
+  }
+
+  if (verify) {
+    for (size_t i = 0; i < batch_size; ++i) {
+      const size_t bytes = parsed.uncompressed_size(i);
+      std::vector<uint8_t> exp_data(bytes);
+      std::vector<uint8_t> act_data(bytes);
+      CUDA_CHECK(cudaMemcpy(
+          exp_data.data(), h_input_ptrs[i], bytes, cudaMemcpyDeviceToHost));
+      CUDA_CHECK(cudaMemcpy(
+          act_data.data(), h_output_ptrs[i], bytes, cudaMemcpyDeviceToHost));
+      benchmark_assert(
+          exp_data == act_data,
+          "Batch item decompressed output did not match input: ix_chunk="
+              + std::to_string(i) + " codec="
+              + parsed.codec_name(parsed.chunk_codec(i)));
+    }
+  }
+
+  MixedResult result;
+  result.container_bytes = layout.total_size();
+  result.comp_time = compress_ms * 1.0e-3;
+  result.decomp_time = decompress_ms * 1.0e-3;
+  return result;
+}
+
+// The single codec key to compare against for a format: the configuration
+// the profiler would pick for the whole batch.
+std::string single_codec_key(
+    const host::DataProfile& aggregate,
+    const std::string& format,
+    const std::vector<size_t>& chunk_sizes)
+{
+  host::FormatRecommendation rec = host::recommend_format(
+      aggregate, std::vector<std::string>(1, format));
+
+  // Stored chunks are not part of the profile, so check that the type
+  // fits all of them.
+  bool aligned = true;
+  for (size_t w = 0; w < host::PROFILE_NUM_WIDTHS; ++w) {
+    const size_t width = host::PROFILE_WIDTHS[w];
+    if (rec.data_type != host::detail::width_type_name(width)) {
+      continue;
+    }
+    for (const size_t bytes : chunk_sizes) {
+      aligned = aligned && bytes % width == 0;
+    }
+  }
+  if (rec.format != format || !aligned) {
+    rec.format = format;
+    rec.data_type = "char";
+    rec.num_RLEs = 1;
+    rec.num_deltas = 1;
+    rec.use_bp = 1;
+  }
+  return host::codec_key(rec);
+}
+
+struct CodecResult
+{
+  std::string name;
+  size_t chunks;
+  MixedResult result;
+};
+
+} // namespace
+
+void run_benchmark(
+    const std::vector<std::vector<char>>& input,
+    const bool warmup,
+    const size_t count,
+    const bool csv_output,
+    const bool tab_separator,
+    const size_t duplicate_count,
+    const size_t num_files)
+{
+  const std::string separator = tab_separator ? "\t" : ",";
+
+  // With '--filter', every chunk is shuffled on the host first, so that the
+  // profiles, the selection and all codecs see the shuffled chunks.
+  std::vector<std::vector<char>> filtered;
+  if (chunkFilter != host::ShuffleFilter::None) {
+    std::vector<char> restored;
+    for (const std::vector<char>& part : input) {
+      filtered.emplace_back(part.size());
+      host::shuffle(
+          chunkFilter,
+          part.data(),
+          filtered.back().data(),
+          part.size(),
+          filterWidth);
+      restored.resize(part.size());
+      host::unshuffle(
+          chunkFilter,
+          filtered.back().data(),
+          restored.data(),
+          part.size(),
+          filterWidth);
+      benchmark_assert(restored == part, "Filter did not round-trip");
+    }
+  }
+  const std::vector<std::vector<char>>& data
+      = chunkFilter != host::ShuffleFilter::None ? filtered : input;
+
+  size_t total_bytes = 0;
+  size_t chunk_size = 0;
+  std::vector<size_t> chunk_sizes(data.size());
+  for (size_t i = 0; i < data.size(); ++i) {
+    total_bytes += data[i].size();
+    chunk_size = std::max(chunk_size, data[i].size());
+    chunk_sizes[i] = data[i].size();
+  }
+
+  // Select a codec per chunk from its profile. With '--store_raw', chunks
+  // the cheaper pre-check finds incompressible are stored without being
+  // profiled.
+  const auto select_start = std::chrono::steady_clock::now();
+  std::vector<uint8_t> raw_flags(data.size(), 0);
+  if (storeRawChunks) {
+    raw_flags = host::mark_raw_chunks(data);
+  }
+  std::vector<size_t> profiled;
+  std::vector<const void*> profiled_ptrs;
+  std::vector<size_t> profiled_sizes;
+  for (size_t i = 0; i < data.size(); ++i) {
+    if (!raw_flags[i]) {
+      profiled.push_back(i);
+      profiled_ptrs.push_back(data[i].data());
+      profiled_sizes.push_back(data[i].size());
+    }
+  }
+  const host::BatchProfile profile = host::profile_batch(
+      profiled_ptrs.data(), profiled_sizes.data(), profiled.size());
+  const std::vector<std::string> selected = host::select_chunk_codecs(
+      profile, mixedAllowedFormats, mixedMinRatio);
+  std::vector<std::string> chunk_codecs(
+      data.size(), host::MIXED_STORED_CODEC);
+  for (size_t i = 0; i < profiled.size(); ++i) {
+    chunk_codecs[profiled[i]] = selected[i];
+  }
+  const double select_time = std::chrono::duration<double>(
+                                 std::chrono::steady_clock::now() - select_start)
+                                 .count();
+
+  BatchData input_data(data);
+
+  cudaStream_t stream;
+  CUDA_CHECK(cudaStreamCreate(&stream));
+
+  std::vector<CodecResult> results;
+
+  std::vector<std::string> layouts(1, "mixed");
+  for (const std::string& format : mixedAllowedFormats) {
+    layouts.push_back(
+        single_codec_key(profile.aggregate, format, chunk_sizes));
+  }
+
+  for (const std::string& name : layouts) {
+    const std::vector<std::string> codecs
+        = name == "mixed" ? chunk_codecs
+                          : std::vector<std::string>(data.size(), name);
+
+    CodecResult codec_result;
+    codec_result.name = name;
+    codec_result.chunks = data.size();
+    codec_result.result.container_bytes = 0;
+    codec_result.result.comp_time = 0.0;
+    codec_result.result.decomp_time = 0.0;
+    for (size_t iter = 0; iter < count; ++iter) {
+      host::MixedBatchLayout layout
+          = host::make_mixed_layout(codecs, chunk_sizes);
+      // only verify last iteration
+      const MixedResult result = run_mixed_batch(
+          layout, input_data, chunk_size, iter + 1 == count, stream);
+      codec_result.result.container_bytes += result.container_bytes;
+      codec_result.result.comp_time += result.comp_time;
+      codec_result.result.decomp_time += result.decomp_time;
+    }
+    codec_result.result.container_bytes /= count;
+    codec_result.result.comp_time /= count;
+    codec_result.result.decomp_time /= count;
+    results.push_back(codec_result);
+  }
+  CUDA_CHECK(cudaStreamDestroy(stream));
+
+  if (warmup) {
+    return;
+  }
+
+  size_t best = 1;
+  for (size_t i = 2; i < results.size(); ++i) {
+    if (results[i].result.container_bytes
+        < results[best].result.container_bytes) {
+      best = i;
+    }
+  }
+
+  if (!csv_output) {
+    const host::MixedBatchLayout layout
+        = host::make_mixed_layout(chunk_codecs, chunk_sizes);
+    const std::vector<std::vector<size_t>> groups = layout.chunks_by_codec();
+
+    std::cout << "----------" << std::endl;
+    std::cout << "files: " << num_files << std::endl;
+    std::cout << "uncompressed (B): " << total_bytes << std::endl;
+    std::cout << "chunks: " << data.size() << std::endl;
+    if (chunkFilter != host::ShuffleFilter::None) {
+      std::cout << "filter: " << host::shuffle_filter_name(chunkFilter)
+                << " shuffle, element width " << filterWidth << " B"
+                << std::endl;
+    }
+    std::cout << "selection throughput (GB/s): " << std::fixed
+              << std::setprecision(4) << total_bytes / (1.0e9 * select_time)
+              << std::endl;
+    std::cout << "selected codecs:" << std::endl;
+    for (size_t c = 0; c < groups.size(); ++c) {
+      std::cout << "  " << layout.codec_name(c) << ": " << groups[c].size()
+                << " chunks" << std::endl;
+    }
+    std::cout << std::left << std::setw(22) << "codec" << std::right
+              << std::setw(14) << "comp_size" << std::setw(10) << "ratio"
+              << std::setw(12) << "comp GB/s" << std::setw(14)
+              << "decomp GB/s" << std::endl;
+    for (const CodecResult& r : results) {
+      std::cout << std::left << std::setw(22) << r.name << std::right
+                << std::setw(14) << r.result.container_bytes << std::setw(10)
+                << std::setprecision(4)
+                << (double)total_bytes / r.result.container_bytes
+                << std::setw(12) << total_bytes / (1.0e9 * r.result.comp_time)
+                << std::setw(14)
+                << total_bytes / (1.0e9 * r.result.decomp_time) << std::endl;
+    }
+    const MixedResult& mixed = results[0].result;
+    const MixedResult& single = results[best].result;
+    std::cout << "best single codec: " << results[best].name << std::endl;
+    std::cout << "mixed vs best single: ratio x"
+              << (double)single.container_bytes / mixed.container_bytes
+              << ", compression throughput x"
+              << single.comp_time / mixed.comp_time
+              << ", decompression throughput x"
+              << single.decomp_time / mixed.decomp_time << std::endl;
+  } else {
+    // header
+    std::cout << "Files";
+    std::cout << separator << "Duplicate data";
+    std::cout << separator << "Codec";
+    std::cout << separator << "Pages";
+    std::cout << separator << "Ucompressed size in bytes";
+    std::cout << separator << "Compressed size in bytes";
+    std::cout << separator << "Compression ratio";
+    std::cout << separator << "Compression throughput (uncompressed) in GB/s";
+    std::cout << separator
+              << "Decompression throughput (uncompressed) in GB/s";
+    std::cout << separator << "Best single codec";
+    if (chunkFilter != host::ShuffleFilter::None) {
+      std::cout << separator << "Filter";
+      std::cout << separator << "Filter element width in bytes";
+    }
+    std::cout << std::endl;
+
+    // values
+    for (size_t i = 0; i < results.size(); ++i) {
+      const CodecResult& r = results[i];
+      std::cout << num_files;
+      std::cout << separator << duplicate_count;
+      std::cout << separator << r.name;
+      std::cout << separator << r.chunks;
+      std::cout << separator << total_bytes;
+      std::cout << separator << r.result.container_bytes;
+      std::cout << separator << std::fixed << std::setprecision(2)
+                << (double)total_bytes / r.result.container_bytes;
+      std::cout << separator << total_bytes / (1.0e9 * r.result.comp_time);
+      std::cout << separator << total_bytes / (1.0e9 * r.result.decomp_time);
+      std::cout << separator << (i == best ? "true" : "false");
+      if (chunkFilter != host::ShuffleFilter::None) {
+        std::cout << separator << host::shuffle_filter_name(chunkFilter);
+        std::cout << separator << filterWidth;
+      }
+      std::cout << std::endl;
+    }
+  }
+}
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Gzip a file on the CPU with the parallel gzip writer, as independent
+// members or as one pigz-style primed member, and report the ratio and how
+// fast it compresses and decompresses. Optionally write the .gz file and
+// its side index.
+
+#include "host/file_io.h"
+#include "host/thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#ifdef NVCOMP_HOST_HAVE_ZLIB
+
+#include "host/pgzip.h"
+
+using namespace nvcomp::host;
+
+static void print_usage()
+{
+  printf("Usage: benchmark_pgzip [OPTIONS]\n");
+  printf("  %-35s Binary input file (required).\n", "-f, --input_file");
+  printf("  %-35s zlib compression level, 0 to 9 (default 6).\n", "-l, --level");
+  printf("  %-35s Uncompressed bytes per member or block (default 65536).\n", "-p, --chunk_size");
+  printf("  %-35s Layout: independent, primed or all (default all).\n", "-m, --mode");
+  printf("  %-35s Worker threads (default one per CPU).\n", "-n, --threads");
+  printf("  %-35s Write the gzip file and <file>.idx (needs one mode).\n", "-o, --output_file");
+  printf("  %-35s Number of measurement iterations (default 3).\n", "-i, --iteration_count");
+  printf("  %-35s Output in CSV format.\n", "-x, --csv");
+}
+
+static void print_header(const bool csv)
+{
+  if (csv) {
+    std::cout << "mode,entries,compressed bytes,ratio,compression MB/s,"
+                 "decompression MB/s"
+              << std::endl;
+    return;
+  }
+  std::cout << std::setw(12) << "mode" << std::setw(10) << "entries"
+            << std::setw(14) << "compressed" << std::setw(8) << "ratio"
+            << std::setw(12) << "comp MB/s" << std::setw(14) << "decomp MB/s"
+            << std::endl;
+}
+
+static int run(
+    ThreadPool& pool,
+    const std::vector<char>& data,
+    PgzipOptions options,
+    const bool prime,
+    const char* const output_file,
+    const int iterations,
+    const bool csv)
+{
+  typedef std::chrono::steady_clock clock;
+  options.prime = prime;
+  double comp_seconds = std::numeric_limits<double>::max();
+  double decomp_seconds = std::numeric_limits<double>::max();
+  std::vector<uint8_t> gz;
+  PgzipIndex index;
+  std::vector<char> decompressed(data.size());
+  for (int it = 0; it < iterations; ++it) {
+    clock::time_point start = clock::now();
+    gz = pgzip_compress(pool, data.data(), data.size(), options, &index);
+    comp_seconds = std::min(
+        comp_seconds,
+        std::chrono::duration<double>(clock::now() - start).count());
+
+    start = clock::now();
+    const nvcompStatus_t status = pgzip_decompress(
+        pool,
+        gz.data(),
+        gz.size(),
+        index,
+        decompressed.data(),
+        decompressed.size());
+    decomp_seconds = std::min(
+        decomp_seconds,
+        std::chrono::duration<double>(clock::now() - start).count());
+    if (status != nvcompSuccess || decompressed != data) {
+      std::cerr << "Gzip decompression gave wrong data." << std::endl;
+      return 1;
+    }
+  }
+
+  if (output_file != nullptr) {
+    std::ofstream fout(output_file, std::ofstream::binary);
+    fout.write(reinterpret_cast<const char*>(gz.data()), gz.size());
+    if (!fout) {
+      std::cerr << "Error writing " << output_file << "." << std::endl;
+      return 1;
+    }
+    write_pgzip_index(std::string(output_file) + ".idx", index);
+  }
+
+  const double ratio = double(data.size()) / gz.size();
+  const double comp_mbs = data.size() / comp_seconds * 1e-6;
+  const double decomp_mbs = data.size() / decomp_seconds * 1e-6;
+  const char* const mode = prime ? "primed" : "independent";
+  if (csv) {
+    std::cout << mode << "," << index.entries.size() << "," << gz.size()
+              << "," << ratio << "," << comp_mbs << "," << decomp_mbs
+              << std::endl;
+    return 0;
+  }
+  std::cout << std::fixed << std::setw(12) << mode << std::setw(10)
+            << index.entries.size() << std::setw(14) << gz.size()
+            << std::setprecision(2) << std::setw(8) << ratio
+            << std::setprecision(1) << std::setw(12) << comp_mbs
+            << std::setw(14) << decomp_mbs << std::endl;
+  return 0;
+}
+
+int main(int argc, char* argv[])
+{
+  char* fname = nullptr;
+  char* output_file = nullptr;
+  int level = 6;
+  size_t chunk_size = 65536;
+  std::string mode = "all";
+  size_t num_threads = 0;
+  int iterations = 3;
+  bool csv = false;
+
+  char** argv_end = argv + argc;
+  argv += 1;
+  while (argv != argv_end) {
+    char* arg = *argv++;
+    if (strcmp(arg, "--help") == 0 || strcmp(arg, "-?") == 0) {
+      print_usage();
+      return 1;
+    }
+    if (strcmp(arg, "--csv") == 0 || strcmp(arg, "-x") == 0) {
+      csv = true;
+      continue;
+    }
+
+    // all arguments below require at least a second value in argv
+    if (argv >= argv_end) {
+      print_usage();
+      return 1;
+    }
+
+    char* optarg = *argv++;
+    if (strcmp(arg, "--input_file") == 0 || strcmp(arg, "-f") == 0) {
+      fname = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--level") == 0 || strcmp(arg, "-l") == 0) {
+      level = atoi(optarg);
+      continue;
+    }
+    if (strcmp(arg, "--chunk_size") == 0 || strcmp(arg, "-p") == 0) {
+      chunk_size = strtoull(optarg, nullptr, 10);
+      continue;
+    }
+    if (strcmp(arg, "--mode") == 0 || strcmp(arg, "-m") == 0) {
+      mode = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--threads") == 0 || strcmp(arg, "-n") == 0) {
+      num_threads = strtoull(optarg, nullptr, 10);
+      continue;
+    }
+    if (strcmp(arg, "--output_file") == 0 || strcmp(arg, "-o") == 0) {
+      output_file = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--iteration_count") == 0 || strcmp(arg, "-i") == 0) {
+      iterations = atoi(optarg);
+      continue;
+    }
+    print_usage();
+    return 1;
+  }
+
+  if (fname == nullptr || iterations <= 0 || chunk_size == 0 || level < 0
+      || level > 9
+      || (mode != "independent" && mode != "primed" && mode != "all")
+      || (output_file != nullptr && mode == "all")) {
+    print_usage();
+    return 1;
+  }
+
+  const std::vector<char> data = readFile(fname);
+  ThreadPool pool(num_threads);
+  std::cout << "----------" << std::endl;
+  std::cout << "file: " << fname << std::endl;
+  std::cout << "level: " << level << std::endl;
+  std::cout << "threads: " << pool.num_threads() << std::endl;
+  std::cout << "uncompressed (B): " << data.size() << std::endl;
+
+  PgzipOptions options = PgzipDefaultOpts;
+  options.level = level;
+  options.chunk_size = chunk_size;
+  print_header(csv);
+  for (const bool prime : {false, true}) {
+    if (mode != "all" && (mode == "primed") != prime) {
+      continue;
+    }
+    const int status
+        = run(pool, data, options, prime, output_file, iterations, csv);
+    if (status != 0) {
+      return status;
+    }
+  }
+  return 0;
+}
+
+#else
+
+int main()
+{
+  std::cerr << "benchmark_pgzip was built without zlib." << std::endl;
+  return 1;
+}
+
+#endif
@@ -38,7 +38,16 @@
 #endif
 
 #include "benchmark_common.h"
-
+#include "host/compaction.h"
+#include "host/file_io.h"
+#include "host/host_allocator.h"
+#include "host/perf_counters.h"
+#include "host/shuffle.h"
+#include "host/store_raw.h"
+#include "host/trace.h"
+
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -79,6 +88,17 @@ static bool handleCommandLineArgument(
     const char* const* additionalArgs,
     size_t& additionalArgsUsed);
 
+// Set by '--store_raw': chunks that the host pre-check finds incompressible
+// are copied instead of compressed.
+static bool storeRawChunks = false;
+
+// Set by '--filter' and '--filter_width': a host shuffle applied to every
+// chunk before it is copied to the GPU, so that the codec compresses the
+// shuffled chunks.
+static nvcomp::host::ShuffleFilter chunkFilter
+    = nvcomp::host::ShuffleFilter::None;
+static size_t filterWidth = 4;
+
 // A helper function for if the input data requires no validation.
 static bool inputAlwaysValid(const std::vector<std::vector<char>>& data)
 {
@@ -159,6 +179,52 @@ std::vector<size_t> compute_chunk_sizes(
   return sizes;
 }
 
+template <typename T>
+std::vector<T>
+gather(const std::vector<T>& values, const std::vector<size_t>& indices)
+{
+  std::vector<T> result(indices.size());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    result[i] = values[indices[i]];
+  }
+  return result;
+}
+
+// Copy each chunk with one thread block. Both sides must be 8-byte aligned.
+__global__ void copy_chunks_kernel(
+    const void* const* const src_ptrs,
+    const size_t* const sizes,
+    void* const* const dst_ptrs)
+{
+  const uint8_t* const src = static_cast<const uint8_t*>(src_ptrs[blockIdx.x]);
+  uint8_t* const dst = static_cast<uint8_t*>(dst_ptrs[blockIdx.x]);
+  const size_t bytes = sizes[blockIdx.x];
+
+  const size_t words = bytes / sizeof(uint64_t);
+  for (size_t i = threadIdx.x; i < words; i += blockDim.x) {
+    reinterpret_cast<uint64_t*>(dst)[i]
+        = reinterpret_cast<const uint64_t*>(src)[i];
+  }
+  for (size_t i = words * sizeof(uint64_t) + threadIdx.x; i < bytes;
+       i += blockDim.x) {
+    dst[i] = src[i];
+  }
+}
+
+void copy_chunks_async(
+    const void* const* const src_ptrs,
+    const size_t* const sizes,
+    void* const* const dst_ptrs,
+    const size_t num_chunks,
+    cudaStream_t stream)
+{
+  if (num_chunks > 0) {
+    copy_chunks_kernel<<<num_chunks, 256, 0, stream>>>(
+        src_ptrs, sizes, dst_ptrs);
+    CUDA_CHECK(cudaGetLastError());
+  }
+}
+
 class BatchData
 {
 public:
@@ -198,6 +264,7 @@ public:
     m_sizes = nvcomp::thrust::device_vector<size_t>(sizes);
 
     // copy data to GPU
+    NVCOMP_TRACE_SCOPE("h2d");
     for (size_t i = 0; i < host_data.size(); ++i) {
       CUDA_CHECK(cudaMemcpy(
           uncompressed_ptrs[i],
@@ -262,98 +329,314 @@ private:
   nvcomp::thrust::device_vector<uint8_t> m_data;
   size_t m_size;
 };
+}
 
-std::vector<char> readFile(const std::string& filename)
+// Size and timings of one compression and decompression of a batch.
+struct BatchRunResult
+{
+  size_t compressed_bytes;
+  double comp_time;
+  double decomp_time;
+};
+
+// Compress and decompress the batch once. Chunks with a nonzero
+// `raw_flags` entry are copied to and from their output slots instead of
+// being passed to the compressor.
+template<
+    typename CompGetTempT,
+    typename CompGetSizeT,
+    typename CompAsyncT,
+    typename DecompGetTempT,
+    typename DecompAsyncT,
+    typename FormatOptsT>
+BatchRunResult
+run_batch_once(
+    CompGetTempT BatchedCompressGetTempSize,
+    CompGetSizeT BatchedCompressGetMaxOutputChunkSize,
+    CompAsyncT BatchedCompressAsync,
+    DecompGetTempT BatchedDecompressGetTempSize,
+    DecompAsyncT BatchedDecompressAsync,
+    const FormatOptsT format_opts,
+    BatchData& input_data,
+    const std::vector<size_t>& h_input_sizes,
+    const size_t chunk_size,
+    const std::vector<uint8_t>& raw_flags,
+    const bool verify,
+    const bool file_output,
+    const std::string& output_filename,
+    cudaStream_t stream)
 {
-  std::ifstream fin(filename, std::ifstream::binary);
-  if (!fin) {
-    std::cerr << "ERROR: Unable to open \"" << filename << "\" for reading."
-              << std::endl;
-    throw std::runtime_error("Error opening file for reading.");
+  const size_t batch_size = input_data.size();
+
+  std::vector<void*> h_input_ptrs(batch_size);
+  CUDA_CHECK(cudaMemcpy(h_input_ptrs.data(), input_data.ptrs(),
+      sizeof(void*)*batch_size, cudaMemcpyDeviceToHost));
+
+  // split the batch into the chunks to compress and the chunks to store
+  std::vector<size_t> comp_chunks;
+  std::vector<size_t> raw_chunks;
+  for (size_t i = 0; i < batch_size; ++i) {
+    if (raw_flags[i]) {
+      raw_chunks.push_back(i);
+    } else {
+      comp_chunks.push_back(i);
+    }
   }
+  const size_t comp_batch_size = comp_chunks.size();
+  const size_t raw_batch_size = raw_chunks.size();
+
+  // compression
+  nvcompStatus_t status;
 
-  fin.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+  // Compress on the GPU using batched API
+  size_t comp_temp_bytes = 0;
+  if (comp_batch_size > 0) {
+    status = BatchedCompressGetTempSize(
+        comp_batch_size, chunk_size, format_opts, &comp_temp_bytes);
+    benchmark_assert(status == nvcompSuccess,
+        "BatchedCompressGetTempSize() failed.");
+  }
 
-  fin.seekg(0, std::ios_base::end);
-  auto fileSize = static_cast<std::streamoff>(fin.tellg());
-  fin.seekg(0, std::ios_base::beg);
+  void* d_comp_temp;
+  CUDA_CHECK(cudaMalloc(&d_comp_temp, comp_temp_bytes));
+
+  size_t max_out_bytes;
+  status = BatchedCompressGetMaxOutputChunkSize(
+      chunk_size, format_opts, &max_out_bytes);
+  benchmark_assert(status == nvcompSuccess,
+      "BatchedGetMaxOutputChunkSize() failed.");
+  // stored chunks need room for the whole chunk
+  if (raw_batch_size > 0) {
+    max_out_bytes
+        = roundUpTo(std::max(max_out_bytes, chunk_size), sizeof(uint64_t));
+  }
 
-  std::vector<char> host_data(fileSize);
-  fin.read(host_data.data(), fileSize);
+  BatchData compress_data(max_out_bytes, batch_size);
 
-  if (!fin) {
-    std::cerr << "ERROR: Unable to read all of file \"" << filename << "\"."
-              << std::endl;
-    throw std::runtime_error("Error reading file.");
+  std::vector<void*> h_comp_ptrs(batch_size);
+  for (size_t i = 0; i < batch_size; ++i) {
+    h_comp_ptrs[i] = compress_data.data() + max_out_bytes * i;
   }
 
-  return host_data;
-}
+  const nvcomp::thrust::device_vector<void*> d_comp_input_ptrs(
+      gather(h_input_ptrs, comp_chunks));
+  const nvcomp::thrust::device_vector<size_t> d_comp_input_sizes(
+      gather(h_input_sizes, comp_chunks));
+  const nvcomp::thrust::device_vector<void*> d_comp_output_ptrs(
+      gather(h_comp_ptrs, comp_chunks));
+  nvcomp::thrust::device_vector<size_t> d_comp_output_sizes(comp_batch_size);
+
+  const nvcomp::thrust::device_vector<void*> d_raw_input_ptrs(
+      gather(h_input_ptrs, raw_chunks));
+  const nvcomp::thrust::device_vector<size_t> d_raw_sizes(
+      gather(h_input_sizes, raw_chunks));
+  const nvcomp::thrust::device_vector<void*> d_raw_output_ptrs(
+      gather(h_comp_ptrs, raw_chunks));
+
+  cudaEvent_t start, end;
+  CUDA_CHECK(cudaEventCreate(&start));
+  CUDA_CHECK(cudaEventCreate(&end));
+  {
+    NVCOMP_TRACE_SCOPE("compress");
+    CUDA_CHECK(cudaEventRecord(start, stream));
 
+    if (comp_batch_size > 0) {
+      status = BatchedCompressAsync(
+          d_comp_input_ptrs.data().get(),
+          d_comp_input_sizes.data().get(),
+          chunk_size,
+          comp_batch_size,
+          d_comp_temp,
+          comp_temp_bytes,
+          d_comp_output_ptrs.data().get(),
+          d_comp_output_sizes.data().get(),
+          format_opts,
+          stream);
+      benchmark_assert(status == nvcompSuccess,
+          "BatchedCompressAsync() failed.");
+    }
+    copy_chunks_async(
+        d_raw_input_ptrs.data().get(),
+        d_raw_sizes.data().get(),
+        d_raw_output_ptrs.data().get(),
+        raw_batch_size,
+        stream);
 
-std::vector<std::vector<char>> readFileWithPageSizes(const std::string& filename)
-{
-  std::vector<std::vector<char>> res;
+    CUDA_CHECK(cudaEventRecord(end, stream));
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
 
-  std::ifstream fin(filename, std::ifstream::binary);
+  // free compression memory
+  CUDA_CHECK(cudaFree(d_comp_temp));
+
+  float compress_ms;
+  CUDA_CHECK(cudaEventElapsedTime(&compress_ms, start, end));
+
+  // compute compression ratio
+  std::vector<size_t> comp_output_sizes_host(comp_batch_size);
+  CUDA_CHECK(cudaMemcpy(
+      comp_output_sizes_host.data(),
+      d_comp_output_sizes.data().get(),
+      comp_batch_size * sizeof(size_t),
+      cudaMemcpyDeviceToHost));
+  std::vector<size_t> compressed_sizes_host(h_input_sizes);
+  for (size_t ix = 0; ix < comp_batch_size; ++ix) {
+    compressed_sizes_host[comp_chunks[ix]] = comp_output_sizes_host[ix];
+  }
+  size_t comp_bytes = 0;
+  for (size_t ix = 0 ; ix < batch_size; ++ix) {
+    comp_bytes += compressed_sizes_host[ix];
+  }
 
-  while (!fin.eof()) {
-    uint64_t chunk_size;
-    fin.read(reinterpret_cast<char *>(&chunk_size), sizeof(uint64_t));
-    if (fin.eof())
-      break;
-    res.emplace_back(chunk_size);
-    fin.read(reinterpret_cast<char*>(res.back().data()), chunk_size);
+  // Then do file output
+  if (file_output) {
+    NVCOMP_TRACE_SCOPE("file output");
+    // Bring the slots over in one transfer and pack them on the host,
+    // rather than issuing one small copy per chunk.
+    nvcomp::host::HostBuffer comp_data(
+        max_out_bytes * batch_size, nvcomp::host::HugePages::None, false);
+    CUDA_CHECK(cudaMemcpy(
+        comp_data.data(),
+        compress_data.data(),
+        comp_data.size(),
+        cudaMemcpyDeviceToHost));
+    std::vector<void*> comp_slots(batch_size);
+    for (size_t i = 0; i < batch_size; ++i) {
+      comp_slots[i] = comp_data.data() + max_out_bytes * i;
+    }
+    const std::vector<size_t> comp_offsets
+        = nvcomp::host::compact_chunks_in_place(
+            nvcomp::host::default_thread_pool(),
+            comp_data.data(),
+            comp_slots.data(),
+            compressed_sizes_host.data(),
+            batch_size);
+
+    std::ofstream outfile{output_filename.c_str(), outfile.binary};
+    // With store-raw, the payloads alone can't be decoded, so they are
+    // preceded by the sizes and raw flag of each chunk.
+    if (storeRawChunks) {
+      const std::vector<uint8_t> table = nvcomp::host::raw_chunk_table(
+          raw_flags.data(),
+          h_input_sizes.data(),
+          compressed_sizes_host.data(),
+          batch_size);
+      outfile.write(
+          reinterpret_cast<const char*>(table.data()), table.size());
+    }
+    outfile.write(
+        reinterpret_cast<char*>(comp_data.data()), comp_offsets[batch_size]);
+    outfile.close();
   }
 
-  return res;
-}
+  // LZ4 decompression
+  size_t decomp_temp_bytes = 0;
+  if (comp_batch_size > 0) {
+    status = BatchedDecompressGetTempSize(
+        comp_batch_size, chunk_size, &decomp_temp_bytes);
+    benchmark_assert(status == nvcompSuccess,
+        "BatchedDecompressGetTempSize() failed.");
+  }
 
+  void* d_decomp_temp;
+  CUDA_CHECK(cudaMalloc(&d_decomp_temp, decomp_temp_bytes));
 
-std::vector<std::vector<char>>
-multi_file(const std::vector<std::string>& filenames, const size_t chunk_size,
-    const bool has_page_sizes, const size_t duplicate_count)
-{
-  std::vector<std::vector<char>> split_data;
-
-  for (auto const& filename : filenames) {
-    if (!has_page_sizes) {
-      std::vector<char> filedata = readFile(filename);
-
-      const size_t num_chunks
-          = (filedata.size() + chunk_size - 1) / chunk_size;
-      size_t offset = 0;
-      for (size_t c = 0; c < num_chunks; ++c) {
-        const size_t size_of_this_chunk = std::min(chunk_size, filedata.size()-offset); 
-        split_data.emplace_back(
-            std::vector<char>(filedata.data() + offset, 
-                              filedata.data()+ offset + size_of_this_chunk));
-        offset += size_of_this_chunk;
-        assert(offset <= filedata.size());
-      }
-    } else {
-      std::vector<std::vector<char>> filedata = readFileWithPageSizes(filename);
-      split_data.insert(split_data.end(), filedata.begin(), filedata.end());
+  nvcomp::thrust::device_vector<size_t> d_decomp_sizes(comp_batch_size);
+  nvcomp::thrust::device_vector<nvcompStatus_t> d_decomp_statuses(
+      comp_batch_size);
+
+  std::vector<void*> h_output_ptrs(batch_size);
+  for (size_t i = 0; i < batch_size; ++i) {
+    CUDA_CHECK(cudaMalloc(&h_output_ptrs[i], h_input_sizes[i]));
+  }
+  const nvcomp::thrust::device_vector<void*> d_decomp_output_ptrs(
+      gather(h_output_ptrs, comp_chunks));
+  const nvcomp::thrust::device_vector<void*> d_raw_decomp_output_ptrs(
+      gather(h_output_ptrs, raw_chunks));
+
+  {
+    NVCOMP_TRACE_SCOPE("decompress");
+    CUDA_CHECK(cudaEventRecord(start, stream));
+    if (comp_batch_size > 0) {
+      status = BatchedDecompressAsync(
+          d_comp_output_ptrs.data().get(),
+          d_comp_output_sizes.data().get(),
+          d_comp_input_sizes.data().get(),
+          d_decomp_sizes.data().get(),
+          comp_batch_size,
+          d_decomp_temp,
+          decomp_temp_bytes,
+          d_decomp_output_ptrs.data().get(),
+          d_decomp_statuses.data().get(),
+          stream);
+      benchmark_assert(
+          status == nvcompSuccess,
+          "BatchedDecompressAsync() not successful");
     }
+    copy_chunks_async(
+        d_raw_output_ptrs.data().get(),
+        d_raw_sizes.data().get(),
+        d_raw_decomp_output_ptrs.data().get(),
+        raw_batch_size,
+        stream);
+
+    CUDA_CHECK(cudaEventRecord(end, stream));
+    CUDA_CHECK(cudaStreamSynchronize(stream));
+  }
+
+  float decompress_ms;
+  CUDA_CHECK(cudaEventElapsedTime(&decompress_ms, start, end));
+  CUDA_CHECK(cudaEventDestroy(start));
+  CUDA_CHECK(cudaEventDestroy(end));
+
+  // verify success each time
+  std::vector<size_t> h_decomp_sizes(h_input_sizes);
+  std::vector<size_t> comp_decomp_sizes(comp_batch_size);
+  CUDA_CHECK(cudaMemcpy(comp_decomp_sizes.data(), d_decomp_sizes.data().get(),
+    sizeof(size_t)*comp_batch_size, cudaMemcpyDeviceToHost));
+
+  std::vector<nvcompStatus_t> h_decomp_statuses(comp_batch_size);
+  CUDA_CHECK(cudaMemcpy(h_decomp_statuses.data(), d_decomp_statuses.data().get(),
+    sizeof(nvcompStatus_t)*comp_batch_size, cudaMemcpyDeviceToHost));
+  for (size_t ix = 0; ix < comp_batch_size; ++ix) {
+    const size_t i = comp_chunks[ix];
+    h_decomp_sizes[i] = comp_decomp_sizes[ix];
+    benchmark_assert(h_decomp_statuses[ix] == nvcompSuccess, "Batch item not successfuly decompressed: i=" + std::to_string(i) + ": status=" +
+    std::to_string(h_decomp_statuses[ix]));
+    benchmark_assert(h_decomp_sizes[i] == h_input_sizes[i], "Batch item of wrong size: i=" + std::to_string(i) + ": act_size=" +
+    std::to_string(h_decomp_sizes[i]) + " exp_size=" +
+    std::to_string(h_input_sizes[i]));
   }
 
-  if (duplicate_count > 1) {
-    // Make duplicate_count copies of the contents of split_data,
-    // but copy into a separate std::vector, to avoid issues with the
-    // memory being reallocated while the contents are being copied.
-    std::vector<std::vector<char>> duplicated;
-    const size_t original_num_chunks = split_data.size();
-    duplicated.reserve(original_num_chunks * duplicate_count);
-    for (size_t d = 0; d < duplicate_count; ++d) {
-      duplicated.insert(duplicated.end(), split_data.begin(), split_data.end());
+  CUDA_CHECK(cudaFree(d_decomp_temp));
+
+  if (verify) {
+    NVCOMP_TRACE_SCOPE("verify");
+    for (size_t ix_chunk = 0; ix_chunk < batch_size; ++ix_chunk) {
+      std::vector<uint8_t> exp_data(h_input_sizes[ix_chunk]);
+      CUDA_CHECK(cudaMemcpy(exp_data.data(), h_input_ptrs[ix_chunk],
+          h_input_sizes[ix_chunk], cudaMemcpyDeviceToHost));
+      std::vector<uint8_t> act_data(h_decomp_sizes[ix_chunk]);
+      CUDA_CHECK(cudaMemcpy(act_data.data(), h_output_ptrs[ix_chunk],
+      h_decomp_sizes[ix_chunk], cudaMemcpyDeviceToHost));
+      for (size_t ix_byte = 0; ix_byte < h_input_sizes[ix_chunk]; ++ix_byte) {
+        if (act_data[ix_byte] != exp_data[ix_byte]) {
+          benchmark_assert(false, "Batch item decompressed output did not match input: ix_chunk="+std::to_string(ix_chunk) + ": ix_byte=" + std::to_string(ix_byte) + " act=" + std::to_string(act_data[ix_byte]) + " exp=" +
+          std::to_string(exp_data[ix_byte]));
+        }
+      }
     }
-    // Now that there are duplicate_count copies of split_data in
-    // duplicated, swap them, so that they're in split_data.
-    duplicated.swap(split_data);
   }
 
-  return split_data;
-}
+  for (size_t i = 0; i < batch_size; ++i) {
+    CUDA_CHECK(cudaFree(h_output_ptrs[i]));
+  }
+
+  BatchRunResult result;
+  result.compressed_bytes = comp_bytes;
+  result.comp_time = compress_ms * 1.0e-3;
+  result.decomp_time = decompress_ms * 1.0e-3;
+  return result;
 }
 
 template<
@@ -396,8 +679,55 @@ run_benchmark_template(
     }
   }
 
+  // With a filter, the chunks are shuffled on the host and everything below
+  // runs on the shuffled chunks. The inverse is timed and checked as well.
+  // The filters run on this thread, so they are also measured with hardware
+  // counters where the platform allows them.
+  nvcomp::host::PerfCounters perf;
+  std::vector<std::vector<char>> filtered;
+  double filter_time = 0.0;
+  double unfilter_time = 0.0;
+  nvcomp::host::PerfSample filter_counters;
+  nvcomp::host::PerfSample unfilter_counters;
+  if (chunkFilter != nvcomp::host::ShuffleFilter::None) {
+    NVCOMP_TRACE_SCOPE("shuffle filter");
+    for (const std::vector<char>& part : data) {
+      filtered.emplace_back(part.size());
+    }
+    const auto filter_start = std::chrono::steady_clock::now();
+    perf.start();
+    for (size_t i = 0; i < data.size(); ++i) {
+      nvcomp::host::shuffle(chunkFilter, data[i].data(),
+          filtered[i].data(), data[i].size(), filterWidth);
+    }
+    filter_counters = perf.stop();
+    filter_time = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - filter_start).count();
+
+    std::vector<char> restored(chunk_size);
+    for (size_t i = 0; i < data.size(); ++i) {
+      const auto unfilter_start = std::chrono::steady_clock::now();
+      perf.start();
+      nvcomp::host::unshuffle(chunkFilter, filtered[i].data(),
+          restored.data(), filtered[i].size(), filterWidth);
+      const nvcomp::host::PerfSample chunk_counters = perf.stop();
+      unfilter_time += std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - unfilter_start).count();
+      // Leave out the check below, as the time does.
+      if (i == 0) {
+        unfilter_counters = chunk_counters;
+      } else {
+        unfilter_counters += chunk_counters;
+      }
+      benchmark_assert(std::equal(data[i].begin(), data[i].end(),
+          restored.begin()), "Filter did not round-trip");
+    }
+  }
+  const std::vector<std::vector<char>>& chunks
+      = chunkFilter != nvcomp::host::ShuffleFilter::None ? filtered : data;
+
   // build up metadata
-  BatchData input_data(data);
+  BatchData input_data(chunks);
 
   cudaStream_t stream;
   CUDA_CHECK(cudaStreamCreate(&stream));
@@ -408,189 +738,75 @@ run_benchmark_template(
   CUDA_CHECK(cudaMemcpy(h_input_sizes.data(), input_data.sizes(),
       sizeof(size_t)*batch_size, cudaMemcpyDeviceToHost));
 
+  // With store-raw, chunks the host pre-check finds incompressible are
+  // copied instead of compressed, and the batch is also run without the
+  // bypass to measure the time saved.
+  const std::vector<uint8_t> no_raw_flags(batch_size, 0);
+  std::vector<uint8_t> raw_flags(no_raw_flags);
+  double precheck_time = 0.0;
+  size_t raw_count = 0;
+  if (storeRawChunks) {
+    NVCOMP_TRACE_SCOPE("store-raw precheck");
+    const auto precheck_start = std::chrono::steady_clock::now();
+    raw_flags = nvcomp::host::mark_raw_chunks(chunks);
+    precheck_time = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - precheck_start).count();
+    for (const uint8_t flag : raw_flags) {
+      raw_count += flag;
+    }
+  }
+
   size_t compressed_size = 0;
   double comp_time = 0.0;
   double decomp_time = 0.0;
+  size_t baseline_compressed_size = 0;
+  double baseline_comp_time = 0.0;
+  double baseline_decomp_time = 0.0;
   for (size_t iter = 0; iter < count; ++iter) {
-    // compression
-    nvcompStatus_t status;
-
-    // Compress on the GPU using batched API
-    size_t comp_temp_bytes;
-    status = BatchedCompressGetTempSize(
-        batch_size, chunk_size, format_opts, &comp_temp_bytes);
-    benchmark_assert(status == nvcompSuccess,
-        "BatchedCompressGetTempSize() failed.");
-
-    void* d_comp_temp;
-    CUDA_CHECK(cudaMalloc(&d_comp_temp, comp_temp_bytes));
-
-    size_t max_out_bytes;
-    status = BatchedCompressGetMaxOutputChunkSize(
-        chunk_size, format_opts, &max_out_bytes);
-    benchmark_assert(status == nvcompSuccess,
-        "BatchedGetMaxOutputChunkSize() failed.");
-
-    BatchData compress_data(max_out_bytes, batch_size);
-
-    cudaEvent_t start, end;
-    CUDA_CHECK(cudaEventCreate(&start));
-    CUDA_CHECK(cudaEventCreate(&end));
-    CUDA_CHECK(cudaEventRecord(start, stream));
-
-    status = BatchedCompressAsync(
-        input_data.ptrs(),
-        input_data.sizes(),
-        chunk_size,
-        batch_size,
-        d_comp_temp,
-        comp_temp_bytes,
-        compress_data.ptrs(),
-        compress_data.sizes(),
+    // only verify last iteration
+    const bool verify = iter + 1 == count;
+
+    const BatchRunResult result = run_batch_once(
+        BatchedCompressGetTempSize,
+        BatchedCompressGetMaxOutputChunkSize,
+        BatchedCompressAsync,
+        BatchedDecompressGetTempSize,
+        BatchedDecompressAsync,
         format_opts,
+        input_data,
+        h_input_sizes,
+        chunk_size,
+        raw_flags,
+        verify,
+        file_output,
+        output_filename,
         stream);
-    benchmark_assert(status == nvcompSuccess,
-        "BatchedCompressAsync() failed.");
-
-    CUDA_CHECK(cudaEventRecord(end, stream));
-    CUDA_CHECK(cudaStreamSynchronize(stream));
-
-    // free compression memory
-    CUDA_CHECK(cudaFree(d_comp_temp));
-
-    float compress_ms;
-    CUDA_CHECK(cudaEventElapsedTime(&compress_ms, start, end));
-
-    // compute compression ratio
-    std::vector<size_t> compressed_sizes_host(compress_data.size());
-    CUDA_CHECK(cudaMemcpy(
-        compressed_sizes_host.data(),
-        compress_data.sizes(),
-        compress_data.size() * sizeof(*compress_data.sizes()),
-        cudaMemcpyDeviceToHost));
-    size_t comp_bytes = 0;
-    for (size_t ix = 0 ; ix < batch_size; ++ix) {
-      comp_bytes += compressed_sizes_host[ix];
-    }
-
-    // Then do file output
-    if (file_output) {
-      std::vector<uint8_t> comp_data(comp_bytes);
-      std::vector<uint8_t*> comp_ptrs(batch_size);
-      cudaMemcpy(comp_ptrs.data(), compress_data.ptrs(), sizeof(size_t) * batch_size, cudaMemcpyDefault);
-      size_t ix_offset = 0;
-      for (int ix_chunk = 0; ix_chunk < batch_size; ++ix_chunk) {
-        cudaMemcpy(&comp_data[ix_offset], comp_ptrs[ix_chunk], compressed_sizes_host[ix_chunk], cudaMemcpyDefault);
-        ix_offset += compressed_sizes_host[ix_chunk];
-      }
-
-      std::ofstream outfile{output_filename.c_str(), outfile.binary};
-      outfile.write(reinterpret_cast<char*>(comp_data.data()), ix_offset);
-      outfile.close();
-    }
-
-    // LZ4 decompression
-    size_t decomp_temp_bytes;
-    status = BatchedDecompressGetTempSize(
-        compress_data.size(), chunk_size, &decomp_temp_bytes);
-    benchmark_assert(status == nvcompSuccess,
-        "BatchedDecompressGetTempSize() failed.");
-
-    void* d_decomp_temp;
-    CUDA_CHECK(cudaMalloc(&d_decomp_temp, decomp_temp_bytes));
-
-    size_t* d_decomp_sizes;
-    CUDA_CHECK(cudaMalloc(
-        &d_decomp_sizes, batch_size*sizeof(*d_decomp_sizes)));
-
-    nvcompStatus_t* d_decomp_statuses;
-    CUDA_CHECK(cudaMalloc(
-        &d_decomp_statuses, batch_size*sizeof(*d_decomp_statuses)));
-
-    std::vector<void*> h_output_ptrs(batch_size);
-    for (size_t i = 0; i < batch_size; ++i) {
-      CUDA_CHECK(cudaMalloc(&h_output_ptrs[i], h_input_sizes[i]));
-    }
-    void ** d_output_ptrs;
-    CUDA_CHECK(cudaMalloc(&d_output_ptrs, sizeof(*d_output_ptrs)*batch_size));
-    CUDA_CHECK(cudaMemcpy(d_output_ptrs, h_output_ptrs.data(),
-        sizeof(*d_output_ptrs)*batch_size, cudaMemcpyHostToDevice));
-
-    CUDA_CHECK(cudaEventRecord(start, stream));
-    status = BatchedDecompressAsync(
-        compress_data.ptrs(),
-        compress_data.sizes(),
-        input_data.sizes(),
-        d_decomp_sizes,
-        batch_size,
-        d_decomp_temp,
-        decomp_temp_bytes,
-        d_output_ptrs,
-        d_decomp_statuses,
-        stream);
-    benchmark_assert(
-        status == nvcompSuccess,
-        "BatchedDecompressAsync() not successful");
-
-    CUDA_CHECK(cudaEventRecord(end, stream));
-    CUDA_CHECK(cudaStreamSynchronize(stream));
-
-    float decompress_ms;
-    CUDA_CHECK(cudaEventElapsedTime(&decompress_ms, start, end));
-    CUDA_CHECK(cudaEventDestroy(start));
-    CUDA_CHECK(cudaEventDestroy(end));
-
-    CUDA_CHECK(cudaFree(d_output_ptrs));
-
-    // verify success each time
-    std::vector<size_t> h_decomp_sizes(batch_size);
-    CUDA_CHECK(cudaMemcpy(h_decomp_sizes.data(), d_decomp_sizes,
-      sizeof(*d_decomp_sizes)*batch_size, cudaMemcpyDeviceToHost));
-    
-    std::vector<nvcompStatus_t> h_decomp_statuses(batch_size);
-    CUDA_CHECK(cudaMemcpy(h_decomp_statuses.data(), d_decomp_statuses,
-      sizeof(*d_decomp_statuses)*batch_size, cudaMemcpyDeviceToHost));
-    for (size_t i = 0; i < batch_size; ++i) {
-      benchmark_assert(h_decomp_statuses[i] == nvcompSuccess, "Batch item not successfuly decompressed: i=" + std::to_string(i) + ": status=" +
-      std::to_string(h_decomp_statuses[i]));
-      benchmark_assert(h_decomp_sizes[i] == h_input_sizes[i], "Batch item of wrong size: i=" + std::to_string(i) + ": act_size=" +
-      std::to_string(h_decomp_sizes[i]) + " exp_size=" +
-      std::to_string(h_input_sizes[i]));
-    }
-
-    CUDA_CHECK(cudaFree(d_decomp_temp));
-    CUDA_CHECK(cudaFree(d_decomp_sizes));
-    CUDA_CHECK(cudaFree(d_decomp_statuses));
-
-    // only verify last iteration
-    if (iter + 1 == count) {
-      std::vector<void*> h_input_ptrs(batch_size);
-      CUDA_CHECK(cudaMemcpy(h_input_ptrs.data(), input_data.ptrs(),
-          sizeof(void*)*batch_size, cudaMemcpyDeviceToHost));
-      for (size_t ix_chunk = 0; ix_chunk < batch_size; ++ix_chunk) {
-        std::vector<uint8_t> exp_data(h_input_sizes[ix_chunk]);
-        CUDA_CHECK(cudaMemcpy(exp_data.data(), h_input_ptrs[ix_chunk],
-            h_input_sizes[ix_chunk], cudaMemcpyDeviceToHost));
-        std::vector<uint8_t> act_data(h_decomp_sizes[ix_chunk]);
-        CUDA_CHECK(cudaMemcpy(act_data.data(), h_output_ptrs[ix_chunk],
-        h_decomp_sizes[ix_chunk], cudaMemcpyDeviceToHost));
-        for (size_t ix_byte = 0; ix_byte < h_input_sizes[ix_chunk]; ++ix_byte) {
-          if (act_data[ix_byte] != exp_data[ix_byte]) {
-            benchmark_assert(false, "Batch item decompressed output did not match input: ix_chunk="+std::to_string(ix_chunk) + ": ix_byte=" + std::to_string(ix_byte) + " act=" + std::to_string(act_data[ix_byte]) + " exp=" +
-            std::to_string(exp_data[ix_byte]));
-          }
-        }      
-      }
-    }
-
-    for (size_t i = 0; i < batch_size; ++i) {
-      CUDA_CHECK(cudaFree(h_output_ptrs[i]));
-    }
 
     // count everything from our iteration
-    compressed_size += comp_bytes;
-    comp_time += compress_ms * 1.0e-3;
-    decomp_time += decompress_ms * 1.0e-3;
+    compressed_size += result.compressed_bytes;
+    comp_time += result.comp_time;
+    decomp_time += result.decomp_time;
+
+    if (storeRawChunks) {
+      const BatchRunResult baseline = run_batch_once(
+          BatchedCompressGetTempSize,
+          BatchedCompressGetMaxOutputChunkSize,
+          BatchedCompressAsync,
+          BatchedDecompressGetTempSize,
+          BatchedDecompressAsync,
+          format_opts,
+          input_data,
+          h_input_sizes,
+          chunk_size,
+          no_raw_flags,
+          verify,
+          false,
+          output_filename,
+          stream);
+      baseline_compressed_size += baseline.compressed_bytes;
+      baseline_comp_time += baseline.comp_time;
+      baseline_decomp_time += baseline.decomp_time;
+    }
   }
   CUDA_CHECK(cudaStreamDestroy(stream));
 
@@ -598,6 +814,9 @@ run_benchmark_template(
   compressed_size /= count;
   comp_time /= count;
   decomp_time /= count;
+  baseline_compressed_size /= count;
+  baseline_comp_time /= count;
+  baseline_decomp_time /= count;
 
   if (!warmup) {
     const double comp_ratio = (double)total_bytes / compressed_size;
@@ -615,6 +834,33 @@ run_benchmark_template(
                 << comp_ratio << std::endl;
       std::cout << "compression throughput (GB/s): " << compression_throughput_gbs << std::endl;
       std::cout << "decompression throughput (GB/s): " << decompression_throughput_gbs << std::endl;
+      if (storeRawChunks) {
+        std::cout << "stored chunks: " << raw_count << " of " << batch_size
+                  << std::endl;
+        std::cout << "pre-check throughput (GB/s): "
+                  << (double)total_bytes / (1.0e9 * precheck_time) << std::endl;
+        std::cout << "without store-raw: comp_size: "
+                  << baseline_compressed_size << ", compressed ratio: "
+                  << (double)total_bytes / baseline_compressed_size
+                  << std::endl;
+        std::cout << "compression time saved (ms): "
+                  << (baseline_comp_time - comp_time) * 1.0e3 << " of "
+                  << baseline_comp_time * 1.0e3 << std::endl;
+        std::cout << "decompression time saved (ms): "
+                  << (baseline_decomp_time - decomp_time) * 1.0e3 << " of "
+                  << baseline_decomp_time * 1.0e3 << std::endl;
+      }
+      if (chunkFilter != nvcomp::host::ShuffleFilter::None) {
+        std::cout << "filter: " << nvcomp::host::shuffle_filter_name(
+            chunkFilter) << " shuffle, element width " << filterWidth
+                  << " B" << std::endl;
+        std::cout << "filter throughput (GB/s): "
+                  << total_bytes / (1.0e9 * filter_time) << std::endl;
+        std::cout << "unfilter throughput (GB/s): "
+                  << total_bytes / (1.0e9 * unfilter_time) << std::endl;
+        print_perf_result("filter", filter_counters, total_bytes);
+        print_perf_result("unfilter", unfilter_counters, total_bytes);
+      }
     } else {
       // header
       std::cout << "Files";
@@ -628,6 +874,20 @@ run_benchmark_template(
       std::cout << separator << "Compression ratio";
       std::cout << separator << "Compression throughput (uncompressed) in GB/s";
       std::cout << separator << "Decompression throughput (uncompressed) in GB/s";
+      if (storeRawChunks) {
+        std::cout << separator << "Stored pages";
+        std::cout << separator << "Compressed size without store-raw in bytes";
+        std::cout << separator << "Compression time saved in ms";
+        std::cout << separator << "Decompression time saved in ms";
+      }
+      if (chunkFilter != nvcomp::host::ShuffleFilter::None) {
+        std::cout << separator << "Filter";
+        std::cout << separator << "Filter element width in bytes";
+        std::cout << separator << "Filter throughput in GB/s";
+        std::cout << separator << "Unfilter throughput in GB/s";
+        print_perf_csv_header(separator, "Filter");
+        print_perf_csv_header(separator, "Unfilter");
+      }
       std::cout << std::endl;
 
       // values
@@ -643,6 +903,21 @@ run_benchmark_template(
                 << comp_ratio;
       std::cout << separator << compression_throughput_gbs;
       std::cout << separator << decompression_throughput_gbs;
+      if (storeRawChunks) {
+        std::cout << separator << raw_count;
+        std::cout << separator << baseline_compressed_size;
+        std::cout << separator << (baseline_comp_time - comp_time) * 1.0e3;
+        std::cout << separator << (baseline_decomp_time - decomp_time) * 1.0e3;
+      }
+      if (chunkFilter != nvcomp::host::ShuffleFilter::None) {
+        std::cout << separator
+                  << nvcomp::host::shuffle_filter_name(chunkFilter);
+        std::cout << separator << filterWidth;
+        std::cout << separator << total_bytes / (1.0e9 * filter_time);
+        std::cout << separator << total_bytes / (1.0e9 * unfilter_time);
+        print_perf_csv_values(separator, filter_counters, total_bytes);
+        print_perf_csv_values(separator, unfilter_counters, total_bytes);
+      }
       std::cout << std::endl;
     }
   }
@@ -667,6 +942,9 @@ struct args_type {
   bool use_tabs;
   bool has_page_sizes;
   size_t chunk_size;
+  bool store_raw;
+  nvcomp::host::ShuffleFilter filter;
+  std::vector<size_t> filter_widths;
 };
 
 struct parameter_type {
@@ -722,6 +1000,9 @@ args_type parse_args(int argc, char ** argv) {
   args.use_tabs = false;
   args.has_page_sizes = false;
   args.chunk_size = 65536;
+  args.store_raw = false;
+  args.filter = nvcomp::host::ShuffleFilter::None;
+  args.filter_widths = {4};
 
   const std::vector<parameter_type> params{
     {"?", "help", "Show options.", ""},
@@ -743,6 +1024,14 @@ args_type parse_args(int argc, char ** argv) {
         "with int64 size.", bool_to_string(args.has_page_sizes)},
     {"p", "chunk_size", "Chunk size when splitting uncompressed data.",
         std::to_string(args.chunk_size)},
+    {"u", "store_raw", "Copy chunks that a host pre-check finds "
+        "incompressible instead of compressing them, and report the time "
+        "saved.", bool_to_string(args.store_raw)},
+    {"y", "filter", "Shuffle every chunk on the host before compressing it: "
+        "none, byte or bit.", nvcomp::host::shuffle_filter_name(args.filter)},
+    {"z", "filter_width", "Element width in bytes for '--filter'. A comma "
+        "separated list, e.g. 2,4,8, runs the benchmark once per width.",
+        std::to_string(args.filter_widths.front())},
   };
 
   char** argv_end = argv + argc;
@@ -804,6 +1093,35 @@ args_type parse_args(int argc, char ** argv) {
         } else if (param.long_flag == "chunk_size") {
           args.chunk_size = size_t(std::stoull(*(argv++)));
           break;
+        } else if (param.long_flag == "store_raw") {
+          std::string on(*(argv++));
+          args.store_raw = parse_bool(on);
+          break;
+        } else if (param.long_flag == "filter") {
+          try {
+            args.filter = nvcomp::host::shuffle_filter_from_name(*(argv++));
+          } catch (const std::runtime_error& e) {
+            std::cerr << "ERROR: " << e.what() << std::endl;
+            std::exit(1);
+          }
+          break;
+        } else if (param.long_flag == "filter_width") {
+          args.filter_widths.clear();
+          std::istringstream widths(*(argv++));
+          std::string width;
+          while (std::getline(widths, width, ',')) {
+            args.filter_widths.push_back(size_t(std::stoull(width)));
+            if (args.filter_widths.back() == 0) {
+              std::cerr << "ERROR: Filter widths must be positive."
+                        << std::endl;
+              std::exit(1);
+            }
+          }
+          if (args.filter_widths.empty()) {
+            std::cerr << "ERROR: Missing filter width." << std::endl;
+            std::exit(1);
+          }
+          break;
         } else {
           std::cerr << "INTERNAL ERROR: Unhandled paramter '" << arg << "'." << std::endl;
           usage(name, params);
@@ -831,19 +1149,29 @@ args_type parse_args(int argc, char ** argv) {
 int main(int argc, char** argv)
 {
   args_type args = parse_args(argc, argv);
+  NVCOMP_TRACE_SESSION();
 
   CUDA_CHECK(cudaSetDevice(args.gpu));
+  storeRawChunks = args.store_raw;
+  chunkFilter = args.filter;
+  filterWidth = args.filter_widths.front();
 
-  auto data = multi_file(args.filenames, args.chunk_size, args.has_page_sizes,
+  auto data = nvcomp::host::multi_file(args.filenames, args.chunk_size, args.has_page_sizes,
       args.duplicate_count);
 
   // one warmup to allow cuda to initialize
   run_benchmark(data, true, args.warmup_count, false, false,
       args.duplicate_count, args.filenames.size());
 
-  // second run to report times
-  run_benchmark(data, false, args.iteration_count, args.csv_output,
-      args.use_tabs, args.duplicate_count, args.filenames.size());
+  // second run to report times, once per filter width
+  for (const size_t width : args.filter_widths) {
+    filterWidth = width;
+    run_benchmark(data, false, args.iteration_count, args.csv_output,
+        args.use_tabs, args.duplicate_count, args.filenames.size());
+    if (chunkFilter == nvcomp::host::ShuffleFilter::None) {
+      break;
+    }
+  }
 
   return 0;
 }
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Predict when compressing data before sending it over a link pays off,
+// from the measured ratio and throughputs of each host codec, and check the
+// predictions against a link simulated with throttled memcpy.
+
+#include "host/file_io.h"
+#include "host/transfer_model.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace nvcomp::host;
+
+static void print_usage()
+{
+  printf("Usage: benchmark_transfer_model [OPTIONS]\n");
+  printf("  %-35s Binary dataset filename(s) (required).\n", "-f, --input_file");
+  printf("  %-35s Chunk size when splitting input (default 64 kB).\n", "-p, --chunk_size");
+  printf("  %-35s Codec(s): lz4, deflate, stored or all (default all).\n", "-c, --codecs");
+  printf("  %-35s Link bandwidths in GB/s (default 0.1,0.5,1,2,5).\n", "-w, --bandwidths");
+  printf("  %-35s Bytes of input to send over the simulated link (default 32 MB).\n", "-v, --validate_bytes");
+  printf("  %-35s Number of measurement iterations (default 3).\n", "-i, --iteration_count");
+  printf("  %-35s Output in CSV format.\n", "-x, --csv");
+}
+
+static std::vector<std::string> split_list(const std::string& text)
+{
+  std::vector<std::string> items;
+  std::istringstream list(text);
+  std::string item;
+  while (std::getline(list, item, ',')) {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+static double percent_error(const double predicted, const double measured)
+{
+  return 100.0 * (predicted - measured) / measured;
+}
+
+int main(int argc, char* argv[])
+{
+  std::vector<std::string> filenames;
+  size_t chunk_size = 1 << 16;
+  std::string codec_list = "all";
+  std::string bandwidth_list = "0.1,0.5,1,2,5";
+  size_t validate_bytes = 32 << 20;
+  int iterations = 3;
+  bool csv = false;
+
+  char** argv_end = argv + argc;
+  argv += 1;
+  while (argv != argv_end) {
+    char* arg = *argv++;
+    if (strcmp(arg, "--help") == 0 || strcmp(arg, "-?") == 0) {
+      print_usage();
+      return 1;
+    }
+    if (strcmp(arg, "--csv") == 0 || strcmp(arg, "-x") == 0) {
+      csv = true;
+      continue;
+    }
+
+    // all arguments below require at least a second value in argv
+    if (argv >= argv_end) {
+      print_usage();
+      return 1;
+    }
+
+    if (strcmp(arg, "--input_file") == 0 || strcmp(arg, "-f") == 0) {
+      // read all following arguments until a new flag is found
+      while (argv != argv_end && (*argv)[0] != '-') {
+        filenames.emplace_back(*argv++);
+      }
+      continue;
+    }
+
+    char* optarg = *argv++;
+    if (strcmp(arg, "--chunk_size") == 0 || strcmp(arg, "-p") == 0) {
+      chunk_size = strtoull(optarg, nullptr, 10);
+      continue;
+    }
+    if (strcmp(arg, "--codecs") == 0 || strcmp(arg, "-c") == 0) {
+      codec_list = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--bandwidths") == 0 || strcmp(arg, "-w") == 0) {
+      bandwidth_list = optarg;
+      continue;
+    }
+    if (strcmp(arg, "--validate_bytes") == 0 || strcmp(arg, "-v") == 0) {
+      validate_bytes = strtoull(optarg, nullptr, 10);
+      continue;
+    }
+    if (strcmp(arg, "--iteration_count") == 0 || strcmp(arg, "-i") == 0) {
+      iterations = atoi(optarg);
+      continue;
+    }
+    print_usage();
+    return 1;
+  }
+
+  if (filenames.empty() || chunk_size == 0 || iterations <= 0) {
+    print_usage();
+    return 1;
+  }
+
+  std::vector<double> bandwidths;
+  for (const std::string& item : split_list(bandwidth_list)) {
+    const double gbs = atof(item.c_str());
+    if (!(gbs > 0)) {
+      std::cerr << "Bandwidths must be positive." << std::endl;
+      return 1;
+    }
+    bandwidths.push_back(gbs * 1e9);
+  }
+
+  std::vector<std::shared_ptr<const HostCodec>> codecs;
+  if (codec_list == "all") {
+    for (const HostCodecId id : {HostCodecId::LZ4, HostCodecId::Deflate}) {
+      if (host_codec_available(id)) {
+        codecs.push_back(make_host_codec(id));
+      }
+    }
+  } else {
+    for (const std::string& item : split_list(codec_list)) {
+      codecs.push_back(make_host_codec(item));
+    }
+  }
+  if (codecs.empty()) {
+    std::cerr << "No host codecs are available in this build." << std::endl;
+    return 1;
+  }
+
+  const std::vector<std::vector<char>> data
+      = multi_file(filenames, chunk_size, false, 0);
+  std::vector<std::vector<uint8_t>> chunks;
+  size_t total_bytes = 0;
+  for (const std::vector<char>& chunk : data) {
+    chunks.emplace_back(chunk.begin(), chunk.end());
+    total_bytes += chunk.size();
+  }
+  // The simulated transfers take real time, so only send a prefix.
+  std::vector<std::vector<uint8_t>> validate_chunks;
+  size_t validated = 0;
+  for (size_t i = 0; i < chunks.size() && validated < validate_bytes; ++i) {
+    validate_chunks.push_back(chunks[i]);
+    validated += chunks[i].size();
+  }
+
+  std::vector<CodecMeasurement> measurements;
+  for (const std::shared_ptr<const HostCodec>& codec : codecs) {
+    measurements.push_back(measure_codec(*codec, chunks, iterations));
+  }
+
+  const char sep = ',';
+  std::cout << "----------" << std::endl;
+  std::cout << "files: " << filenames.size() << std::endl;
+  std::cout << "uncompressed (B): " << total_bytes << std::endl;
+  std::cout << "validated (B): " << validated << std::endl;
+
+  // Model parameters and crossover bandwidths per codec.
+  if (csv) {
+    std::cout << "codec" << sep << "ratio" << sep << "compression (GB/s)"
+              << sep << "decompression (GB/s)" << sep
+              << "serial crossover (GB/s)" << sep
+              << "pipelined crossover (GB/s)" << std::endl;
+  } else {
+    std::cout << std::setw(9) << "codec" << std::setw(8) << "ratio"
+              << std::setw(11) << "comp GB/s" << std::setw(13)
+              << "decomp GB/s" << std::setw(22) << "serial crossover GB/s"
+              << std::setw(25) << "pipelined crossover GB/s" << std::endl;
+  }
+  for (const CodecMeasurement& m : measurements) {
+    if (csv) {
+      std::cout << m.name << sep << m.ratio << sep
+                << m.compress_throughput * 1e-9 << sep
+                << m.decompress_throughput * 1e-9 << sep
+                << serial_crossover_bandwidth(m) * 1e-9 << sep
+                << pipelined_crossover_bandwidth(m) * 1e-9 << std::endl;
+    } else {
+      std::cout << std::fixed << std::setprecision(3) << std::setw(9)
+                << m.name << std::setw(8) << m.ratio << std::setw(11)
+                << m.compress_throughput * 1e-9 << std::setw(13)
+                << m.decompress_throughput * 1e-9 << std::setw(22)
+                << serial_crossover_bandwidth(m) * 1e-9 << std::setw(25)
+                << pipelined_crossover_bandwidth(m) * 1e-9 << std::endl;
+    }
+  }
+
+  // Predicted and measured effective rates per bandwidth and codec.
+  std::cout << std::endl;
+  if (csv) {
+    std::cout << "bandwidth (GB/s)" << sep << "codec" << sep
+              << "uncompressed (GB/s)" << sep << "serial predicted (GB/s)"
+              << sep << "serial measured (GB/s)" << sep << "serial error (%)"
+              << sep << "pipelined predicted (GB/s)" << sep
+              << "pipelined measured (GB/s)" << sep << "pipelined error (%)"
+              << sep << "best" << std::endl;
+  } else {
+    std::cout << std::setw(8) << "link" << std::setw(9) << "codec"
+              << std::setw(8) << "raw" << std::setw(11) << "serial"
+              << std::setw(10) << "measured" << std::setw(8) << "err%"
+              << std::setw(11) << "pipelined" << std::setw(10) << "measured"
+              << std::setw(8) << "err%" << std::setw(11) << "best"
+              << "   (GB/s)" << std::endl;
+  }
+  for (const double bandwidth : bandwidths) {
+    const double raw_rate
+        = validated / simulate_transfer(nullptr, validate_chunks, bandwidth, false);
+    for (size_t c = 0; c < codecs.size(); ++c) {
+      const CodecMeasurement& m = measurements[c];
+      const TransferPrediction predicted = predict_transfer(m, bandwidth);
+      const double serial = validated
+                            / simulate_transfer(
+                                codecs[c].get(), validate_chunks, bandwidth, false);
+      const double pipelined = validated
+                               / simulate_transfer(
+                                   codecs[c].get(), validate_chunks, bandwidth, true);
+
+      std::string best = "raw";
+      if (std::max(serial, pipelined) > raw_rate) {
+        best = serial > pipelined ? "serial" : "pipelined";
+      }
+
+      if (csv) {
+        std::cout << bandwidth * 1e-9 << sep << m.name << sep
+                  << raw_rate * 1e-9 << sep << predicted.serial_rate * 1e-9
+                  << sep << serial * 1e-9 << sep
+                  << percent_error(predicted.serial_rate, serial) << sep
+                  << predicted.pipelined_rate * 1e-9 << sep
+                  << pipelined * 1e-9 << sep
+                  << percent_error(predicted.pipelined_rate, pipelined) << sep
+                  << best << std::endl;
+      } else {
+        std::cout << std::fixed << std::setprecision(3) << std::setw(8)
+                  << bandwidth * 1e-9 << std::setw(9) << m.name
+                  << std::setw(8) << raw_rate * 1e-9 << std::setw(11)
+                  << predicted.serial_rate * 1e-9 << std::setw(10)
+                  << serial * 1e-9 << std::setprecision(1) << std::setw(8)
+                  << percent_error(predicted.serial_rate, serial)
+                  << std::setprecision(3) << std::setw(11)
+                  << predicted.pipelined_rate * 1e-9 << std::setw(10)
+                  << pipelined * 1e-9 << std::setprecision(1) << std::setw(8)
+                  << percent_error(predicted.pipelined_rate, pipelined)
+                  << std::setw(11) << best << std::endl;
+      }
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Profile the compressibility of input files, split into chunks the same way
+// as the chunked benchmarks, and recommend a format to benchmark.
+
+#include "host/data_profiler.h"
+#include "host/file_io.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace nvcomp::host;
+
+static void print_usage()
+{
+  printf("Usage: data_profiler [OPTIONS]\n");
+  printf("  %-35s Binary dataset filename(s) (required).\n", "-f, --input_file");
+  printf("  %-35s Chunk size when splitting input (default 64 kB).\n", "-p, --chunk_size");
+  printf("  %-35s Files contain pages, each prefixed with int64 size (default false).\n", "-s, --file_with_page_sizes");
+  printf("  %-35s Number of profiling threads (default all cores).\n", "-n, --num_threads");
+  printf("  %-35s Test every n-th byte for LZ matches (default 1).\n", "-l, --lz_stride");
+  printf("  %-35s Write the profile as JSON to this file ('-' for stdout).\n", "-j, --json");
+  printf("  %-35s Print the profile of every chunk.\n", "-v, --verbose");
+}
+
+static void print_profile(const DataProfile& profile)
+{
+  std::cout << "bytes: " << profile.bytes << std::endl;
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "byte entropy (bits/B): " << profile.byte_entropy << std::endl;
+  std::cout << "zero fraction: " << profile.zero_fraction << std::endl;
+  std::cout << "lz match density: " << profile.match_density << std::endl;
+  std::cout << "width  delta_entropy  mean_run  for_bits  delta_for_bits"
+            << std::endl;
+  for (size_t w = 0; w < PROFILE_NUM_WIDTHS; ++w) {
+    const WidthProfile& wp = profile.widths[w];
+    if (!wp.aligned) {
+      std::cout << std::setw(5) << PROFILE_WIDTHS[w] << "  (unaligned)"
+                << std::endl;
+      continue;
+    }
+    std::cout << std::setw(5) << PROFILE_WIDTHS[w] << std::setw(15)
+              << wp.delta_entropy << std::setw(10) << wp.mean_run_length
+              << std::setw(10) << wp.for_bits << std::setw(16)
+              << wp.delta_for_bits << std::endl;
+  }
+}
+
+static void print_recommendation(const FormatRecommendation& rec)
+{
+  std::cout << "recommended format: " << rec.format;
+  if (rec.format == "cascaded") {
+    std::cout << " -t " << rec.data_type << " -r " << rec.num_RLEs << " -d "
+              << rec.num_deltas << " -b " << rec.use_bp;
+  }
+  std::cout << std::endl
+            << "estimated ratio: " << std::fixed << std::setprecision(2)
+            << rec.estimated_ratio << " (" << rec.reason << ")" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  std::vector<std::string> filenames;
+  size_t chunk_size = 1 << 16;
+  bool has_page_sizes = false;
+  size_t num_threads = 0;
+  bool verbose = false;
+  std::string json_filename;
+  HostProfileOptions opts = HostProfileDefaultOpts;
+
+  char** argv_end = argv + argc;
+  argv += 1;
+  while (argv != argv_end) {
+    char* arg = *argv++;
+    if (strcmp(arg, "--help") == 0 || strcmp(arg, "-?") == 0) {
+      print_usage();
+      return 1;
+    }
+    if (strcmp(arg, "--verbose") == 0 || strcmp(arg, "-v") == 0) {
+      verbose = true;
+      continue;
+    }
+
+    // all arguments below require at least a second value in argv
+    if (argv >= argv_end) {
+      print_usage();
+      return 1;
+    }
+
+    if (strcmp(arg, "--input_file") == 0 || strcmp(arg, "-f") == 0) {
+      // read all following arguments until a new flag is found
+      while (argv != argv_end && (*argv)[0] != '-') {
+        filenames.emplace_back(*argv++);
+      }
+      continue;
+    }
+
+    char* optarg = *argv++;
+    if (strcmp(arg, "--chunk_size") == 0 || strcmp(arg, "-p") == 0) {
+      chunk_size = strtoull(optarg, nullptr, 10);
+      continue;
+    }
+    if (strcmp(arg, "--file_with_page_sizes") == 0 || strcmp(arg, "-s") == 0) {
+      has_page_sizes = strcmp(optarg, "true") == 0;
+      continue;
+    }
+    if (strcmp(arg, "--num_threads") == 0 || strcmp(arg, "-n") == 0) {
+      num_threads = strtoull(optarg, nullptr, 10);
+      continue;
+    }
+    if (strcmp(arg, "--lz_stride") == 0 || strcmp(arg, "-l") == 0) {
+      opts.lz_sample_stride = strtoull(optarg, nullptr, 10);
+      continue;
+    }
+    if (strcmp(arg, "--json") == 0 || strcmp(arg, "-j") == 0) {
+      json_filename = optarg;
+      continue;
+    }
+    print_usage();
+    return 1;
+  }
+
+  if (filenames.empty() || chunk_size == 0) {
+    print_usage();
+    return 1;
+  }
+
+  const std::vector<std::vector<char>> data
+      = multi_file(filenames, chunk_size, has_page_sizes, 0);
+
+  ThreadPool pool(num_threads);
+
+  auto start = std::chrono::steady_clock::now();
+  const BatchProfile profile = profile_batch(data, pool, opts);
+  auto end = std::chrono::steady_clock::now();
+
+  const FormatRecommendation rec = recommend_format(profile.aggregate);
+
+  std::vector<FormatRecommendation> chunk_recs(data.size());
+  for (size_t i = 0; i < data.size(); ++i) {
+    chunk_recs[i] = recommend_format(profile.chunks[i]);
+  }
+
+  std::cout << "----------" << std::endl;
+  std::cout << "files: " << filenames.size() << std::endl;
+  std::cout << "chunks: " << data.size() << std::endl;
+  print_profile(profile.aggregate);
+  print_recommendation(rec);
+  std::cout << "profiling throughput (GB/s): " << std::fixed
+            << std::setprecision(2)
+            << (double)profile.aggregate.bytes
+                   / std::chrono::nanoseconds(end - start).count()
+            << std::endl;
+
+  if (verbose) {
+    for (size_t i = 0; i < data.size(); ++i) {
+      const DataProfile& p = profile.chunks[i];
+      std::cout << "chunk " << i << ": entropy=" << std::setprecision(3)
+                << p.byte_entropy << " zeros=" << p.zero_fraction
+                << " matches=" << p.match_density
+                << " -> " << chunk_recs[i].format;
+      if (chunk_recs[i].format == "cascaded") {
+        std::cout << " (" << chunk_recs[i].data_type << " "
+                  << chunk_recs[i].num_RLEs << " " << chunk_recs[i].num_deltas
+                  << " " << chunk_recs[i].use_bp << ")";
+      }
+      std::cout << std::endl;
+    }
+  }
+
+  if (!json_filename.empty()) {
+    std::ofstream json_file;
+    if (json_filename != "-") {
+      json_file.open(json_filename);
+      if (!json_file) {
+        std::cerr << "ERROR: Unable to open \"" << json_filename
+                  << "\" for writing." << std::endl;
+        return 1;
+      }
+    }
+    std::ostream& os = json_filename == "-" ? std::cout : json_file;
+    os << "{\"chunk_size\": " << chunk_size << ",\n \"aggregate\": "
+       << to_json(profile.aggregate) << ",\n \"recommendation\": "
+       << to_json(rec) << ",\n \"chunks\": [";
+    for (size_t i = 0; i < data.size(); ++i) {
+      os << (i == 0 ? "\n  " : ",\n  ") << "{\"profile\": "
+         << to_json(profile.chunks[i])
+         << ", \"recommendation\": " << to_json(chunk_recs[i]) << "}";
+    }
+    os << "]}" << std::endl;
+  }
+
+  return 0;
+}
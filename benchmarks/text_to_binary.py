@@ -54,8 +54,9 @@ if len(sys.argv) != 5 and len(sys.argv) != 6:
     print("(a comma-separated values file by default), into a binary file.")
     print()
     print("The <column choice> should be an integer in the range [0, N-1], where N is the number of columns.") 
-    print("The <datatype> option should be one of 'int', 'long', 'float', 'double', or 'string'.")
+    print("The <datatype> option should be one of 'int', 'long', 'float', 'double', 'string', or 'text'.")
     print("'string' keeps the text, converting it to UTF-16 with no separators between the values.")
+    print("'text' keeps the text as UTF-8, ending every value with a newline, as benchmark_dictionary reads it.")
     print("The [delimiter] is an optional argument, and defaults to '%s'" % delimiter)
     print("Some delimiters may need to be surrounded by quotation marks or prefixed by a backslash, depending on")
     print("the shell, for example space, semicolon, or vertical pipe, due to the command line parsing")
@@ -86,10 +87,10 @@ elif datatype == "float":
     dtype = "float32"
 elif datatype == "double":
     dtype = "float64"
-elif datatype == "string":
+elif datatype == "string" or datatype == "text":
     dtype = "str"
 else:
-    print("Please select datatype int, long, float, double, or string")
+    print("Please select datatype int, long, float, double, string, or text")
     exit()
 
 
@@ -109,7 +110,11 @@ with open(str(in_fname), "r") as inFile:
                     # don't warn about an empty file after we have read something
                     warnings.filterwarnings('ignore', r'genfromtxt: Empty input file:')
 
-                if in_data.size > 0:
+                if in_data.size > 0 and datatype == "text":
+                    for value in in_data.reshape(-1):
+                        newFile.write((str(value) + "\n").encode("utf-8"))
+                    offset += in_data.size
+                elif in_data.size > 0:
                     in_data.tofile(newFile)
                     offset += in_data.size
                 else:
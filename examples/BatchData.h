@@ -105,9 +105,21 @@ public:
     if (copy_data) {
       const void* const* src = batch_data.ptrs();
       const size_t* bytes = batch_data.sizes();
-      for (size_t i = 0; i < size(); ++i)
-        CUDA_CHECK(
-            cudaMemcpy(ptrs[i], src[i], bytes[i], cudaMemcpyHostToDevice));
+      // A compacted batch goes over in a single transfer.
+      bool contiguous = true;
+      for (size_t i = 1; i < size() && contiguous; ++i) {
+        contiguous = static_cast<const uint8_t*>(src[i])
+                     == static_cast<const uint8_t*>(src[i - 1]) + bytes[i - 1];
+      }
+      if (contiguous) {
+        if (data_size > 0)
+          CUDA_CHECK(cudaMemcpy(
+              data(), src[0], data_size, cudaMemcpyHostToDevice));
+      } else {
+        for (size_t i = 0; i < size(); ++i)
+          CUDA_CHECK(
+              cudaMemcpy(ptrs[i], src[i], bytes[i], cudaMemcpyHostToDevice));
+      }
     }
   }
 
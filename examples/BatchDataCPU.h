@@ -28,15 +28,23 @@
 
 #pragma once
 #include "util.h"
+#include "host/compaction.h"
+#include "host/host_allocator.h"
+#include "host/thread_pool.h"
 
 class BatchData;
 
 class BatchDataCPU
 {
 public:
+  // Split `host_data` into chunks of at most `chunk_size` bytes. With
+  // `copy_data` the chunks are copied, in parallel, into storage owned by the
+  // batch. Without it the batch is a view of `host_data`, which must then
+  // outlive it, and `data()` is null.
   BatchDataCPU(
       const std::vector<std::vector<char>>& host_data,
-      const size_t chunk_size) :
+      const size_t chunk_size,
+      const bool copy_data = true) :
       m_ptrs(),
       m_sizes(),
       m_data(),
@@ -45,9 +53,17 @@ public:
     m_size = compute_batch_size(host_data, chunk_size);
     m_sizes = compute_chunk_sizes(host_data, m_size, chunk_size);
 
+    std::vector<void*> src = get_input_ptrs(host_data, size(), chunk_size);
+    if (!copy_data) {
+      m_ptrs = std::move(src);
+      return;
+    }
+
     size_t data_size = std::accumulate(
         m_sizes.begin(), m_sizes.end(), static_cast<size_t>(0));
-    m_data = std::vector<uint8_t>(data_size);
+    // Every byte is copied below, so the storage is not zero-filled first.
+    m_data = nvcomp::host::HostBuffer(
+        data_size, nvcomp::host::HugePages::None, false);
 
     size_t offset = 0;
     m_ptrs = std::vector<void*>(size());
@@ -56,18 +72,34 @@ public:
       offset += m_sizes[i];
     }
 
-    std::vector<void*> src = get_input_ptrs(host_data, size(), chunk_size);
-    for (size_t i = 0; i < size(); ++i)
-      std::memcpy(m_ptrs[i], src[i], m_sizes[i]);
+    // Small batches are not worth waking the pool for.
+    const size_t min_parallel_bytes = 1 << 24;
+    if (data_size < min_parallel_bytes) {
+      for (size_t i = 0; i < size(); ++i)
+        std::memcpy(m_ptrs[i], src[i], m_sizes[i]);
+    } else {
+      nvcomp::host::default_thread_pool().parallel_for(
+          size(), [this, &src](const size_t i) {
+            std::memcpy(m_ptrs[i], src[i], m_sizes[i]);
+          });
+    }
   }
 
-  BatchDataCPU(const size_t max_output_size, const size_t batch_size) :
+  // Allocate output space. The buffer is not zero-filled, as it is about to
+  // be overwritten, and can be backed by huge pages, which saves page faults
+  // and TLB misses on large batches.
+  BatchDataCPU(
+      const size_t max_output_size,
+      const size_t batch_size,
+      const nvcomp::host::HugePages huge_pages
+      = nvcomp::host::HugePages::None) :
       m_ptrs(),
       m_sizes(),
       m_data(),
       m_size(batch_size)
   {
-    m_data = std::vector<uint8_t>(max_output_size * size());
+    m_data = nvcomp::host::HostBuffer(
+        max_output_size * size(), huge_pages, false);
 
     m_sizes = std::vector<size_t>(size(), max_output_size);
 
@@ -95,7 +127,10 @@ public:
 
     size_t data_size
         = std::accumulate(sizes(), sizes() + size(), static_cast<size_t>(0));
-    m_data = std::vector<uint8_t>(data_size);
+    // Without `copy_data` this is output space, so in neither case does it
+    // need to be zero-filled.
+    m_data = nvcomp::host::HostBuffer(
+        data_size, nvcomp::host::HugePages::None, false);
 
     size_t offset = 0;
     m_ptrs = std::vector<void*>(size());
@@ -157,10 +192,24 @@ public:
     return m_size;
   }
 
+  // Move the chunks back to back at the start of the owned buffer, e.g. once
+  // compression has set the actual sizes of worst-case sized output chunks,
+  // so that the batch can be written or transferred as one contiguous range
+  // of `sizes()` summed bytes. Returns the offset of every chunk, plus the
+  // total. The buffer itself keeps its size.
+  std::vector<size_t> compact()
+  {
+    if (size() > 0 && data() == nullptr) {
+      throw std::runtime_error("Cannot compact a view of host data.");
+    }
+    return nvcomp::host::compact_chunks_in_place(
+        nvcomp::host::default_thread_pool(), data(), ptrs(), sizes(), size());
+  }
+
 private:
   std::vector<void*> m_ptrs;
   std::vector<size_t> m_sizes;
-  std::vector<uint8_t> m_data;
+  nvcomp::host::HostBuffer m_data;
   size_t m_size;
 };
 
@@ -26,6 +26,8 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
  #include "BatchData.h"
+ #include "host/perf_counters.h"
+ #include "host/trace.h"
  #include "zlib.h"
  #include "libdeflate.h"
  #include "nvcomp/deflate.h"
@@ -44,8 +46,8 @@
  
    const size_t chunk_size = 1 << 16;
  
-   // build up input batch on CPU
-   BatchDataCPU input_data_cpu(data, chunk_size);
+   // build up input batch on CPU, as a view of the loaded data
+   BatchDataCPU input_data_cpu(data, chunk_size, false);
    std::cout << "chunks: " << input_data_cpu.size() << std::endl;
  
    // compression
@@ -54,8 +56,12 @@
    BatchDataCPU compress_data_cpu(
        chunk_size, input_data_cpu.size());
  
-   // loop over chunks on the CPU, compressing each one
+   // loop over chunks on the CPU, compressing each one, with hardware
+   // counters if the platform allows them
+   nvcomp::host::PerfCounters perf;
+   perf.start();
    for (size_t i = 0; i < input_data_cpu.size(); ++i) {
+     NVCOMP_TRACE_SCOPE("compress chunk");
      int actual_len = 0;
      if(algo==0){ //libdeflate
        struct libdeflate_compressor *compressor;
@@ -102,6 +108,7 @@
     // set the actual compressed size
     compress_data_cpu.sizes()[i] = actual_len;
    }
+   const nvcomp::host::PerfSample compress_counters = perf.stop();
  
    // compute compression ratio
    size_t* compressed_sizes_host = compress_data_cpu.sizes();
@@ -112,8 +119,11 @@
    std::cout << "comp_size: " << comp_bytes
              << ", compressed ratio: " << std::fixed << std::setprecision(2)
              << (double)total_bytes / comp_bytes << std::endl;
+   nvcomp::host::print_perf_sample(
+       std::cout, "compression", compress_counters, total_bytes);
  
-   // Copy compressed data to GPU
+   // Pack the compressed chunks back to back and copy them to GPU in one go
+   compress_data_cpu.compact();
    BatchData compress_data(compress_data_cpu, true);
  
    // Allocate and build up decompression batch on GPU
@@ -205,6 +215,7 @@
  
  std::vector<char> readFile(const std::string& filename)
  {
+   NVCOMP_TRACE_SCOPE("load");
    std::vector<char> buffer(4096);
    std::vector<char> host_data;
  
@@ -234,6 +245,7 @@
  
  int main(int argc, char* argv[])
  {
+   NVCOMP_TRACE_SESSION();
    std::vector<std::string> file_names;
  
    if (argc < 5) {
@@ -27,6 +27,8 @@
  */
 
  #include "BatchData.h"
+ #include "host/perf_counters.h"
+ #include "host/trace.h"
  #include "zlib.h"
  #include "libdeflate.h"
  #include "nvcomp/deflate.h"
@@ -137,8 +139,12 @@
    BatchDataCPU compress_data_cpu = GetBatchDataCPU(compress_data, true);
    BatchDataCPU decompress_data_cpu = GetBatchDataCPU(input_data, false);
 
-   // loop over chunks on the CPU, decompressing each one
+   // loop over chunks on the CPU, decompressing each one, with hardware
+   // counters if the platform allows them
+   nvcomp::host::PerfCounters perf;
+   perf.start();
    for (size_t i = 0; i < input_data.size(); ++i) {
+     NVCOMP_TRACE_SCOPE("decompress chunk");
      if(algo==0){
          struct libdeflate_decompressor  *decompressor;
          decompressor = libdeflate_alloc_decompressor();
@@ -174,11 +180,14 @@
          }
      }
    }
+   const nvcomp::host::PerfSample decompress_counters = perf.stop();
    // Validate decompressed data against input
    if (!(decompress_data_cpu == input_data))
      throw std::runtime_error("Failed to validate CPU decompressed data");
    else
      std::cout << "CPU decompression validated :)" << std::endl;
+   nvcomp::host::print_perf_sample(
+       std::cout, "CPU decompression", decompress_counters, total_bytes);
  
    cudaEventDestroy(start);
    cudaEventDestroy(end);
@@ -187,6 +196,7 @@
  
  std::vector<char> readFile(const std::string& filename)
  {
+   NVCOMP_TRACE_SCOPE("load");
    std::vector<char> buffer(4096);
    std::vector<char> host_data;
  
@@ -216,6 +226,7 @@
  
  int main(int argc, char* argv[])
  {
+  NVCOMP_TRACE_SESSION();
   std::vector<std::string> file_names;
  
   if (argc < 5) {
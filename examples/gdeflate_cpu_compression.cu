@@ -44,8 +44,8 @@ static void run_example(const std::vector<std::vector<char>>& data)
 
   const size_t chunk_size = 1 << 16;
 
-  // build up input batch on CPU
-  BatchDataCPU input_data_cpu(data, chunk_size);
+  // build up input batch on CPU, as a view of the loaded data
+  BatchDataCPU input_data_cpu(data, chunk_size, false);
   std::cout << "chunks: " << input_data_cpu.size() << std::endl;
 
   // compression
@@ -81,7 +81,8 @@ static void run_example(const std::vector<std::vector<char>>& data)
             << ", compressed ratio: " << std::fixed << std::setprecision(2)
             << (double)total_bytes / comp_bytes << std::endl;
 
-  // Copy compressed data to GPU
+  // Pack the compressed chunks back to back and copy them to GPU in one go
+  compress_data_cpu.compact();
   BatchData compress_data(compress_data_cpu, true);
 
   // Allocate and build up decompression batch on GPU
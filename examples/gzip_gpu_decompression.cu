@@ -26,7 +26,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
  #include "BatchData.h"
- #include "zlib.h"
+ #include "host/pgzip.h"
  #include "nvcomp/gzip.h"
 
  // Benchmark performance from the binary data file fname
@@ -43,41 +43,50 @@
  
    const size_t chunk_size = 1 << 16;
  
-   // build up input batch on CPU
-   BatchDataCPU input_data_cpu(data, chunk_size);
+   // build up input batch on CPU, as a view of the loaded data
+   BatchDataCPU input_data_cpu(data, chunk_size, false);
    std::cout << "chunks: " << input_data_cpu.size() << std::endl;
  
    // compression
  
-   // Allocate and prepare output/compressed batch
-   BatchDataCPU compress_data_cpu(
-       chunk_size, input_data_cpu.size());
- 
-   // loop over chunks on the CPU, compressing each one
-   for (size_t i = 0; i < input_data_cpu.size(); ++i) {
-    //zlib::deflate
-    z_stream zs;
-    zs.zalloc = NULL; zs.zfree = NULL;
-    zs.msg = NULL;
-    zs.next_in  = (Bytef *)input_data_cpu.ptrs()[i];
-    zs.avail_in = input_data_cpu.sizes()[i];
-    zs.next_out = (Bytef *)compress_data_cpu.ptrs()[i];
-    zs.avail_out = input_data_cpu.sizes()[i];
-    int strategy=Z_DEFAULT_STRATEGY; //Z_HUFFMAN_ONLY //Z_FIXED, Z_DEFAULT_STRATEGY 
-    // -15 to disable zlib header/footer
-    // 15|16 to enable gzip header
-    int ret = deflateInit2(&zs, 9, Z_DEFLATED, 15|16, 8, strategy);
-    if (ret!=Z_OK) {
-        throw std::runtime_error("Call to deflateInit2 failed: " + std::to_string(ret));
-    }
-    if ((ret = deflate(&zs, Z_FINISH)) != Z_STREAM_END) {
-        throw std::runtime_error("Gzip operation failed: " + std::to_string(ret));
-    }
-    if ((ret = deflateEnd(&zs)) != Z_OK) {
-        throw std::runtime_error("Call to deflateEnd failed: " + std::to_string(ret));
-    }
-    // set the actual compressed size
-    compress_data_cpu.sizes()[i] = zs.total_out;;
+   // Gzip each file on all CPU cores, as one independent gzip member per
+   // chunk, so the members line up with the chunks of `input_data_cpu`.
+   nvcomp::host::ThreadPool pool;
+   nvcomp::host::PgzipOptions options = nvcomp::host::PgzipDefaultOpts;
+   options.level = 9;
+   options.chunk_size = chunk_size;
+   std::vector<std::vector<uint8_t>> gz_files;
+   std::vector<nvcomp::host::PgzipIndex> indices;
+   size_t max_member_bytes = 0;
+   for (const std::vector<char>& part : data) {
+     // Empty files have no chunks in the batch.
+     if (part.empty()) {
+       continue;
+     }
+     indices.emplace_back();
+     gz_files.push_back(nvcomp::host::pgzip_compress(
+         pool, part.data(), part.size(), options, &indices.back()));
+     for (const nvcomp::host::PgzipEntry& entry : indices.back().entries) {
+       max_member_bytes = std::max<size_t>(
+           max_member_bytes, entry.compressed_bytes);
+     }
+   }
+ 
+   // Allocate the compressed batch, and split the files by member into it
+   BatchDataCPU compress_data_cpu(max_member_bytes, input_data_cpu.size());
+   size_t member = 0;
+   for (size_t f = 0; f < gz_files.size(); ++f) {
+     for (const nvcomp::host::PgzipEntry& entry : indices[f].entries) {
+       std::memcpy(
+           compress_data_cpu.ptrs()[member],
+           gz_files[f].data() + entry.compressed_offset,
+           entry.compressed_bytes);
+       compress_data_cpu.sizes()[member] = entry.compressed_bytes;
+       ++member;
+     }
+   }
+   if (member != compress_data_cpu.size()) {
+     throw std::runtime_error("Gzip members don't match the input chunks.");
    }
  
    // compute compression ratio
@@ -90,7 +99,8 @@
              << ", compressed ratio: " << std::fixed << std::setprecision(2)
              << (double)total_bytes / comp_bytes << std::endl;
  
-   // Copy compressed data to GPU
+   // Pack the compressed chunks back to back and copy them to GPU in one go
+   compress_data_cpu.compact();
    BatchData compress_data(compress_data_cpu, true);
  
    // Allocate and build up decompression batch on GPU
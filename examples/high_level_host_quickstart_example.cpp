@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <random>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "host/host_manager.h"
+#include "host/trace.h"
+
+/*
+  The flows of high_level_quickstart_example.cpp, run on the CPU with the
+  host managers, so no GPU is needed. The buffers are host vectors, and
+  there is no stream: every call returns once its work is done.
+
+  To build, execute
+
+  mkdir build
+  cd build
+  cmake -DBUILD_EXAMPLES=ON ..
+  make -j
+
+  To execute,
+  bin/high_level_host_quickstart_example
+*/
+
+using namespace nvcomp::host;
+
+static void check_result(
+    const std::vector<uint8_t>& expected, const std::vector<uint8_t>& result)
+{
+  if (expected != result) {
+    throw std::runtime_error("Decompressed data does not match the input.");
+  }
+}
+
+/**
+ * In this example, we:
+ *  1) compress the input data
+ *  2) construct a new manager using the input data for demonstration purposes
+ *  3) decompress the input data
+ */
+void decomp_compressed_with_manager_factory_example(
+    const std::vector<uint8_t>& input)
+{
+  const size_t chunk_size = 1 << 16;
+
+  LZ4Manager nvcomp_manager{chunk_size};
+  CompressionConfig comp_config
+      = nvcomp_manager.configure_compression(input.size());
+
+  std::vector<uint8_t> comp_buffer(comp_config.max_compressed_buffer_size);
+  nvcomp_manager.compress(input.data(), comp_buffer.data(), comp_config);
+
+  // Construct a new manager from the compressed buffer, as for a buffer
+  // received from elsewhere whose format isn't known.
+  auto decomp_nvcomp_manager = create_manager(comp_buffer.data());
+
+  DecompressionConfig decomp_config
+      = decomp_nvcomp_manager->configure_decompression(comp_buffer.data());
+  std::vector<uint8_t> res_decomp_buffer(decomp_config.decomp_data_size);
+
+  decomp_nvcomp_manager->decompress(
+      res_decomp_buffer.data(), comp_buffer.data(), decomp_config);
+
+  check_result(input, res_decomp_buffer);
+}
+
+/**
+ * In this example, we:
+ *  1) construct a manager
+ *  2) compress the input data
+ *  3) decompress the input data
+ */
+void comp_decomp_with_single_manager(const std::vector<uint8_t>& input)
+{
+  const size_t chunk_size = 1 << 16;
+
+  LZ4Manager nvcomp_manager{chunk_size};
+  CompressionConfig comp_config
+      = nvcomp_manager.configure_compression(input.size());
+
+  std::vector<uint8_t> comp_buffer(comp_config.max_compressed_buffer_size);
+
+  // The optional last argument returns the size of the compressed frame,
+  // so the buffer can be shrunk before it is stored or sent.
+  size_t comp_size = 0;
+  nvcomp_manager.compress(
+      input.data(), comp_buffer.data(), comp_config, &comp_size);
+  comp_buffer.resize(comp_size);
+
+  DecompressionConfig decomp_config
+      = nvcomp_manager.configure_decompression(comp_buffer.data(), &comp_size);
+  std::vector<uint8_t> res_decomp_buffer(decomp_config.decomp_data_size);
+
+  nvcomp_manager.decompress(
+      res_decomp_buffer.data(), comp_buffer.data(), decomp_config, &comp_size);
+
+  check_result(input, res_decomp_buffer);
+}
+
+/**
+ * The same manager can be used for many compressions / decompressions. In
+ * this example we configure the decompressions by inspecting the compressed
+ * buffers.
+ */
+void multi_comp_decomp_example(const std::vector<std::vector<uint8_t>>& inputs)
+{
+  const size_t num_buffers = inputs.size();
+  const size_t chunk_size = 1 << 16;
+
+  LZ4Manager nvcomp_manager{chunk_size};
+
+  std::vector<std::vector<uint8_t>> comp_result_buffers(num_buffers);
+  for (size_t ix_buffer = 0; ix_buffer < num_buffers; ++ix_buffer) {
+    auto comp_config
+        = nvcomp_manager.configure_compression(inputs[ix_buffer].size());
+
+    comp_result_buffers[ix_buffer].resize(
+        comp_config.max_compressed_buffer_size);
+    nvcomp_manager.compress(
+        inputs[ix_buffer].data(),
+        comp_result_buffers[ix_buffer].data(),
+        comp_config);
+  }
+
+  for (size_t ix_buffer = 0; ix_buffer < num_buffers; ++ix_buffer) {
+    const uint8_t* comp_data = comp_result_buffers[ix_buffer].data();
+
+    auto decomp_config = nvcomp_manager.configure_decompression(comp_data);
+
+    std::vector<uint8_t> decomp_result_buffer(decomp_config.decomp_data_size);
+    nvcomp_manager.decompress(
+        decomp_result_buffer.data(), comp_data, decomp_config);
+
+    check_result(inputs[ix_buffer], decomp_result_buffer);
+  }
+}
+
+/**
+ * The same manager can be used for many compressions / decompressions. In
+ * this example we configure the decompressions from the stored compression
+ * configs.
+ */
+void multi_comp_decomp_example_comp_config(
+    const std::vector<std::vector<uint8_t>>& inputs)
+{
+  const size_t num_buffers = inputs.size();
+  const size_t chunk_size = 1 << 16;
+
+  LZ4Manager nvcomp_manager{chunk_size};
+
+  std::vector<CompressionConfig> comp_configs;
+  comp_configs.reserve(num_buffers);
+
+  std::vector<std::vector<uint8_t>> comp_result_buffers(num_buffers);
+  for (size_t ix_buffer = 0; ix_buffer < num_buffers; ++ix_buffer) {
+    comp_configs.push_back(
+        nvcomp_manager.configure_compression(inputs[ix_buffer].size()));
+    auto& comp_config = comp_configs.back();
+
+    comp_result_buffers[ix_buffer].resize(
+        comp_config.max_compressed_buffer_size);
+    nvcomp_manager.compress(
+        inputs[ix_buffer].data(),
+        comp_result_buffers[ix_buffer].data(),
+        comp_config);
+  }
+
+  for (size_t ix_buffer = 0; ix_buffer < num_buffers; ++ix_buffer) {
+    auto decomp_config
+        = nvcomp_manager.configure_decompression(comp_configs[ix_buffer]);
+
+    std::vector<uint8_t> decomp_result_buffer(decomp_config.decomp_data_size);
+    nvcomp_manager.decompress(
+        decomp_result_buffer.data(),
+        comp_result_buffers[ix_buffer].data(),
+        decomp_config);
+
+    check_result(inputs[ix_buffer], decomp_result_buffer);
+  }
+}
+
+/**
+ * In this example, we:
+ *  1) construct a manager with checksum support enabled
+ *  2) compress the input data
+ *  3) decompress the input data
+ *
+ * The checksum modes are the same as for the GPU managers; see
+ * high_level_quickstart_example.cpp for a description of each.
+ */
+void comp_decomp_with_single_manager_with_checksums(
+    const std::vector<uint8_t>& input)
+{
+  const size_t chunk_size = 1 << 16;
+
+  // manager constructed with checksum mode as final argument
+  LZ4Manager nvcomp_manager{chunk_size, ComputeAndVerify};
+  CompressionConfig comp_config
+      = nvcomp_manager.configure_compression(input.size());
+
+  std::vector<uint8_t> comp_buffer(comp_config.max_compressed_buffer_size);
+
+  // Checksums are computed and stored for every compressed and uncompressed
+  // chunk during compression
+  nvcomp_manager.compress(input.data(), comp_buffer.data(), comp_config);
+
+  DecompressionConfig decomp_config
+      = nvcomp_manager.configure_decompression(comp_buffer.data());
+  std::vector<uint8_t> res_decomp_buffer(decomp_config.decomp_data_size);
+
+  // Checksums are computed for compressed and decompressed chunks and
+  // verified against those stored during compression
+  nvcomp_manager.decompress(
+      res_decomp_buffer.data(), comp_buffer.data(), decomp_config);
+
+  // The status can be checked as soon as decompress() returns. Provided no
+  // unrelated errors occurred, it is nvcompSuccess if the checksums were
+  // verified, and nvcompErrorBadChecksum otherwise.
+  nvcompStatus_t final_status = *decomp_config.get_status();
+  if (final_status == nvcompErrorBadChecksum) {
+    throw std::runtime_error("One or more checksums were incorrect.\n");
+  }
+
+  check_result(input, res_decomp_buffer);
+}
+
+void decomp_compressed_with_manager_factory_with_checksums(
+    const std::vector<uint8_t>& input)
+{
+  const size_t chunk_size = 1 << 16;
+
+  // The manager computes checksums on compression, but does not verify them
+  // on decompression.
+  LZ4Manager nvcomp_manager{chunk_size, ComputeAndNoVerify};
+  CompressionConfig comp_config
+      = nvcomp_manager.configure_compression(input.size());
+
+  std::vector<uint8_t> comp_buffer(comp_config.max_compressed_buffer_size);
+  nvcomp_manager.compress(input.data(), comp_buffer.data(), comp_config);
+
+  // This manager verifies the checksums if the compressed buffer has them.
+  auto decomp_nvcomp_manager
+      = create_manager(comp_buffer.data(), NoComputeAndVerifyIfPresent);
+
+  DecompressionConfig decomp_config
+      = decomp_nvcomp_manager->configure_decompression(comp_buffer.data());
+  std::vector<uint8_t> res_decomp_buffer(decomp_config.decomp_data_size);
+
+  decomp_nvcomp_manager->decompress(
+      res_decomp_buffer.data(), comp_buffer.data(), decomp_config);
+
+  nvcompStatus_t final_status = *decomp_config.get_status();
+  if (final_status == nvcompErrorBadChecksum) {
+    throw std::runtime_error("One or more checksums were incorrect.\n");
+  }
+
+  check_result(input, res_decomp_buffer);
+}
+
+int main()
+{
+  NVCOMP_TRACE_SESSION();
+
+  // Initialize a random array of chars
+  const size_t input_buffer_len = 1000000;
+  std::vector<uint8_t> uncompressed_data(input_buffer_len);
+
+  std::mt19937 random_gen(42);
+
+  // char specialization of std::uniform_int_distribution is
+  // non-standard, and isn't available on MSVC, so use short instead,
+  // but with the range limited, and then cast below.
+  std::uniform_int_distribution<short> uniform_dist(0, 255);
+  for (size_t ix = 0; ix < input_buffer_len; ++ix) {
+    uncompressed_data[ix] = static_cast<uint8_t>(uniform_dist(random_gen));
+  }
+
+  decomp_compressed_with_manager_factory_example(uncompressed_data);
+  comp_decomp_with_single_manager(uncompressed_data);
+  comp_decomp_with_single_manager_with_checksums(uncompressed_data);
+  decomp_compressed_with_manager_factory_with_checksums(uncompressed_data);
+
+  // Test multi-buffer with compressible data
+  const size_t num_buffers = 10;
+  std::vector<std::vector<uint8_t>> inputs(num_buffers);
+  for (size_t ix_buffer = 0; ix_buffer < num_buffers; ++ix_buffer) {
+    inputs[ix_buffer].resize(input_buffer_len + ix_buffer * 1000);
+    for (size_t ix = 0; ix < inputs[ix_buffer].size(); ++ix) {
+      inputs[ix_buffer][ix] = static_cast<uint8_t>((ix / 16) % 32);
+    }
+  }
+
+  multi_comp_decomp_example(inputs);
+  multi_comp_decomp_example_comp_config(inputs);
+
+  std::cout << "All host examples passed." << std::endl;
+
+  return 0;
+}
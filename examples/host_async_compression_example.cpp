@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "host/async_batch.h"
+#include "host/trace.h"
+
+/*
+  Compresses files on the CPU with the asynchronous host batch queue, so
+  that reading the input, compressing, verifying and writing the output
+  overlap. Each file is read in segments, and every segment is submitted as
+  one batch of 64 kB chunks. The main thread reads the next segment while
+  earlier batches are compressed, and writes results in submission order.
+
+  Usage:
+  host_async_compression_example -f <input_file>... [-o <output_file>]
+                                 [-c lz4|deflate] [-s <segment_MB>]
+*/
+
+using namespace nvcomp::host;
+
+// Write the chunks of a batch, each prefixed with its compressed and
+// uncompressed size.
+static void write_result(
+    std::ofstream& out,
+    const BatchResult& result,
+    const std::vector<size_t>& uncompressed_sizes)
+{
+  for (size_t i = 0; i < result.chunks.size(); ++i) {
+    const uint64_t sizes[2]
+        = {result.chunks[i].size(), uncompressed_sizes[i]};
+    out.write(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+    out.write(
+        reinterpret_cast<const char*>(result.chunks[i].data()),
+        result.chunks[i].size());
+  }
+}
+
+static void run_example(
+    const std::vector<std::string>& file_names,
+    const std::string& output_name,
+    const std::string& codec_name,
+    const size_t segment_size)
+{
+  const size_t chunk_size = 1 << 16;
+  std::shared_ptr<const HostCodec> codec = make_host_codec(codec_name);
+
+  std::ofstream out;
+  if (!output_name.empty()) {
+    out.open(output_name, std::ofstream::binary);
+    if (!out) {
+      throw std::runtime_error("Unable to open " + output_name + ".");
+    }
+  }
+
+  // Declared before the queue, so that it outlives callbacks still running
+  // when an exception unwinds this function.
+  std::atomic<size_t> batches_done(0);
+  AsyncBatchQueue queue;
+
+  struct Pending
+  {
+    BatchJob job;
+    std::vector<size_t> uncompressed_sizes;
+
+    Pending() : job(), uncompressed_sizes()
+    {
+    }
+  };
+  std::deque<Pending> pending;
+
+  size_t total_bytes = 0;
+  size_t comp_bytes = 0;
+  double busy_seconds = 0;
+
+  // Wait for the oldest batch and write it out.
+  auto retire = [&]() {
+    Pending& oldest = pending.front();
+    BatchResult result = oldest.job.get();
+    if (result.status != nvcompSuccess) {
+      throw std::runtime_error(
+          "Failed to compress or verify a batch, status "
+          + std::to_string(result.status) + ".");
+    }
+    total_bytes += result.input_bytes;
+    comp_bytes += result.output_bytes;
+    busy_seconds += result.seconds;
+    if (out.is_open()) {
+      write_result(out, result, oldest.uncompressed_sizes);
+    }
+    pending.pop_front();
+  };
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<char> segment(segment_size);
+  for (const std::string& file_name : file_names) {
+    std::ifstream fin(file_name, std::ifstream::binary);
+    if (!fin) {
+      throw std::runtime_error("Unable to open " + file_name + ".");
+    }
+    while (fin) {
+      size_t bytes;
+      {
+        NVCOMP_TRACE_SCOPE("load");
+        fin.read(segment.data(), segment.size());
+        bytes = static_cast<size_t>(fin.gcount());
+      }
+      if (bytes == 0) {
+        break;
+      }
+
+      HostBatch batch = make_compression_batch(
+          codec, segment.data(), bytes, chunk_size, true);
+      Pending entry;
+      for (const std::vector<uint8_t>& chunk : batch.chunks) {
+        entry.uncompressed_sizes.push_back(chunk.size());
+      }
+      // The callback runs on a pool thread as soon as the batch is done,
+      // e.g. to report progress; results are written in order below.
+      entry.job = queue.submit(
+          std::move(batch), [&batches_done](const BatchResult&) {
+            ++batches_done;
+          });
+      pending.push_back(std::move(entry));
+
+      // Keep at most as many batches outstanding as the queue runs at once,
+      // so memory stays bounded even if writing is the bottleneck.
+      while (pending.size() > queue.max_in_flight()) {
+        retire();
+      }
+    }
+  }
+  while (!pending.empty()) {
+    retire();
+  }
+  const double seconds = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+
+  std::cout << "----------" << std::endl;
+  std::cout << "files: " << file_names.size() << std::endl;
+  std::cout << "codec: " << codec->name() << std::endl;
+  std::cout << "batches: " << batches_done << std::endl;
+  std::cout << "uncompressed (B): " << total_bytes << std::endl;
+  std::cout << "comp_size: " << comp_bytes << ", compressed ratio: "
+            << (comp_bytes > 0 ? static_cast<double>(total_bytes) / comp_bytes
+                               : 0.0)
+            << std::endl;
+  std::cout << "end-to-end throughput (GB/s): " << total_bytes / seconds * 1e-9
+            << std::endl;
+  std::cout << "summed batch time (s): " << busy_seconds
+            << ", wall time (s): " << seconds << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  NVCOMP_TRACE_SESSION();
+  std::vector<std::string> file_names;
+  std::string output_name;
+  std::string codec_name = "lz4";
+  size_t segment_size = 16 << 20;
+
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    if (strcmp(arg, "-f") == 0) {
+      while (i + 1 < argc && argv[i + 1][0] != '-') {
+        file_names.push_back(argv[++i]);
+      }
+    } else if (strcmp(arg, "-o") == 0 && i + 1 < argc) {
+      output_name = argv[++i];
+    } else if (strcmp(arg, "-c") == 0 && i + 1 < argc) {
+      codec_name = argv[++i];
+    } else if (strcmp(arg, "-s") == 0 && i + 1 < argc) {
+      segment_size = std::stoul(argv[++i]) << 20;
+    } else {
+      std::cerr << "Unknown argument '" << arg << "'." << std::endl;
+      return 1;
+    }
+  }
+
+  if (file_names.empty()) {
+    std::cerr << "Must specify at least one file with '-f'." << std::endl;
+    return 1;
+  }
+  if (segment_size == 0) {
+    std::cerr << "Segment size must be positive." << std::endl;
+    return 1;
+  }
+
+  run_example(file_names, output_name, codec_name, segment_size);
+
+  return 0;
+}
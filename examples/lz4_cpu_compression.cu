@@ -26,6 +26,8 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include "BatchData.h"
+#include "host/perf_counters.h"
+#include "host/trace.h"
 
 #include "lz4.h"
 #include "lz4hc.h"
@@ -45,8 +47,8 @@ static void run_example(const std::vector<std::vector<char>>& data)
 
   const size_t chunk_size = 1 << 16;
 
-  // build up input batch on CPU
-  BatchDataCPU input_data_cpu(data, chunk_size);
+  // build up input batch on CPU, as a view of the loaded data
+  BatchDataCPU input_data_cpu(data, chunk_size, false);
   std::cout << "chunks: " << input_data_cpu.size() << std::endl;
 
   // compression
@@ -55,8 +57,12 @@ static void run_example(const std::vector<std::vector<char>>& data)
   BatchDataCPU compress_data_cpu(
       LZ4_compressBound(chunk_size), input_data_cpu.size());
 
-  // loop over chunks on the CPU, compressing each one
+  // loop over chunks on the CPU, compressing each one, with hardware
+  // counters if the platform allows them
+  nvcomp::host::PerfCounters perf;
+  perf.start();
   for (size_t i = 0; i < input_data_cpu.size(); ++i) {
+    NVCOMP_TRACE_SCOPE("compress chunk");
     // could use LZ4_compress_default or LZ4_compress_fast instead
     const int size = LZ4_compress_HC(
         static_cast<const char*>(input_data_cpu.ptrs()[i]),
@@ -72,6 +78,7 @@ static void run_example(const std::vector<std::vector<char>>& data)
     // set the actual compressed size
     compress_data_cpu.sizes()[i] = size;
   }
+  const nvcomp::host::PerfSample compress_counters = perf.stop();
 
   // compute compression ratio
   size_t* compressed_sizes_host = compress_data_cpu.sizes();
@@ -82,8 +89,11 @@ static void run_example(const std::vector<std::vector<char>>& data)
   std::cout << "comp_size: " << comp_bytes
             << ", compressed ratio: " << std::fixed << std::setprecision(2)
             << (double)total_bytes / comp_bytes << std::endl;
+  nvcomp::host::print_perf_sample(
+      std::cout, "compression", compress_counters, total_bytes);
 
-  // Copy compressed data to GPU
+  // Pack the compressed chunks back to back and copy them to GPU in one go
+  compress_data_cpu.compact();
   BatchData compress_data(compress_data_cpu, true);
 
   // Allocate and build up decompression batch on GPU
@@ -175,6 +185,7 @@ static void run_example(const std::vector<std::vector<char>>& data)
 
 std::vector<char> readFile(const std::string& filename)
 {
+  NVCOMP_TRACE_SCOPE("load");
   std::vector<char> buffer(4096);
   std::vector<char> host_data;
 
@@ -204,6 +215,7 @@ multi_file(const std::vector<std::string>& filenames)
 
 int main(int argc, char* argv[])
 {
+  NVCOMP_TRACE_SESSION();
   std::vector<std::string> file_names(argc - 1);
 
   if (argc == 1) {
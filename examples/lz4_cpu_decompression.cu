@@ -27,6 +27,8 @@
  */
 
 #include "BatchData.h"
+#include "host/perf_counters.h"
+#include "host/trace.h"
 
 #include "lz4.h"
 #include "lz4hc.h"
@@ -138,8 +140,12 @@ static void run_example(const std::vector<std::vector<char>>& data)
   BatchDataCPU compress_data_cpu = GetBatchDataCPU(compress_data, true);
   BatchDataCPU decompress_data_cpu = GetBatchDataCPU(input_data, false);
 
-  // loop over chunks on the CPU, decompressing each one
+  // loop over chunks on the CPU, decompressing each one, with hardware
+  // counters if the platform allows them
+  nvcomp::host::PerfCounters perf;
+  perf.start();
   for (size_t i = 0; i < input_data.size(); ++i) {
+    NVCOMP_TRACE_SCOPE("decompress chunk");
     const int size = LZ4_decompress_safe(
         static_cast<const char*>(compress_data_cpu.ptrs()[i]),
         static_cast<char*>(decompress_data_cpu.ptrs()[i]),
@@ -150,11 +156,14 @@ static void run_example(const std::vector<std::vector<char>>& data)
           "LZ4 CPU failed to decompress chunk " + std::to_string(i) + ".");
     }
   }
+  const nvcomp::host::PerfSample decompress_counters = perf.stop();
   // Validate decompressed data against input
   if (!(decompress_data_cpu == input_data))
     throw std::runtime_error("Failed to validate CPU decompressed data");
   else
     std::cout << "CPU decompression validated :)" << std::endl;
+  nvcomp::host::print_perf_sample(
+      std::cout, "CPU decompression", decompress_counters, total_bytes);
 
   cudaEventDestroy(start);
   cudaEventDestroy(end);
@@ -163,6 +172,7 @@ static void run_example(const std::vector<std::vector<char>>& data)
 
 std::vector<char> readFile(const std::string& filename)
 {
+  NVCOMP_TRACE_SCOPE("load");
   std::vector<char> buffer(4096);
   std::vector<char> host_data;
 
@@ -192,6 +202,7 @@ multi_file(const std::vector<std::string>& filenames)
 
 int main(int argc, char* argv[])
 {
+  NVCOMP_TRACE_SESSION();
   std::vector<std::string> file_names(argc - 1);
 
   if (argc == 1) {
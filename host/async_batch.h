@@ -0,0 +1,417 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/host_codecs.h"
+#include "host/thread_pool.h"
+#include "host/trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace nvcomp
+{
+namespace host
+{
+
+enum class BatchOperation
+{
+  Compress,
+  Decompress
+};
+
+/**
+ * @brief A batch of chunks to compress or decompress on the host.
+ *
+ * The batch owns its chunks, so the caller may reuse its buffers as soon as
+ * the batch is submitted.
+ */
+struct HostBatch
+{
+  BatchOperation operation;
+  std::shared_ptr<const HostCodec> codec;
+  std::vector<std::vector<uint8_t>> chunks;
+  // Decompression only: the uncompressed size of every chunk.
+  std::vector<size_t> uncompressed_sizes;
+  // Compression only: decompress every chunk again and compare it with the
+  // input, as the examples do.
+  bool verify;
+
+  HostBatch() :
+      operation(BatchOperation::Compress),
+      codec(),
+      chunks(),
+      uncompressed_sizes(),
+      verify(false)
+  {
+  }
+};
+
+// Split `bytes` of `data` into chunks of `chunk_size` to compress.
+inline HostBatch make_compression_batch(
+    std::shared_ptr<const HostCodec> codec,
+    const void* const data,
+    const size_t bytes,
+    const size_t chunk_size,
+    const bool verify = false)
+{
+  if (chunk_size == 0) {
+    throw std::runtime_error("Chunk size must be positive.");
+  }
+  HostBatch batch;
+  batch.operation = BatchOperation::Compress;
+  batch.codec = std::move(codec);
+  batch.verify = verify;
+  const uint8_t* const ptr = static_cast<const uint8_t*>(data);
+  for (size_t offset = 0; offset < bytes; offset += chunk_size) {
+    const size_t size = std::min(chunk_size, bytes - offset);
+    batch.chunks.emplace_back(ptr + offset, ptr + offset + size);
+  }
+  return batch;
+}
+
+struct BatchResult
+{
+  // The compressed or decompressed chunks, in the order of the batch.
+  std::vector<std::vector<uint8_t>> chunks;
+  std::vector<nvcompStatus_t> statuses;
+  // The first failure of any chunk, or nvcompSuccess. A chunk that does not
+  // round trip during verification is reported as
+  // nvcompErrorCannotDecompress, and a chunk skipped after cancellation as
+  // nvcompErrorInternal.
+  nvcompStatus_t status;
+  bool cancelled;
+  size_t input_bytes;
+  size_t output_bytes;
+  // Time from the start of processing to the end, excluding queueing.
+  double seconds;
+
+  BatchResult() :
+      chunks(),
+      statuses(),
+      status(nvcompSuccess),
+      cancelled(false),
+      input_bytes(0),
+      output_bytes(0),
+      seconds(0)
+  {
+  }
+};
+
+// Called on a pool thread once a batch is done, before its future is ready.
+// It must not block on submit() of the same queue.
+typedef std::function<void(const BatchResult&)> BatchCallback;
+
+/**
+ * @brief Handle of a submitted batch.
+ */
+class BatchJob
+{
+public:
+  BatchJob() : m_future(), m_cancelled()
+  {
+  }
+
+  BatchJob(
+      std::future<BatchResult> future,
+      std::shared_ptr<std::atomic<bool>> cancelled) :
+      m_future(std::move(future)),
+      m_cancelled(std::move(cancelled))
+  {
+  }
+
+  bool valid() const
+  {
+    return m_future.valid();
+  }
+
+  void wait() const
+  {
+    m_future.wait();
+  }
+
+  // Wait for the result. Rethrows exceptions of the batch or its callback.
+  BatchResult get()
+  {
+    return m_future.get();
+  }
+
+  std::future<BatchResult>& future()
+  {
+    return m_future;
+  }
+
+  // Ask the batch to stop. Chunks that have not started are skipped and the
+  // result is marked as cancelled. Has no effect once the batch is done.
+  void cancel()
+  {
+    if (m_cancelled) {
+      *m_cancelled = true;
+    }
+  }
+
+private:
+  std::future<BatchResult> m_future;
+  std::shared_ptr<std::atomic<bool>> m_cancelled;
+};
+
+/**
+ * @brief Runs host batches asynchronously on a thread pool.
+ *
+ * submit() returns as soon as the batch is queued, so the caller can read
+ * the next input while earlier batches are compressed, and write results
+ * from the callbacks. At most `max_in_flight` batches are queued or
+ * running at once; submit() blocks until a slot is free, which bounds the
+ * memory held by queued batches. The chunks of each batch are processed in
+ * parallel on the same pool.
+ *
+ * The destructor waits for all batches.
+ */
+class AsyncBatchQueue
+{
+public:
+  // A `max_in_flight` of 0 allows two batches per pool thread.
+  explicit AsyncBatchQueue(
+      const size_t max_in_flight = 0,
+      ThreadPool& pool = default_thread_pool()) :
+      m_pool(pool),
+      m_max_in_flight(
+          max_in_flight > 0 ? max_in_flight : 2 * pool.num_threads()),
+      m_mutex(),
+      m_slot_cv(),
+      m_in_flight(0),
+      m_cancel_epoch(0)
+  {
+  }
+
+  ~AsyncBatchQueue()
+  {
+    wait_all();
+  }
+
+  // disable copying
+  AsyncBatchQueue(const AsyncBatchQueue& other) = delete;
+  AsyncBatchQueue& operator=(const AsyncBatchQueue& other) = delete;
+
+  size_t max_in_flight() const
+  {
+    return m_max_in_flight;
+  }
+
+  size_t in_flight() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_in_flight;
+  }
+
+  BatchJob submit(HostBatch batch, BatchCallback callback = BatchCallback())
+  {
+    if (!batch.codec) {
+      throw std::runtime_error("Host batch requires a codec.");
+    }
+    if (batch.operation == BatchOperation::Decompress
+        && batch.uncompressed_sizes.size() != batch.chunks.size()) {
+      throw std::runtime_error(
+          "Decompression batch requires the uncompressed size of every "
+          "chunk.");
+    }
+
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    job->batch = std::move(batch);
+    job->callback = std::move(callback);
+    job->cancelled = std::make_shared<std::atomic<bool>>(false);
+    BatchJob handle(job->promise.get_future(), job->cancelled);
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_slot_cv.wait(lock, [this]() { return m_in_flight < m_max_in_flight; });
+      ++m_in_flight;
+      job->cancel_epoch = m_cancel_epoch;
+    }
+
+    m_pool.enqueue([this, job]() { run(*job); });
+    return handle;
+  }
+
+  // Cancel every batch submitted so far.
+  void cancel_all()
+  {
+    ++m_cancel_epoch;
+  }
+
+  // Block until every submitted batch is done and its callback returned.
+  void wait_all()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_slot_cv.wait(lock, [this]() { return m_in_flight == 0; });
+  }
+
+private:
+  struct Job
+  {
+    HostBatch batch;
+    BatchCallback callback;
+    std::promise<BatchResult> promise;
+    std::shared_ptr<std::atomic<bool>> cancelled;
+    uint64_t cancel_epoch;
+
+    Job() : batch(), callback(), promise(), cancelled(), cancel_epoch(0)
+    {
+    }
+  };
+
+  bool is_cancelled(const Job& job) const
+  {
+    return *job.cancelled || m_cancel_epoch != job.cancel_epoch;
+  }
+
+  static nvcompStatus_t compress_chunk(
+      const HostBatch& batch,
+      const std::vector<uint8_t>& in,
+      std::vector<uint8_t>& out)
+  {
+    NVCOMP_TRACE_SCOPE("compress chunk");
+    const HostCodec& codec = *batch.codec;
+    out.resize(codec.max_compressed_size(in.size()));
+    try {
+      out.resize(codec.compress(in.data(), in.size(), out.data(), out.size()));
+    } catch (const std::exception&) {
+      out.clear();
+      return nvcompErrorInternal;
+    }
+    if (!batch.verify) {
+      return nvcompSuccess;
+    }
+    NVCOMP_TRACE_SCOPE("verify");
+    std::vector<uint8_t> check(in.size());
+    size_t check_bytes = 0;
+    const nvcompStatus_t status = codec.decompress(
+        out.data(), out.size(), check.data(), check.size(), &check_bytes);
+    if (status != nvcompSuccess) {
+      return status;
+    }
+    return check_bytes == in.size() && check == in
+               ? nvcompSuccess
+               : nvcompErrorCannotDecompress;
+  }
+
+  static nvcompStatus_t decompress_chunk(
+      const HostBatch& batch,
+      const std::vector<uint8_t>& in,
+      const size_t uncompressed_size,
+      std::vector<uint8_t>& out)
+  {
+    NVCOMP_TRACE_SCOPE("decompress chunk");
+    out.resize(uncompressed_size);
+    size_t out_bytes = 0;
+    const nvcompStatus_t status = batch.codec->decompress(
+        in.data(), in.size(), out.data(), out.size(), &out_bytes);
+    if (status != nvcompSuccess) {
+      return status;
+    }
+    return out_bytes == uncompressed_size ? nvcompSuccess
+                                          : nvcompErrorCannotDecompress;
+  }
+
+  void run(Job& job)
+  {
+    try {
+      const HostBatch& batch = job.batch;
+      const size_t num_chunks = batch.chunks.size();
+      const auto start = std::chrono::steady_clock::now();
+
+      BatchResult result;
+      result.chunks.resize(num_chunks);
+      result.statuses.assign(num_chunks, nvcompSuccess);
+      std::atomic<bool> skipped(false);
+      m_pool.parallel_for(num_chunks, [&](const size_t i) {
+        if (is_cancelled(job)) {
+          result.statuses[i] = nvcompErrorInternal;
+          skipped = true;
+          return;
+        }
+        result.statuses[i]
+            = batch.operation == BatchOperation::Compress
+                  ? compress_chunk(batch, batch.chunks[i], result.chunks[i])
+                  : decompress_chunk(
+                      batch,
+                      batch.chunks[i],
+                      batch.uncompressed_sizes[i],
+                      result.chunks[i]);
+      });
+
+      result.cancelled = skipped;
+      for (size_t i = 0; i < num_chunks; ++i) {
+        if (result.status == nvcompSuccess) {
+          result.status = result.statuses[i];
+        }
+        result.input_bytes += batch.chunks[i].size();
+        result.output_bytes += result.chunks[i].size();
+      }
+      result.seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+
+      // Free the input before the callback, which may take a while.
+      job.batch.chunks.clear();
+      job.batch.chunks.shrink_to_fit();
+
+      if (job.callback) {
+        job.callback(result);
+      }
+      job.promise.set_value(std::move(result));
+    } catch (...) {
+      job.promise.set_exception(std::current_exception());
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    --m_in_flight;
+    m_slot_cv.notify_all();
+  }
+
+  ThreadPool& m_pool;
+  size_t m_max_in_flight;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_slot_cv;
+  size_t m_in_flight;
+  std::atomic<uint64_t> m_cancel_epoch;
+};
+
+} // namespace host
+} // namespace nvcomp
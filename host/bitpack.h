@@ -0,0 +1,593 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NVCOMP_HOST_BITPACK_X86
+#include <immintrin.h>
+#endif
+
+namespace nvcomp
+{
+namespace host
+{
+
+/**
+ * @brief Bit packing of unsigned integers, as used by the last stage of
+ * Cascaded.
+ *
+ * Value i, minus `base` and truncated to `bits` bits, occupies bits
+ * [i * bits, (i + 1) * bits) of a stream of 64-bit words, least significant
+ * bit first, so that values straddle word boundaries whenever `bits` doesn't
+ * divide 64. Blocks of 64 values fill exactly `bits` words, and are packed
+ * and unpacked by kernels generated for every width from 1 to 64, with all
+ * shifts and word offsets known at compile time. Unpacking also has SSE4.1,
+ * AVX2 and AVX-512 kernels for widths up to 56, which load every value at
+ * the byte holding its first bit and shift it into place, selected at run
+ * time. Eight-lane AVX-512 gathers beat the scalar kernels at most widths,
+ * but four-lane AVX2 gathers rarely do, and SSE4.1, which has neither
+ * gathers nor per-lane shifts, loads and shifts its two lanes one at a
+ * time, so these two are only used when asked for; benchmark_bitpack
+ * compares them all.
+ */
+enum class BitpackKernel
+{
+  Scalar,
+  SSE41,
+  AVX2,
+  AVX512
+};
+
+inline const char* bitpack_kernel_name(const BitpackKernel kernel)
+{
+  switch (kernel) {
+  case BitpackKernel::Scalar:
+    return "scalar";
+  case BitpackKernel::SSE41:
+    return "sse4.1";
+  case BitpackKernel::AVX2:
+    return "avx2";
+  case BitpackKernel::AVX512:
+    return "avx512";
+  }
+  return "unknown";
+}
+
+inline bool bitpack_kernel_supported(const BitpackKernel kernel)
+{
+  switch (kernel) {
+  case BitpackKernel::Scalar:
+    return true;
+#ifdef NVCOMP_HOST_BITPACK_X86
+  case BitpackKernel::SSE41:
+    return __builtin_cpu_supports("sse4.1");
+  case BitpackKernel::AVX2:
+    return __builtin_cpu_supports("avx2");
+  case BitpackKernel::AVX512:
+    return __builtin_cpu_supports("avx512f");
+#endif
+  default:
+    return false;
+  }
+}
+
+// The unpacking kernel used by default, detected once.
+inline BitpackKernel bitpack_default_kernel()
+{
+  static const BitpackKernel kernel
+      = bitpack_kernel_supported(BitpackKernel::AVX512)
+            ? BitpackKernel::AVX512
+            : BitpackKernel::Scalar;
+  return kernel;
+}
+
+// Number of 64-bit words that `count` values of `bits` bits take.
+inline size_t bitpack_words(const size_t count, const size_t bits)
+{
+  return (count * bits + 63) / 64;
+}
+
+namespace detail
+{
+
+static constexpr size_t BITPACK_BLOCK = 64;
+
+// Widest values that the SIMD kernels load with a single 8-byte gather at
+// any bit offset.
+static constexpr size_t BITPACK_MAX_SIMD_BITS = 56;
+
+inline constexpr uint64_t bitpack_mask(const size_t bits)
+{
+  return bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+}
+
+// Shifts that give 0 for a count of 64, so that they can be instantiated for
+// every offset, even where the branch using them is never taken.
+template <size_t SHIFT>
+inline uint64_t bitpack_shl(const uint64_t x)
+{
+  return SHIFT >= 64 ? 0 : x << (SHIFT & 63);
+}
+
+template <size_t SHIFT>
+inline uint64_t bitpack_shr(const uint64_t x)
+{
+  return SHIFT >= 64 ? 0 : x >> (SHIFT & 63);
+}
+
+// Calls f.template step<I>() for I in [BEGIN, END).
+template <size_t BEGIN, size_t END>
+struct BitpackUnroll
+{
+  template <typename F>
+  static void run(F& f)
+  {
+    f.template step<BEGIN>();
+    BitpackUnroll<BEGIN + 1, END>::run(f);
+  }
+};
+
+template <size_t END>
+struct BitpackUnroll<END, END>
+{
+  template <typename F>
+  static void run(F&)
+  {
+  }
+};
+
+template <typename T, size_t BITS>
+struct PackBlock
+{
+  const T* in;
+  T base;
+  uint64_t* out;
+
+  template <size_t I>
+  void step()
+  {
+    constexpr size_t WORD = I * BITS / 64;
+    constexpr size_t OFFSET = I * BITS % 64;
+    const uint64_t v
+        = static_cast<T>(in[I] - base) & bitpack_mask(BITS);
+    // The first value to touch a word assigns it, whole or the part
+    // carried over from the previous word.
+    if (OFFSET == 0) {
+      out[WORD] = v;
+    } else {
+      out[WORD] |= bitpack_shl<OFFSET>(v);
+    }
+    if (OFFSET + BITS > 64) {
+      out[WORD + 1] = bitpack_shr<64 - OFFSET>(v);
+    }
+  }
+};
+
+template <typename T, size_t BITS>
+struct UnpackBlock
+{
+  const uint64_t* in;
+  T base;
+  T* out;
+
+  template <size_t I>
+  void step()
+  {
+    constexpr size_t WORD = I * BITS / 64;
+    constexpr size_t OFFSET = I * BITS % 64;
+    uint64_t v = bitpack_shr<OFFSET>(in[WORD]);
+    if (OFFSET + BITS > 64) {
+      v |= bitpack_shl<64 - OFFSET>(in[WORD + 1]);
+    }
+    out[I] = static_cast<T>((v & bitpack_mask(BITS)) + base);
+  }
+};
+
+template <typename T>
+using PackFn = void (*)(const T*, size_t, T, uint64_t*);
+
+template <typename T>
+using UnpackFn = void (*)(const uint64_t*, size_t, T, T*);
+
+template <typename T, size_t BITS>
+void pack_blocks(
+    const T* in, const size_t num_blocks, const T base, uint64_t* out)
+{
+  for (size_t b = 0; b < num_blocks; ++b) {
+    PackBlock<T, BITS> block{in + b * BITPACK_BLOCK, base, out + b * BITS};
+    BitpackUnroll<0, BITPACK_BLOCK>::run(block);
+  }
+}
+
+template <typename T, size_t BITS>
+void unpack_blocks(
+    const uint64_t* in, const size_t num_blocks, const T base, T* out)
+{
+  for (size_t b = 0; b < num_blocks; ++b) {
+    UnpackBlock<T, BITS> block{in + b * BITS, base, out + b * BITPACK_BLOCK};
+    BitpackUnroll<0, BITPACK_BLOCK>::run(block);
+  }
+}
+
+// Tables of the block kernels, indexed by width, for widths 1 to the bits
+// of T.
+template <typename T, size_t BITS = 8 * sizeof(T)>
+struct BitpackTable
+{
+  static void fill(PackFn<T>* pack, UnpackFn<T>* unpack)
+  {
+    pack[BITS] = &pack_blocks<T, BITS>;
+    unpack[BITS] = &unpack_blocks<T, BITS>;
+    BitpackTable<T, BITS - 1>::fill(pack, unpack);
+  }
+};
+
+template <typename T>
+struct BitpackTable<T, 0>
+{
+  static void fill(PackFn<T>* pack, UnpackFn<T>* unpack)
+  {
+    pack[0] = nullptr;
+    unpack[0] = nullptr;
+  }
+};
+
+template <typename T>
+struct BitpackKernels
+{
+  PackFn<T> pack[8 * sizeof(T) + 1];
+  UnpackFn<T> unpack[8 * sizeof(T) + 1];
+
+  BitpackKernels()
+  {
+    BitpackTable<T>::fill(pack, unpack);
+  }
+
+  static const BitpackKernels& get()
+  {
+    static const BitpackKernels kernels;
+    return kernels;
+  }
+};
+
+// Pack or unpack the values from `first` on one at a time, for the values
+// after the last whole block.
+template <typename T>
+void pack_tail(
+    const T* const in,
+    const size_t first,
+    const size_t count,
+    const size_t bits,
+    const T base,
+    uint64_t* const out)
+{
+  for (size_t i = first; i < count; ++i) {
+    const uint64_t v = static_cast<T>(in[i] - base) & bitpack_mask(bits);
+    const size_t word = i * bits / 64;
+    const size_t offset = i * bits % 64;
+    if (offset == 0) {
+      out[word] = v;
+    } else {
+      out[word] |= v << offset;
+    }
+    if (offset + bits > 64) {
+      out[word + 1] = v >> (64 - offset);
+    }
+  }
+}
+
+template <typename T>
+void unpack_tail(
+    const uint64_t* const in,
+    const size_t first,
+    const size_t count,
+    const size_t bits,
+    const T base,
+    T* const out)
+{
+  for (size_t i = first; i < count; ++i) {
+    const size_t word = i * bits / 64;
+    const size_t offset = i * bits % 64;
+    uint64_t v = in[word] >> offset;
+    if (offset + bits > 64) {
+      v |= in[word + 1] << (64 - offset);
+    }
+    out[i] = static_cast<T>((v & bitpack_mask(bits)) + base);
+  }
+}
+
+// The number of leading values whose 8 bytes starting at the byte holding
+// their first bit lie within the packed words, which the SIMD kernels may
+// load.
+inline size_t bitpack_gather_count(const size_t count, const size_t bits)
+{
+  const size_t bytes = 8 * bitpack_words(count, bits);
+  if (bytes < 8) {
+    return 0;
+  }
+  // Value i may be gathered while i * bits / 8 <= bytes - 8.
+  return std::min(count, (bytes - 8) * 8 / bits + 1);
+}
+
+#ifdef NVCOMP_HOST_BITPACK_X86
+
+// Unpack `count` values with 2 lanes of 64 bits, returning how many were
+// done. Without gathers or per-lane shifts, each lane is loaded and shifted
+// on its own, and only the masking and adding run on both at once.
+template <typename T>
+__attribute__((target("sse4.1"))) size_t unpack_sse41(
+    const uint64_t* const in,
+    const size_t count,
+    const size_t bits,
+    const T base,
+    T* const out)
+{
+  const size_t n = bitpack_gather_count(count, bits) / 2 * 2;
+  const uint8_t* const bytes = reinterpret_cast<const uint8_t*>(in);
+  const __m128i mask
+      = _mm_set1_epi64x(static_cast<long long>(bitpack_mask(bits)));
+  const __m128i add = _mm_set1_epi64x(static_cast<long long>(base));
+  size_t position = 0;
+  for (size_t i = 0; i < n; i += 2) {
+    const size_t next = position + bits;
+    const __m128i lo = _mm_srl_epi64(
+        _mm_loadl_epi64(
+            reinterpret_cast<const __m128i*>(bytes + position / 8)),
+        _mm_cvtsi32_si128(static_cast<int>(position % 8)));
+    const __m128i hi = _mm_srl_epi64(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes + next / 8)),
+        _mm_cvtsi32_si128(static_cast<int>(next % 8)));
+    __m128i v = _mm_unpacklo_epi64(lo, hi);
+    v = _mm_add_epi64(_mm_and_si128(v, mask), add);
+    switch (sizeof(T)) {
+    case 8:
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), v);
+      break;
+    case 4:
+      _mm_storel_epi64(
+          reinterpret_cast<__m128i*>(out + i),
+          _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 2, 0)));
+      break;
+    case 2:
+      out[i] = static_cast<T>(_mm_extract_epi16(v, 0));
+      out[i + 1] = static_cast<T>(_mm_extract_epi16(v, 4));
+      break;
+    default:
+      out[i] = static_cast<T>(_mm_extract_epi8(v, 0));
+      out[i + 1] = static_cast<T>(_mm_extract_epi8(v, 8));
+      break;
+    }
+    position = next + bits;
+  }
+  return n;
+}
+
+// Unpack `count` values with 4 lanes of 64 bits, returning how many were
+// done.
+template <typename T>
+__attribute__((target("avx2"))) size_t unpack_avx2(
+    const uint64_t* const in,
+    const size_t count,
+    const size_t bits,
+    const T base,
+    T* const out)
+{
+  if (sizeof(T) < 4) {
+    return 0;
+  }
+  const size_t n = bitpack_gather_count(count, bits) / 4 * 4;
+  const long long* const bytes = reinterpret_cast<const long long*>(in);
+  const __m256i mask
+      = _mm256_set1_epi64x(static_cast<long long>(bitpack_mask(bits)));
+  const __m256i add = _mm256_set1_epi64x(static_cast<long long>(base));
+  const __m256i seven = _mm256_set1_epi64x(7);
+  const __m256i step = _mm256_set1_epi64x(static_cast<long long>(4 * bits));
+  __m256i position = _mm256_setr_epi64x(
+      0,
+      static_cast<long long>(bits),
+      static_cast<long long>(2 * bits),
+      static_cast<long long>(3 * bits));
+  // Gathers 32-bit values into the low half for narrow outputs.
+  const __m256i narrow = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+  for (size_t i = 0; i < n; i += 4) {
+    __m256i v = _mm256_i64gather_epi64(
+        bytes, _mm256_srli_epi64(position, 3), 1);
+    v = _mm256_srlv_epi64(v, _mm256_and_si256(position, seven));
+    v = _mm256_add_epi64(_mm256_and_si256(v, mask), add);
+    if (sizeof(T) == 8) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), v);
+    } else {
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(out + i),
+          _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(v, narrow)));
+    }
+    position = _mm256_add_epi64(position, step);
+  }
+  return n;
+}
+
+// GCC 12 warns about the undefined upper halves that its AVX-512
+// intrinsics start from (GCC bug 105593).
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// Unpack `count` values with 8 lanes of 64 bits, returning how many were
+// done.
+template <typename T>
+__attribute__((target("avx512f"))) size_t unpack_avx512(
+    const uint64_t* const in,
+    const size_t count,
+    const size_t bits,
+    const T base,
+    T* const out)
+{
+  const size_t n = bitpack_gather_count(count, bits) / 8 * 8;
+  const __m512i mask
+      = _mm512_set1_epi64(static_cast<long long>(bitpack_mask(bits)));
+  const __m512i add = _mm512_set1_epi64(static_cast<long long>(base));
+  const __m512i seven = _mm512_set1_epi64(7);
+  const __m512i step = _mm512_set1_epi64(static_cast<long long>(8 * bits));
+  const long long b = static_cast<long long>(bits);
+  __m512i position
+      = _mm512_setr_epi64(0, b, 2 * b, 3 * b, 4 * b, 5 * b, 6 * b, 7 * b);
+  for (size_t i = 0; i < n; i += 8) {
+    __m512i v = _mm512_i64gather_epi64(
+        _mm512_srli_epi64(position, 3), in, 1);
+    v = _mm512_srlv_epi64(v, _mm512_and_si512(position, seven));
+    v = _mm512_add_epi64(_mm512_and_si512(v, mask), add);
+    switch (sizeof(T)) {
+    case 8:
+      _mm512_storeu_si512(out + i, v);
+      break;
+    case 4:
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i*>(out + i), _mm512_cvtepi64_epi32(v));
+      break;
+    case 2:
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(out + i), _mm512_cvtepi64_epi16(v));
+      break;
+    default:
+      _mm_storel_epi64(
+          reinterpret_cast<__m128i*>(out + i), _mm512_cvtepi64_epi8(v));
+      break;
+    }
+    position = _mm512_add_epi64(position, step);
+  }
+  return n;
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
+
+template <typename T>
+void check_bitpack_width(const size_t bits)
+{
+  static_assert(
+      std::is_unsigned<T>::value, "Bit packing takes unsigned integers");
+  if (bits > 8 * sizeof(T)) {
+    throw std::runtime_error(
+        "Bit width " + std::to_string(bits) + " is wider than the values.");
+  }
+}
+
+} // namespace detail
+
+/**
+ * @brief Pack `count` values of `in`, minus `base`, into `bits` bits each.
+ *
+ * `out` must hold bitpack_words(count, bits) words. Bits of the values
+ * above `bits` are dropped.
+ */
+template <typename T>
+void bitpack(
+    const T* const in,
+    const size_t count,
+    const size_t bits,
+    const T base,
+    uint64_t* const out)
+{
+  detail::check_bitpack_width<T>(bits);
+  if (bits == 0) {
+    return;
+  }
+  const size_t num_blocks = count / detail::BITPACK_BLOCK;
+  detail::BitpackKernels<T>::get().pack[bits](in, num_blocks, base, out);
+  detail::pack_tail(
+      in, num_blocks * detail::BITPACK_BLOCK, count, bits, base, out);
+}
+
+/**
+ * @brief Unpack `count` values of `bits` bits each from `in`, adding `base`,
+ * with the given kernel, which must be supported.
+ *
+ * With 0 bits, every value is `base`.
+ */
+template <typename T>
+void bitunpack(
+    const uint64_t* const in,
+    const size_t count,
+    const size_t bits,
+    const T base,
+    T* const out,
+    const BitpackKernel kernel = bitpack_default_kernel())
+{
+  detail::check_bitpack_width<T>(bits);
+  if (bits == 0) {
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = base;
+    }
+    return;
+  }
+
+  size_t done = 0;
+#ifdef NVCOMP_HOST_BITPACK_X86
+  if (bits <= detail::BITPACK_MAX_SIMD_BITS) {
+    if (kernel == BitpackKernel::AVX512) {
+      done = detail::unpack_avx512(in, count, bits, base, out);
+    } else if (kernel == BitpackKernel::AVX2) {
+      done = detail::unpack_avx2(in, count, bits, base, out);
+    } else if (kernel == BitpackKernel::SSE41) {
+      done = detail::unpack_sse41(in, count, bits, base, out);
+    }
+  }
+#else
+  (void)kernel;
+#endif
+  // Go on with whole blocks, which start on a word.
+  const size_t first_block
+      = (done + detail::BITPACK_BLOCK - 1) / detail::BITPACK_BLOCK;
+  const size_t num_blocks = count / detail::BITPACK_BLOCK;
+  if (first_block < num_blocks) {
+    detail::unpack_tail(
+        in, done, first_block * detail::BITPACK_BLOCK, bits, base, out);
+    detail::BitpackKernels<T>::get().unpack[bits](
+        in + first_block * bits,
+        num_blocks - first_block,
+        base,
+        out + first_block * detail::BITPACK_BLOCK);
+    done = num_blocks * detail::BITPACK_BLOCK;
+  }
+  detail::unpack_tail(in, done, count, bits, base, out);
+}
+
+} // namespace host
+} // namespace nvcomp
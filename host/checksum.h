@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace nvcomp
+{
+namespace host
+{
+
+namespace detail
+{
+
+// Lookup tables for slicing-by-8 CRC-32 (IEEE 802.3, reflected).
+struct Crc32Tables
+{
+  uint32_t table[8][256];
+
+  Crc32Tables()
+  {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t crc = i;
+      for (int k = 0; k < 8; ++k) {
+        crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+      }
+      table[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+      for (int t = 1; t < 8; ++t) {
+        table[t][i]
+            = (table[t - 1][i] >> 8) ^ table[0][table[t - 1][i] & 0xff];
+      }
+    }
+  }
+};
+
+inline const Crc32Tables& crc32_tables()
+{
+  static const Crc32Tables tables;
+  return tables;
+}
+
+} // namespace detail
+
+// CRC-32 as used by gzip and zlib. Pass the previous result as `crc` to
+// continue a checksum over several buffers.
+inline uint32_t crc32(const void* const data, size_t bytes, uint32_t crc = 0)
+{
+  const uint32_t(&t)[8][256] = detail::crc32_tables().table;
+  const uint8_t* ptr = static_cast<const uint8_t*>(data);
+  crc = ~crc;
+  while (bytes >= 8) {
+    uint32_t lo;
+    uint32_t hi;
+    std::memcpy(&lo, ptr, sizeof(lo));
+    std::memcpy(&hi, ptr + 4, sizeof(hi));
+    lo ^= crc;
+    crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff]
+          ^ t[4][lo >> 24] ^ t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff]
+          ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+    ptr += 8;
+    bytes -= 8;
+  }
+  while (bytes-- > 0) {
+    crc = (crc >> 8) ^ t[0][(crc ^ *ptr++) & 0xff];
+  }
+  return ~crc;
+}
+
+} // namespace host
+} // namespace nvcomp
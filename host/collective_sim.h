@@ -0,0 +1,1205 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/host_manager.h"
+#include "host/host_stream.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nvcomp
+{
+namespace host
+{
+
+// One direction of a link between two endpoints.
+struct LinkModel
+{
+  // Bytes per second, or 0 for a link only limited by memcpy.
+  double bandwidth;
+  // Seconds from the start of a transfer until its first byte arrives.
+  double latency;
+};
+
+/**
+ * @brief The links between simulated ranks.
+ *
+ * Links are one-directional and carry one transfer at a time, so transfers
+ * that share a link queue behind each other. Subclass this to model other
+ * interconnects.
+ */
+class Topology
+{
+public:
+  virtual ~Topology()
+  {
+  }
+
+  virtual const char* name() const = 0;
+
+  virtual size_t num_ranks() const = 0;
+
+  virtual size_t num_links() const = 0;
+
+  virtual LinkModel link(size_t link_id) const = 0;
+
+  // The links that a message from `src` to `dst` passes through.
+  virtual std::vector<size_t> route(size_t src, size_t dst) const = 0;
+};
+
+// A direct link for every ordered pair of ranks, as with NVLink through a
+// switch.
+class FullyConnectedTopology : public Topology
+{
+public:
+  FullyConnectedTopology(const size_t num_ranks, const LinkModel link) :
+      m_num_ranks(num_ranks), m_link(link)
+  {
+  }
+
+  const char* name() const override
+  {
+    return "full";
+  }
+
+  size_t num_ranks() const override
+  {
+    return m_num_ranks;
+  }
+
+  size_t num_links() const override
+  {
+    return m_num_ranks * m_num_ranks;
+  }
+
+  LinkModel link(size_t /*link_id*/) const override
+  {
+    return m_link;
+  }
+
+  std::vector<size_t> route(const size_t src, const size_t dst) const override
+  {
+    return std::vector<size_t>(1, src * m_num_ranks + dst);
+  }
+
+private:
+  size_t m_num_ranks;
+  LinkModel m_link;
+};
+
+// Every rank is linked to its two neighbours in both directions. Messages
+// to other ranks are forwarded along the shorter way around.
+class RingTopology : public Topology
+{
+public:
+  RingTopology(const size_t num_ranks, const LinkModel link) :
+      m_num_ranks(num_ranks), m_link(link)
+  {
+  }
+
+  const char* name() const override
+  {
+    return "ring";
+  }
+
+  size_t num_ranks() const override
+  {
+    return m_num_ranks;
+  }
+
+  // Link 2 * r leads from rank r to r + 1, and 2 * r + 1 from r to r - 1.
+  size_t num_links() const override
+  {
+    return 2 * m_num_ranks;
+  }
+
+  LinkModel link(size_t /*link_id*/) const override
+  {
+    return m_link;
+  }
+
+  std::vector<size_t> route(const size_t src, const size_t dst) const override
+  {
+    const size_t n = m_num_ranks;
+    const size_t forward = (dst + n - src) % n;
+    std::vector<size_t> links;
+    if (forward <= n - forward) {
+      for (size_t r = src; r != dst; r = (r + 1) % n) {
+        links.push_back(2 * r);
+      }
+    } else {
+      for (size_t r = src; r != dst; r = (r + n - 1) % n) {
+        links.push_back(2 * r + 1);
+      }
+    }
+    return links;
+  }
+
+private:
+  size_t m_num_ranks;
+  LinkModel m_link;
+};
+
+// Every rank has one link to and one from a central switch, as with PCIe or
+// a NIC per rank, so the messages a rank sends share its uplink.
+class SwitchTopology : public Topology
+{
+public:
+  SwitchTopology(const size_t num_ranks, const LinkModel link) :
+      m_num_ranks(num_ranks), m_link(link)
+  {
+  }
+
+  const char* name() const override
+  {
+    return "switch";
+  }
+
+  size_t num_ranks() const override
+  {
+    return m_num_ranks;
+  }
+
+  // Link 2 * r is the uplink of rank r, and 2 * r + 1 its downlink.
+  size_t num_links() const override
+  {
+    return 2 * m_num_ranks;
+  }
+
+  LinkModel link(size_t /*link_id*/) const override
+  {
+    return m_link;
+  }
+
+  std::vector<size_t> route(const size_t src, const size_t dst) const override
+  {
+    std::vector<size_t> links(2);
+    links[0] = 2 * src;
+    links[1] = 2 * dst + 1;
+    return links;
+  }
+
+private:
+  size_t m_num_ranks;
+  LinkModel m_link;
+};
+
+inline std::unique_ptr<Topology> make_topology(
+    const std::string& name, const size_t num_ranks, const LinkModel link)
+{
+  if (name == "full") {
+    return std::unique_ptr<Topology>(
+        new FullyConnectedTopology(num_ranks, link));
+  }
+  if (name == "ring") {
+    return std::unique_ptr<Topology>(new RingTopology(num_ranks, link));
+  }
+  if (name == "switch") {
+    return std::unique_ptr<Topology>(new SwitchTopology(num_ranks, link));
+  }
+  throw std::runtime_error("Unknown topology '" + name + "'.");
+}
+
+enum class AllgatherAlgorithm
+{
+  // Every rank sends its shard directly to every other rank.
+  Naive,
+  // n - 1 steps, each passing one shard on to the next rank.
+  Ring,
+  // log2(n) steps, each exchanging all shards held so far with the rank
+  // whose index differs in one bit. Needs a power of two number of ranks.
+  RecursiveDoubling,
+  // Gather to rank 0 and broadcast back, both along a binomial tree.
+  Tree,
+  // Every rank sends its shard directly to every other rank, like Naive,
+  // but in sub-chunks, and compression, transfer and decompression run on
+  // separate streams, so that they overlap.
+  Pipelined
+};
+
+inline const char* algorithm_name(const AllgatherAlgorithm algorithm)
+{
+  switch (algorithm) {
+  case AllgatherAlgorithm::Naive:
+    return "naive";
+  case AllgatherAlgorithm::Ring:
+    return "ring";
+  case AllgatherAlgorithm::RecursiveDoubling:
+    return "rd";
+  case AllgatherAlgorithm::Tree:
+    return "tree";
+  case AllgatherAlgorithm::Pipelined:
+    return "pipelined";
+  }
+  return "unknown";
+}
+
+inline AllgatherAlgorithm parse_algorithm(const std::string& name)
+{
+  if (name == "naive") {
+    return AllgatherAlgorithm::Naive;
+  }
+  if (name == "ring") {
+    return AllgatherAlgorithm::Ring;
+  }
+  if (name == "rd" || name == "recursive_doubling") {
+    return AllgatherAlgorithm::RecursiveDoubling;
+  }
+  if (name == "tree") {
+    return AllgatherAlgorithm::Tree;
+  }
+  if (name == "pipelined") {
+    return AllgatherAlgorithm::Pipelined;
+  }
+  throw std::runtime_error("Unknown allgather algorithm '" + name + "'.");
+}
+
+struct AllgatherOptions
+{
+  // Compress every shard with this codec before it is sent, or send it
+  // uncompressed if null.
+  std::shared_ptr<const HostCodec> codec;
+  size_t chunk_size;
+  // With AllgatherAlgorithm::Pipelined, shards are compressed, sent and
+  // decompressed in pieces of this size.
+  size_t pipeline_chunk_size;
+  // Pool for compressing and decompressing the chunks of a shard, shared by
+  // all ranks.
+  ThreadPool* pool;
+
+  AllgatherOptions() :
+      codec(), chunk_size(1 << 16), pipeline_chunk_size(1 << 20), pool(nullptr)
+  {
+  }
+  AllgatherOptions(const AllgatherOptions&) = default;
+  AllgatherOptions& operator=(const AllgatherOptions&) = default;
+};
+
+enum class PipelineStage
+{
+  Compress,
+  Transfer,
+  Decompress
+};
+
+inline const char* stage_name(const PipelineStage stage)
+{
+  switch (stage) {
+  case PipelineStage::Compress:
+    return "compress";
+  case PipelineStage::Transfer:
+    return "transfer";
+  case PipelineStage::Decompress:
+    return "decompress";
+  }
+  return "unknown";
+}
+
+// One task of a pipelined allgather, in seconds since the start.
+struct PipelineInterval
+{
+  size_t rank;
+  PipelineStage stage;
+  // The sub-chunk of the shard, which is the rank's own for Compress and
+  // Transfer, and a received one for Decompress.
+  size_t chunk;
+  double begin;
+  double end;
+};
+
+struct AllgatherStats
+{
+  // Wall time from the start until the last rank holds every shard.
+  double seconds;
+  // Slowest rank in each phase. When pipelined, the time each stage was
+  // busy.
+  double compress_seconds;
+  double exchange_seconds;
+  double decompress_seconds;
+  size_t uncompressed_bytes;
+  // Size of all shards as sent, i.e. after compression.
+  size_t shard_bytes;
+  // Bytes over all links, counting every hop.
+  size_t link_bytes;
+  size_t messages;
+  bool correct;
+  // Pipelined only: the fraction of its busy time during which a rank ran
+  // two or more stages at once (see overlap_fraction()), averaged over the
+  // ranks, and the timelines of all stages.
+  double overlap_fraction;
+  std::vector<PipelineInterval> timeline;
+
+  AllgatherStats() :
+      seconds(0),
+      compress_seconds(0),
+      exchange_seconds(0),
+      decompress_seconds(0),
+      uncompressed_bytes(0),
+      shard_bytes(0),
+      link_bytes(0),
+      messages(0),
+      correct(false),
+      overlap_fraction(0),
+      timeline()
+  {
+  }
+};
+
+namespace detail
+{
+
+typedef std::chrono::steady_clock SimClock;
+
+struct SimShard
+{
+  size_t index;
+  std::vector<uint8_t> data;
+
+  SimShard() : index(0), data()
+  {
+  }
+};
+
+struct SimMessage
+{
+  size_t src;
+  int tag;
+  SimClock::time_point arrival;
+  std::vector<SimShard> shards;
+
+  SimMessage() : src(0), tag(0), arrival(), shards()
+  {
+  }
+};
+
+struct SimLink
+{
+  std::mutex mutex;
+  SimClock::time_point free_at;
+
+  SimLink() : mutex(), free_at()
+  {
+  }
+};
+
+struct SimMailbox
+{
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::list<SimMessage> messages;
+
+  SimMailbox() : mutex(), cv(), messages()
+  {
+  }
+};
+
+// The links and mailboxes shared by the ranks of one run.
+class SimNetwork
+{
+public:
+  explicit SimNetwork(const Topology& topology) :
+      m_topology(topology),
+      m_links(topology.num_links()),
+      m_mailboxes(topology.num_ranks()),
+      m_stats_mutex(),
+      m_link_bytes(0),
+      m_messages(0),
+      m_aborted(false)
+  {
+    for (size_t i = 0; i < m_links.size(); ++i) {
+      m_links[i].reset(new SimLink());
+    }
+    for (size_t i = 0; i < m_mailboxes.size(); ++i) {
+      m_mailboxes[i].reset(new SimMailbox());
+    }
+  }
+
+  // Copy `shards` to rank `dst` without waiting for the transfer. Each link
+  // on the route is busy for bytes / bandwidth, and the message arrives
+  // after the slowest link plus the latency of every hop. Returns the
+  // arrival time.
+  SimClock::time_point send(
+      const size_t src,
+      const size_t dst,
+      const int tag,
+      const std::vector<const SimShard*>& shards)
+  {
+    SimMessage message;
+    message.src = src;
+    message.tag = tag;
+    size_t bytes = 0;
+    for (const SimShard* shard : shards) {
+      message.shards.push_back(*shard);
+      bytes += shard->data.size();
+    }
+
+    std::vector<size_t> route = m_topology.route(src, dst);
+    double busy = 0;
+    double latency = 0;
+    for (const size_t link_id : route) {
+      const LinkModel model = m_topology.link(link_id);
+      if (model.bandwidth > 0) {
+        busy = std::max(busy, bytes / model.bandwidth);
+      }
+      latency += model.latency;
+    }
+    const SimClock::duration busy_time
+        = std::chrono::duration_cast<SimClock::duration>(
+            std::chrono::duration<double>(busy));
+    const SimClock::duration latency_time
+        = std::chrono::duration_cast<SimClock::duration>(
+            std::chrono::duration<double>(latency));
+
+    // Reserve the links in a fixed order, so concurrent sends can't
+    // deadlock.
+    std::sort(route.begin(), route.end());
+    std::vector<std::unique_lock<std::mutex>> locks;
+    SimClock::time_point start = SimClock::now();
+    for (const size_t link_id : route) {
+      locks.emplace_back(m_links[link_id]->mutex);
+      start = std::max(start, m_links[link_id]->free_at);
+    }
+    for (const size_t link_id : route) {
+      m_links[link_id]->free_at = start + busy_time;
+    }
+    locks.clear();
+    message.arrival = start + busy_time + latency_time;
+    const SimClock::time_point arrival = message.arrival;
+
+    {
+      std::lock_guard<std::mutex> lock(m_stats_mutex);
+      m_link_bytes += bytes * route.size();
+      ++m_messages;
+    }
+
+    SimMailbox& mailbox = *m_mailboxes[dst];
+    {
+      std::lock_guard<std::mutex> lock(mailbox.mutex);
+      mailbox.messages.push_back(std::move(message));
+    }
+    mailbox.cv.notify_all();
+    return arrival;
+  }
+
+  // Wait for the message from `src` with `tag` to arrive at `dst`.
+  std::vector<SimShard> recv(const size_t dst, const size_t src, const int tag)
+  {
+    SimMailbox& mailbox = *m_mailboxes[dst];
+    SimMessage message;
+    {
+      std::unique_lock<std::mutex> lock(mailbox.mutex);
+      std::list<SimMessage>::iterator it;
+      mailbox.cv.wait(lock, [&]() {
+        if (m_aborted) {
+          return true;
+        }
+        it = std::find_if(
+            mailbox.messages.begin(),
+            mailbox.messages.end(),
+            [src, tag](const SimMessage& m) {
+              return m.src == src && m.tag == tag;
+            });
+        return it != mailbox.messages.end();
+      });
+      if (m_aborted) {
+        throw std::runtime_error("Allgather aborted by another rank.");
+      }
+      message = std::move(*it);
+      mailbox.messages.erase(it);
+    }
+    std::this_thread::sleep_until(message.arrival);
+    return std::move(message.shards);
+  }
+
+  // Make every pending and future recv() throw, e.g. once a rank failed and
+  // the messages it owes will never be sent.
+  void abort()
+  {
+    m_aborted = true;
+    for (const std::unique_ptr<SimMailbox>& mailbox : m_mailboxes) {
+      // Taking the lock orders the flag before a waiter re-checks it.
+      { std::lock_guard<std::mutex> lock(mailbox->mutex); }
+      mailbox->cv.notify_all();
+    }
+  }
+
+  size_t link_bytes() const
+  {
+    return m_link_bytes;
+  }
+
+  size_t messages() const
+  {
+    return m_messages;
+  }
+
+private:
+  const Topology& m_topology;
+  std::vector<std::unique_ptr<SimLink>> m_links;
+  std::vector<std::unique_ptr<SimMailbox>> m_mailboxes;
+  std::mutex m_stats_mutex;
+  size_t m_link_bytes;
+  size_t m_messages;
+  std::atomic<bool> m_aborted;
+};
+
+// The shards one rank holds during an allgather.
+class SimRank
+{
+public:
+  SimRank(SimNetwork& network, const size_t rank, const size_t num_ranks) :
+      m_network(network),
+      m_rank(rank),
+      m_num_ranks(num_ranks),
+      m_shards(num_ranks),
+      m_held(num_ranks, false)
+  {
+  }
+
+  size_t rank() const
+  {
+    return m_rank;
+  }
+
+  size_t num_ranks() const
+  {
+    return m_num_ranks;
+  }
+
+  void set(const size_t index, std::vector<uint8_t> data)
+  {
+    m_shards[index].index = index;
+    m_shards[index].data = std::move(data);
+    m_held[index] = true;
+  }
+
+  std::vector<uint8_t>& shard(const size_t index)
+  {
+    return m_shards[index].data;
+  }
+
+  // Send the shards in [first, first + count), wrapping around.
+  void send_range(
+      const size_t dst, const int tag, const size_t first, const size_t count)
+  {
+    std::vector<const SimShard*> shards;
+    for (size_t k = 0; k < count; ++k) {
+      const size_t index = (first + k) % m_num_ranks;
+      if (!m_held[index]) {
+        throw std::logic_error("Allgather sends a shard it doesn't hold.");
+      }
+      shards.push_back(&m_shards[index]);
+    }
+    m_network.send(m_rank, dst, tag, shards);
+  }
+
+  void send_held(const size_t dst, const int tag)
+  {
+    std::vector<const SimShard*> shards;
+    for (size_t i = 0; i < m_num_ranks; ++i) {
+      if (m_held[i]) {
+        shards.push_back(&m_shards[i]);
+      }
+    }
+    m_network.send(m_rank, dst, tag, shards);
+  }
+
+  void recv(const size_t src, const int tag)
+  {
+    std::vector<SimShard> shards = m_network.recv(m_rank, src, tag);
+    for (SimShard& shard : shards) {
+      set(shard.index, std::move(shard.data));
+    }
+  }
+
+  bool holds_all() const
+  {
+    return std::find(m_held.begin(), m_held.end(), false) == m_held.end();
+  }
+
+private:
+  SimNetwork& m_network;
+  size_t m_rank;
+  size_t m_num_ranks;
+  std::vector<SimShard> m_shards;
+  std::vector<bool> m_held;
+};
+
+inline void allgather_naive(SimRank& self)
+{
+  const size_t n = self.num_ranks();
+  const size_t r = self.rank();
+  // Start with the next rank, so that not everyone sends to rank 0 first.
+  for (size_t k = 1; k < n; ++k) {
+    self.send_range((r + k) % n, 0, r, 1);
+  }
+  for (size_t k = 1; k < n; ++k) {
+    self.recv((r + n - k) % n, 0);
+  }
+}
+
+inline void allgather_ring(SimRank& self)
+{
+  const size_t n = self.num_ranks();
+  const size_t r = self.rank();
+  const size_t right = (r + 1) % n;
+  const size_t left = (r + n - 1) % n;
+  for (size_t step = 0; step + 1 < n; ++step) {
+    self.send_range(right, static_cast<int>(step), (r + n - step) % n, 1);
+    self.recv(left, static_cast<int>(step));
+  }
+}
+
+inline void allgather_recursive_doubling(SimRank& self)
+{
+  const size_t n = self.num_ranks();
+  const size_t r = self.rank();
+  int tag = 0;
+  for (size_t mask = 1; mask < n; mask <<= 1, ++tag) {
+    // Before this step, a rank holds the `mask` shards of its aligned block.
+    self.send_range(r ^ mask, tag, r & ~(mask - 1), mask);
+    self.recv(r ^ mask, tag);
+  }
+}
+
+inline void allgather_tree(SimRank& self)
+{
+  const size_t n = self.num_ranks();
+  const size_t r = self.rank();
+  const int gather_tag = 0;
+  const int bcast_tag = 1;
+
+  // Binomial gather: rank r collects the subtrees r + mask, then hands its
+  // shards to r - mask at its lowest set bit.
+  size_t mask = 1;
+  for (; mask < n; mask <<= 1) {
+    if ((r & mask) != 0) {
+      self.send_held(r - mask, gather_tag);
+      break;
+    }
+    if (r + mask < n) {
+      self.recv(r + mask, gather_tag);
+    }
+  }
+
+  // Binomial broadcast down the same tree.
+  size_t top = 1;
+  while (top < n) {
+    top <<= 1;
+  }
+  for (mask = top >> 1; mask > 0; mask >>= 1) {
+    if (r % (2 * mask) == 0) {
+      if (r + mask < n) {
+        self.send_held(r + mask, bcast_tag);
+      }
+    } else if (r % (2 * mask) == mask) {
+      self.recv(r - mask, bcast_tag);
+    }
+  }
+}
+
+class SimBarrier
+{
+public:
+  explicit SimBarrier(const size_t count) :
+      m_mutex(), m_cv(), m_count(count), m_waiting(0), m_aborted(false)
+  {
+  }
+
+  void wait()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (++m_waiting == m_count) {
+      m_cv.notify_all();
+    } else {
+      m_cv.wait(
+          lock, [this]() { return m_waiting == m_count || m_aborted; });
+    }
+    if (m_waiting != m_count) {
+      throw std::runtime_error("Allgather aborted by another rank.");
+    }
+  }
+
+  // Release the waiting threads, which then throw, and make any later
+  // wait() that can't complete throw as well.
+  void abort()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_aborted = true;
+    }
+    m_cv.notify_all();
+  }
+
+private:
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  size_t m_count;
+  size_t m_waiting;
+  bool m_aborted;
+};
+
+inline double seconds_between(
+    const SimClock::time_point start, const SimClock::time_point end)
+{
+  return std::chrono::duration<double>(end - start).count();
+}
+
+inline double busy_seconds(const std::vector<StreamInterval>& timeline)
+{
+  double seconds = 0;
+  for (const StreamInterval& interval : timeline) {
+    seconds += seconds_between(interval.begin, interval.end);
+  }
+  return seconds;
+}
+
+/**
+ * @brief The Pipelined allgather.
+ *
+ * Every rank has a compression, a transfer and a decompression stream, like
+ * a GPU with one stream per engine. Sub-chunk k of a shard is compressed,
+ * then sent to all other ranks by the transfer stream, which stays busy
+ * until it arrived everywhere, and each receiver decompresses it after
+ * waiting on the sender's event. The streams run ahead of each other, so
+ * compressing sub-chunk k + 1 overlaps sending k and decompressing k - 1.
+ */
+inline AllgatherStats pipelined_allgather(
+    const Topology& topology,
+    const std::vector<std::vector<uint8_t>>& shards,
+    const AllgatherOptions& options,
+    ThreadPool& pool)
+{
+  const size_t n = topology.num_ranks();
+  const size_t piece = options.pipeline_chunk_size;
+  if (piece == 0) {
+    throw std::runtime_error("Pipeline chunk size must be positive.");
+  }
+
+  std::vector<size_t> num_pieces(n);
+  size_t max_pieces = 0;
+  for (size_t r = 0; r < n; ++r) {
+    num_pieces[r] = std::max<size_t>(1, (shards[r].size() + piece - 1) / piece);
+    max_pieces = std::max(max_pieces, num_pieces[r]);
+  }
+
+  SimNetwork network(topology);
+  std::vector<std::unique_ptr<HostStream>> compress_streams(n);
+  std::vector<std::unique_ptr<HostStream>> transfer_streams(n);
+  std::vector<std::unique_ptr<HostStream>> decompress_streams(n);
+  // Each stream has its own manager, as each GPU stream would.
+  std::vector<std::unique_ptr<HostManager>> compressors(n);
+  std::vector<std::unique_ptr<HostManager>> decompressors(n);
+  std::vector<std::vector<SimShard>> pieces(n);
+  std::vector<std::vector<HostEvent>> compressed(n);
+  std::vector<std::vector<HostEvent>> sent(n);
+  std::vector<std::vector<std::vector<uint8_t>>> gathered(n);
+  for (size_t r = 0; r < n; ++r) {
+    compress_streams[r].reset(new HostStream(true));
+    transfer_streams[r].reset(new HostStream(true));
+    decompress_streams[r].reset(new HostStream(true));
+    if (options.codec) {
+      compressors[r].reset(new HostManager(
+          options.codec, options.chunk_size, NoComputeNoVerify, pool));
+      decompressors[r].reset(new HostManager(
+          options.codec, options.chunk_size, NoComputeNoVerify, pool));
+    }
+    pieces[r].resize(num_pieces[r]);
+    compressed[r].resize(num_pieces[r]);
+    sent[r].resize(num_pieces[r]);
+    gathered[r].resize(n);
+    for (size_t src = 0; src < n; ++src) {
+      gathered[r][src].resize(shards[src].size());
+    }
+    gathered[r][r] = shards[r];
+  }
+
+  const SimClock::time_point start = SimClock::now();
+
+  // Events are recorded before anything waits on them, so issue the stages
+  // in pipeline order.
+  for (size_t r = 0; r < n; ++r) {
+    HostManager* const manager = compressors[r].get();
+    for (size_t k = 0; k < num_pieces[r]; ++k) {
+      const size_t begin = std::min(shards[r].size(), k * piece);
+      const size_t bytes = std::min(piece, shards[r].size() - begin);
+      SimShard& out = pieces[r][k];
+      out.index = r;
+      const uint8_t* const in = shards[r].data() + begin;
+      compress_streams[r]->enqueue(
+          [manager, in, bytes, &out]() {
+            if (manager == nullptr) {
+              out.data.assign(in, in + bytes);
+              return;
+            }
+            const CompressionConfig config
+                = manager->configure_compression(bytes);
+            out.data.resize(config.max_compressed_buffer_size);
+            size_t frame_size = 0;
+            manager->compress(in, out.data.data(), config, &frame_size);
+            out.data.resize(frame_size);
+          },
+          k);
+      compress_streams[r]->record(compressed[r][k]);
+    }
+  }
+
+  for (size_t r = 0; r < n; ++r) {
+    for (size_t k = 0; k < num_pieces[r]; ++k) {
+      const SimShard* const out = &pieces[r][k];
+      transfer_streams[r]->wait(compressed[r][k]);
+      transfer_streams[r]->enqueue(
+          [&network, r, n, k, out]() {
+            // Start with the next rank, as allgather_naive does.
+            SimClock::time_point arrival = SimClock::now();
+            for (size_t j = 1; j < n; ++j) {
+              arrival = std::max(
+                  arrival,
+                  network.send(
+                      r,
+                      (r + j) % n,
+                      static_cast<int>(k),
+                      std::vector<const SimShard*>(1, out)));
+            }
+            std::this_thread::sleep_until(arrival);
+          },
+          k);
+      transfer_streams[r]->record(sent[r][k]);
+    }
+  }
+
+  for (size_t r = 0; r < n; ++r) {
+    HostManager* const manager = decompressors[r].get();
+    for (size_t k = 0; k < max_pieces; ++k) {
+      for (size_t j = 1; j < n; ++j) {
+        const size_t src = (r + n - j) % n;
+        if (k >= num_pieces[src]) {
+          continue;
+        }
+        uint8_t* const out = gathered[r][src].data() + k * piece;
+        const size_t out_bytes
+            = std::min(piece, gathered[r][src].size() - k * piece);
+        decompress_streams[r]->wait(sent[src][k]);
+        decompress_streams[r]->enqueue(
+            [&network, manager, r, src, k, out, out_bytes]() {
+              const std::vector<SimShard> received
+                  = network.recv(r, src, static_cast<int>(k));
+              const std::vector<uint8_t>& frame = received[0].data;
+              if (manager == nullptr) {
+                if (frame.size() != out_bytes) {
+                  throw std::runtime_error("Received a truncated shard.");
+                }
+                std::copy(frame.begin(), frame.end(), out);
+                return;
+              }
+              const size_t frame_size = frame.size();
+              const DecompressionConfig config
+                  = manager->configure_decompression(frame.data(), &frame_size);
+              if (config.decomp_data_size != out_bytes) {
+                throw std::runtime_error("Received a truncated shard.");
+              }
+              manager->decompress(out, frame.data(), config, &frame_size);
+              if (*config.get_status() != nvcompSuccess) {
+                throw std::runtime_error("Failed to decompress a shard.");
+              }
+            },
+            k);
+      }
+    }
+  }
+
+  // Wait for every stream before rethrowing, since the tasks reference the
+  // locals above.
+  std::exception_ptr error;
+  for (size_t r = 0; r < n; ++r) {
+    for (HostStream* stream :
+         {compress_streams[r].get(),
+          transfer_streams[r].get(),
+          decompress_streams[r].get()}) {
+      try {
+        stream->synchronize();
+      } catch (...) {
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+    }
+  }
+  const SimClock::time_point end = SimClock::now();
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  AllgatherStats stats;
+  stats.seconds = seconds_between(start, end);
+  stats.compress_seconds = 0;
+  stats.exchange_seconds = 0;
+  stats.decompress_seconds = 0;
+  stats.uncompressed_bytes = 0;
+  stats.shard_bytes = 0;
+  stats.correct = true;
+  stats.overlap_fraction = 0;
+  for (size_t r = 0; r < n; ++r) {
+    stats.uncompressed_bytes += shards[r].size();
+    for (const SimShard& out : pieces[r]) {
+      stats.shard_bytes += out.data.size();
+    }
+    stats.correct = stats.correct && gathered[r] == shards;
+
+    const std::vector<std::vector<StreamInterval>> timelines
+        = {compress_streams[r]->timeline(),
+           transfer_streams[r]->timeline(),
+           decompress_streams[r]->timeline()};
+    stats.compress_seconds
+        = std::max(stats.compress_seconds, busy_seconds(timelines[0]));
+    stats.exchange_seconds
+        = std::max(stats.exchange_seconds, busy_seconds(timelines[1]));
+    stats.decompress_seconds
+        = std::max(stats.decompress_seconds, busy_seconds(timelines[2]));
+    stats.overlap_fraction += overlap_fraction(timelines) / n;
+
+    const PipelineStage stages[]
+        = {PipelineStage::Compress,
+           PipelineStage::Transfer,
+           PipelineStage::Decompress};
+    for (size_t s = 0; s < timelines.size(); ++s) {
+      for (const StreamInterval& interval : timelines[s]) {
+        PipelineInterval event;
+        event.rank = r;
+        event.stage = stages[s];
+        event.chunk = interval.tag;
+        event.begin = seconds_between(start, interval.begin);
+        event.end = seconds_between(start, interval.end);
+        stats.timeline.push_back(event);
+      }
+    }
+  }
+  stats.link_bytes = network.link_bytes();
+  stats.messages = network.messages();
+  return stats;
+}
+
+} // namespace detail
+
+/**
+ * @brief Simulate an allgather of `shards` between the ranks of `topology`.
+ *
+ * Rank i starts with shards[i], and one thread runs each rank. With a
+ * codec, every rank compresses its shard into a host frame (see
+ * host_manager.h) before sending, forwards the frames it receives as they
+ * are, and decompresses all of them at the end. Transfers are real copies,
+ * delayed to the arrival time the links give them, so the compression and
+ * decompression times are measured while the transfer times are modelled.
+ * The sleep granularity of the OS, typically tens of microseconds, limits
+ * how well small latencies are modelled.
+ *
+ * The other algorithms run the three phases one after another. Pipelined
+ * compresses, sends and decompresses every options.pipeline_chunk_size
+ * bytes of a shard as a separate frame on HostStreams, and also returns
+ * the timeline of every stage.
+ */
+inline AllgatherStats run_allgather(
+    const Topology& topology,
+    const AllgatherAlgorithm algorithm,
+    const std::vector<std::vector<uint8_t>>& shards,
+    const AllgatherOptions& options = AllgatherOptions())
+{
+  const size_t n = topology.num_ranks();
+  if (shards.size() != n) {
+    throw std::runtime_error("Allgather needs one shard per rank.");
+  }
+  if (algorithm == AllgatherAlgorithm::RecursiveDoubling
+      && (n & (n - 1)) != 0) {
+    throw std::runtime_error(
+        "Recursive doubling needs a power of two number of ranks.");
+  }
+  ThreadPool& pool
+      = options.pool != nullptr ? *options.pool : default_thread_pool();
+  if (algorithm == AllgatherAlgorithm::Pipelined) {
+    return detail::pipelined_allgather(topology, shards, options, pool);
+  }
+
+  detail::SimNetwork network(topology);
+  detail::SimBarrier barrier(n);
+  std::vector<std::unique_ptr<detail::SimRank>> ranks(n);
+  for (size_t r = 0; r < n; ++r) {
+    ranks[r].reset(new detail::SimRank(network, r, n));
+  }
+  std::vector<double> compress_seconds(n, 0);
+  std::vector<double> exchange_seconds(n, 0);
+  std::vector<double> decompress_seconds(n, 0);
+  std::vector<size_t> shard_bytes(n, 0);
+  std::vector<bool> correct(n, false);
+  // The first error of any rank. The others may be waiting for the failed
+  // rank at the barrier or for its messages, so they are released and fail
+  // too, but only the first error is reported.
+  std::mutex error_mutex;
+  std::exception_ptr error;
+
+  auto seconds_since = [](const detail::SimClock::time_point start) {
+    return std::chrono::duration<double>(detail::SimClock::now() - start)
+        .count();
+  };
+
+  detail::SimClock::time_point start;
+  auto run_rank = [&](const size_t r) {
+    try {
+      detail::SimRank& self = *ranks[r];
+      std::unique_ptr<HostManager> manager;
+      if (options.codec) {
+        manager.reset(new HostManager(
+            options.codec, options.chunk_size, NoComputeNoVerify, pool));
+      }
+
+      barrier.wait();
+      if (r == 0) {
+        start = detail::SimClock::now();
+      }
+      detail::SimClock::time_point phase = detail::SimClock::now();
+
+      if (manager) {
+        const CompressionConfig config
+            = manager->configure_compression(shards[r].size());
+        std::vector<uint8_t> frame(config.max_compressed_buffer_size);
+        size_t frame_size = 0;
+        manager->compress(shards[r].data(), frame.data(), config, &frame_size);
+        frame.resize(frame_size);
+        self.set(r, std::move(frame));
+      } else {
+        self.set(r, shards[r]);
+      }
+      shard_bytes[r] = self.shard(r).size();
+      compress_seconds[r] = seconds_since(phase);
+
+      phase = detail::SimClock::now();
+      switch (algorithm) {
+      case AllgatherAlgorithm::Naive:
+        detail::allgather_naive(self);
+        break;
+      case AllgatherAlgorithm::Ring:
+        detail::allgather_ring(self);
+        break;
+      case AllgatherAlgorithm::RecursiveDoubling:
+        detail::allgather_recursive_doubling(self);
+        break;
+      case AllgatherAlgorithm::Tree:
+        detail::allgather_tree(self);
+        break;
+      case AllgatherAlgorithm::Pipelined:
+        // Handled by detail::pipelined_allgather().
+        break;
+      }
+      exchange_seconds[r] = seconds_since(phase);
+
+      phase = detail::SimClock::now();
+      std::vector<std::vector<uint8_t>> gathered(n);
+      if (manager) {
+        for (size_t i = 0; i < n; ++i) {
+          if (i == r) {
+            gathered[i] = shards[r];
+            continue;
+          }
+          const uint8_t* const frame = self.shard(i).data();
+          const size_t frame_size = self.shard(i).size();
+          const DecompressionConfig config
+              = manager->configure_decompression(frame, &frame_size);
+          gathered[i].resize(config.decomp_data_size);
+          manager->decompress(gathered[i].data(), frame, config, &frame_size);
+          if (*config.get_status() != nvcompSuccess) {
+            throw std::runtime_error("Failed to decompress a shard.");
+          }
+        }
+      } else {
+        for (size_t i = 0; i < n; ++i) {
+          gathered[i] = std::move(self.shard(i));
+        }
+      }
+      decompress_seconds[r] = seconds_since(phase);
+
+      correct[r] = self.holds_all() && gathered == shards;
+    } catch (...) {
+      {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+      barrier.abort();
+      network.abort();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(n);
+  for (size_t r = 0; r < n; ++r) {
+    threads.emplace_back(run_rank, r);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  AllgatherStats stats;
+  stats.seconds = seconds_since(start);
+  stats.compress_seconds
+      = *std::max_element(compress_seconds.begin(), compress_seconds.end());
+  stats.exchange_seconds
+      = *std::max_element(exchange_seconds.begin(), exchange_seconds.end());
+  stats.decompress_seconds = *std::max_element(
+      decompress_seconds.begin(), decompress_seconds.end());
+  stats.uncompressed_bytes = 0;
+  stats.shard_bytes = 0;
+  for (size_t r = 0; r < n; ++r) {
+    stats.uncompressed_bytes += shards[r].size();
+    stats.shard_bytes += shard_bytes[r];
+  }
+  stats.link_bytes = network.link_bytes();
+  stats.messages = network.messages();
+  stats.correct
+      = std::find(correct.begin(), correct.end(), false) == correct.end();
+  stats.overlap_fraction = 0;
+  return stats;
+}
+
+} // namespace host
+} // namespace nvcomp
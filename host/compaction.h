@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/thread_pool.h"
+#include "host/trace.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace nvcomp
+{
+namespace host
+{
+
+// Compactions moving at least this many bytes write with non-temporal
+// stores: the result is larger than most last-level caches and is only read
+// again by the next transfer, so there is no point in polluting the cache
+// with it.
+static constexpr size_t STREAMING_COMPACTION_BYTES = 1 << 24;
+
+// Below this many chunks the prefix sum runs on the calling thread.
+static constexpr size_t PARALLEL_SCAN_MIN_CHUNKS = 1 << 14;
+
+/**
+ * @brief Copy `bytes` from `src` to `dst`, which must not overlap, bypassing
+ * the cache for the destination where the platform allows it.
+ *
+ * Falls back to memcpy without SSE2. The stores are fenced before returning,
+ * so the data is visible to other threads once they synchronize with this
+ * one.
+ */
+inline void stream_copy(void* const dst, const void* const src, size_t bytes)
+{
+#if defined(__SSE2__)
+  uint8_t* out = static_cast<uint8_t*>(dst);
+  const uint8_t* in = static_cast<const uint8_t*>(src);
+
+  // Non-temporal stores need an aligned destination.
+  const size_t head = std::min(
+      bytes, (16 - reinterpret_cast<uintptr_t>(out) % 16) % 16);
+  std::memcpy(out, in, head);
+  out += head;
+  in += head;
+  bytes -= head;
+
+  for (; bytes >= 64; bytes -= 64, out += 64, in += 64) {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+    const __m128i b
+        = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16));
+    const __m128i c
+        = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 32));
+    const __m128i d
+        = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 48));
+    _mm_stream_si128(reinterpret_cast<__m128i*>(out), a);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(out + 16), b);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(out + 32), c);
+    _mm_stream_si128(reinterpret_cast<__m128i*>(out + 48), d);
+  }
+  std::memcpy(out, in, bytes);
+  _mm_sfence();
+#else
+  std::memcpy(dst, src, bytes);
+#endif
+}
+
+/**
+ * @brief Exclusive prefix sum of `sizes`, i.e. the offset of every chunk
+ * when the chunks are packed back to back.
+ *
+ * The result has `n + 1` entries, the last one being the total. Large
+ * batches are scanned in parallel: every block of chunks is summed on the
+ * pool, the block totals are scanned serially, and the blocks are then
+ * scanned in parallel starting from their block's offset.
+ */
+inline std::vector<size_t>
+compaction_offsets(ThreadPool& pool, const size_t* const sizes, const size_t n)
+{
+  NVCOMP_TRACE_SCOPE("compaction offsets");
+  std::vector<size_t> offsets(n + 1);
+
+  if (n < PARALLEL_SCAN_MIN_CHUNKS || pool.num_threads() == 1) {
+    size_t offset = 0;
+    for (size_t i = 0; i < n; ++i) {
+      offsets[i] = offset;
+      offset += sizes[i];
+    }
+    offsets[n] = offset;
+    return offsets;
+  }
+
+  const size_t num_blocks = std::min(
+      pool.num_threads() * 4, n / (PARALLEL_SCAN_MIN_CHUNKS / 4));
+  const size_t block_chunks = (n + num_blocks - 1) / num_blocks;
+
+  std::vector<size_t> block_offsets(num_blocks + 1, 0);
+  pool.parallel_for(num_blocks, [&](const size_t b) {
+    const size_t end = std::min(n, (b + 1) * block_chunks);
+    size_t total = 0;
+    for (size_t i = b * block_chunks; i < end; ++i) {
+      total += sizes[i];
+    }
+    block_offsets[b + 1] = total;
+  });
+  for (size_t b = 0; b < num_blocks; ++b) {
+    block_offsets[b + 1] += block_offsets[b];
+  }
+
+  pool.parallel_for(num_blocks, [&](const size_t b) {
+    const size_t end = std::min(n, (b + 1) * block_chunks);
+    size_t offset = block_offsets[b];
+    for (size_t i = b * block_chunks; i < end; ++i) {
+      offsets[i] = offset;
+      offset += sizes[i];
+    }
+  });
+  offsets[n] = block_offsets[num_blocks];
+  return offsets;
+}
+
+/**
+ * @brief Pack the `n` chunks at `ptrs` back to back into `dst`, which must
+ * hold the sum of `sizes` and must not overlap any chunk.
+ *
+ * Returns the offset of every chunk in `dst`, as by compaction_offsets().
+ */
+inline std::vector<size_t> compact_chunks(
+    ThreadPool& pool,
+    const void* const* const ptrs,
+    const size_t* const sizes,
+    const size_t n,
+    void* const dst)
+{
+  std::vector<size_t> offsets = compaction_offsets(pool, sizes, n);
+
+  NVCOMP_TRACE_SCOPE("compact chunks");
+  uint8_t* const out = static_cast<uint8_t*>(dst);
+  const bool streaming = offsets[n] >= STREAMING_COMPACTION_BYTES;
+  pool.parallel_for(n, [&](const size_t i) {
+    if (streaming) {
+      stream_copy(out + offsets[i], ptrs[i], sizes[i]);
+    } else {
+      std::memcpy(out + offsets[i], ptrs[i], sizes[i]);
+    }
+  });
+  return offsets;
+}
+
+/**
+ * @brief Pack the `n` chunks at `ptrs` back to back at the start of `base`,
+ * the buffer holding them, e.g. compressed chunks sitting in worst-case
+ * sized slots. The chunks must be in ascending address order, must not
+ * overlap, and must all lie in the buffer. On return, `ptrs[i]` points at
+ * the moved chunk.
+ *
+ * A chunk's destination can overlap the source of an earlier chunk, so the
+ * moves can't all run at once. Instead, the chunks are moved in rounds: a
+ * round starting at chunk `a` takes every following chunk whose destination
+ * ends at or below the source of chunk `a`, so no move in the round touches
+ * a source that is still to be read. As the gap between the packed data and
+ * the remaining chunks grows, so do the rounds; with a compression ratio of
+ * `r` their size grows about geometrically by `r`. A round of a single chunk
+ * whose destination overlaps its own source uses memmove.
+ *
+ * Returns the offset of every chunk from `base`, as by compaction_offsets().
+ */
+inline std::vector<size_t> compact_chunks_in_place(
+    ThreadPool& pool,
+    void* const base,
+    void** const ptrs,
+    const size_t* const sizes,
+    const size_t n)
+{
+  uint8_t* const out = static_cast<uint8_t*>(base);
+  for (size_t i = 0; i < n; ++i) {
+    const uint8_t* const chunk = static_cast<const uint8_t*>(ptrs[i]);
+    const uint8_t* const floor
+        = i == 0 ? out
+                 : static_cast<const uint8_t*>(ptrs[i - 1]) + sizes[i - 1];
+    if (chunk < floor) {
+      throw std::runtime_error(
+          "Chunk " + std::to_string(i)
+          + " is out of order or overlaps the previous one.");
+    }
+  }
+
+  std::vector<size_t> offsets = compaction_offsets(pool, sizes, n);
+
+  NVCOMP_TRACE_SCOPE("compact chunks in place");
+  const bool streaming = offsets[n] >= STREAMING_COMPACTION_BYTES;
+  size_t begin = 0;
+  while (begin < n) {
+    const uint8_t* const round_floor = static_cast<uint8_t*>(ptrs[begin]);
+    size_t end = begin;
+    while (end < n && out + offsets[end + 1] <= round_floor) {
+      ++end;
+    }
+
+    if (end == begin) {
+      if (out + offsets[begin] != ptrs[begin]) {
+        std::memmove(out + offsets[begin], ptrs[begin], sizes[begin]);
+      }
+      end = begin + 1;
+    } else {
+      pool.parallel_for(end - begin, [&](const size_t k) {
+        const size_t i = begin + k;
+        if (streaming) {
+          stream_copy(out + offsets[i], ptrs[i], sizes[i]);
+        } else {
+          std::memcpy(out + offsets[i], ptrs[i], sizes[i]);
+        }
+      });
+    }
+    begin = end;
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    ptrs[i] = out + offsets[i];
+  }
+  return offsets;
+}
+
+} // namespace host
+} // namespace nvcomp
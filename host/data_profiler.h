@@ -0,0 +1,699 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace nvcomp
+{
+namespace host
+{
+
+// Element widths (in bytes) that typed statistics are computed for. These
+// match the 'char', 'short', 'int' and 'longlong' benchmark data types.
+constexpr size_t PROFILE_NUM_WIDTHS = 4;
+constexpr size_t PROFILE_WIDTHS[PROFILE_NUM_WIDTHS] = {1, 2, 4, 8};
+
+struct HostProfileOptions
+{
+  // Test every n-th position against the LZ match table. 1 tests all.
+  size_t lz_sample_stride;
+  // log2 of the number of entries in the LZ match table.
+  int lz_table_bits;
+};
+
+constexpr HostProfileOptions HostProfileDefaultOpts = {1, 12};
+
+// Statistics of a buffer interpreted as little-endian elements of one width.
+struct WidthProfile
+{
+  // Whether the buffer length is a multiple of the width, i.e. if the
+  // buffer could be compressed with this data type.
+  bool aligned;
+  size_t elements;
+  // Order-0 entropy, in bits per byte, of the bytes of the delta stream.
+  double delta_entropy;
+  // Number of runs of equal consecutive elements.
+  size_t runs;
+  double mean_run_length;
+  size_t max_run_length;
+  // Bits per element needed after frame-of-reference (value - min).
+  int for_bits;
+  // Bits per element needed after delta encoding and frame-of-reference.
+  int delta_for_bits;
+};
+
+struct DataProfile
+{
+  size_t chunks;
+  size_t bytes;
+  // Order-0 entropy in bits per byte.
+  double byte_entropy;
+  double zero_fraction;
+  // Fraction of the tested positions where a 4-byte match within the
+  // last 64 KB was found, an estimate of the bytes an LZ coder can cover.
+  double match_density;
+  WidthProfile widths[PROFILE_NUM_WIDTHS];
+};
+
+struct FormatRecommendation
+{
+  // One of the `benchmark_hlif` format names, or "none" if the data is
+  // unlikely to compress.
+  std::string format;
+  // The `--type` to use for typed formats, otherwise "char".
+  std::string data_type;
+  // Cascaded configuration, only meaningful if `format` is "cascaded".
+  int num_RLEs;
+  int num_deltas;
+  int use_bp;
+  double estimated_ratio;
+  std::string reason;
+
+  FormatRecommendation() :
+      format("none"),
+      data_type("char"),
+      num_RLEs(0),
+      num_deltas(0),
+      use_bp(0),
+      estimated_ratio(1.0),
+      reason()
+  {
+  }
+};
+
+namespace detail
+{
+
+inline int bits_needed(uint64_t range)
+{
+  int bits = 0;
+  while (range != 0) {
+    ++bits;
+    range >>= 1;
+  }
+  return bits;
+}
+
+inline double entropy(const uint64_t* hist, const size_t num_bins)
+{
+  uint64_t total = 0;
+  for (size_t i = 0; i < num_bins; ++i) {
+    total += hist[i];
+  }
+  if (total == 0) {
+    return 0.0;
+  }
+  double h = 0.0;
+  for (size_t i = 0; i < num_bins; ++i) {
+    if (hist[i] != 0) {
+      const double p = static_cast<double>(hist[i]) / total;
+      h -= p * std::log2(p);
+    }
+  }
+  return h;
+}
+
+inline uint64_t load_element(const uint8_t* ptr, const size_t width)
+{
+  uint64_t val = 0;
+  std::memcpy(&val, ptr, width);
+  return val;
+}
+
+inline int64_t sign_extend(const uint64_t val, const size_t width)
+{
+  const int shift = static_cast<int>(64 - 8 * width);
+  return static_cast<int64_t>(val << shift) >> shift;
+}
+
+inline const char* width_type_name(const size_t width)
+{
+  switch (width) {
+  case 1:
+    return "char";
+  case 2:
+    return "short";
+  case 4:
+    return "int";
+  default:
+    return "longlong";
+  }
+}
+
+} // namespace detail
+
+// Raw counts behind a DataProfile. Accumulators of separate chunks can be
+// merged to get exact statistics over a whole batch.
+class ProfileAccumulator
+{
+public:
+  ProfileAccumulator() :
+      m_byte_hist(),
+      m_delta_hist(),
+      m_widths(),
+      m_chunks(0),
+      m_bytes(0),
+      m_lz_samples(0),
+      m_lz_matches(0)
+  {
+    reset();
+  }
+
+  void reset()
+  {
+    std::memset(m_byte_hist, 0, sizeof(m_byte_hist));
+    std::memset(m_delta_hist, 0, sizeof(m_delta_hist));
+    m_chunks = 0;
+    m_bytes = 0;
+    m_lz_samples = 0;
+    m_lz_matches = 0;
+    for (size_t w = 0; w < PROFILE_NUM_WIDTHS; ++w) {
+      WidthCounts& c = m_widths[w];
+      c.aligned = true;
+      c.elements = 0;
+      c.runs = 0;
+      c.max_run = 0;
+      c.min = std::numeric_limits<uint64_t>::max();
+      c.max = 0;
+      c.delta_min = std::numeric_limits<int64_t>::max();
+      c.delta_max = std::numeric_limits<int64_t>::min();
+    }
+  }
+
+  void add_chunk(
+      const void* const ptr,
+      const size_t bytes,
+      const HostProfileOptions& opts = HostProfileDefaultOpts)
+  {
+    const uint8_t* const data = static_cast<const uint8_t*>(ptr);
+
+    ++m_chunks;
+    m_bytes += bytes;
+
+    for (size_t i = 0; i < bytes; ++i) {
+      ++m_byte_hist[data[i]];
+    }
+
+    for (size_t w = 0; w < PROFILE_NUM_WIDTHS; ++w) {
+      add_width(data, bytes, w);
+    }
+
+    add_matches(data, bytes, opts);
+  }
+
+  void merge(const ProfileAccumulator& other)
+  {
+    for (size_t i = 0; i < 256; ++i) {
+      m_byte_hist[i] += other.m_byte_hist[i];
+    }
+    for (size_t w = 0; w < PROFILE_NUM_WIDTHS; ++w) {
+      for (size_t i = 0; i < 256; ++i) {
+        m_delta_hist[w][i] += other.m_delta_hist[w][i];
+      }
+      WidthCounts& c = m_widths[w];
+      const WidthCounts& o = other.m_widths[w];
+      c.aligned = c.aligned && o.aligned;
+      c.elements += o.elements;
+      c.runs += o.runs;
+      c.max_run = std::max(c.max_run, o.max_run);
+      c.min = std::min(c.min, o.min);
+      c.max = std::max(c.max, o.max);
+      c.delta_min = std::min(c.delta_min, o.delta_min);
+      c.delta_max = std::max(c.delta_max, o.delta_max);
+    }
+    m_chunks += other.m_chunks;
+    m_bytes += other.m_bytes;
+    m_lz_samples += other.m_lz_samples;
+    m_lz_matches += other.m_lz_matches;
+  }
+
+  DataProfile finalize() const
+  {
+    DataProfile profile;
+    profile.chunks = m_chunks;
+    profile.bytes = m_bytes;
+    profile.byte_entropy = detail::entropy(m_byte_hist, 256);
+    profile.zero_fraction
+        = m_bytes == 0 ? 0.0 : static_cast<double>(m_byte_hist[0]) / m_bytes;
+    profile.match_density
+        = m_lz_samples == 0
+              ? 0.0
+              : static_cast<double>(m_lz_matches) / m_lz_samples;
+
+    for (size_t w = 0; w < PROFILE_NUM_WIDTHS; ++w) {
+      const WidthCounts& c = m_widths[w];
+      WidthProfile& wp = profile.widths[w];
+      wp.aligned = c.aligned;
+      wp.elements = c.elements;
+      wp.delta_entropy = detail::entropy(m_delta_hist[w], 256);
+      wp.runs = c.runs;
+      wp.mean_run_length
+          = c.runs == 0 ? 0.0 : static_cast<double>(c.elements) / c.runs;
+      wp.max_run_length = c.max_run;
+      wp.for_bits = c.elements == 0 ? 0 : detail::bits_needed(c.max - c.min);
+      // The range is computed modulo 2^64, which is exact since
+      // delta_max >= delta_min.
+      wp.delta_for_bits
+          = c.delta_min > c.delta_max
+                ? 0
+                : detail::bits_needed(
+                    static_cast<uint64_t>(c.delta_max)
+                    - static_cast<uint64_t>(c.delta_min));
+    }
+    return profile;
+  }
+
+private:
+  struct WidthCounts
+  {
+    bool aligned;
+    size_t elements;
+    size_t runs;
+    size_t max_run;
+    uint64_t min;
+    uint64_t max;
+    int64_t delta_min;
+    int64_t delta_max;
+  };
+
+  void add_width(const uint8_t* const data, const size_t bytes, const size_t w)
+  {
+    switch (PROFILE_WIDTHS[w]) {
+    case 1:
+      add_width<1>(data, bytes, w);
+      break;
+    case 2:
+      add_width<2>(data, bytes, w);
+      break;
+    case 4:
+      add_width<4>(data, bytes, w);
+      break;
+    default:
+      add_width<8>(data, bytes, w);
+      break;
+    }
+  }
+
+  template <size_t width>
+  void add_width(const uint8_t* const data, const size_t bytes, const size_t w)
+  {
+    const size_t num = bytes / width;
+    WidthCounts& c = m_widths[w];
+    uint64_t* const delta_hist = m_delta_hist[w];
+
+    c.aligned = c.aligned && (bytes % width == 0);
+    if (num == 0) {
+      return;
+    }
+
+    const uint64_t mask
+        = width == 8 ? ~uint64_t(0) : (uint64_t(1) << (8 * width)) - 1;
+
+    uint64_t prev = detail::load_element(data, width);
+    uint64_t min = prev;
+    uint64_t max = prev;
+    int64_t delta_min = c.delta_min;
+    int64_t delta_max = c.delta_max;
+    size_t runs = 1;
+    size_t run = 1;
+    size_t max_run = c.max_run;
+    for (size_t i = 1; i < num; ++i) {
+      const uint64_t val = detail::load_element(data + i * width, width);
+      min = std::min(min, val);
+      max = std::max(max, val);
+
+      const uint64_t delta = (val - prev) & mask;
+      for (size_t b = 0; b < width; ++b) {
+        ++delta_hist[(delta >> (8 * b)) & 0xff];
+      }
+      const int64_t sdelta = detail::sign_extend(delta, width);
+      delta_min = std::min(delta_min, sdelta);
+      delta_max = std::max(delta_max, sdelta);
+
+      if (val == prev) {
+        ++run;
+      } else {
+        max_run = std::max(max_run, run);
+        run = 1;
+        ++runs;
+      }
+      prev = val;
+    }
+    max_run = std::max(max_run, run);
+
+    c.elements += num;
+    c.runs += runs;
+    c.max_run = max_run;
+    c.min = std::min(c.min, min);
+    c.max = std::max(c.max, max);
+    c.delta_min = delta_min;
+    c.delta_max = delta_max;
+  }
+
+  void add_matches(
+      const uint8_t* const data,
+      const size_t bytes,
+      const HostProfileOptions& opts)
+  {
+    if (bytes < 4) {
+      return;
+    }
+    constexpr size_t MAX_DISTANCE = 1 << 16;
+    const int shift = 32 - opts.lz_table_bits;
+    const size_t stride = std::max<size_t>(opts.lz_sample_stride, 1);
+
+    // Positions are stored off by one, so that zero marks an empty slot.
+    std::vector<uint32_t> table(size_t(1) << opts.lz_table_bits, 0);
+    for (size_t i = 0; i + 4 <= bytes; i += stride) {
+      uint32_t seq;
+      std::memcpy(&seq, data + i, sizeof(seq));
+      const uint32_t hash = (seq * 2654435761u) >> shift;
+      const uint32_t candidate = table[hash];
+      if (candidate != 0 && i - (candidate - 1) <= MAX_DISTANCE) {
+        uint32_t prev_seq;
+        std::memcpy(&prev_seq, data + candidate - 1, sizeof(prev_seq));
+        m_lz_matches += prev_seq == seq;
+      }
+      table[hash] = static_cast<uint32_t>(i + 1);
+      ++m_lz_samples;
+    }
+  }
+
+  uint64_t m_byte_hist[256];
+  uint64_t m_delta_hist[PROFILE_NUM_WIDTHS][256];
+  WidthCounts m_widths[PROFILE_NUM_WIDTHS];
+  size_t m_chunks;
+  size_t m_bytes;
+  size_t m_lz_samples;
+  size_t m_lz_matches;
+};
+
+inline DataProfile profile_chunk(
+    const void* const ptr,
+    const size_t bytes,
+    const HostProfileOptions& opts = HostProfileDefaultOpts)
+{
+  ProfileAccumulator acc;
+  acc.add_chunk(ptr, bytes, opts);
+  return acc.finalize();
+}
+
+struct BatchProfile
+{
+  std::vector<DataProfile> chunks;
+  DataProfile aggregate;
+
+  BatchProfile() : chunks(), aggregate()
+  {
+  }
+};
+
+// Profile every chunk of a batch in parallel, and the batch as a whole.
+inline BatchProfile profile_batch(
+    const void* const* const ptrs,
+    const size_t* const sizes,
+    const size_t batch_size,
+    ThreadPool& pool = default_thread_pool(),
+    const HostProfileOptions& opts = HostProfileDefaultOpts)
+{
+  BatchProfile result;
+  result.chunks.resize(batch_size);
+
+  // Chunks are processed in contiguous ranges, each with one aggregate
+  // accumulator, so that the aggregate doesn't need a lock.
+  const size_t num_ranges
+      = std::max<size_t>(1, std::min(batch_size, 4 * pool.num_threads()));
+  std::vector<ProfileAccumulator> range_accs(num_ranges);
+  pool.parallel_for(num_ranges, [&](const size_t r) {
+    const size_t begin = batch_size * r / num_ranges;
+    const size_t end = batch_size * (r + 1) / num_ranges;
+    ProfileAccumulator chunk_acc;
+    for (size_t i = begin; i < end; ++i) {
+      chunk_acc.reset();
+      chunk_acc.add_chunk(ptrs[i], sizes[i], opts);
+      result.chunks[i] = chunk_acc.finalize();
+      range_accs[r].merge(chunk_acc);
+    }
+  });
+
+  for (size_t r = 1; r < num_ranges; ++r) {
+    range_accs[0].merge(range_accs[r]);
+  }
+  result.aggregate = range_accs[0].finalize();
+  return result;
+}
+
+inline BatchProfile profile_batch(
+    const std::vector<std::vector<char>>& data,
+    ThreadPool& pool = default_thread_pool(),
+    const HostProfileOptions& opts = HostProfileDefaultOpts)
+{
+  std::vector<const void*> ptrs(data.size());
+  std::vector<size_t> sizes(data.size());
+  for (size_t i = 0; i < data.size(); ++i) {
+    ptrs[i] = data[i].data();
+    sizes[i] = data[i].size();
+  }
+  return profile_batch(ptrs.data(), sizes.data(), data.size(), pool, opts);
+}
+
+namespace detail
+{
+
+inline bool format_allowed(
+    const std::vector<std::string>& allowed, const char* format)
+{
+  return allowed.empty()
+         || std::find(allowed.begin(), allowed.end(), format) != allowed.end();
+}
+
+} // namespace detail
+
+// Pick a format from the profile by estimating the bits per input byte
+// each family of compressors would produce. The estimates are coarse: they
+// are meant to rank the families, not to predict exact ratios.
+//
+// If `allowed` is not empty, only the listed formats are considered, and
+// formats of the same family stand in for each other (snappy for lz4,
+// deflate or gdeflate for zstd, bitcomp for cascaded).
+inline FormatRecommendation recommend_format(
+    const DataProfile& profile,
+    const std::vector<std::string>& allowed = std::vector<std::string>())
+{
+  FormatRecommendation rec;
+
+  if (profile.bytes == 0) {
+    rec.reason = "empty input";
+    return rec;
+  }
+
+  // Literals cost a full byte for LZ4 style coders and roughly the order-0
+  // entropy for coders with an entropy stage, while matched bytes are
+  // nearly free.
+  const double m = profile.match_density;
+  const double lz_bits = 8.0 * (1.0 - m) + 0.25;
+  const double lz_entropy_bits = profile.byte_entropy * (1.0 - m) + 0.2;
+  const double entropy_bits = profile.byte_entropy + 0.05;
+
+  const char* lz_format = detail::format_allowed(allowed, "lz4")     ? "lz4"
+                          : detail::format_allowed(allowed, "snappy") ? "snappy"
+                                                                      : nullptr;
+  const char* lz_entropy_format
+      = detail::format_allowed(allowed, "zstd")       ? "zstd"
+        : detail::format_allowed(allowed, "deflate")  ? "deflate"
+        : detail::format_allowed(allowed, "gdeflate") ? "gdeflate"
+                                                      : nullptr;
+  const bool use_cascaded = detail::format_allowed(allowed, "cascaded");
+  const bool use_bitcomp
+      = !use_cascaded && detail::format_allowed(allowed, "bitcomp");
+
+  double best_bits = 8.0;
+  std::ostringstream reason;
+
+  // Numeric schemes: try each aligned width with bitpacking after
+  // frame-of-reference, after a delta, or after RLE. Bitcomp is only
+  // credited with the first two.
+  for (size_t w = 0; w < PROFILE_NUM_WIDTHS; ++w) {
+    const WidthProfile& wp = profile.widths[w];
+    const double width_bits = 8.0 * PROFILE_WIDTHS[w];
+    if ((!use_cascaded && !use_bitcomp) || !wp.aligned || wp.elements == 0) {
+      continue;
+    }
+    const double bp_bits = wp.for_bits / width_bits * 8.0;
+    const double delta_bits = wp.delta_for_bits / width_bits * 8.0;
+    const int run_bits = detail::bits_needed(wp.max_run_length);
+    const double rle_bits = static_cast<double>(wp.runs) / wp.elements
+                            * (wp.for_bits + run_bits) / width_bits * 8.0;
+
+    int rles = 0;
+    int deltas = 0;
+    double bits = bp_bits;
+    if (delta_bits < bits) {
+      bits = delta_bits;
+      deltas = 1;
+    }
+    if (use_cascaded && rle_bits < bits) {
+      bits = rle_bits;
+      rles = 1;
+      deltas = 0;
+    }
+    if (bits < best_bits) {
+      best_bits = bits;
+      rec.format = use_cascaded ? "cascaded" : "bitcomp";
+      rec.data_type = detail::width_type_name(PROFILE_WIDTHS[w]);
+      rec.num_RLEs = rles;
+      rec.num_deltas = deltas;
+      rec.use_bp = 1;
+      reason.str("");
+      reason << PROFILE_WIDTHS[w] << "-byte elements need "
+             << (rles ? "few runs" : deltas ? "few delta bits" : "few bits")
+             << " (for_bits=" << wp.for_bits
+             << ", delta_for_bits=" << wp.delta_for_bits
+             << ", mean_run=" << std::fixed << std::setprecision(1)
+             << wp.mean_run_length << ")";
+    }
+  }
+
+  if (detail::format_allowed(allowed, "ans") && entropy_bits < best_bits) {
+    best_bits = entropy_bits;
+    rec.format = "ans";
+    rec.data_type = "char";
+    reason.str("");
+    reason << "skewed byte distribution without repeats (entropy="
+           << std::fixed << std::setprecision(2) << profile.byte_entropy
+           << ", match_density=" << m << ")";
+  }
+  if (lz_entropy_format && lz_entropy_bits < best_bits) {
+    best_bits = lz_entropy_bits;
+    rec.format = lz_entropy_format;
+    rec.data_type = "char";
+    reason.str("");
+    reason << "repeated strings and skewed literals (entropy=" << std::fixed
+           << std::setprecision(2) << profile.byte_entropy
+           << ", match_density=" << m << ")";
+  }
+  // LZ4 trades a little ratio for much higher throughput, so prefer it
+  // whenever it is within 15% of the best estimate.
+  if (lz_format && lz_bits < 1.15 * best_bits && rec.format != "cascaded"
+      && rec.format != "bitcomp") {
+    best_bits = std::min(best_bits, lz_bits);
+    rec.format = lz_format;
+    rec.data_type = "char";
+    reason.str("");
+    reason << "mostly repeated strings (match_density=" << std::fixed
+           << std::setprecision(2) << m << ")";
+  }
+
+  if (best_bits >= 7.8) {
+    rec.format = "none";
+    rec.data_type = "char";
+    rec.num_RLEs = 0;
+    rec.num_deltas = 0;
+    rec.use_bp = 0;
+    best_bits = 8.0;
+    reason.str("");
+    reason << "incompressible (entropy=" << std::fixed << std::setprecision(2)
+           << profile.byte_entropy << ", match_density=" << m << ")";
+  }
+
+  rec.estimated_ratio = 8.0 / std::max(best_bits, 0.01);
+  rec.reason = reason.str();
+  return rec;
+}
+
+namespace detail
+{
+
+inline std::string json_escape(const std::string& str)
+{
+  std::string out;
+  out.reserve(str.size());
+  for (const char c : str) {
+    if (c == '"' || c == '\\') {
+      out.push_back('\\');
+    }
+    out.push_back(c);
+  }
+  return out;
+}
+
+} // namespace detail
+
+inline std::string to_json(const DataProfile& profile)
+{
+  std::ostringstream os;
+  os << std::setprecision(6);
+  os << "{\"chunks\": " << profile.chunks << ", \"bytes\": " << profile.bytes
+     << ", \"byte_entropy\": " << profile.byte_entropy
+     << ", \"zero_fraction\": " << profile.zero_fraction
+     << ", \"match_density\": " << profile.match_density << ", \"widths\": [";
+  for (size_t w = 0; w < PROFILE_NUM_WIDTHS; ++w) {
+    const WidthProfile& wp = profile.widths[w];
+    os << (w == 0 ? "" : ", ") << "{\"width\": " << PROFILE_WIDTHS[w]
+       << ", \"aligned\": " << (wp.aligned ? "true" : "false")
+       << ", \"delta_entropy\": " << wp.delta_entropy
+       << ", \"runs\": " << wp.runs
+       << ", \"mean_run_length\": " << wp.mean_run_length
+       << ", \"max_run_length\": " << wp.max_run_length
+       << ", \"for_bits\": " << wp.for_bits
+       << ", \"delta_for_bits\": " << wp.delta_for_bits << "}";
+  }
+  os << "]}";
+  return os.str();
+}
+
+inline std::string to_json(const FormatRecommendation& rec)
+{
+  std::ostringstream os;
+  os << std::setprecision(4);
+  os << "{\"format\": \"" << rec.format << "\", \"type\": \"" << rec.data_type
+     << "\"";
+  if (rec.format == "cascaded") {
+    os << ", \"num_RLEs\": " << rec.num_RLEs
+       << ", \"num_deltas\": " << rec.num_deltas
+       << ", \"use_bp\": " << rec.use_bp;
+  }
+  os << ", \"estimated_ratio\": " << rec.estimated_ratio << ", \"reason\": \""
+     << detail::json_escape(rec.reason) << "\"}";
+  return os.str();
+}
+
+} // namespace host
+} // namespace nvcomp
@@ -0,0 +1,543 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/thread_pool.h"
+#include "nvcomp/shared_types.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace nvcomp
+{
+namespace host
+{
+
+// Below this many values delta coding runs on the calling thread.
+static constexpr size_t PARALLEL_DELTA_MIN_VALUES = 1 << 20;
+
+namespace detail
+{
+
+#if defined(__SSE2__)
+// Lane arithmetic on 128-bit vectors of SIZE-byte integers. scan() is the
+// in-register inclusive prefix sum (log2 of the lane count shift-and-add
+// steps), last() broadcasts the highest lane, which is the carry into the
+// next vector.
+template <size_t SIZE>
+struct DeltaLanes;
+
+template <>
+struct DeltaLanes<1>
+{
+  static __m128i add(const __m128i a, const __m128i b)
+  {
+    return _mm_add_epi8(a, b);
+  }
+  static __m128i sub(const __m128i a, const __m128i b)
+  {
+    return _mm_sub_epi8(a, b);
+  }
+  static __m128i scan(__m128i x)
+  {
+    x = _mm_add_epi8(x, _mm_slli_si128(x, 1));
+    x = _mm_add_epi8(x, _mm_slli_si128(x, 2));
+    x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+    return _mm_add_epi8(x, _mm_slli_si128(x, 8));
+  }
+  static __m128i last(const __m128i x)
+  {
+    __m128i t = _mm_srli_si128(x, 15);
+    t = _mm_unpacklo_epi8(t, t);
+    t = _mm_shufflelo_epi16(t, 0);
+    return _mm_unpacklo_epi64(t, t);
+  }
+};
+
+template <>
+struct DeltaLanes<2>
+{
+  static __m128i add(const __m128i a, const __m128i b)
+  {
+    return _mm_add_epi16(a, b);
+  }
+  static __m128i sub(const __m128i a, const __m128i b)
+  {
+    return _mm_sub_epi16(a, b);
+  }
+  static __m128i scan(__m128i x)
+  {
+    x = _mm_add_epi16(x, _mm_slli_si128(x, 2));
+    x = _mm_add_epi16(x, _mm_slli_si128(x, 4));
+    return _mm_add_epi16(x, _mm_slli_si128(x, 8));
+  }
+  static __m128i last(const __m128i x)
+  {
+    const __m128i t = _mm_shufflehi_epi16(x, 0xFF);
+    return _mm_unpackhi_epi64(t, t);
+  }
+};
+
+template <>
+struct DeltaLanes<4>
+{
+  static __m128i add(const __m128i a, const __m128i b)
+  {
+    return _mm_add_epi32(a, b);
+  }
+  static __m128i sub(const __m128i a, const __m128i b)
+  {
+    return _mm_sub_epi32(a, b);
+  }
+  static __m128i scan(__m128i x)
+  {
+    x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+    return _mm_add_epi32(x, _mm_slli_si128(x, 8));
+  }
+  static __m128i last(const __m128i x)
+  {
+    return _mm_shuffle_epi32(x, 0xFF);
+  }
+};
+
+template <>
+struct DeltaLanes<8>
+{
+  static __m128i add(const __m128i a, const __m128i b)
+  {
+    return _mm_add_epi64(a, b);
+  }
+  static __m128i sub(const __m128i a, const __m128i b)
+  {
+    return _mm_sub_epi64(a, b);
+  }
+  static __m128i scan(const __m128i x)
+  {
+    return _mm_add_epi64(x, _mm_slli_si128(x, 8));
+  }
+  static __m128i last(const __m128i x)
+  {
+    return _mm_shuffle_epi32(x, 0xEE);
+  }
+};
+
+template <typename U>
+__m128i delta_broadcast(const U value)
+{
+  U lanes[16 / sizeof(U)];
+  std::fill(lanes, lanes + 16 / sizeof(U), value);
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes));
+}
+#endif
+
+/**
+ * @brief Delta code `n` values of order ORDER (1 or 2), `prev1` and `prev2`
+ * being the values just before `in[0]` and `in[-1]`.
+ *
+ * Runs from the end towards the front, so `out` may be `in`.
+ */
+template <typename U, int ORDER>
+void delta_encode_block(
+    const U* const in,
+    U* const out,
+    const size_t n,
+    const U prev1,
+    const U prev2)
+{
+  static_assert(std::is_unsigned<U>::value, "Delta coding wraps around.");
+  size_t i = n;
+#if defined(__SSE2__)
+  typedef DeltaLanes<sizeof(U)> Lanes;
+  constexpr size_t LANES = 16 / sizeof(U);
+  while (i >= LANES + ORDER) {
+    i -= LANES;
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    const __m128i p1
+        = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i - 1));
+    __m128i r = Lanes::sub(v, p1);
+    if (ORDER == 2) {
+      const __m128i p2
+          = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i - 2));
+      r = Lanes::add(Lanes::sub(r, p1), p2);
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), r);
+  }
+#endif
+  while (i-- > 0) {
+    const U p1 = i >= 1 ? in[i - 1] : prev1;
+    U r = static_cast<U>(in[i] - p1);
+    if (ORDER == 2) {
+      const U p2 = i >= 2 ? in[i - 2] : (i == 1 ? prev1 : prev2);
+      r = static_cast<U>(r - p1 + p2);
+    }
+    out[i] = r;
+  }
+}
+
+/**
+ * @brief Invert delta_encode_block() with zero history, starting the inner
+ * and outer prefix sums from `carry1` and `carry2`. For ORDER 1 only
+ * `carry1` is used, and the result is `carry1` plus the inclusive prefix sum
+ * of `in`.
+ *
+ * `out` may be `in`.
+ */
+template <typename U, int ORDER>
+void delta_decode_block(
+    const U* const in,
+    U* const out,
+    const size_t n,
+    U carry1,
+    U carry2)
+{
+  static_assert(std::is_unsigned<U>::value, "Delta coding wraps around.");
+  size_t i = 0;
+#if defined(__SSE2__)
+  typedef DeltaLanes<sizeof(U)> Lanes;
+  constexpr size_t LANES = 16 / sizeof(U);
+  if (n >= LANES) {
+    // The only serial dependency left is the carry, one add and one
+    // shuffle per vector.
+    __m128i c1 = delta_broadcast(carry1);
+    __m128i c2 = delta_broadcast(carry2);
+    for (; i + LANES <= n; i += LANES) {
+      __m128i x
+          = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+      x = Lanes::add(Lanes::scan(x), c1);
+      c1 = Lanes::last(x);
+      if (ORDER == 2) {
+        x = Lanes::add(Lanes::scan(x), c2);
+        c2 = Lanes::last(x);
+      }
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), x);
+    }
+    U lanes[LANES];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), c1);
+    carry1 = lanes[0];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), c2);
+    carry2 = lanes[0];
+  }
+#endif
+  for (; i < n; ++i) {
+    carry1 = static_cast<U>(carry1 + in[i]);
+    if (ORDER == 2) {
+      carry2 = static_cast<U>(carry2 + carry1);
+      out[i] = carry2;
+    } else {
+      out[i] = carry1;
+    }
+  }
+}
+
+inline void delta_check_order(const int order)
+{
+  if (order != 1 && order != 2) {
+    throw std::runtime_error(
+        "Delta coding supports order 1 (delta) and 2 (delta of delta).");
+  }
+}
+
+// Split n values into blocks for the pool, or return 1 if the work is too
+// small to be worth splitting.
+inline size_t delta_num_blocks(ThreadPool& pool, const size_t n)
+{
+  if (n < PARALLEL_DELTA_MIN_VALUES || pool.num_threads() == 1) {
+    return 1;
+  }
+  return std::min(
+      pool.num_threads() * 4, n / (PARALLEL_DELTA_MIN_VALUES / 4));
+}
+
+// Reduce-then-scan prefix sum of `in` into `out`: every block is summed on
+// the pool, the block totals are scanned serially, and the blocks are then
+// scanned in parallel starting from their block's carry.
+template <typename U>
+void delta_decode_parallel(
+    ThreadPool& pool, const U* const in, U* const out, const size_t n)
+{
+  const size_t num_blocks = delta_num_blocks(pool, n);
+  const size_t block_values = (n + num_blocks - 1) / num_blocks;
+
+  std::vector<U> carries(num_blocks, 0);
+  pool.parallel_for(num_blocks, [&](const size_t b) {
+    if (b + 1 == num_blocks) {
+      return;
+    }
+    const size_t end = std::min(n, (b + 1) * block_values);
+    U total = 0;
+    for (size_t i = b * block_values; i < end; ++i) {
+      total = static_cast<U>(total + in[i]);
+    }
+    carries[b + 1] = total;
+  });
+  for (size_t b = 1; b < num_blocks; ++b) {
+    carries[b] = static_cast<U>(carries[b] + carries[b - 1]);
+  }
+
+  pool.parallel_for(num_blocks, [&](const size_t b) {
+    const size_t begin = std::min(n, b * block_values);
+    const size_t end = std::min(n, (b + 1) * block_values);
+    delta_decode_block<U, 1>(
+        in + begin, out + begin, end - begin, carries[b], 0);
+  });
+}
+
+} // namespace detail
+
+/**
+ * @brief Delta encode `n` integers of type T from `in` into `out`.
+ *
+ * Order 1 stores the difference of every value from the previous one, order
+ * 2 (delta of delta) the difference of consecutive differences; the values
+ * before `in[0]` count as zero, so `out[0] == in[0]`. The arithmetic wraps
+ * around in the unsigned type of T's width, which for signed T is the two's
+ * complement result, so every input round trips through delta_decode().
+ * `out` may be `in`, but must not partially overlap it.
+ */
+template <typename T>
+void delta_encode(
+    const T* const in, T* const out, const size_t n, int order = 1)
+{
+  static_assert(std::is_integral<T>::value, "Delta coding needs integers.");
+  typedef typename std::make_unsigned<T>::type U;
+  detail::delta_check_order(order);
+  const U* const src = reinterpret_cast<const U*>(in);
+  U* const dst = reinterpret_cast<U*>(out);
+  if (order == 1) {
+    detail::delta_encode_block<U, 1>(src, dst, n, 0, 0);
+  } else {
+    detail::delta_encode_block<U, 2>(src, dst, n, 0, 0);
+  }
+}
+
+/**
+ * @brief Invert delta_encode() of the same order; `out` may be `in`.
+ *
+ * Decoding is a prefix sum (two for order 2). Each 16-byte vector is summed
+ * in register, so the serial dependency is one carry per vector rather than
+ * one per value.
+ */
+template <typename T>
+void delta_decode(
+    const T* const in, T* const out, const size_t n, int order = 1)
+{
+  static_assert(std::is_integral<T>::value, "Delta coding needs integers.");
+  typedef typename std::make_unsigned<T>::type U;
+  detail::delta_check_order(order);
+  const U* const src = reinterpret_cast<const U*>(in);
+  U* const dst = reinterpret_cast<U*>(out);
+  if (order == 1) {
+    detail::delta_decode_block<U, 1>(src, dst, n, 0, 0);
+  } else {
+    detail::delta_decode_block<U, 2>(src, dst, n, 0, 0);
+  }
+}
+
+/**
+ * @brief delta_encode() split across the pool for large inputs.
+ *
+ * The values each block needs from its predecessor are read before any block
+ * is written, so this also works in place.
+ */
+template <typename T>
+void delta_encode(
+    ThreadPool& pool,
+    const T* const in,
+    T* const out,
+    const size_t n,
+    int order = 1)
+{
+  typedef typename std::make_unsigned<T>::type U;
+  const size_t num_blocks = detail::delta_num_blocks(pool, n);
+  if (num_blocks == 1) {
+    delta_encode(in, out, n, order);
+    return;
+  }
+  detail::delta_check_order(order);
+  const size_t block_values = (n + num_blocks - 1) / num_blocks;
+  const U* const src = reinterpret_cast<const U*>(in);
+  U* const dst = reinterpret_cast<U*>(out);
+
+  std::vector<U> prev1(num_blocks, 0);
+  std::vector<U> prev2(num_blocks, 0);
+  for (size_t b = 1; b < num_blocks; ++b) {
+    const size_t begin = std::min(n, b * block_values);
+    prev1[b] = src[begin - 1];
+    prev2[b] = begin >= 2 ? src[begin - 2] : 0;
+  }
+
+  pool.parallel_for(num_blocks, [&](const size_t b) {
+    const size_t begin = std::min(n, b * block_values);
+    const size_t end = std::min(n, (b + 1) * block_values);
+    if (order == 1) {
+      detail::delta_encode_block<U, 1>(
+          src + begin, dst + begin, end - begin, prev1[b], prev2[b]);
+    } else {
+      detail::delta_encode_block<U, 2>(
+          src + begin, dst + begin, end - begin, prev1[b], prev2[b]);
+    }
+  });
+}
+
+/**
+ * @brief delta_decode() split across the pool for large inputs, with the
+ * carries propagated between blocks; `out` may be `in`.
+ *
+ * Order 2 runs the parallel prefix sum twice.
+ */
+template <typename T>
+void delta_decode(
+    ThreadPool& pool,
+    const T* const in,
+    T* const out,
+    const size_t n,
+    int order = 1)
+{
+  typedef typename std::make_unsigned<T>::type U;
+  if (detail::delta_num_blocks(pool, n) == 1) {
+    delta_decode(in, out, n, order);
+    return;
+  }
+  detail::delta_check_order(order);
+  const U* const src = reinterpret_cast<const U*>(in);
+  U* const dst = reinterpret_cast<U*>(out);
+  detail::delta_decode_parallel(pool, src, dst, n);
+  if (order == 2) {
+    detail::delta_decode_parallel(pool, dst, dst, n);
+  }
+}
+
+/**
+ * @brief Size in bytes of an element of `type` for delta coding.
+ *
+ * NVCOMP_TYPE_BITS is coded as bytes.
+ */
+inline size_t delta_type_size(const nvcompType_t type)
+{
+  switch (type) {
+  case NVCOMP_TYPE_CHAR:
+  case NVCOMP_TYPE_UCHAR:
+  case NVCOMP_TYPE_BITS:
+    return 1;
+  case NVCOMP_TYPE_SHORT:
+  case NVCOMP_TYPE_USHORT:
+    return 2;
+  case NVCOMP_TYPE_INT:
+  case NVCOMP_TYPE_UINT:
+    return 4;
+  case NVCOMP_TYPE_LONGLONG:
+  case NVCOMP_TYPE_ULONGLONG:
+    return 8;
+  }
+  throw std::runtime_error("Unknown nvcompType_t for delta coding.");
+}
+
+/**
+ * @brief Delta encode `n` elements of `type`, on the pool when large.
+ *
+ * Signed and unsigned types of the same width share a kernel, as their
+ * wrapping arithmetic is bit for bit the same.
+ */
+inline void delta_encode(
+    ThreadPool& pool,
+    const nvcompType_t type,
+    const void* const in,
+    void* const out,
+    const size_t n,
+    const int order = 1)
+{
+  switch (delta_type_size(type)) {
+  case 1:
+    delta_encode(
+        pool, static_cast<const uint8_t*>(in), static_cast<uint8_t*>(out), n,
+        order);
+    break;
+  case 2:
+    delta_encode(
+        pool, static_cast<const uint16_t*>(in), static_cast<uint16_t*>(out),
+        n, order);
+    break;
+  case 4:
+    delta_encode(
+        pool, static_cast<const uint32_t*>(in), static_cast<uint32_t*>(out),
+        n, order);
+    break;
+  default:
+    delta_encode(
+        pool, static_cast<const uint64_t*>(in), static_cast<uint64_t*>(out),
+        n, order);
+    break;
+  }
+}
+
+/**
+ * @brief Invert the typed delta_encode() above.
+ */
+inline void delta_decode(
+    ThreadPool& pool,
+    const nvcompType_t type,
+    const void* const in,
+    void* const out,
+    const size_t n,
+    const int order = 1)
+{
+  switch (delta_type_size(type)) {
+  case 1:
+    delta_decode(
+        pool, static_cast<const uint8_t*>(in), static_cast<uint8_t*>(out), n,
+        order);
+    break;
+  case 2:
+    delta_decode(
+        pool, static_cast<const uint16_t*>(in), static_cast<uint16_t*>(out),
+        n, order);
+    break;
+  case 4:
+    delta_decode(
+        pool, static_cast<const uint32_t*>(in), static_cast<uint32_t*>(out),
+        n, order);
+    break;
+  default:
+    delta_decode(
+        pool, static_cast<const uint64_t*>(in), static_cast<uint64_t*>(out),
+        n, order);
+    break;
+  }
+}
+
+} // namespace host
+} // namespace nvcomp
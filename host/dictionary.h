@@ -0,0 +1,383 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace nvcomp
+{
+namespace host
+{
+
+// Below this many values dictionaries are built on the calling thread.
+static constexpr size_t PARALLEL_DICTIONARY_MIN_VALUES = 1 << 16;
+
+namespace detail
+{
+
+inline uint64_t dictionary_mix(uint64_t x)
+{
+  // The finalizer of MurmurHash3, so that keys differing only in their high
+  // bits still land in different slots.
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+template <typename K>
+uint64_t dictionary_hash(const K& key)
+{
+  static_assert(std::is_integral<K>::value, "Keys are integers or strings.");
+  return dictionary_mix(static_cast<uint64_t>(key));
+}
+
+inline uint64_t dictionary_hash(const std::string& key)
+{
+  // FNV-1a.
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (const char c : key) {
+    h = (h ^ static_cast<uint8_t>(c)) * 0x100000001b3ULL;
+  }
+  return dictionary_mix(h);
+}
+
+/**
+ * @brief Open-addressing hash table giving every distinct key a code, in
+ * the order the keys were first inserted.
+ *
+ * The slots hold code + 1, so that 0 marks an empty slot, and the table is
+ * kept at most half full. The hash of every key is kept alongside it, so
+ * growing the table and merging tables never hash a key twice.
+ */
+template <typename K>
+class DictionaryTable
+{
+public:
+  DictionaryTable() : m_keys(), m_hashes(), m_slots(16, 0)
+  {
+  }
+
+  size_t size() const
+  {
+    return m_keys.size();
+  }
+
+  const std::vector<K>& keys() const
+  {
+    return m_keys;
+  }
+
+  std::vector<K>& keys()
+  {
+    return m_keys;
+  }
+
+  const std::vector<uint64_t>& hashes() const
+  {
+    return m_hashes;
+  }
+
+  uint32_t insert(const K& key)
+  {
+    return insert(key, dictionary_hash(key));
+  }
+
+  uint32_t insert(const K& key, const uint64_t hash)
+  {
+    const size_t mask = m_slots.size() - 1;
+    size_t slot = static_cast<size_t>(hash) & mask;
+    for (uint32_t s = m_slots[slot]; s != 0; s = m_slots[slot]) {
+      if (m_hashes[s - 1] == hash && m_keys[s - 1] == key) {
+        return s - 1;
+      }
+      slot = (slot + 1) & mask;
+    }
+    const uint32_t code = static_cast<uint32_t>(m_keys.size());
+    m_keys.push_back(key);
+    m_hashes.push_back(hash);
+    m_slots[slot] = code + 1;
+    if (2 * m_keys.size() > m_slots.size()) {
+      grow();
+    }
+    return code;
+  }
+
+private:
+  void grow()
+  {
+    m_slots.assign(2 * m_slots.size(), 0);
+    const size_t mask = m_slots.size() - 1;
+    for (size_t code = 0; code < m_keys.size(); ++code) {
+      size_t slot = static_cast<size_t>(m_hashes[code]) & mask;
+      while (m_slots[slot] != 0) {
+        slot = (slot + 1) & mask;
+      }
+      m_slots[slot] = static_cast<uint32_t>(code + 1);
+    }
+  }
+
+  std::vector<K> m_keys;
+  std::vector<uint64_t> m_hashes;
+  std::vector<uint32_t> m_slots;
+};
+
+// Sort `values` and return the new position of every old code.
+template <typename K>
+std::vector<uint32_t> sort_dictionary(std::vector<K>& values)
+{
+  std::vector<uint32_t> order(values.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(
+      order.begin(), order.end(), [&](const uint32_t a, const uint32_t b) {
+        return values[a] < values[b];
+      });
+  std::vector<uint32_t> rank(values.size());
+  std::vector<K> sorted;
+  sorted.reserve(values.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    rank[order[i]] = static_cast<uint32_t>(i);
+    sorted.push_back(std::move(values[order[i]]));
+  }
+  values.swap(sorted);
+  return rank;
+}
+
+} // namespace detail
+
+/**
+ * @brief A column as its distinct values and, for every element, the index
+ * (code) of its value.
+ */
+template <typename K>
+struct Dictionary
+{
+  std::vector<K> values;
+  std::vector<uint32_t> codes;
+
+  Dictionary() : values(), codes()
+  {
+  }
+};
+
+// Bits per code for a dictionary of `num_values` values.
+inline size_t dictionary_code_bits(const size_t num_values)
+{
+  size_t bits = 0;
+  while (bits < 32 && (uint64_t(1) << bits) < num_values) {
+    ++bits;
+  }
+  return bits;
+}
+
+// Bytes per code when the codes are stored at a fixed width of 1, 2 or 4
+// bytes, e.g. as the input of another integer codec.
+inline size_t dictionary_code_bytes(const size_t num_values)
+{
+  const size_t bits = dictionary_code_bits(num_values);
+  return bits <= 8 ? 1 : bits <= 16 ? 2 : 4;
+}
+
+/**
+ * @brief Dictionary encode the `n` keys at `in` on the calling thread.
+ *
+ * Integer keys and std::string keys are supported. The codes follow the
+ * order in which the values first appear, or the order of the values
+ * themselves with `sorted`, in which case comparing codes compares values.
+ */
+template <typename K>
+Dictionary<K> build_dictionary(
+    const K* const in, const size_t n, const bool sorted = false)
+{
+  if (n > UINT32_MAX) {
+    throw std::runtime_error("Dictionary columns hold at most 2^32 values.");
+  }
+  Dictionary<K> dict;
+  dict.codes.resize(n);
+  detail::DictionaryTable<K> table;
+  for (size_t i = 0; i < n; ++i) {
+    dict.codes[i] = table.insert(in[i]);
+  }
+  dict.values.swap(table.keys());
+  if (sorted) {
+    const std::vector<uint32_t> rank = detail::sort_dictionary(dict.values);
+    for (uint32_t& code : dict.codes) {
+      code = rank[code];
+    }
+  }
+  return dict;
+}
+
+/**
+ * @brief build_dictionary() split across the pool for large columns.
+ *
+ * Every block of the column is encoded with its own table, the tables are
+ * then merged in block order, and the codes of every block are mapped to
+ * the merged codes in parallel, so the result is the same as on one thread.
+ */
+template <typename K>
+Dictionary<K> build_dictionary(
+    ThreadPool& pool,
+    const K* const in,
+    const size_t n,
+    const bool sorted = false)
+{
+  if (n < PARALLEL_DICTIONARY_MIN_VALUES || pool.num_threads() == 1) {
+    return build_dictionary(in, n, sorted);
+  }
+  if (n > UINT32_MAX) {
+    throw std::runtime_error("Dictionary columns hold at most 2^32 values.");
+  }
+  const size_t num_blocks = std::min(
+      pool.num_threads() * 4, n / (PARALLEL_DICTIONARY_MIN_VALUES / 4));
+  const size_t block_values = (n + num_blocks - 1) / num_blocks;
+
+  Dictionary<K> dict;
+  dict.codes.resize(n);
+  std::vector<detail::DictionaryTable<K>> tables(num_blocks);
+  pool.parallel_for(num_blocks, [&](const size_t b) {
+    const size_t end = std::min(n, (b + 1) * block_values);
+    for (size_t i = b * block_values; i < end; ++i) {
+      dict.codes[i] = tables[b].insert(in[i]);
+    }
+  });
+
+  detail::DictionaryTable<K> merged;
+  std::vector<std::vector<uint32_t>> remap(num_blocks);
+  for (size_t b = 0; b < num_blocks; ++b) {
+    const std::vector<K>& keys = tables[b].keys();
+    remap[b].resize(keys.size());
+    for (size_t code = 0; code < keys.size(); ++code) {
+      remap[b][code] = merged.insert(keys[code], tables[b].hashes()[code]);
+    }
+    tables[b] = detail::DictionaryTable<K>();
+  }
+  dict.values.swap(merged.keys());
+  if (sorted) {
+    const std::vector<uint32_t> rank = detail::sort_dictionary(dict.values);
+    for (std::vector<uint32_t>& block_remap : remap) {
+      for (uint32_t& code : block_remap) {
+        code = rank[code];
+      }
+    }
+  }
+
+  pool.parallel_for(num_blocks, [&](const size_t b) {
+    const size_t end = std::min(n, (b + 1) * block_values);
+    for (size_t i = b * block_values; i < end; ++i) {
+      dict.codes[i] = remap[b][dict.codes[i]];
+    }
+  });
+  return dict;
+}
+
+/**
+ * @brief Write the value of each of the `n` codes at `codes` to `out`.
+ *
+ * Returns false if a code is not below `num_values`.
+ */
+template <typename K>
+bool dictionary_decode(
+    const K* const values,
+    const size_t num_values,
+    const uint32_t* const codes,
+    const size_t n,
+    K* const out)
+{
+  for (size_t i = 0; i < n; ++i) {
+    if (codes[i] >= num_values) {
+      return false;
+    }
+    out[i] = values[codes[i]];
+  }
+  return true;
+}
+
+// dictionary_decode() split across the pool for large columns.
+template <typename K>
+bool dictionary_decode(
+    ThreadPool& pool,
+    const K* const values,
+    const size_t num_values,
+    const uint32_t* const codes,
+    const size_t n,
+    K* const out)
+{
+  if (n < PARALLEL_DICTIONARY_MIN_VALUES || pool.num_threads() == 1) {
+    return dictionary_decode(values, num_values, codes, n, out);
+  }
+  const size_t num_blocks = std::min(
+      pool.num_threads() * 4, n / (PARALLEL_DICTIONARY_MIN_VALUES / 4));
+  const size_t block_values = (n + num_blocks - 1) / num_blocks;
+  std::atomic<bool> ok(true);
+  pool.parallel_for(num_blocks, [&](const size_t b) {
+    const size_t begin = std::min(n, b * block_values);
+    const size_t end = std::min(n, (b + 1) * block_values);
+    if (!dictionary_decode(
+            values, num_values, codes + begin, end - begin, out + begin)) {
+      ok = false;
+    }
+  });
+  return ok;
+}
+
+// Split `bytes` of text into the values ending with `separator`; text after
+// the last separator is a value too.
+inline std::vector<std::string> split_dictionary_strings(
+    const char* const data, const size_t bytes, const char separator = '\n')
+{
+  std::vector<std::string> values;
+  size_t start = 0;
+  for (size_t i = 0; i < bytes; ++i) {
+    if (data[i] == separator) {
+      values.emplace_back(data + start, i - start);
+      start = i + 1;
+    }
+  }
+  if (start < bytes) {
+    values.emplace_back(data + start, bytes - start);
+  }
+  return values;
+}
+
+} // namespace host
+} // namespace nvcomp
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/trace.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace nvcomp
+{
+namespace host
+{
+
+inline std::vector<char> readFile(const std::string& filename)
+{
+  NVCOMP_TRACE_SCOPE("load");
+  std::ifstream fin(filename, std::ifstream::binary);
+  if (!fin) {
+    std::cerr << "ERROR: Unable to open \"" << filename << "\" for reading."
+              << std::endl;
+    throw std::runtime_error("Error opening file for reading.");
+  }
+
+  fin.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+
+  fin.seekg(0, std::ios_base::end);
+  auto fileSize = static_cast<std::streamoff>(fin.tellg());
+  fin.seekg(0, std::ios_base::beg);
+
+  std::vector<char> host_data(fileSize);
+  fin.read(host_data.data(), fileSize);
+
+  if (!fin) {
+    std::cerr << "ERROR: Unable to read all of file \"" << filename << "\"."
+              << std::endl;
+    throw std::runtime_error("Error reading file.");
+  }
+
+  return host_data;
+}
+
+inline std::vector<std::vector<char>>
+readFileWithPageSizes(const std::string& filename)
+{
+  NVCOMP_TRACE_SCOPE("load");
+  std::vector<std::vector<char>> res;
+
+  std::ifstream fin(filename, std::ifstream::binary);
+
+  while (!fin.eof()) {
+    uint64_t chunk_size;
+    fin.read(reinterpret_cast<char *>(&chunk_size), sizeof(uint64_t));
+    if (fin.eof())
+      break;
+    res.emplace_back(chunk_size);
+    fin.read(reinterpret_cast<char*>(res.back().data()), chunk_size);
+  }
+
+  return res;
+}
+
+// Read each file and split it into chunks of at most `chunk_size` bytes, or
+// into its stored pages if `has_page_sizes` is set. The resulting chunk list
+// is repeated `duplicate_count` times.
+inline std::vector<std::vector<char>>
+multi_file(const std::vector<std::string>& filenames, const size_t chunk_size,
+    const bool has_page_sizes, const size_t duplicate_count)
+{
+  std::vector<std::vector<char>> split_data;
+
+  for (auto const& filename : filenames) {
+    if (!has_page_sizes) {
+      std::vector<char> filedata = readFile(filename);
+
+      NVCOMP_TRACE_SCOPE("split");
+
+      const size_t num_chunks
+          = (filedata.size() + chunk_size - 1) / chunk_size;
+      size_t offset = 0;
+      for (size_t c = 0; c < num_chunks; ++c) {
+        const size_t size_of_this_chunk = std::min(chunk_size, filedata.size()-offset); 
+        split_data.emplace_back(
+            std::vector<char>(filedata.data() + offset, 
+                              filedata.data()+ offset + size_of_this_chunk));
+        offset += size_of_this_chunk;
+        assert(offset <= filedata.size());
+      }
+    } else {
+      std::vector<std::vector<char>> filedata = readFileWithPageSizes(filename);
+      split_data.insert(split_data.end(), filedata.begin(), filedata.end());
+    }
+  }
+
+  if (duplicate_count > 1) {
+    // Make duplicate_count copies of the contents of split_data,
+    // but copy into a separate std::vector, to avoid issues with the
+    // memory being reallocated while the contents are being copied.
+    std::vector<std::vector<char>> duplicated;
+    const size_t original_num_chunks = split_data.size();
+    duplicated.reserve(original_num_chunks * duplicate_count);
+    for (size_t d = 0; d < duplicate_count; ++d) {
+      duplicated.insert(duplicated.end(), split_data.begin(), split_data.end());
+    }
+    // Now that there are duplicate_count copies of split_data in
+    // duplicated, swap them, so that they're in split_data.
+    duplicated.swap(split_data);
+  }
+
+  return split_data;
+}
+
+} // namespace host
+} // namespace nvcomp
@@ -0,0 +1,515 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/thread_pool.h"
+#include "nvcomp/shared_types.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+namespace nvcomp
+{
+namespace host
+{
+
+// Default uncompressed bytes between checkpoints of a gzip index.
+static constexpr size_t GZIP_INDEX_DEFAULT_SPAN = 1 << 20;
+
+// Wrapper around the deflate data of an indexed stream.
+enum class GzipIndexFormat : uint32_t
+{
+  Raw = 0,
+  Zlib = 1,
+  // One or more gzip members.
+  Gzip = 2
+};
+
+// A point at a deflate block boundary where decompression can resume.
+struct GzipCheckpoint
+{
+  // First byte of the stream that holds data of the block.
+  uint64_t compressed_offset;
+  uint64_t uncompressed_offset;
+  // Bits of the byte before `compressed_offset` that belong to the block.
+  uint32_t bits;
+  // Up to 32 KB of uncompressed data before the block, which it may refer
+  // back to.
+  std::vector<uint8_t> window;
+
+  GzipCheckpoint() :
+      compressed_offset(0), uncompressed_offset(0), bits(0), window()
+  {
+  }
+};
+
+// Index of a gzip, zlib or raw deflate stream, built by build_gzip_index().
+struct GzipIndex
+{
+  GzipIndexFormat format;
+  uint64_t compressed_bytes;
+  uint64_t uncompressed_bytes;
+  std::vector<GzipCheckpoint> checkpoints;
+
+  GzipIndex() :
+      format(GzipIndexFormat::Raw),
+      compressed_bytes(0),
+      uncompressed_bytes(0),
+      checkpoints()
+  {
+  }
+};
+
+namespace detail
+{
+
+static constexpr size_t GZIP_INDEX_WINDOW = 32 * 1024;
+static constexpr char GZIP_INDEX_MAGIC[8]
+    = {'N', 'V', 'G', 'Z', 'I', 'D', 'X', '1'};
+
+// Header of an index file, followed by the checkpoints, each a
+// GzipCheckpointHeader and its window.
+struct GzipIndexHeader
+{
+  char magic[8];
+  uint32_t format;
+  uint32_t reserved;
+  uint64_t compressed_bytes;
+  uint64_t uncompressed_bytes;
+  uint64_t num_checkpoints;
+};
+
+static_assert(sizeof(GzipIndexHeader) == 40, "Header must be 40 B");
+
+struct GzipCheckpointHeader
+{
+  uint64_t compressed_offset;
+  uint64_t uncompressed_offset;
+  uint32_t bits;
+  uint32_t window_bytes;
+};
+
+static_assert(sizeof(GzipCheckpointHeader) == 24, "Header must be 24 B");
+
+inline bool gzip_index_is_gzip(const uint8_t* const in, const size_t bytes)
+{
+  return bytes >= 2 && in[0] == 0x1f && in[1] == 0x8b;
+}
+
+inline GzipIndexFormat
+gzip_index_detect(const uint8_t* const in, const size_t bytes)
+{
+  if (gzip_index_is_gzip(in, bytes)) {
+    return GzipIndexFormat::Gzip;
+  }
+  if (bytes >= 2 && (in[0] & 0xf) == Z_DEFLATED
+      && (in[0] * 256 + in[1]) % 31 == 0) {
+    return GzipIndexFormat::Zlib;
+  }
+  return GzipIndexFormat::Raw;
+}
+
+inline int gzip_index_window_bits(const GzipIndexFormat format)
+{
+  switch (format) {
+  case GzipIndexFormat::Gzip:
+    return 15 | 16;
+  case GzipIndexFormat::Zlib:
+    return 15;
+  default:
+    return -15;
+  }
+}
+
+// Give inflate the rest of the input, as much of it as fits in a uInt.
+inline void gzip_index_refill(z_stream& zs, const uint8_t* const end)
+{
+  zs.avail_in = static_cast<uInt>(std::min<size_t>(
+      end - zs.next_in, std::numeric_limits<uInt>::max()));
+}
+
+// Check that `index` fits a stream of `in_bytes` before decoding with it.
+inline bool gzip_index_valid(const GzipIndex& index, const size_t in_bytes)
+{
+  if (index.compressed_bytes != in_bytes || index.checkpoints.empty()
+      || index.checkpoints.front().uncompressed_offset != 0) {
+    return false;
+  }
+  uint64_t uncompressed_offset = 0;
+  for (const GzipCheckpoint& point : index.checkpoints) {
+    if (point.compressed_offset > in_bytes || point.bits > 7
+        || (point.bits > 0 && point.compressed_offset == 0)
+        || point.window.size() > GZIP_INDEX_WINDOW
+        || point.uncompressed_offset < uncompressed_offset
+        || point.uncompressed_offset > index.uncompressed_bytes) {
+      return false;
+    }
+    uncompressed_offset = point.uncompressed_offset;
+  }
+  return true;
+}
+
+// Decompress from `point`, drop the first `skip` bytes, and write the next
+// `bytes` to `out`. Gzip members after the one of `point` are decoded in
+// turn. Trailers are not checked, as the checksums cover whole members.
+inline bool gzip_inflate_range(
+    const uint8_t* const in,
+    const size_t in_bytes,
+    const GzipIndexFormat format,
+    const GzipCheckpoint& point,
+    uint64_t skip,
+    uint8_t* out,
+    size_t bytes)
+{
+  const uint8_t* const end = in + in_bytes;
+  z_stream zs;
+  std::memset(&zs, 0, sizeof(zs));
+  if (inflateInit2(&zs, -15) != Z_OK) {
+    return false;
+  }
+  bool ok = true;
+  if (point.bits > 0) {
+    const int byte = in[point.compressed_offset - 1];
+    ok = inflatePrime(&zs, point.bits, byte >> (8 - point.bits)) == Z_OK;
+  }
+  if (ok && !point.window.empty()) {
+    ok = inflateSetDictionary(
+             &zs, point.window.data(), static_cast<uInt>(point.window.size()))
+         == Z_OK;
+  }
+  zs.next_in = const_cast<Bytef*>(in + point.compressed_offset);
+  std::vector<uint8_t> discard(skip > 0 ? GZIP_INDEX_WINDOW : 0);
+  bool raw = true;
+  while (ok && (skip > 0 || bytes > 0)) {
+    if (zs.avail_in == 0) {
+      gzip_index_refill(zs, end);
+    }
+    const size_t want = skip > 0 ? std::min<uint64_t>(skip, discard.size())
+                                 : std::min<size_t>(
+                                     bytes, std::numeric_limits<uInt>::max());
+    zs.next_out = skip > 0 ? discard.data() : out;
+    zs.avail_out = static_cast<uInt>(want);
+    const int ret = inflate(&zs, Z_NO_FLUSH);
+    const size_t produced = want - zs.avail_out;
+    if (skip > 0) {
+      skip -= produced;
+    } else {
+      out += produced;
+      bytes -= produced;
+    }
+    if (ret == Z_STREAM_END) {
+      if (skip == 0 && bytes == 0) {
+        break;
+      }
+      // The next gzip member follows the trailer of this one, which a raw
+      // stream leaves unread.
+      const uint8_t* next = zs.next_in;
+      if (raw) {
+        next += std::min<size_t>(8, end - next);
+      }
+      if (format != GzipIndexFormat::Gzip
+          || !gzip_index_is_gzip(next, end - next)
+          || inflateReset2(&zs, 15 | 16) != Z_OK) {
+        ok = false;
+        break;
+      }
+      zs.next_in = const_cast<Bytef*>(next);
+      zs.avail_in = 0;
+      raw = false;
+    } else if (ret != Z_OK) {
+      // Including running out of input.
+      ok = false;
+    }
+  }
+  inflateEnd(&zs);
+  return ok;
+}
+
+} // namespace detail
+
+/**
+ * @brief Index a gzip, zlib or raw deflate stream in one pass, with a
+ * checkpoint at the first deflate block and then at the first block
+ * boundary after every `span` uncompressed bytes.
+ *
+ * Each checkpoint keeps up to 32 KB of uncompressed data, so the index
+ * takes about 32 KB per `span` bytes of the stream. Gzip files of several
+ * members, such as those of pgzip_compress(), are indexed across members.
+ * The stream is checked as it is indexed, and errors are thrown as
+ * std::runtime_error.
+ */
+inline GzipIndex build_gzip_index(
+    const void* const in,
+    const size_t bytes,
+    const size_t span = GZIP_INDEX_DEFAULT_SPAN)
+{
+  const uint8_t* const src = static_cast<const uint8_t*>(in);
+  const uint8_t* const end = src + bytes;
+  GzipIndex index;
+  index.format = detail::gzip_index_detect(src, bytes);
+  index.compressed_bytes = bytes;
+
+  z_stream zs;
+  std::memset(&zs, 0, sizeof(zs));
+  if (inflateInit2(&zs, detail::gzip_index_window_bits(index.format))
+      != Z_OK) {
+    throw std::runtime_error("inflateInit2() failed.");
+  }
+  // The last 32 KB of output, as a ring.
+  std::vector<uint8_t> window(detail::GZIP_INDEX_WINDOW);
+  zs.next_in = const_cast<Bytef*>(src);
+  zs.next_out = window.data();
+  zs.avail_out = static_cast<uInt>(window.size());
+  uint64_t total_out = 0;
+  uint64_t last = 0;
+  // inflate() stops before the first block only after a header.
+  if (index.format == GzipIndexFormat::Raw) {
+    index.checkpoints.push_back(GzipCheckpoint());
+  }
+  for (;;) {
+    if (zs.avail_in == 0) {
+      detail::gzip_index_refill(zs, end);
+    }
+    if (zs.avail_out == 0) {
+      zs.next_out = window.data();
+      zs.avail_out = static_cast<uInt>(window.size());
+    }
+    const uInt avail_out = zs.avail_out;
+    const int ret = inflate(&zs, Z_BLOCK);
+    total_out += avail_out - zs.avail_out;
+    if (ret == Z_STREAM_END) {
+      const size_t rest = end - zs.next_in;
+      if (index.format == GzipIndexFormat::Gzip
+          && detail::gzip_index_is_gzip(zs.next_in, rest)
+          && inflateReset(&zs) == Z_OK) {
+        zs.avail_in = 0;
+        continue;
+      }
+      break;
+    }
+    if (ret != Z_OK) {
+      inflateEnd(&zs);
+      throw std::runtime_error("Invalid or truncated deflate stream.");
+    }
+    // Between two blocks, other than after the last one.
+    if ((zs.data_type & 128) != 0 && (zs.data_type & 64) == 0
+        && (index.checkpoints.empty() || total_out - last >= span)) {
+      GzipCheckpoint point;
+      point.compressed_offset = zs.next_in - src;
+      point.uncompressed_offset = total_out;
+      point.bits = zs.data_type & 7;
+      const size_t size = window.size();
+      const size_t pos = size - zs.avail_out;
+      const size_t n = std::min<uint64_t>(total_out, size);
+      if (n <= pos) {
+        point.window.assign(
+            window.begin() + (pos - n), window.begin() + pos);
+      } else {
+        point.window.assign(window.end() - (n - pos), window.end());
+        point.window.insert(
+            point.window.end(), window.begin(), window.begin() + pos);
+      }
+      index.checkpoints.push_back(std::move(point));
+      last = total_out;
+    }
+  }
+  inflateEnd(&zs);
+  index.uncompressed_bytes = total_out;
+  return index;
+}
+
+/**
+ * @brief Decompress the indexed stream `in` into `out`, which must hold
+ * `index.uncompressed_bytes`, decoding the ranges between checkpoints in
+ * parallel on `pool`.
+ *
+ * Returns nvcompErrorCannotDecompress if the index doesn't match the
+ * stream.
+ */
+inline nvcompStatus_t gzip_index_decompress(
+    ThreadPool& pool,
+    const void* const in,
+    const size_t in_bytes,
+    const GzipIndex& index,
+    void* const out,
+    const size_t out_capacity)
+{
+  if (!detail::gzip_index_valid(index, in_bytes)
+      || index.uncompressed_bytes > out_capacity) {
+    return nvcompErrorCannotDecompress;
+  }
+  const uint8_t* const src = static_cast<const uint8_t*>(in);
+  uint8_t* const dst = static_cast<uint8_t*>(out);
+  const size_t num_points = index.checkpoints.size();
+  std::atomic<bool> ok(true);
+  pool.parallel_for(num_points, [&](const size_t c) {
+    const GzipCheckpoint& point = index.checkpoints[c];
+    const uint64_t range_end
+        = c + 1 < num_points ? index.checkpoints[c + 1].uncompressed_offset
+                             : index.uncompressed_bytes;
+    if (!detail::gzip_inflate_range(
+            src,
+            in_bytes,
+            index.format,
+            point,
+            0,
+            dst + point.uncompressed_offset,
+            range_end - point.uncompressed_offset)) {
+      ok = false;
+    }
+  });
+  return ok ? nvcompSuccess : nvcompErrorCannotDecompress;
+}
+
+/**
+ * @brief Read `bytes` of uncompressed data at `offset` of the indexed
+ * stream `in` into `out`, decoding from the last checkpoint before
+ * `offset`, which costs at most about `span` bytes of decoding beyond the
+ * data read.
+ *
+ * Returns nvcompErrorCannotDecompress if the range is out of the stream or
+ * the index doesn't match it.
+ */
+inline nvcompStatus_t gzip_index_read(
+    const void* const in,
+    const size_t in_bytes,
+    const GzipIndex& index,
+    const uint64_t offset,
+    void* const out,
+    const size_t bytes)
+{
+  if (!detail::gzip_index_valid(index, in_bytes)
+      || offset > index.uncompressed_bytes
+      || bytes > index.uncompressed_bytes - offset) {
+    return nvcompErrorCannotDecompress;
+  }
+  if (bytes == 0) {
+    return nvcompSuccess;
+  }
+  const std::vector<GzipCheckpoint>& points = index.checkpoints;
+  const auto next = std::upper_bound(
+      points.begin() + 1,
+      points.end(),
+      offset,
+      [](const uint64_t value, const GzipCheckpoint& point) {
+        return value < point.uncompressed_offset;
+      });
+  const GzipCheckpoint& point = *(next - 1);
+  return detail::gzip_inflate_range(
+             static_cast<const uint8_t*>(in),
+             in_bytes,
+             index.format,
+             point,
+             offset - point.uncompressed_offset,
+             static_cast<uint8_t*>(out),
+             bytes)
+             ? nvcompSuccess
+             : nvcompErrorCannotDecompress;
+}
+
+// Write `index` to the side file `filename`, e.g. "data.gz.gzi".
+inline void
+write_gzip_index(const std::string& filename, const GzipIndex& index)
+{
+  detail::GzipIndexHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, detail::GZIP_INDEX_MAGIC, sizeof(header.magic));
+  header.format = static_cast<uint32_t>(index.format);
+  header.compressed_bytes = index.compressed_bytes;
+  header.uncompressed_bytes = index.uncompressed_bytes;
+  header.num_checkpoints = index.checkpoints.size();
+
+  std::ofstream fout(filename, std::ofstream::binary);
+  fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (const GzipCheckpoint& point : index.checkpoints) {
+    detail::GzipCheckpointHeader point_header;
+    point_header.compressed_offset = point.compressed_offset;
+    point_header.uncompressed_offset = point.uncompressed_offset;
+    point_header.bits = point.bits;
+    point_header.window_bytes = static_cast<uint32_t>(point.window.size());
+    fout.write(
+        reinterpret_cast<const char*>(&point_header), sizeof(point_header));
+    fout.write(
+        reinterpret_cast<const char*>(point.window.data()),
+        point.window.size());
+  }
+  if (!fout) {
+    throw std::runtime_error("Error writing gzip index " + filename + ".");
+  }
+}
+
+// Read an index written by write_gzip_index().
+inline GzipIndex read_gzip_index(const std::string& filename)
+{
+  std::ifstream fin(filename, std::ifstream::binary);
+  detail::GzipIndexHeader header;
+  fin.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!fin
+      || std::memcmp(
+             header.magic, detail::GZIP_INDEX_MAGIC, sizeof(header.magic))
+             != 0
+      || header.format > static_cast<uint32_t>(GzipIndexFormat::Gzip)) {
+    throw std::runtime_error("Invalid gzip index " + filename + ".");
+  }
+
+  GzipIndex index;
+  index.format = static_cast<GzipIndexFormat>(header.format);
+  index.compressed_bytes = header.compressed_bytes;
+  index.uncompressed_bytes = header.uncompressed_bytes;
+  for (uint64_t c = 0; c < header.num_checkpoints; ++c) {
+    detail::GzipCheckpointHeader point_header;
+    fin.read(reinterpret_cast<char*>(&point_header), sizeof(point_header));
+    if (!fin || point_header.window_bytes > detail::GZIP_INDEX_WINDOW) {
+      throw std::runtime_error("Invalid gzip index " + filename + ".");
+    }
+    GzipCheckpoint point;
+    point.compressed_offset = point_header.compressed_offset;
+    point.uncompressed_offset = point_header.uncompressed_offset;
+    point.bits = point_header.bits;
+    point.window.resize(point_header.window_bytes);
+    fin.read(reinterpret_cast<char*>(point.window.data()), point.window.size());
+    if (!fin) {
+      throw std::runtime_error("Truncated gzip index " + filename + ".");
+    }
+    index.checkpoints.push_back(std::move(point));
+  }
+  return index;
+}
+
+} // namespace host
+} // namespace nvcomp
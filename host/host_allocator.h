@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/resource.h>
+#endif
+
+namespace nvcomp
+{
+namespace host
+{
+
+static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+/**
+ * @brief How a HostBuffer is backed.
+ *
+ * - None: regular heap memory.
+ * - Transparent: anonymous memory aligned to 2 MB and marked with
+ *   madvise(MADV_HUGEPAGE), so that the kernel backs it with transparent
+ *   huge pages when it can.
+ * - Explicit: 2 MB pages from the hugetlbfs pool (MAP_HUGETLB), which must
+ *   be reserved beforehand, e.g. through /proc/sys/vm/nr_hugepages. If none
+ *   are available, this falls back to Transparent.
+ *
+ * Huge pages are only supported on Linux; elsewhere every policy gives
+ * heap memory.
+ */
+enum class HugePages
+{
+  None,
+  Transparent,
+  Explicit
+};
+
+inline const char* huge_pages_name(const HugePages huge_pages)
+{
+  switch (huge_pages) {
+  case HugePages::None:
+    return "none";
+  case HugePages::Transparent:
+    return "transparent";
+  case HugePages::Explicit:
+    return "explicit";
+  }
+  return "unknown";
+}
+
+inline HugePages huge_pages_from_name(const std::string& name)
+{
+  if (name == "none") {
+    return HugePages::None;
+  } else if (name == "transparent") {
+    return HugePages::Transparent;
+  } else if (name == "explicit") {
+    return HugePages::Explicit;
+  }
+  throw std::runtime_error("Unknown huge page policy \"" + name + "\".");
+}
+
+/**
+ * @brief An owning host buffer that can be backed by huge pages and can skip
+ * initialization.
+ *
+ * Memory that is about to be overwritten, such as compression output, need
+ * not be zero-filled: with `zero` false, heap memory is left uninitialized,
+ * and mapped memory is only zeroed by the kernel when each page is first
+ * touched. `huge_pages()` reports what was actually obtained.
+ */
+class HostBuffer
+{
+public:
+  HostBuffer() :
+      m_data(nullptr),
+      m_size(0),
+      m_map(nullptr),
+      m_map_bytes(0),
+      m_huge_pages(HugePages::None)
+  {
+  }
+
+  explicit HostBuffer(
+      const size_t bytes,
+      const HugePages huge_pages = HugePages::None,
+      const bool zero = true) :
+      HostBuffer()
+  {
+    m_size = bytes;
+    if (bytes == 0) {
+      return;
+    }
+#ifdef __linux__
+    if (huge_pages == HugePages::Explicit && map_explicit(bytes)) {
+      return;
+    }
+    if (huge_pages != HugePages::None && map_transparent(bytes)) {
+      return;
+    }
+#else
+    (void)huge_pages;
+#endif
+    m_data = zero ? new uint8_t[bytes]() : new uint8_t[bytes];
+  }
+
+  HostBuffer(HostBuffer&& other) : HostBuffer()
+  {
+    swap(other);
+  }
+
+  HostBuffer& operator=(HostBuffer&& other)
+  {
+    HostBuffer tmp(std::move(other));
+    swap(tmp);
+    return *this;
+  }
+
+  ~HostBuffer()
+  {
+#ifdef __linux__
+    if (m_map != nullptr) {
+      munmap(m_map, m_map_bytes);
+      return;
+    }
+#endif
+    delete[] m_data;
+  }
+
+  // disable copying
+  HostBuffer(const HostBuffer&) = delete;
+  HostBuffer& operator=(const HostBuffer&) = delete;
+
+  uint8_t* data()
+  {
+    return m_data;
+  }
+
+  const uint8_t* data() const
+  {
+    return m_data;
+  }
+
+  size_t size() const
+  {
+    return m_size;
+  }
+
+  HugePages huge_pages() const
+  {
+    return m_huge_pages;
+  }
+
+private:
+  void swap(HostBuffer& other)
+  {
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+    std::swap(m_map, other.m_map);
+    std::swap(m_map_bytes, other.m_map_bytes);
+    std::swap(m_huge_pages, other.m_huge_pages);
+  }
+
+  static size_t round_up_to_huge_page(const size_t bytes)
+  {
+    return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  }
+
+#ifdef __linux__
+  bool map_explicit(const size_t bytes)
+  {
+#ifdef MAP_HUGETLB
+    const size_t map_bytes = round_up_to_huge_page(bytes);
+    void* const ptr = mmap(
+        nullptr,
+        map_bytes,
+        PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+        -1,
+        0);
+    if (ptr == MAP_FAILED) {
+      return false;
+    }
+    m_map = ptr;
+    m_map_bytes = map_bytes;
+    m_data = static_cast<uint8_t*>(ptr);
+    m_huge_pages = HugePages::Explicit;
+    return true;
+#else
+    (void)bytes;
+    return false;
+#endif
+  }
+
+  bool map_transparent(const size_t bytes)
+  {
+    // Map an extra huge page and trim both ends, so that the buffer starts
+    // on a huge page boundary and can be backed by huge pages throughout.
+    const size_t map_bytes = round_up_to_huge_page(bytes);
+    void* const ptr = mmap(
+        nullptr,
+        map_bytes + HUGE_PAGE_SIZE,
+        PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS,
+        -1,
+        0);
+    if (ptr == MAP_FAILED) {
+      return false;
+    }
+    uint8_t* const base = static_cast<uint8_t*>(ptr);
+    const uintptr_t address = reinterpret_cast<uintptr_t>(base);
+    const size_t head = (HUGE_PAGE_SIZE - address % HUGE_PAGE_SIZE)
+                        % HUGE_PAGE_SIZE;
+    if (head > 0) {
+      munmap(base, head);
+    }
+    munmap(base + head + map_bytes, HUGE_PAGE_SIZE - head);
+    m_map = base + head;
+    m_map_bytes = map_bytes;
+    m_data = base + head;
+#ifdef MADV_HUGEPAGE
+    if (madvise(m_map, m_map_bytes, MADV_HUGEPAGE) == 0) {
+      m_huge_pages = HugePages::Transparent;
+    }
+#endif
+    return true;
+  }
+#endif
+
+  uint8_t* m_data;
+  size_t m_size;
+  void* m_map;
+  size_t m_map_bytes;
+  HugePages m_huge_pages;
+};
+
+// Page faults taken by this process so far, or 0 where that is unknown.
+inline uint64_t page_fault_count()
+{
+#ifdef __linux__
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    return static_cast<uint64_t>(usage.ru_minflt)
+           + static_cast<uint64_t>(usage.ru_majflt);
+  }
+#endif
+  return 0;
+}
+
+} // namespace host
+} // namespace nvcomp
@@ -0,0 +1,927 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/host_codec.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace nvcomp
+{
+namespace host
+{
+
+// Options of the host ANS codec.
+struct HostANSOptions
+{
+  // Number of interleaved rANS states: 4, 8 or 32, e.g. to match the width
+  // of the SIMD unit or of a warp that decodes them.
+  size_t num_lanes;
+  // 0 codes every byte with one frequency table, 1 with a table per value
+  // of the previous byte.
+  int order;
+};
+
+constexpr HostANSOptions HostANSDefaultOpts = {8, 0};
+
+namespace detail
+{
+
+// Frequencies are normalized to 2^12. The state is kept in [2^16, 2^32)
+// and renormalized 16 bits at a time, so every step reads or writes at
+// most one word.
+static constexpr uint32_t ANS_PROB_BITS = 12;
+static constexpr uint32_t ANS_PROB_SCALE = 1u << ANS_PROB_BITS;
+static constexpr uint32_t ANS_STATE_LOW = 1u << 16;
+static constexpr size_t ANS_NUM_SYMBOLS = 256;
+
+// Chunk header of the host ANS format. It is followed by the frequency
+// table unless `shared_table` is set, the final state of every lane
+// (uint32_t each), the number of 16-bit renormalization words of every lane
+// (uint32_t each), and the words of every lane in turn. A chunk that doesn't
+// shrink is stored as it is, with `mode` 0.
+struct ANSChunkHeader
+{
+  uint8_t mode;
+  uint8_t order;
+  uint8_t num_lanes;
+  uint8_t shared_table;
+  uint32_t num_symbols;
+  // Identifies the shared table the chunk was coded with.
+  uint32_t table_id;
+  uint32_t reserved;
+};
+
+static_assert(sizeof(ANSChunkHeader) == 16, "Header must be 16 B");
+
+// Normalized frequencies of the symbols in one context, and where each
+// symbol's range of slots starts.
+struct ANSContextTable
+{
+  uint16_t freq[ANS_NUM_SYMBOLS];
+  uint16_t start[ANS_NUM_SYMBOLS];
+};
+
+inline bool ans_valid_lanes(const size_t num_lanes)
+{
+  return num_lanes == 4 || num_lanes == 8 || num_lanes == 32;
+}
+
+// A chunk of `num_symbols` bytes is split into `num_lanes` contiguous
+// segments, the first `num_symbols % num_lanes` of which are one byte
+// longer. Each lane codes one segment, so that order-1 contexts stay within
+// a lane and the lanes can be decoded independently.
+inline size_t ans_segment_start(
+    const size_t num_symbols, const size_t num_lanes, const size_t lane)
+{
+  const size_t base = num_symbols / num_lanes;
+  return lane * base + std::min(lane, num_symbols % num_lanes);
+}
+
+inline size_t ans_segment_length(
+    const size_t num_symbols, const size_t num_lanes, const size_t lane)
+{
+  return num_symbols / num_lanes + (lane < num_symbols % num_lanes ? 1 : 0);
+}
+
+// Add the (context, symbol) counts of `bytes` of `data`, as a chunk coded
+// with `num_lanes` lanes sees them, to `counts`.
+inline void ans_count(
+    const uint8_t* const data,
+    const size_t bytes,
+    const size_t num_lanes,
+    const int order,
+    std::vector<uint32_t>& counts)
+{
+  if (order == 0) {
+    for (size_t i = 0; i < bytes; ++i) {
+      ++counts[data[i]];
+    }
+    return;
+  }
+  for (size_t lane = 0; lane < num_lanes; ++lane) {
+    const size_t start = ans_segment_start(bytes, num_lanes, lane);
+    const size_t length = ans_segment_length(bytes, num_lanes, lane);
+    uint8_t context = 0;
+    for (size_t i = start; i < start + length; ++i) {
+      ++counts[context * ANS_NUM_SYMBOLS + data[i]];
+      context = data[i];
+    }
+  }
+}
+
+// Scale `counts` to frequencies adding up to ANS_PROB_SCALE, keeping every
+// symbol that occurs at a frequency of at least 1.
+inline void ans_normalize(const uint32_t* const counts, ANSContextTable& table)
+{
+  uint64_t total = 0;
+  for (size_t s = 0; s < ANS_NUM_SYMBOLS; ++s) {
+    total += counts[s];
+  }
+  uint32_t sum = 0;
+  for (size_t s = 0; s < ANS_NUM_SYMBOLS; ++s) {
+    uint32_t freq = 0;
+    if (counts[s] > 0) {
+      freq = std::max<uint32_t>(
+          1,
+          static_cast<uint32_t>(counts[s] * uint64_t(ANS_PROB_SCALE) / total));
+    }
+    table.freq[s] = static_cast<uint16_t>(freq);
+    sum += freq;
+  }
+
+  // Rounding down leaves a deficit, which goes to the most frequent symbol.
+  // Rounding rare symbols up to 1 can leave an excess, which is taken from
+  // the most frequent symbols, none of them going below 1.
+  while (sum != ANS_PROB_SCALE) {
+    size_t max_symbol = 0;
+    for (size_t s = 1; s < ANS_NUM_SYMBOLS; ++s) {
+      if (table.freq[s] > table.freq[max_symbol]) {
+        max_symbol = s;
+      }
+    }
+    if (sum < ANS_PROB_SCALE) {
+      table.freq[max_symbol] = static_cast<uint16_t>(
+          table.freq[max_symbol] + ANS_PROB_SCALE - sum);
+      sum = ANS_PROB_SCALE;
+    } else {
+      const uint32_t cut = std::min<uint32_t>(
+          sum - ANS_PROB_SCALE, table.freq[max_symbol] - 1);
+      table.freq[max_symbol]
+          = static_cast<uint16_t>(table.freq[max_symbol] - cut);
+      sum -= cut;
+    }
+  }
+
+  uint32_t start = 0;
+  for (size_t s = 0; s < ANS_NUM_SYMBOLS; ++s) {
+    table.start[s] = static_cast<uint16_t>(start);
+    start += table.freq[s];
+  }
+}
+
+// 1 / freq for every frequency.
+inline const std::vector<double>& ans_reciprocals()
+{
+  static const std::vector<double> reciprocals = []() {
+    std::vector<double> values(ANS_PROB_SCALE + 1, 0);
+    for (size_t freq = 1; freq <= ANS_PROB_SCALE; ++freq) {
+      values[freq] = 1.0 / freq;
+    }
+    return values;
+  }();
+  return reciprocals;
+}
+
+inline void ans_write_varint(std::vector<uint8_t>& out, uint32_t value)
+{
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+inline bool ans_read_varint(
+    const uint8_t* const in,
+    const size_t in_bytes,
+    size_t& pos,
+    uint32_t& value)
+{
+  value = 0;
+  for (size_t shift = 0; shift < 21; shift += 7) {
+    if (pos >= in_bytes) {
+      return false;
+    }
+    const uint8_t byte = in[pos++];
+    value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace detail
+
+/**
+ * @brief The normalized frequency tables of an order-0 or order-1 ANS
+ * model, along with the slot to symbol lookup used to decode.
+ *
+ * A table is either stored in every chunk, or built once from a whole batch
+ * with build() and shared by the codec that compresses and decompresses
+ * it.
+ */
+class ANSTable
+{
+public:
+  ANSTable() : m_order(0), m_context_index(), m_tables(), m_slots(), m_id(0)
+  {
+  }
+
+  // Table of the (context, symbol) counts of `order`, which has 256 counts
+  // per context.
+  static ANSTable
+  from_counts(const int order, const std::vector<uint32_t>& counts)
+  {
+    ANSTable table = normalized(order, counts);
+    table.finish();
+    return table;
+  }
+
+  // Table of the `batch_size` chunks at `in_ptrs`, as coded with `options`.
+  static ANSTable build(
+      const void* const* const in_ptrs,
+      const size_t* const in_bytes,
+      const size_t batch_size,
+      const HostANSOptions& options)
+  {
+    check_options(options);
+    std::vector<uint32_t> counts(
+        (options.order == 0 ? 1 : detail::ANS_NUM_SYMBOLS)
+        * detail::ANS_NUM_SYMBOLS);
+    for (size_t i = 0; i < batch_size; ++i) {
+      detail::ans_count(
+          static_cast<const uint8_t*>(in_ptrs[i]),
+          in_bytes[i],
+          options.num_lanes,
+          options.order,
+          counts);
+    }
+    return from_counts(options.order, counts);
+  }
+
+  static void check_options(const HostANSOptions& options)
+  {
+    if (!detail::ans_valid_lanes(options.num_lanes)) {
+      throw std::runtime_error("ANS supports 4, 8 or 32 lanes.");
+    }
+    if (options.order != 0 && options.order != 1) {
+      throw std::runtime_error("ANS supports order 0 or order 1 models.");
+    }
+  }
+
+  int order() const
+  {
+    return m_order;
+  }
+
+  // Hash of the serialized table, stored in chunks coded with it.
+  uint32_t id() const
+  {
+    return m_id;
+  }
+
+  // Context table, or null if the context never occurs.
+  const detail::ANSContextTable* context(const size_t context) const
+  {
+    const int index = m_context_index[context];
+    return index < 0 ? nullptr : &m_tables[index];
+  }
+
+  // Decoding lookup of a context that occurs: for every slot, the symbol
+  // in the low 8 bits, the slot's offset in the symbol's range in the next
+  // 12 bits, and the symbol's frequency minus 1 in the top 12 bits, so that
+  // a decoding step needs a single load.
+  const uint32_t* slots(const size_t context) const
+  {
+    return m_slots.data()
+           + m_context_index[context] * size_t(detail::ANS_PROB_SCALE);
+  }
+
+  // Whether every (context, symbol) of `counts` has a frequency, i.e. the
+  // data they were counted from can be coded with this table.
+  bool covers(const std::vector<uint32_t>& counts) const
+  {
+    for (size_t c = 0; c < m_context_index.size(); ++c) {
+      const detail::ANSContextTable* const table = context(c);
+      for (size_t s = 0; s < detail::ANS_NUM_SYMBOLS; ++s) {
+        if (counts[c * detail::ANS_NUM_SYMBOLS + s] > 0
+            && (table == nullptr || table->freq[s] == 0)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  // For order 1, a bitmap of the contexts that occur. Then, for every one
+  // of them, a bitmap of its symbols followed by their frequencies minus 1
+  // as varints.
+  void serialize(std::vector<uint8_t>& out) const
+  {
+    if (m_order == 1) {
+      write_bitmap(
+          out, [this](const size_t c) { return context(c) != nullptr; });
+    }
+    for (const detail::ANSContextTable& table : m_tables) {
+      write_bitmap(out, [&table](const size_t s) { return table.freq[s] > 0; });
+      for (size_t s = 0; s < detail::ANS_NUM_SYMBOLS; ++s) {
+        if (table.freq[s] > 0) {
+          detail::ans_write_varint(out, table.freq[s] - 1u);
+        }
+      }
+    }
+  }
+
+  // Read a table written by serialize(), advancing `pos`. Returns false if
+  // the table is truncated or its frequencies don't add up.
+  static bool deserialize(
+      const uint8_t* const in,
+      const size_t in_bytes,
+      size_t& pos,
+      const int order,
+      ANSTable& table)
+  {
+    if (!parse(in, in_bytes, pos, order, table)) {
+      return false;
+    }
+    table.finish();
+    return true;
+  }
+
+private:
+  friend class ANSCodec;
+
+  static constexpr size_t BITMAP_BYTES = detail::ANS_NUM_SYMBOLS / 8;
+
+  // The frequencies only, which is all that encoding needs.
+  static ANSTable
+  normalized(const int order, const std::vector<uint32_t>& counts)
+  {
+    ANSTable table;
+    table.m_order = order;
+    const size_t num_contexts = order == 0 ? 1 : detail::ANS_NUM_SYMBOLS;
+    table.m_context_index.assign(num_contexts, -1);
+    for (size_t c = 0; c < num_contexts; ++c) {
+      const uint32_t* const context_counts
+          = counts.data() + c * detail::ANS_NUM_SYMBOLS;
+      if (std::none_of(
+              context_counts,
+              context_counts + detail::ANS_NUM_SYMBOLS,
+              [](const uint32_t count) { return count > 0; })) {
+        continue;
+      }
+      table.m_context_index[c] = static_cast<int>(table.m_tables.size());
+      table.m_tables.emplace_back();
+      detail::ans_normalize(context_counts, table.m_tables.back());
+    }
+    return table;
+  }
+
+  // Read the frequencies of a table written by serialize().
+  static bool parse(
+      const uint8_t* const in,
+      const size_t in_bytes,
+      size_t& pos,
+      const int order,
+      ANSTable& table)
+  {
+    table = ANSTable();
+    table.m_order = order;
+    const size_t num_contexts = order == 0 ? 1 : detail::ANS_NUM_SYMBOLS;
+    table.m_context_index.assign(num_contexts, order == 0 ? 0 : -1);
+    if (order == 1) {
+      if (in_bytes - pos < BITMAP_BYTES) {
+        return false;
+      }
+      for (size_t c = 0; c < num_contexts; ++c) {
+        if (bitmap_test(in + pos, c)) {
+          table.m_context_index[c] = static_cast<int>(table.m_tables.size());
+          table.m_tables.emplace_back();
+        }
+      }
+      pos += BITMAP_BYTES;
+    } else {
+      table.m_tables.emplace_back();
+    }
+
+    for (detail::ANSContextTable& context_table : table.m_tables) {
+      if (in_bytes - pos < BITMAP_BYTES) {
+        return false;
+      }
+      const uint8_t* const bitmap = in + pos;
+      pos += BITMAP_BYTES;
+      uint32_t sum = 0;
+      for (size_t s = 0; s < detail::ANS_NUM_SYMBOLS; ++s) {
+        uint32_t freq = 0;
+        if (bitmap_test(bitmap, s)) {
+          if (!detail::ans_read_varint(in, in_bytes, pos, freq)
+              || freq >= detail::ANS_PROB_SCALE) {
+            return false;
+          }
+          ++freq;
+        }
+        context_table.freq[s] = static_cast<uint16_t>(freq);
+        context_table.start[s] = static_cast<uint16_t>(sum);
+        sum += freq;
+      }
+      if (sum != detail::ANS_PROB_SCALE) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  template <typename Pred>
+  static void write_bitmap(std::vector<uint8_t>& out, Pred present)
+  {
+    uint8_t bitmap[BITMAP_BYTES] = {};
+    for (size_t i = 0; i < detail::ANS_NUM_SYMBOLS; ++i) {
+      if (present(i)) {
+        bitmap[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+      }
+    }
+    out.insert(out.end(), bitmap, bitmap + BITMAP_BYTES);
+  }
+
+  static bool bitmap_test(const uint8_t* const bitmap, const size_t i)
+  {
+    return (bitmap[i / 8] >> (i % 8)) & 1;
+  }
+
+  // Build the decoding lookup and the id.
+  void finish()
+  {
+    build_slots();
+
+    // FNV-1a
+    std::vector<uint8_t> bytes(1, static_cast<uint8_t>(m_order));
+    serialize(bytes);
+    m_id = 2166136261u;
+    for (const uint8_t byte : bytes) {
+      m_id = (m_id ^ byte) * 16777619u;
+    }
+  }
+
+  void build_slots()
+  {
+    m_slots.resize(m_tables.size() * detail::ANS_PROB_SCALE);
+    for (size_t t = 0; t < m_tables.size(); ++t) {
+      uint32_t* const slots = m_slots.data() + t * detail::ANS_PROB_SCALE;
+      for (uint32_t s = 0; s < detail::ANS_NUM_SYMBOLS; ++s) {
+        const uint32_t freq = m_tables[t].freq[s];
+        for (uint32_t k = 0; k < freq; ++k) {
+          slots[m_tables[t].start[s] + k] = s | (k << 8) | ((freq - 1) << 20);
+        }
+      }
+    }
+  }
+
+  int m_order;
+  std::vector<int> m_context_index;
+  std::vector<detail::ANSContextTable> m_tables;
+  std::vector<uint32_t> m_slots;
+  uint32_t m_id;
+};
+
+/**
+ * @brief A CPU rANS entropy coder for bytes, e.g. quantized data that has
+ * no repeated strings for an LZ codec to find.
+ *
+ * A chunk is split into `num_lanes` segments, each coded by its own rANS
+ * state into its own stream of 16-bit words. The decoder advances every
+ * lane by one symbol in turn, so the lanes are independent chains that keep
+ * the core's pipelines busy, rather than one chain of dependent multiplies
+ * and table lookups, and map directly onto SIMD lanes or the threads of a
+ * warp.
+ *
+ * Each chunk normally carries its own frequency table. A codec constructed
+ * with a shared table, e.g. from ANSTable::build() over a batch, codes every
+ * chunk that the table covers without one, which saves the table's size
+ * per chunk on small chunks; such chunks can only be decompressed by a codec
+ * with the same table. Chunks with symbols the shared table lacks still
+ * carry their own.
+ *
+ * This is not the chunk format of nvcompBatchedANS, so its chunks can't be
+ * decompressed by the GPU ANS API or vice versa.
+ */
+class ANSCodec : public HostCodec
+{
+public:
+  explicit ANSCodec(
+      const HostANSOptions& options = HostANSDefaultOpts,
+      std::shared_ptr<const ANSTable> shared_table
+      = std::shared_ptr<const ANSTable>()) :
+      m_options(options), m_shared_table(std::move(shared_table))
+  {
+    ANSTable::check_options(options);
+    if (m_shared_table && m_shared_table->order() != options.order) {
+      throw std::runtime_error("ANS shared table has the wrong order.");
+    }
+  }
+
+  HostCodecId id() const override
+  {
+    return HostCodecId::ANS;
+  }
+
+  const char* name() const override
+  {
+    return "ans";
+  }
+
+  const HostANSOptions& options() const
+  {
+    return m_options;
+  }
+
+  const std::shared_ptr<const ANSTable>& shared_table() const
+  {
+    return m_shared_table;
+  }
+
+  size_t max_compressed_size(const size_t uncompressed_bytes) const override
+  {
+    check_size(uncompressed_bytes);
+    return sizeof(detail::ANSChunkHeader) + uncompressed_bytes;
+  }
+
+  size_t compress(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity) const override
+  {
+    check_size(in_bytes);
+    const uint8_t* const src = static_cast<const uint8_t*>(in);
+    const size_t num_lanes = m_options.num_lanes;
+    const int order = m_options.order;
+
+    detail::ANSChunkHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.mode = 1;
+    header.order = static_cast<uint8_t>(order);
+    header.num_lanes = static_cast<uint8_t>(num_lanes);
+    header.num_symbols = static_cast<uint32_t>(in_bytes);
+
+    std::vector<uint32_t> counts(
+        (order == 0 ? 1 : detail::ANS_NUM_SYMBOLS) * detail::ANS_NUM_SYMBOLS);
+    detail::ans_count(src, in_bytes, num_lanes, order, counts);
+
+    std::vector<uint8_t> encoded(sizeof(header));
+    ANSTable chunk_table;
+    const ANSTable* table = m_shared_table.get();
+    if (table != nullptr && table->covers(counts)) {
+      header.shared_table = 1;
+      header.table_id = table->id();
+    } else {
+      chunk_table = ANSTable::normalized(order, counts);
+      chunk_table.serialize(encoded);
+      table = &chunk_table;
+    }
+
+    // Code the symbols last to first, so that the decoder reads the words
+    // of every lane first to last.
+    std::vector<uint32_t> states(num_lanes, detail::ANS_STATE_LOW);
+    const std::vector<double>& reciprocals = detail::ans_reciprocals();
+    std::vector<std::vector<uint16_t>> words(num_lanes);
+    std::vector<size_t> starts(num_lanes);
+    for (size_t lane = 0; lane < num_lanes; ++lane) {
+      starts[lane] = detail::ans_segment_start(in_bytes, num_lanes, lane);
+      words[lane].reserve(in_bytes / num_lanes / 2 + 1);
+    }
+    const size_t base = in_bytes / num_lanes;
+    const size_t num_long_lanes = in_bytes % num_lanes;
+    // Context 0 starts every lane, so it exists if there are any symbols.
+    const detail::ANSContextTable* const ctx0 = table->context(0);
+    for (size_t t = base + 1; t-- > 0;) {
+      for (size_t lane = 0; lane < (t < base ? num_lanes : num_long_lanes);
+           ++lane) {
+        const size_t i = starts[lane] + t;
+        const detail::ANSContextTable& ctx
+            = order == 1 && t > 0 ? *table->context(src[i - 1]) : *ctx0;
+        const uint32_t freq = ctx.freq[src[i]];
+        uint32_t x = states[lane];
+        // Largest state that stays below 2^32 once the symbol is coded.
+        const uint64_t x_max = (uint64_t(detail::ANS_STATE_LOW)
+                                << (16 - detail::ANS_PROB_BITS))
+                               * freq;
+        if (x >= x_max) {
+          words[lane].push_back(static_cast<uint16_t>(x));
+          x >>= 16;
+        }
+        // x / freq through a reciprocal, which is much cheaper than a
+        // division. The estimate is exact or 1 too small.
+        uint32_t q = static_cast<uint32_t>(x * reciprocals[freq]);
+        uint32_t r = x - q * freq;
+        if (r >= freq) {
+          ++q;
+          r -= freq;
+        }
+        states[lane] = (q << detail::ANS_PROB_BITS) + r + ctx.start[src[i]];
+      }
+    }
+
+    std::vector<uint32_t> word_counts(num_lanes);
+    size_t num_words = 0;
+    for (size_t lane = 0; lane < num_lanes; ++lane) {
+      std::reverse(words[lane].begin(), words[lane].end());
+      word_counts[lane] = static_cast<uint32_t>(words[lane].size());
+      num_words += words[lane].size();
+    }
+    size_t pos = encoded.size();
+    encoded.resize(
+        pos + 2 * num_lanes * sizeof(uint32_t) + num_words * sizeof(uint16_t));
+    std::memcpy(
+        encoded.data() + pos, states.data(), num_lanes * sizeof(uint32_t));
+    pos += num_lanes * sizeof(uint32_t);
+    std::memcpy(
+        encoded.data() + pos, word_counts.data(), num_lanes * sizeof(uint32_t));
+    pos += num_lanes * sizeof(uint32_t);
+    for (const std::vector<uint16_t>& lane_words : words) {
+      if (!lane_words.empty()) {
+        std::memcpy(
+            encoded.data() + pos,
+            lane_words.data(),
+            lane_words.size() * sizeof(uint16_t));
+      }
+      pos += lane_words.size() * sizeof(uint16_t);
+    }
+
+    if (encoded.size() >= sizeof(header) + in_bytes) {
+      // Store the chunk as it is instead.
+      std::memset(&header, 0, sizeof(header));
+      encoded.assign(sizeof(header), 0);
+      encoded.insert(encoded.end(), src, src + in_bytes);
+    }
+    if (encoded.size() > out_capacity) {
+      throw std::runtime_error("Output buffer too small for ANS chunk.");
+    }
+    std::memcpy(encoded.data(), &header, sizeof(header));
+    std::memcpy(out, encoded.data(), encoded.size());
+    return encoded.size();
+  }
+
+  nvcompStatus_t decompress(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity,
+      size_t* const out_bytes) const override
+  {
+    const uint8_t* const src = static_cast<const uint8_t*>(in);
+    uint8_t* const dst = static_cast<uint8_t*>(out);
+    detail::ANSChunkHeader header;
+    if (in_bytes < sizeof(header)) {
+      return nvcompErrorCannotDecompress;
+    }
+    std::memcpy(&header, src, sizeof(header));
+
+    if (header.mode == 0) {
+      const size_t bytes = in_bytes - sizeof(header);
+      if (bytes > out_capacity) {
+        return nvcompErrorCannotDecompress;
+      }
+      if (bytes > 0) {
+        std::memcpy(dst, src + sizeof(header), bytes);
+      }
+      *out_bytes = bytes;
+      return nvcompSuccess;
+    }
+
+    const size_t num_lanes = header.num_lanes;
+    const size_t num_symbols = header.num_symbols;
+    if (header.mode != 1 || header.order > 1
+        || !detail::ans_valid_lanes(num_lanes) || num_symbols > out_capacity) {
+      return nvcompErrorCannotDecompress;
+    }
+
+    size_t pos = sizeof(header);
+    ANSTable chunk_table;
+    const ANSTable* table = m_shared_table.get();
+    if (header.shared_table) {
+      if (table == nullptr || table->id() != header.table_id
+          || table->order() != header.order) {
+        return nvcompErrorCannotDecompress;
+      }
+    } else {
+      if (!ANSTable::parse(src, in_bytes, pos, header.order, chunk_table)) {
+        return nvcompErrorCannotDecompress;
+      }
+      chunk_table.build_slots();
+      table = &chunk_table;
+    }
+
+    if ((in_bytes - pos) / sizeof(uint32_t) < 2 * num_lanes) {
+      return nvcompErrorCannotDecompress;
+    }
+    const uint8_t* const lanes = src + pos;
+    pos += 2 * num_lanes * sizeof(uint32_t);
+
+    const uint8_t* const words = src + pos;
+    const size_t word_bytes = in_bytes - pos;
+    const bool ok
+        = header.order == 0
+              ? decode<0>(
+                  *table,
+                  num_lanes,
+                  lanes,
+                  words,
+                  word_bytes,
+                  dst,
+                  num_symbols)
+              : decode<1>(
+                  *table,
+                  num_lanes,
+                  lanes,
+                  words,
+                  word_bytes,
+                  dst,
+                  num_symbols);
+    if (!ok) {
+      return nvcompErrorCannotDecompress;
+    }
+    *out_bytes = num_symbols;
+    return nvcompSuccess;
+  }
+
+private:
+  static void check_size(const size_t bytes)
+  {
+    if (bytes > UINT32_MAX) {
+      throw std::runtime_error("ANS chunk too large.");
+    }
+  }
+
+  // The decoding state of one lane.
+  struct LaneDecoder
+  {
+    uint32_t x;
+    const uint8_t* words;
+    size_t last_word;
+    size_t w;
+    size_t start;
+  };
+
+  // Decode the symbol at step `t` of a lane.
+  template <int ORDER>
+  static bool decode_step(
+      const ANSTable& table,
+      const uint32_t*& slots,
+      LaneDecoder& lane,
+      uint8_t* const dst,
+      const size_t t)
+  {
+    const size_t i = lane.start + t;
+    if (ORDER == 1) {
+      const size_t context = t > 0 ? dst[i - 1] : 0;
+      if (table.context(context) == nullptr) {
+        return false;
+      }
+      slots = table.slots(context);
+    }
+    const uint32_t entry = slots[lane.x & (detail::ANS_PROB_SCALE - 1)];
+    const uint32_t next
+        = ((entry >> 20) + 1) * (lane.x >> detail::ANS_PROB_BITS)
+          + ((entry >> 8) & 0xfff);
+    // Renormalizing is about as likely as not, so it is done without a
+    // branch: the next word is always loaded, and only used and consumed if
+    // needed. The load is clamped to the last word, and reading past it is
+    // caught once decoding is done.
+    uint16_t word;
+    std::memcpy(
+        &word,
+        lane.words + std::min(lane.w, lane.last_word) * sizeof(uint16_t),
+        sizeof(word));
+    const uint32_t renormalize = next < detail::ANS_STATE_LOW;
+    lane.x = (next << (16 * renormalize)) | (word & (0u - renormalize));
+    lane.w += renormalize;
+    dst[i] = static_cast<uint8_t>(entry);
+    return true;
+  }
+
+  // Decode every lane in turn, one symbol each, until all segments are
+  // done. Each lane reads its own words, so the lanes are independent
+  // chains of lookups and multiplies that the core can overlap. Every lane
+  // must use up exactly its words and end in the initial state, which
+  // catches most corruption.
+  template <int ORDER, size_t LANES>
+  static bool decode_lanes(
+      const ANSTable& table,
+      const uint8_t* const lane_bytes,
+      const uint8_t* const words,
+      const size_t word_bytes,
+      uint8_t* const dst,
+      const size_t num_symbols)
+  {
+    // Lanes without words read a zero word instead.
+    static const uint16_t no_words = 0;
+
+    uint32_t states[LANES];
+    uint32_t word_counts[LANES];
+    std::memcpy(states, lane_bytes, sizeof(states));
+    std::memcpy(word_counts, lane_bytes + sizeof(states), sizeof(word_counts));
+    LaneDecoder lanes[LANES];
+    size_t offset = 0;
+    for (size_t k = 0; k < LANES; ++k) {
+      if (states[k] < detail::ANS_STATE_LOW
+          || (word_bytes - offset) / sizeof(uint16_t) < word_counts[k]) {
+        return false;
+      }
+      lanes[k].x = states[k];
+      lanes[k].words = word_counts[k] > 0
+                           ? words + offset
+                           : reinterpret_cast<const uint8_t*>(&no_words);
+      lanes[k].last_word = word_counts[k] > 0 ? word_counts[k] - 1 : 0;
+      lanes[k].w = 0;
+      lanes[k].start = detail::ans_segment_start(num_symbols, LANES, k);
+      offset += word_counts[k] * sizeof(uint16_t);
+    }
+    if (offset != word_bytes) {
+      return false;
+    }
+
+    // With order 0 the lookup is hoisted out of the loop.
+    const bool has_context0 = table.context(0) != nullptr;
+    const uint32_t* slots = has_context0 ? table.slots(0) : nullptr;
+    if (ORDER == 0 && !has_context0) {
+      return num_symbols == 0;
+    }
+
+    // All lanes take part in the first `base` steps, which is the loop
+    // that matters. The longer lanes then have one symbol left each.
+    const size_t base = num_symbols / LANES;
+    for (size_t t = 0; t < base; ++t) {
+      for (size_t k = 0; k < LANES; ++k) {
+        if (!decode_step<ORDER>(table, slots, lanes[k], dst, t)) {
+          return false;
+        }
+      }
+    }
+    for (size_t k = 0; k < num_symbols % LANES; ++k) {
+      if (!decode_step<ORDER>(table, slots, lanes[k], dst, base)) {
+        return false;
+      }
+    }
+
+    for (size_t k = 0; k < LANES; ++k) {
+      if (lanes[k].w != word_counts[k] || lanes[k].x != detail::ANS_STATE_LOW) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  template <int ORDER>
+  static bool decode(
+      const ANSTable& table,
+      const size_t num_lanes,
+      const uint8_t* const lane_bytes,
+      const uint8_t* const words,
+      const size_t word_bytes,
+      uint8_t* const dst,
+      const size_t num_symbols)
+  {
+    switch (num_lanes) {
+    case 4:
+      return decode_lanes<ORDER, 4>(
+          table, lane_bytes, words, word_bytes, dst, num_symbols);
+    case 8:
+      return decode_lanes<ORDER, 8>(
+          table, lane_bytes, words, word_bytes, dst, num_symbols);
+    case 32:
+      return decode_lanes<ORDER, 32>(
+          table, lane_bytes, words, word_bytes, dst, num_symbols);
+    }
+    return false;
+  }
+
+  HostANSOptions m_options;
+  std::shared_ptr<const ANSTable> m_shared_table;
+};
+
+} // namespace host
+} // namespace nvcomp
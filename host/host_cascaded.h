@@ -0,0 +1,485 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/bitpack.h"
+#include "host/delta.h"
+#include "host/host_codec.h"
+#include "host/rle.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace nvcomp
+{
+namespace host
+{
+
+// Options of the host Cascaded codec, as in nvcompBatchedCascadedOpts_t.
+struct HostCascadedOptions
+{
+  // Size of the integer elements: 1, 2, 4 or 8 bytes.
+  size_t type_size;
+  int num_RLEs;
+  int num_deltas;
+  bool use_bp;
+};
+
+constexpr HostCascadedOptions HostCascadedDefaultOpts = {4, 2, 1, true};
+
+namespace detail
+{
+
+// Chunk header of the host Cascaded format. It is followed by the first
+// value of every delta pass (uint64_t each), one stream of run lengths per
+// RLE pass, the stream of values, and the bytes after the last whole
+// element. A chunk that doesn't shrink is stored as it is, with `mode` 0.
+struct CascadedChunkHeader
+{
+  uint8_t mode;
+  uint8_t type_size;
+  uint8_t num_RLEs;
+  uint8_t num_deltas;
+  uint8_t use_bp;
+  uint8_t num_tail_bytes;
+  uint16_t reserved;
+  uint32_t num_elements;
+  uint32_t reserved2;
+};
+
+static_assert(sizeof(CascadedChunkHeader) == 16, "Header must be 16 B");
+
+// Each stream starts with this header, followed by the values packed
+// into `bits` bits each after subtracting `base`, in 64-bit words.
+struct CascadedStreamHeader
+{
+  uint32_t count;
+  uint8_t bits;
+  uint8_t reserved[3];
+  uint64_t base;
+};
+
+static_assert(sizeof(CascadedStreamHeader) == 16, "Header must be 16 B");
+
+inline uint64_t cascaded_mask(const size_t bits)
+{
+  return bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+}
+
+// Sign extend the low `type_size` bytes of `value`.
+inline int64_t cascaded_signed(const uint64_t value, const size_t type_size)
+{
+  const size_t shift = 64 - 8 * type_size;
+  return static_cast<int64_t>(value << shift) >> shift;
+}
+
+// Whether an RLE pass that leaves `num_runs` of `num_values` values shrinks
+// the chunk. Packed run lengths of all ones take no bits, so with bit
+// packing a pass is only skipped when it finds no repeats at all; without,
+// each run costs a 4-byte length.
+inline bool cascaded_rle_helps(
+    const size_t num_values,
+    const size_t num_runs,
+    const size_t type_size,
+    const bool use_bp)
+{
+  if (use_bp) {
+    return num_runs < num_values;
+  }
+  return num_runs * (type_size + sizeof(uint32_t)) < num_values * type_size;
+}
+
+inline size_t cascaded_bits(uint64_t range)
+{
+  size_t bits = 0;
+  while (range != 0) {
+    ++bits;
+    range >>= 1;
+  }
+  return bits;
+}
+
+// Append `values` to `out` as one stream. With `use_bp`, the minimum (as a
+// signed `type_size` integer) is subtracted and only the bits needed for
+// the rest are kept, otherwise every value takes `type_size` bytes.
+inline void write_cascaded_stream(
+    std::vector<uint8_t>& out,
+    const std::vector<uint64_t>& values,
+    const size_t type_size,
+    const bool use_bp)
+{
+  CascadedStreamHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.count = static_cast<uint32_t>(values.size());
+  header.bits = static_cast<uint8_t>(8 * type_size);
+  header.base = 0;
+  if (use_bp && !values.empty()) {
+    int64_t min = cascaded_signed(values[0], type_size);
+    int64_t max = min;
+    for (const uint64_t value : values) {
+      const int64_t v = cascaded_signed(value, type_size);
+      min = std::min(min, v);
+      max = std::max(max, v);
+    }
+    header.base = static_cast<uint64_t>(min);
+    header.bits = static_cast<uint8_t>(cascaded_bits(
+        static_cast<uint64_t>(max) - static_cast<uint64_t>(min)));
+  }
+
+  const size_t bits = header.bits;
+  const size_t num_words = (values.size() * bits + 63) / 64;
+  const size_t offset = out.size();
+  out.resize(offset + sizeof(header) + num_words * sizeof(uint64_t));
+  std::memcpy(out.data() + offset, &header, sizeof(header));
+
+  std::vector<uint64_t> words(num_words);
+  bitpack(values.data(), values.size(), bits, header.base, words.data());
+  if (num_words > 0) {
+    std::memcpy(
+        out.data() + offset + sizeof(header),
+        words.data(),
+        num_words * sizeof(uint64_t));
+  }
+}
+
+// Read a stream written by write_cascaded_stream(), advancing `pos`.
+// Returns false if the stream doesn't fit in `in_bytes` or has more than
+// `max_count` values.
+inline bool read_cascaded_stream(
+    const uint8_t* const in,
+    const size_t in_bytes,
+    size_t& pos,
+    const size_t type_size,
+    const size_t max_count,
+    std::vector<uint64_t>& values)
+{
+  CascadedStreamHeader header;
+  if (in_bytes - pos < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, in + pos, sizeof(header));
+  pos += sizeof(header);
+
+  const size_t bits = header.bits;
+  if (bits > 64 || header.count > max_count) {
+    return false;
+  }
+  const size_t num_words = (static_cast<size_t>(header.count) * bits + 63) / 64;
+  if ((in_bytes - pos) / sizeof(uint64_t) < num_words) {
+    return false;
+  }
+  std::vector<uint64_t> words(num_words);
+  if (num_words > 0) {
+    std::memcpy(words.data(), in + pos, num_words * sizeof(uint64_t));
+  }
+  pos += num_words * sizeof(uint64_t);
+
+  values.resize(header.count);
+  bitunpack(words.data(), values.size(), bits, header.base, values.data());
+  if (type_size < 8) {
+    const uint64_t type_mask = cascaded_mask(8 * type_size);
+    for (uint64_t& value : values) {
+      value &= type_mask;
+    }
+  }
+  return true;
+}
+
+} // namespace detail
+
+/**
+ * @brief A CPU implementation of the Cascaded scheme: run-length encoding,
+ * delta encoding and bit packing of integer elements.
+ *
+ * Each RLE pass replaces the values with their runs, keeping the run
+ * lengths as a separate stream. The deltas are then taken of the remaining
+ * values, and with bit packing every stream is stored with the fewest
+ * bits that hold its range. This follows nvcompBatchedCascaded, but the
+ * chunk format is this codec's own, so its chunks can't be decompressed by
+ * the GPU Cascaded API or vice versa.
+ *
+ * The options are stored in every chunk, so any instance can decompress
+ * any chunk.
+ */
+class CascadedCodec : public HostCodec
+{
+public:
+  explicit CascadedCodec(
+      const HostCascadedOptions options = HostCascadedDefaultOpts) :
+      m_options(options)
+  {
+    if (options.type_size != 1 && options.type_size != 2
+        && options.type_size != 4 && options.type_size != 8) {
+      throw std::runtime_error("Cascaded type size must be 1, 2, 4 or 8.");
+    }
+    if (options.num_RLEs < 0 || options.num_RLEs > 8 || options.num_deltas < 0
+        || options.num_deltas > 8) {
+      throw std::runtime_error(
+          "Cascaded supports between 0 and 8 RLE and delta passes.");
+    }
+  }
+
+  HostCodecId id() const override
+  {
+    return HostCodecId::Cascaded;
+  }
+
+  const char* name() const override
+  {
+    return "cascaded";
+  }
+
+  const HostCascadedOptions& options() const
+  {
+    return m_options;
+  }
+
+  size_t max_compressed_size(const size_t uncompressed_bytes) const override
+  {
+    check_size(uncompressed_bytes);
+    return sizeof(detail::CascadedChunkHeader) + uncompressed_bytes;
+  }
+
+  size_t compress(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity) const override
+  {
+    check_size(in_bytes);
+    const size_t type_size = m_options.type_size;
+    const size_t num_elements = in_bytes / type_size;
+    const size_t num_tail_bytes = in_bytes % type_size;
+    const uint8_t* const src = static_cast<const uint8_t*>(in);
+
+    std::vector<uint64_t> values(num_elements, 0);
+    for (size_t i = 0; i < num_elements; ++i) {
+      std::memcpy(&values[i], src + i * type_size, type_size);
+    }
+
+    // RLE passes, each leaving the run values and a stream of run lengths.
+    // The runs are counted first, and the passes stop as soon as one would
+    // not pay for its stream of run lengths; the chunk header records how
+    // many were done.
+    std::vector<std::vector<uint64_t>> runs;
+    for (int r = 0; r < m_options.num_RLEs; ++r) {
+      const size_t num_runs = rle_count_runs(values.data(), values.size());
+      if (!detail::cascaded_rle_helps(
+              values.size(), num_runs, type_size, m_options.use_bp)) {
+        break;
+      }
+      std::vector<uint64_t> run_values(num_runs);
+      std::vector<uint64_t> run_lengths(num_runs);
+      rle_encode(
+          values.data(), values.size(), run_values.data(), run_lengths.data());
+      values.swap(run_values);
+      runs.push_back(std::move(run_lengths));
+    }
+
+    // Delta passes. The first value of each pass is kept aside, so that
+    // the stream only holds the differences.
+    const uint64_t type_mask = detail::cascaded_mask(8 * type_size);
+    std::vector<uint64_t> seeds(m_options.num_deltas, 0);
+    for (int d = 0; d < m_options.num_deltas && !values.empty(); ++d) {
+      seeds[d] = values[0];
+      delta_encode(values.data(), values.data(), values.size());
+      values[0] = 0;
+      for (uint64_t& value : values) {
+        value &= type_mask;
+      }
+    }
+
+    detail::CascadedChunkHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.mode = 1;
+    header.type_size = static_cast<uint8_t>(type_size);
+    header.num_RLEs = static_cast<uint8_t>(runs.size());
+    header.num_deltas = static_cast<uint8_t>(m_options.num_deltas);
+    header.use_bp = m_options.use_bp ? 1 : 0;
+    header.num_tail_bytes = static_cast<uint8_t>(num_tail_bytes);
+    header.num_elements = static_cast<uint32_t>(num_elements);
+
+    std::vector<uint8_t> encoded(
+        sizeof(header) + seeds.size() * sizeof(uint64_t));
+    if (!seeds.empty()) {
+      std::memcpy(
+          encoded.data() + sizeof(header),
+          seeds.data(),
+          seeds.size() * sizeof(uint64_t));
+    }
+    for (size_t r = 0; r < runs.size(); ++r) {
+      // Run lengths always fit in 32 bits, and are never negative.
+      detail::write_cascaded_stream(
+          encoded, runs[r], sizeof(uint32_t), m_options.use_bp);
+    }
+    detail::write_cascaded_stream(
+        encoded, values, type_size, m_options.use_bp);
+    encoded.insert(encoded.end(), src + in_bytes - num_tail_bytes, src + in_bytes);
+
+    if (encoded.size() >= sizeof(header) + in_bytes) {
+      // Store the chunk as it is instead.
+      header.mode = 0;
+      encoded.assign(sizeof(header), 0);
+      encoded.insert(encoded.end(), src, src + in_bytes);
+    }
+    if (encoded.size() > out_capacity) {
+      throw std::runtime_error("Output buffer too small for Cascaded chunk.");
+    }
+    std::memcpy(encoded.data(), &header, sizeof(header));
+    std::memcpy(out, encoded.data(), encoded.size());
+    return encoded.size();
+  }
+
+  nvcompStatus_t decompress(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity,
+      size_t* const out_bytes) const override
+  {
+    const uint8_t* const src = static_cast<const uint8_t*>(in);
+    uint8_t* const dst = static_cast<uint8_t*>(out);
+    detail::CascadedChunkHeader header;
+    if (in_bytes < sizeof(header)) {
+      return nvcompErrorCannotDecompress;
+    }
+    std::memcpy(&header, src, sizeof(header));
+
+    if (header.mode == 0) {
+      const size_t bytes = in_bytes - sizeof(header);
+      if (bytes > out_capacity) {
+        return nvcompErrorCannotDecompress;
+      }
+      if (bytes > 0) {
+        std::memcpy(dst, src + sizeof(header), bytes);
+      }
+      *out_bytes = bytes;
+      return nvcompSuccess;
+    }
+
+    const size_t type_size = header.type_size;
+    if (header.mode != 1
+        || (type_size != 1 && type_size != 2 && type_size != 4
+            && type_size != 8)
+        || header.num_tail_bytes >= type_size) {
+      return nvcompErrorCannotDecompress;
+    }
+    const size_t num_elements = header.num_elements;
+    const size_t total_bytes = num_elements * type_size + header.num_tail_bytes;
+    if (total_bytes > out_capacity) {
+      return nvcompErrorCannotDecompress;
+    }
+
+    std::vector<uint64_t> seeds(header.num_deltas);
+    if ((in_bytes - sizeof(header)) / sizeof(uint64_t) < seeds.size()) {
+      return nvcompErrorCannotDecompress;
+    }
+    if (!seeds.empty()) {
+      std::memcpy(
+          seeds.data(), src + sizeof(header), seeds.size() * sizeof(uint64_t));
+    }
+
+    size_t pos = sizeof(header) + seeds.size() * sizeof(uint64_t);
+    std::vector<std::vector<uint64_t>> runs(header.num_RLEs);
+    for (size_t r = 0; r < runs.size(); ++r) {
+      if (!detail::read_cascaded_stream(
+              src, in_bytes, pos, sizeof(uint32_t), num_elements, runs[r])) {
+        return nvcompErrorCannotDecompress;
+      }
+    }
+    std::vector<uint64_t> values;
+    if (!detail::read_cascaded_stream(
+            src, in_bytes, pos, type_size, num_elements, values)) {
+      return nvcompErrorCannotDecompress;
+    }
+    if (in_bytes - pos != header.num_tail_bytes) {
+      return nvcompErrorCannotDecompress;
+    }
+
+    const uint64_t type_mask = detail::cascaded_mask(8 * type_size);
+    for (size_t d = seeds.size(); d-- > 0 && !values.empty();) {
+      values[0] = seeds[d];
+      delta_decode(values.data(), values.data(), values.size());
+    }
+    for (uint64_t& value : values) {
+      value &= type_mask;
+    }
+
+    // Undo the RLE passes, last first. The run lengths must add up to the
+    // number of values of the previous pass, and in the end to
+    // num_elements.
+    for (size_t r = runs.size(); r-- > 0;) {
+      if (runs[r].size() != values.size()) {
+        return nvcompErrorCannotDecompress;
+      }
+      const size_t limit = r == 0 ? num_elements : runs[r - 1].size();
+      std::vector<uint64_t> expanded(limit);
+      if (!rle_decode(
+              values.data(),
+              runs[r].data(),
+              values.size(),
+              expanded.data(),
+              limit)) {
+        return nvcompErrorCannotDecompress;
+      }
+      values.swap(expanded);
+    }
+    if (values.size() != num_elements) {
+      return nvcompErrorCannotDecompress;
+    }
+
+    for (size_t i = 0; i < num_elements; ++i) {
+      std::memcpy(dst + i * type_size, &values[i], type_size);
+    }
+    if (header.num_tail_bytes > 0) {
+      std::memcpy(
+          dst + num_elements * type_size, src + pos, header.num_tail_bytes);
+    }
+    *out_bytes = total_bytes;
+    return nvcompSuccess;
+  }
+
+private:
+  static void check_size(const size_t bytes)
+  {
+    if (bytes > UINT32_MAX) {
+      throw std::runtime_error("Cascaded chunk too large.");
+    }
+  }
+
+  HostCascadedOptions m_options;
+};
+
+} // namespace host
+} // namespace nvcomp
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "nvcomp/shared_types.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nvcomp
+{
+namespace host
+{
+
+// Identifies the codec of host compressed chunks. The values are stored in
+// host frames, so they must not change.
+enum class HostCodecId : uint8_t
+{
+  Stored = 0,
+  LZ4 = 1,
+  Deflate = 2,
+  Cascaded = 3,
+  ANS = 4,
+  Float = 5,
+  RLE = 6,
+  Dictionary = 7,
+  PFOR = 8,
+};
+
+/**
+ * @brief A CPU implementation of one chunk format.
+ *
+ * Codecs are stateless and may be used from many threads at once. The LZ4
+ * and Deflate codecs produce the same chunk formats as the GPU batched
+ * LZ4 and Deflate APIs, so their chunks can be decompressed on either side.
+ * The codecs and make_host_codec() are in host/host_codecs.h.
+ */
+class HostCodec
+{
+public:
+  virtual ~HostCodec()
+  {
+  }
+
+  virtual HostCodecId id() const = 0;
+
+  virtual const char* name() const = 0;
+
+  // Largest compressed size of a chunk of `uncompressed_bytes`.
+  virtual size_t max_compressed_size(size_t uncompressed_bytes) const = 0;
+
+  // Compress one chunk, returning the compressed size. Throws on failure.
+  virtual size_t compress(
+      const void* in, size_t in_bytes, void* out, size_t out_capacity) const
+      = 0;
+
+  // Decompress one chunk. Corrupt input is reported through the status, as
+  // with the batched GPU APIs.
+  virtual nvcompStatus_t decompress(
+      const void* in,
+      size_t in_bytes,
+      void* out,
+      size_t out_capacity,
+      size_t* out_bytes) const
+      = 0;
+};
+
+} // namespace host
+} // namespace nvcomp
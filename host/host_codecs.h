@@ -0,0 +1,417 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/host_ans.h"
+#include "host/host_cascaded.h"
+#include "host/host_codec.h"
+#include "host/host_dictionary.h"
+#include "host/host_float.h"
+#include "host/host_pfor.h"
+#include "host/host_rle.h"
+#include "host/thread_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#ifdef NVCOMP_HOST_HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef NVCOMP_HOST_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace nvcomp
+{
+namespace host
+{
+
+// Copies chunks as they are.
+class StoredCodec : public HostCodec
+{
+public:
+  HostCodecId id() const override
+  {
+    return HostCodecId::Stored;
+  }
+
+  const char* name() const override
+  {
+    return "stored";
+  }
+
+  size_t max_compressed_size(const size_t uncompressed_bytes) const override
+  {
+    return uncompressed_bytes;
+  }
+
+  size_t compress(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity) const override
+  {
+    if (in_bytes > out_capacity) {
+      throw std::runtime_error("Output buffer too small for stored chunk.");
+    }
+    if (in_bytes > 0) {
+      std::memcpy(out, in, in_bytes);
+    }
+    return in_bytes;
+  }
+
+  nvcompStatus_t decompress(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity,
+      size_t* const out_bytes) const override
+  {
+    if (in_bytes > out_capacity) {
+      return nvcompErrorCannotDecompress;
+    }
+    if (in_bytes > 0) {
+      std::memcpy(out, in, in_bytes);
+    }
+    *out_bytes = in_bytes;
+    return nvcompSuccess;
+  }
+};
+
+#ifdef NVCOMP_HOST_HAVE_LZ4
+// LZ4 block format, as produced by nvcompBatchedLZ4CompressAsync.
+class LZ4Codec : public HostCodec
+{
+public:
+  HostCodecId id() const override
+  {
+    return HostCodecId::LZ4;
+  }
+
+  const char* name() const override
+  {
+    return "lz4";
+  }
+
+  size_t max_compressed_size(const size_t uncompressed_bytes) const override
+  {
+    check_size(uncompressed_bytes);
+    return LZ4_compressBound(static_cast<int>(uncompressed_bytes));
+  }
+
+  size_t compress(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity) const override
+  {
+    check_size(in_bytes);
+    const int bytes = LZ4_compress_default(
+        static_cast<const char*>(in),
+        static_cast<char*>(out),
+        static_cast<int>(in_bytes),
+        static_cast<int>(std::min<size_t>(out_capacity, LZ4_MAX_INPUT_SIZE)));
+    if (bytes <= 0 && in_bytes > 0) {
+      throw std::runtime_error("LZ4 compression failed.");
+    }
+    return static_cast<size_t>(bytes);
+  }
+
+  nvcompStatus_t decompress(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity,
+      size_t* const out_bytes) const override
+  {
+    if (in_bytes > LZ4_MAX_INPUT_SIZE) {
+      return nvcompErrorCannotDecompress;
+    }
+    const int bytes = LZ4_decompress_safe(
+        static_cast<const char*>(in),
+        static_cast<char*>(out),
+        static_cast<int>(in_bytes),
+        static_cast<int>(std::min<size_t>(out_capacity, LZ4_MAX_INPUT_SIZE)));
+    if (bytes < 0) {
+      return nvcompErrorCannotDecompress;
+    }
+    *out_bytes = static_cast<size_t>(bytes);
+    return nvcompSuccess;
+  }
+
+private:
+  static void check_size(const size_t bytes)
+  {
+    if (bytes > LZ4_MAX_INPUT_SIZE) {
+      throw std::runtime_error(
+          "LZ4 chunks must be at most " + std::to_string(LZ4_MAX_INPUT_SIZE)
+          + " bytes.");
+    }
+  }
+};
+#endif
+
+#ifdef NVCOMP_HOST_HAVE_ZLIB
+// Raw Deflate streams, as produced by nvcompBatchedDeflateCompressAsync.
+class DeflateCodec : public HostCodec
+{
+public:
+  explicit DeflateCodec(const int level = Z_DEFAULT_COMPRESSION) :
+      m_level(level)
+  {
+  }
+
+  HostCodecId id() const override
+  {
+    return HostCodecId::Deflate;
+  }
+
+  const char* name() const override
+  {
+    return "deflate";
+  }
+
+  size_t max_compressed_size(const size_t uncompressed_bytes) const override
+  {
+    check_size(uncompressed_bytes);
+    // This includes the zlib wrapper, so it also bounds raw streams.
+    return compressBound(static_cast<uLong>(uncompressed_bytes));
+  }
+
+  size_t compress(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity) const override
+  {
+    check_size(in_bytes);
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(
+            &stream, m_level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY)
+        != Z_OK) {
+      throw std::runtime_error("deflateInit2() failed.");
+    }
+    stream.next_in = static_cast<Bytef*>(const_cast<void*>(in));
+    stream.avail_in = static_cast<uInt>(in_bytes);
+    stream.next_out = static_cast<Bytef*>(out);
+    stream.avail_out = static_cast<uInt>(
+        std::min<size_t>(out_capacity, std::numeric_limits<uInt>::max()));
+    const int ret = deflate(&stream, Z_FINISH);
+    const size_t bytes = stream.total_out;
+    deflateEnd(&stream);
+    if (ret != Z_STREAM_END) {
+      throw std::runtime_error("Deflate compression failed.");
+    }
+    return bytes;
+  }
+
+  nvcompStatus_t decompress(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity,
+      size_t* const out_bytes) const override
+  {
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, -15) != Z_OK) {
+      return nvcompErrorInternal;
+    }
+    stream.next_in = static_cast<Bytef*>(const_cast<void*>(in));
+    stream.avail_in = static_cast<uInt>(
+        std::min<size_t>(in_bytes, std::numeric_limits<uInt>::max()));
+    stream.next_out = static_cast<Bytef*>(out);
+    stream.avail_out = static_cast<uInt>(
+        std::min<size_t>(out_capacity, std::numeric_limits<uInt>::max()));
+    const int ret = inflate(&stream, Z_FINISH);
+    *out_bytes = stream.total_out;
+    inflateEnd(&stream);
+    return ret == Z_STREAM_END ? nvcompSuccess : nvcompErrorCannotDecompress;
+  }
+
+private:
+  static void check_size(const size_t bytes)
+  {
+    if (bytes > std::numeric_limits<uInt>::max() / 2) {
+      throw std::runtime_error("Deflate chunk too large.");
+    }
+  }
+
+  int m_level;
+};
+#endif
+
+// Whether the codec was compiled in.
+inline bool host_codec_available(const HostCodecId id)
+{
+  switch (id) {
+  case HostCodecId::Stored:
+    return true;
+#ifdef NVCOMP_HOST_HAVE_LZ4
+  case HostCodecId::LZ4:
+    return true;
+#endif
+#ifdef NVCOMP_HOST_HAVE_ZLIB
+  case HostCodecId::Deflate:
+    return true;
+#endif
+  case HostCodecId::Cascaded:
+  case HostCodecId::ANS:
+  case HostCodecId::Float:
+  case HostCodecId::RLE:
+  case HostCodecId::Dictionary:
+  case HostCodecId::PFOR:
+    return true;
+  default:
+    return false;
+  }
+}
+
+inline std::shared_ptr<const HostCodec> make_host_codec(const HostCodecId id)
+{
+  switch (id) {
+  case HostCodecId::Stored:
+    return std::make_shared<StoredCodec>();
+#ifdef NVCOMP_HOST_HAVE_LZ4
+  case HostCodecId::LZ4:
+    return std::make_shared<LZ4Codec>();
+#endif
+#ifdef NVCOMP_HOST_HAVE_ZLIB
+  case HostCodecId::Deflate:
+    return std::make_shared<DeflateCodec>();
+#endif
+  case HostCodecId::Cascaded:
+    return std::make_shared<CascadedCodec>();
+  case HostCodecId::ANS:
+    return std::make_shared<ANSCodec>();
+  case HostCodecId::Float:
+    return std::make_shared<FloatCodec>();
+  case HostCodecId::RLE:
+    return std::make_shared<RleCodec>();
+  case HostCodecId::Dictionary:
+    return std::make_shared<DictionaryCodec>();
+  case HostCodecId::PFOR:
+    return std::make_shared<PforCodec>();
+  default:
+    throw std::runtime_error(
+        "Host codec " + std::to_string(static_cast<int>(id))
+        + " is not available in this build.");
+  }
+}
+
+// Codec from its name() or its format name in the benchmarks.
+inline std::shared_ptr<const HostCodec> make_host_codec(const std::string& name)
+{
+  if (name == "stored" || name == "none") {
+    return make_host_codec(HostCodecId::Stored);
+  }
+  if (name == "lz4") {
+    return make_host_codec(HostCodecId::LZ4);
+  }
+  if (name == "deflate") {
+    return make_host_codec(HostCodecId::Deflate);
+  }
+  if (name == "cascaded") {
+    return make_host_codec(HostCodecId::Cascaded);
+  }
+  if (name == "ans") {
+    return make_host_codec(HostCodecId::ANS);
+  }
+  if (name == "float") {
+    return make_host_codec(HostCodecId::Float);
+  }
+  if (name == "double") {
+    HostFloatOptions options = HostFloatDefaultOpts;
+    options.element_bytes = 8;
+    return std::make_shared<FloatCodec>(options);
+  }
+  if (name == "rle") {
+    return make_host_codec(HostCodecId::RLE);
+  }
+  if (name == "dict") {
+    return make_host_codec(HostCodecId::Dictionary);
+  }
+  if (name == "pfor") {
+    return make_host_codec(HostCodecId::PFOR);
+  }
+  throw std::runtime_error("Unknown host codec '" + name + "'.");
+}
+
+/**
+ * @brief Compress `batch_size` chunks on `pool`, taking the same pointer and
+ * size arrays as the batched GPU compression APIs, in host memory.
+ *
+ * `out_ptrs[i]` must hold `codec.max_compressed_size(in_bytes[i])` bytes.
+ * The first exception thrown by the codec is rethrown.
+ */
+inline void host_batched_compress(
+    const HostCodec& codec,
+    const void* const* const in_ptrs,
+    const size_t* const in_bytes,
+    const size_t batch_size,
+    void* const* const out_ptrs,
+    size_t* const out_bytes,
+    ThreadPool& pool = default_thread_pool())
+{
+  pool.parallel_for(batch_size, [&](const size_t i) {
+    out_bytes[i] = codec.compress(
+        in_ptrs[i],
+        in_bytes[i],
+        out_ptrs[i],
+        codec.max_compressed_size(in_bytes[i]));
+  });
+}
+
+// Decompress `batch_size` chunks on `pool`, as the batched GPU
+// decompression APIs do, with a status per chunk.
+inline void host_batched_decompress(
+    const HostCodec& codec,
+    const void* const* const in_ptrs,
+    const size_t* const in_bytes,
+    const size_t* const out_capacities,
+    const size_t batch_size,
+    void* const* const out_ptrs,
+    size_t* const out_bytes,
+    nvcompStatus_t* const statuses,
+    ThreadPool& pool = default_thread_pool())
+{
+  pool.parallel_for(batch_size, [&](const size_t i) {
+    statuses[i] = codec.decompress(
+        in_ptrs[i], in_bytes[i], out_ptrs[i], out_capacities[i], &out_bytes[i]);
+  });
+}
+
+} // namespace host
+} // namespace nvcomp
@@ -0,0 +1,423 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/bitpack.h"
+#include "host/dictionary.h"
+#include "host/host_cascaded.h"
+#include "host/host_codec.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace nvcomp
+{
+namespace host
+{
+
+// How the dictionary codec stores the codes of a chunk.
+enum class DictionaryCodes : uint8_t
+{
+  // Bit packed, with the fewest bits that hold every code.
+  Packed = 0,
+  // At a fixed width of 1, 2 or 4 bytes, compressed with the host Cascaded
+  // codec, whose RLE passes pay off when equal values come in runs.
+  Cascaded = 1
+};
+
+inline const char* dictionary_codes_name(const DictionaryCodes codes)
+{
+  switch (codes) {
+  case DictionaryCodes::Packed:
+    return "packed";
+  case DictionaryCodes::Cascaded:
+    return "cascaded";
+  }
+  return "unknown";
+}
+
+inline DictionaryCodes dictionary_codes_from_name(const std::string& name)
+{
+  if (name == "packed") {
+    return DictionaryCodes::Packed;
+  }
+  if (name == "cascaded") {
+    return DictionaryCodes::Cascaded;
+  }
+  throw std::runtime_error(
+      "Unknown dictionary codes '" + name + "', use packed or cascaded.");
+}
+
+// Options of the host dictionary codec.
+struct HostDictionaryOptions
+{
+  // Size of the integer elements: 1, 2, 4 or 8 bytes.
+  size_t type_size;
+  // Whether the codes follow the order of the values, rather than the order
+  // in which they first appear.
+  bool sorted;
+  DictionaryCodes codes;
+};
+
+constexpr HostDictionaryOptions HostDictionaryDefaultOpts
+    = {4, false, DictionaryCodes::Packed};
+
+namespace detail
+{
+
+// Chunk header of the host dictionary format. It is followed by the
+// distinct values (`type_size` bytes each), the codes, and the bytes after
+// the last whole element. Packed codes take `code_bits` bits each in 64-bit
+// words; Cascaded codes are a host Cascaded chunk of `code_bits / 8`-byte
+// elements filling the space up to the tail. A chunk that doesn't shrink is
+// stored as it is, with `mode` 0.
+struct DictionaryChunkHeader
+{
+  uint8_t mode;
+  uint8_t type_size;
+  uint8_t codes;
+  uint8_t code_bits;
+  uint32_t num_elements;
+  uint32_t num_values;
+  uint32_t num_tail_bytes;
+};
+
+static_assert(sizeof(DictionaryChunkHeader) == 16, "Header must be 16 B");
+
+inline HostCascadedOptions dictionary_cascaded_options(const size_t code_bytes)
+{
+  HostCascadedOptions options = HostCascadedDefaultOpts;
+  options.type_size = code_bytes;
+  return options;
+}
+
+} // namespace detail
+
+/**
+ * @brief A CPU dictionary codec for low-cardinality integer elements.
+ *
+ * Each chunk stores its distinct values once and every element as the code
+ * of its value, which takes only a few bits for categorical columns. The
+ * codes are bit packed, or run through the host Cascaded codec.
+ */
+class DictionaryCodec : public HostCodec
+{
+public:
+  explicit DictionaryCodec(
+      const HostDictionaryOptions options = HostDictionaryDefaultOpts) :
+      m_options(options)
+  {
+    if (options.type_size != 1 && options.type_size != 2
+        && options.type_size != 4 && options.type_size != 8) {
+      throw std::runtime_error("Dictionary type size must be 1, 2, 4 or 8.");
+    }
+    if (options.codes != DictionaryCodes::Packed
+        && options.codes != DictionaryCodes::Cascaded) {
+      throw std::runtime_error("Unknown dictionary code layout.");
+    }
+  }
+
+  HostCodecId id() const override
+  {
+    return HostCodecId::Dictionary;
+  }
+
+  const char* name() const override
+  {
+    return "dict";
+  }
+
+  const HostDictionaryOptions& options() const
+  {
+    return m_options;
+  }
+
+  size_t max_compressed_size(const size_t uncompressed_bytes) const override
+  {
+    check_size(uncompressed_bytes);
+    return sizeof(detail::DictionaryChunkHeader) + uncompressed_bytes;
+  }
+
+  size_t compress(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity) const override
+  {
+    check_size(in_bytes);
+    switch (m_options.type_size) {
+    case 1:
+      return compress_typed<uint8_t>(in, in_bytes, out, out_capacity);
+    case 2:
+      return compress_typed<uint16_t>(in, in_bytes, out, out_capacity);
+    case 4:
+      return compress_typed<uint32_t>(in, in_bytes, out, out_capacity);
+    default:
+      return compress_typed<uint64_t>(in, in_bytes, out, out_capacity);
+    }
+  }
+
+  nvcompStatus_t decompress(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity,
+      size_t* const out_bytes) const override
+  {
+    const uint8_t* const src = static_cast<const uint8_t*>(in);
+    uint8_t* const dst = static_cast<uint8_t*>(out);
+    detail::DictionaryChunkHeader header;
+    if (in_bytes < sizeof(header)) {
+      return nvcompErrorCannotDecompress;
+    }
+    std::memcpy(&header, src, sizeof(header));
+
+    if (header.mode == 0) {
+      const size_t bytes = in_bytes - sizeof(header);
+      if (bytes > out_capacity) {
+        return nvcompErrorCannotDecompress;
+      }
+      if (bytes > 0) {
+        std::memcpy(dst, src + sizeof(header), bytes);
+      }
+      *out_bytes = bytes;
+      return nvcompSuccess;
+    }
+
+    const size_t type_size = header.type_size;
+    const size_t num_elements = header.num_elements;
+    const size_t num_values = header.num_values;
+    const size_t tail_bytes = header.num_tail_bytes;
+    const size_t total_bytes = num_elements * type_size + tail_bytes;
+    if (header.mode != 1
+        || (type_size != 1 && type_size != 2 && type_size != 4
+            && type_size != 8)
+        || tail_bytes >= type_size || header.code_bits > 32
+        || header.codes > 1 || num_values > num_elements
+        || total_bytes > out_capacity
+        || (in_bytes - sizeof(header)) / type_size < num_values
+        || in_bytes - sizeof(header) - num_values * type_size < tail_bytes) {
+      return nvcompErrorCannotDecompress;
+    }
+
+    bool ok;
+    switch (type_size) {
+    case 1:
+      ok = decompress_typed<uint8_t>(header, src, in_bytes, dst);
+      break;
+    case 2:
+      ok = decompress_typed<uint16_t>(header, src, in_bytes, dst);
+      break;
+    case 4:
+      ok = decompress_typed<uint32_t>(header, src, in_bytes, dst);
+      break;
+    default:
+      ok = decompress_typed<uint64_t>(header, src, in_bytes, dst);
+      break;
+    }
+    if (!ok) {
+      return nvcompErrorCannotDecompress;
+    }
+    *out_bytes = total_bytes;
+    return nvcompSuccess;
+  }
+
+private:
+  static void check_size(const size_t bytes)
+  {
+    if (bytes > UINT32_MAX) {
+      throw std::runtime_error("Dictionary chunk too large.");
+    }
+  }
+
+  template <typename U>
+  size_t compress_typed(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity) const
+  {
+    const uint8_t* const src = static_cast<const uint8_t*>(in);
+    uint8_t* const dst = static_cast<uint8_t*>(out);
+    const size_t num_elements = in_bytes / sizeof(U);
+    const size_t tail_bytes = in_bytes % sizeof(U);
+
+    std::vector<U> elements(num_elements);
+    if (num_elements > 0) {
+      std::memcpy(elements.data(), src, num_elements * sizeof(U));
+    }
+    const Dictionary<U> dict
+        = build_dictionary(elements.data(), num_elements, m_options.sorted);
+    const size_t num_values = dict.values.size();
+
+    detail::DictionaryChunkHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.mode = 1;
+    header.type_size = sizeof(U);
+    header.codes = static_cast<uint8_t>(m_options.codes);
+    header.num_elements = static_cast<uint32_t>(num_elements);
+    header.num_values = static_cast<uint32_t>(num_values);
+    header.num_tail_bytes = static_cast<uint32_t>(tail_bytes);
+
+    std::vector<uint8_t> codes;
+    if (m_options.codes == DictionaryCodes::Packed) {
+      const size_t bits = dictionary_code_bits(num_values);
+      header.code_bits = static_cast<uint8_t>(bits);
+      std::vector<uint64_t> words(bitpack_words(num_elements, bits));
+      bitpack(dict.codes.data(), num_elements, bits, 0u, words.data());
+      codes.resize(words.size() * sizeof(uint64_t));
+      if (!words.empty()) {
+        std::memcpy(codes.data(), words.data(), codes.size());
+      }
+    } else {
+      const size_t code_bytes = dictionary_code_bytes(num_values);
+      header.code_bits = static_cast<uint8_t>(8 * code_bytes);
+      // Codes are little-endian, as is the rest of the chunk.
+      std::vector<uint8_t> narrow(num_elements * code_bytes);
+      for (size_t i = 0; i < num_elements; ++i) {
+        std::memcpy(&narrow[i * code_bytes], &dict.codes[i], code_bytes);
+      }
+      const CascadedCodec cascaded(
+          detail::dictionary_cascaded_options(code_bytes));
+      codes.resize(cascaded.max_compressed_size(narrow.size()));
+      codes.resize(cascaded.compress(
+          narrow.data(), narrow.size(), codes.data(), codes.size()));
+    }
+
+    const size_t encoded_bytes = sizeof(header) + num_values * sizeof(U)
+                                 + codes.size() + tail_bytes;
+    if (encoded_bytes >= sizeof(header) + in_bytes) {
+      // Store the chunk as it is instead.
+      if (sizeof(header) + in_bytes > out_capacity) {
+        throw std::runtime_error(
+            "Output buffer too small for dictionary chunk.");
+      }
+      std::memset(dst, 0, sizeof(header));
+      if (in_bytes > 0) {
+        std::memcpy(dst + sizeof(header), src, in_bytes);
+      }
+      return sizeof(header) + in_bytes;
+    }
+    if (encoded_bytes > out_capacity) {
+      throw std::runtime_error("Output buffer too small for dictionary chunk.");
+    }
+
+    size_t pos = 0;
+    std::memcpy(dst, &header, sizeof(header));
+    pos += sizeof(header);
+    if (num_values > 0) {
+      std::memcpy(dst + pos, dict.values.data(), num_values * sizeof(U));
+    }
+    pos += num_values * sizeof(U);
+    if (!codes.empty()) {
+      std::memcpy(dst + pos, codes.data(), codes.size());
+    }
+    pos += codes.size();
+    if (tail_bytes > 0) {
+      std::memcpy(dst + pos, src + num_elements * sizeof(U), tail_bytes);
+    }
+    return encoded_bytes;
+  }
+
+  template <typename U>
+  static bool decompress_typed(
+      const detail::DictionaryChunkHeader& header,
+      const uint8_t* const src,
+      const size_t in_bytes,
+      uint8_t* const dst)
+  {
+    const size_t num_elements = header.num_elements;
+    const size_t num_values = header.num_values;
+    const size_t tail_bytes = header.num_tail_bytes;
+    size_t pos = sizeof(header);
+
+    std::vector<U> values(num_values);
+    if (num_values > 0) {
+      std::memcpy(values.data(), src + pos, num_values * sizeof(U));
+    }
+    pos += num_values * sizeof(U);
+    const size_t code_stream_bytes = in_bytes - pos - tail_bytes;
+
+    std::vector<uint32_t> codes(num_elements);
+    if (header.codes == static_cast<uint8_t>(DictionaryCodes::Packed)) {
+      const size_t bits = header.code_bits;
+      const size_t num_words = bitpack_words(num_elements, bits);
+      if (code_stream_bytes != num_words * sizeof(uint64_t)) {
+        return false;
+      }
+      std::vector<uint64_t> words(num_words);
+      if (num_words > 0) {
+        std::memcpy(words.data(), src + pos, code_stream_bytes);
+      }
+      bitunpack(words.data(), num_elements, bits, 0u, codes.data());
+    } else {
+      const size_t code_bytes = header.code_bits / 8;
+      if (code_bytes != 1 && code_bytes != 2 && code_bytes != 4) {
+        return false;
+      }
+      std::vector<uint8_t> narrow(num_elements * code_bytes);
+      const CascadedCodec cascaded(
+          detail::dictionary_cascaded_options(code_bytes));
+      size_t narrow_bytes = 0;
+      if (cascaded.decompress(
+              src + pos,
+              code_stream_bytes,
+              narrow.data(),
+              narrow.size(),
+              &narrow_bytes)
+              != nvcompSuccess
+          || narrow_bytes != narrow.size()) {
+        return false;
+      }
+      for (size_t i = 0; i < num_elements; ++i) {
+        std::memcpy(&codes[i], &narrow[i * code_bytes], code_bytes);
+      }
+    }
+    pos += code_stream_bytes;
+
+    for (size_t i = 0; i < num_elements; ++i) {
+      if (codes[i] >= num_values) {
+        return false;
+      }
+      std::memcpy(dst + i * sizeof(U), &values[codes[i]], sizeof(U));
+    }
+    if (tail_bytes > 0) {
+      std::memcpy(dst + num_elements * sizeof(U), src + pos, tail_bytes);
+    }
+    return true;
+  }
+
+  HostDictionaryOptions m_options;
+};
+
+} // namespace host
+} // namespace nvcomp
@@ -0,0 +1,627 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/host_codec.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace nvcomp
+{
+namespace host
+{
+
+// How the float codec predicts each value from the previous ones of its
+// lane, and what residual it codes.
+enum class FloatPredictor : uint8_t
+{
+  // The previous value, with the XOR as the residual, as in Gorilla.
+  Previous = 0,
+  // The previous value plus the difference of the previous two, taken on
+  // the bit patterns, which follows a steady slope within an exponent. The
+  // residual is the difference from the prediction.
+  Stride = 1
+};
+
+// Options of the host float codec.
+struct HostFloatOptions
+{
+  // Width of the values: 4 for float, 8 for double.
+  size_t element_bytes;
+  // Number of independent lanes, between 1 and 64.
+  size_t num_lanes;
+  FloatPredictor predictor;
+};
+
+constexpr HostFloatOptions HostFloatDefaultOpts
+    = {4, 8, FloatPredictor::Stride};
+
+namespace detail
+{
+
+// Chunk header of the host float format. It is followed by the number of
+// 64-bit words of every lane (uint32_t each), the words of every lane in
+// turn, and the bytes after the last whole element. A chunk that doesn't
+// shrink is stored as it is, with `mode` 0.
+struct FloatChunkHeader
+{
+  uint8_t mode;
+  uint8_t element_bytes;
+  uint8_t num_lanes;
+  uint8_t predictor;
+  uint32_t num_elements;
+  uint32_t num_tail_bytes;
+  uint32_t reserved;
+};
+
+static_assert(sizeof(FloatChunkHeader) == 16, "Header must be 16 B");
+
+static constexpr size_t FLOAT_MAX_LANES = 64;
+
+// The elements are split into `num_lanes` contiguous segments, the first
+// `num_elements % num_lanes` of which are one element longer, so that each
+// lane predicts from its neighbours in the input.
+inline size_t float_segment_start(
+    const size_t num_elements, const size_t num_lanes, const size_t lane)
+{
+  const size_t base = num_elements / num_lanes;
+  return lane * base + std::min(lane, num_elements % num_lanes);
+}
+
+inline int float_leading_zeros(const uint64_t x)
+{
+#if defined(__GNUC__)
+  return __builtin_clzll(x);
+#else
+  int n = 0;
+  for (uint64_t bit = uint64_t(1) << 63; (x & bit) == 0; bit >>= 1) {
+    ++n;
+  }
+  return n;
+#endif
+}
+
+inline int float_trailing_zeros(const uint64_t x)
+{
+#if defined(__GNUC__)
+  return __builtin_ctzll(x);
+#else
+  int n = 0;
+  for (uint64_t bit = 1; (x & bit) == 0; bit <<= 1) {
+    ++n;
+  }
+  return n;
+#endif
+}
+
+inline uint64_t float_low_bits(const uint64_t x, const int bits)
+{
+  return bits >= 64 ? x : x & ((uint64_t(1) << bits) - 1);
+}
+
+// Appends values of up to 64 bits, least significant bit first.
+class FloatBitWriter
+{
+public:
+  FloatBitWriter() : m_words(), m_word(0), m_used(0)
+  {
+  }
+
+  void put(const uint64_t value, const int bits)
+  {
+    m_word |= value << m_used;
+    const int free = 64 - m_used;
+    if (bits < free) {
+      m_used += bits;
+      return;
+    }
+    m_words.push_back(m_word);
+    m_word = free < 64 ? value >> free : 0;
+    m_used = bits - free;
+  }
+
+  // The words written, with the last one padded with zeros.
+  std::vector<uint64_t>& finish()
+  {
+    if (m_used > 0) {
+      m_words.push_back(m_word);
+      m_word = 0;
+      m_used = 0;
+    }
+    return m_words;
+  }
+
+private:
+  std::vector<uint64_t> m_words;
+  uint64_t m_word;
+  int m_used;
+};
+
+// Reads a lane back. The `last_word` is the index of the last word that
+// may be read, which must be followed by one more. Reads beyond it are
+// clamped, which only happens for corrupt input, and reading past the
+// lane's own words is caught by comparing used_words() to the count once
+// decoding is done.
+class FloatBitReader
+{
+public:
+  FloatBitReader() = default;
+
+  FloatBitReader(const uint64_t* const words, const size_t last_word) :
+      m_words(words), m_last_word(last_word)
+  {
+  }
+
+  // The next 64 bits.
+  uint64_t peek() const
+  {
+    const uint64_t* const word
+        = m_words + std::min<size_t>(m_pos >> 6, m_last_word);
+    const int offset = static_cast<int>(m_pos & 63);
+    return offset == 0 ? word[0]
+                       : (word[0] >> offset) | (word[1] << (64 - offset));
+  }
+
+  void skip(const int bits)
+  {
+    m_pos += bits;
+  }
+
+  size_t used_words() const
+  {
+    return (m_pos + 63) / 64;
+  }
+
+private:
+  const uint64_t* m_words = nullptr;
+  size_t m_last_word = 0;
+  size_t m_pos = 0;
+};
+
+// Prediction and XOR window of one lane. A window wider than the value is
+// not valid yet.
+template <typename U>
+struct FloatLaneState
+{
+  U prev = 0;
+  U prev2 = 0;
+  int leading = 8 * sizeof(U) + 1;
+  int trailing = 0;
+
+  U predict(const FloatPredictor predictor) const
+  {
+    return predictor == FloatPredictor::Previous
+               ? prev
+               : static_cast<U>(prev + (prev - prev2));
+  }
+
+  // The difference of the Stride predictor is zigzag coded, so that small
+  // negative ones also have leading zeros.
+  U residual(const FloatPredictor predictor, const U value) const
+  {
+    const U pred = predict(predictor);
+    if (predictor == FloatPredictor::Previous) {
+      return value ^ pred;
+    }
+    const U diff = static_cast<U>(value - pred);
+    return static_cast<U>((diff << 1) ^ (0 - (diff >> (8 * sizeof(U) - 1))));
+  }
+
+  U restore(const FloatPredictor predictor, const U x) const
+  {
+    const U pred = predict(predictor);
+    if (predictor == FloatPredictor::Previous) {
+      return x ^ pred;
+    }
+    const U diff = static_cast<U>((x >> 1) ^ (0 - (x & 1)));
+    return static_cast<U>(pred + diff);
+  }
+
+  void push(const U value)
+  {
+    prev2 = prev;
+    prev = value;
+  }
+};
+
+} // namespace detail
+
+/**
+ * @brief A CPU codec for columns of floats or doubles.
+ *
+ * Every value is predicted from the previous values of its lane, and the
+ * residual is coded as in Gorilla: a single 0 bit if it is zero, else the
+ * bits between its leading and trailing zeros. These are stored within the
+ * window of the last value that sent one, if they fit, and otherwise with
+ * a new window of 5 or 6 bits each for the leading zeros and the length.
+ *
+ * The elements of a chunk are split into lanes with separate predictors
+ * and bit streams, which the encoder and decoder step through together, so
+ * that their dependency chains overlap.
+ *
+ * The options are stored in every chunk, so any instance can decompress
+ * any chunk.
+ */
+class FloatCodec : public HostCodec
+{
+public:
+  explicit FloatCodec(const HostFloatOptions& options = HostFloatDefaultOpts) :
+      m_options(options)
+  {
+    if (options.element_bytes != 4 && options.element_bytes != 8) {
+      throw std::runtime_error("Float element size must be 4 or 8.");
+    }
+    if (options.num_lanes < 1 || options.num_lanes > detail::FLOAT_MAX_LANES) {
+      throw std::runtime_error("Float codec supports 1 to 64 lanes.");
+    }
+    if (options.predictor != FloatPredictor::Previous
+        && options.predictor != FloatPredictor::Stride) {
+      throw std::runtime_error("Unknown float predictor.");
+    }
+  }
+
+  HostCodecId id() const override
+  {
+    return HostCodecId::Float;
+  }
+
+  const char* name() const override
+  {
+    return m_options.element_bytes == 4 ? "float" : "double";
+  }
+
+  const HostFloatOptions& options() const
+  {
+    return m_options;
+  }
+
+  size_t max_compressed_size(const size_t uncompressed_bytes) const override
+  {
+    check_size(uncompressed_bytes);
+    return sizeof(detail::FloatChunkHeader) + uncompressed_bytes;
+  }
+
+  size_t compress(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity) const override
+  {
+    check_size(in_bytes);
+    const uint8_t* const src = static_cast<const uint8_t*>(in);
+    const size_t element_bytes = m_options.element_bytes;
+    const size_t num_elements = in_bytes / element_bytes;
+    const size_t tail_bytes = in_bytes - num_elements * element_bytes;
+    // Lanes without elements would only cost their word counts.
+    const size_t num_lanes = std::max<size_t>(
+        1, std::min(m_options.num_lanes, num_elements));
+
+    detail::FloatChunkHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.mode = 1;
+    header.element_bytes = static_cast<uint8_t>(element_bytes);
+    header.num_lanes = static_cast<uint8_t>(num_lanes);
+    header.predictor = static_cast<uint8_t>(m_options.predictor);
+    header.num_elements = static_cast<uint32_t>(num_elements);
+    header.num_tail_bytes = static_cast<uint32_t>(tail_bytes);
+
+    std::vector<detail::FloatBitWriter> writers(num_lanes);
+    if (element_bytes == 4) {
+      encode<uint32_t>(src, num_elements, writers);
+    } else {
+      encode<uint64_t>(src, num_elements, writers);
+    }
+
+    std::vector<uint32_t> word_counts(num_lanes);
+    size_t num_words = 0;
+    for (size_t lane = 0; lane < num_lanes; ++lane) {
+      word_counts[lane] = static_cast<uint32_t>(writers[lane].finish().size());
+      num_words += word_counts[lane];
+    }
+    const size_t encoded_bytes = sizeof(header)
+                                 + num_lanes * sizeof(uint32_t)
+                                 + num_words * sizeof(uint64_t) + tail_bytes;
+
+    uint8_t* const dst = static_cast<uint8_t*>(out);
+    if (encoded_bytes >= sizeof(header) + in_bytes) {
+      // Store the chunk as it is instead.
+      if (sizeof(header) + in_bytes > out_capacity) {
+        throw std::runtime_error("Output buffer too small for float chunk.");
+      }
+      std::memset(dst, 0, sizeof(header));
+      if (in_bytes > 0) {
+        std::memcpy(dst + sizeof(header), src, in_bytes);
+      }
+      return sizeof(header) + in_bytes;
+    }
+    if (encoded_bytes > out_capacity) {
+      throw std::runtime_error("Output buffer too small for float chunk.");
+    }
+
+    size_t pos = 0;
+    std::memcpy(dst, &header, sizeof(header));
+    pos += sizeof(header);
+    std::memcpy(dst + pos, word_counts.data(), num_lanes * sizeof(uint32_t));
+    pos += num_lanes * sizeof(uint32_t);
+    for (detail::FloatBitWriter& writer : writers) {
+      const std::vector<uint64_t>& words = writer.finish();
+      if (!words.empty()) {
+        std::memcpy(dst + pos, words.data(), words.size() * sizeof(uint64_t));
+      }
+      pos += words.size() * sizeof(uint64_t);
+    }
+    if (tail_bytes > 0) {
+      std::memcpy(dst + pos, src + num_elements * element_bytes, tail_bytes);
+    }
+    return encoded_bytes;
+  }
+
+  nvcompStatus_t decompress(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity,
+      size_t* const out_bytes) const override
+  {
+    const uint8_t* const src = static_cast<const uint8_t*>(in);
+    uint8_t* const dst = static_cast<uint8_t*>(out);
+    detail::FloatChunkHeader header;
+    if (in_bytes < sizeof(header)) {
+      return nvcompErrorCannotDecompress;
+    }
+    std::memcpy(&header, src, sizeof(header));
+
+    if (header.mode == 0) {
+      const size_t bytes = in_bytes - sizeof(header);
+      if (bytes > out_capacity) {
+        return nvcompErrorCannotDecompress;
+      }
+      if (bytes > 0) {
+        std::memcpy(dst, src + sizeof(header), bytes);
+      }
+      *out_bytes = bytes;
+      return nvcompSuccess;
+    }
+
+    const size_t element_bytes = header.element_bytes;
+    const size_t num_lanes = header.num_lanes;
+    const size_t num_elements = header.num_elements;
+    const size_t tail_bytes = header.num_tail_bytes;
+    const size_t total_bytes = num_elements * element_bytes + tail_bytes;
+    if (header.mode != 1 || (element_bytes != 4 && element_bytes != 8)
+        || num_lanes < 1 || num_lanes > detail::FLOAT_MAX_LANES
+        || header.predictor > 1 || total_bytes > out_capacity) {
+      return nvcompErrorCannotDecompress;
+    }
+
+    size_t pos = sizeof(header);
+    if ((in_bytes - pos) / sizeof(uint32_t) < num_lanes) {
+      return nvcompErrorCannotDecompress;
+    }
+    uint32_t word_counts[detail::FLOAT_MAX_LANES];
+    std::memcpy(word_counts, src + pos, num_lanes * sizeof(uint32_t));
+    pos += num_lanes * sizeof(uint32_t);
+    size_t num_words = 0;
+    for (size_t lane = 0; lane < num_lanes; ++lane) {
+      num_words += word_counts[lane];
+    }
+    if ((in_bytes - pos) / sizeof(uint64_t) < num_words
+        || in_bytes - pos - num_words * sizeof(uint64_t) != tail_bytes) {
+      return nvcompErrorCannotDecompress;
+    }
+
+    // Copied into aligned words, with two zero words of padding for peek().
+    std::vector<uint64_t> words(num_words + 2, 0);
+    if (num_words > 0) {
+      std::memcpy(words.data(), src + pos, num_words * sizeof(uint64_t));
+    }
+    pos += num_words * sizeof(uint64_t);
+
+    const FloatPredictor predictor
+        = static_cast<FloatPredictor>(header.predictor);
+    const bool ok = element_bytes == 4
+                        ? decode<uint32_t>(
+                            words.data(),
+                            word_counts,
+                            num_words,
+                            num_lanes,
+                            predictor,
+                            dst,
+                            num_elements)
+                        : decode<uint64_t>(
+                            words.data(),
+                            word_counts,
+                            num_words,
+                            num_lanes,
+                            predictor,
+                            dst,
+                            num_elements);
+    if (!ok) {
+      return nvcompErrorCannotDecompress;
+    }
+    if (tail_bytes > 0) {
+      std::memcpy(dst + num_elements * element_bytes, src + pos, tail_bytes);
+    }
+    *out_bytes = total_bytes;
+    return nvcompSuccess;
+  }
+
+private:
+  static void check_size(const size_t bytes)
+  {
+    if (bytes > UINT32_MAX) {
+      throw std::runtime_error("Float chunk too large.");
+    }
+  }
+
+  // Bits of the leading zero count, and of the length minus one.
+  template <typename U>
+  static constexpr int field_bits()
+  {
+    return sizeof(U) == 4 ? 5 : 6;
+  }
+
+  template <typename U>
+  void encode(
+      const uint8_t* const src,
+      const size_t num_elements,
+      std::vector<detail::FloatBitWriter>& writers) const
+  {
+    constexpr int BITS = 8 * sizeof(U);
+    constexpr int FIELD = field_bits<U>();
+    const size_t num_lanes = writers.size();
+    const FloatPredictor predictor = m_options.predictor;
+
+    std::vector<detail::FloatLaneState<U>> lanes(num_lanes);
+    std::vector<size_t> starts(num_lanes);
+    for (size_t lane = 0; lane < num_lanes; ++lane) {
+      starts[lane] = detail::float_segment_start(num_elements, num_lanes, lane);
+    }
+
+    // All lanes take part in the first `base` steps; the longer lanes then
+    // have one element left each.
+    const size_t base = num_elements / num_lanes;
+    for (size_t t = 0; t <= base; ++t) {
+      const size_t active = t < base ? num_lanes : num_elements % num_lanes;
+      for (size_t lane = 0; lane < active; ++lane) {
+        detail::FloatLaneState<U>& state = lanes[lane];
+        detail::FloatBitWriter& writer = writers[lane];
+        U value;
+        std::memcpy(
+            &value, src + (starts[lane] + t) * sizeof(U), sizeof(value));
+        const U x = state.residual(predictor, value);
+        state.push(value);
+        if (x == 0) {
+          writer.put(0, 1);
+          continue;
+        }
+        const int leading = detail::float_leading_zeros(x) - (64 - BITS);
+        const int trailing = detail::float_trailing_zeros(x);
+        const int length = BITS - leading - trailing;
+        const int window = BITS - state.leading - state.trailing;
+        // Unlike Gorilla, a window that fits is only reused while that is
+        // cheaper than sending a new one, so that one large residual
+        // doesn't widen all the following ones.
+        if (leading >= state.leading && trailing >= state.trailing
+            && window - length <= 2 * FIELD) {
+          writer.put(1, 2);
+          writer.put(x >> state.trailing, window);
+        } else {
+          writer.put(
+              3 | (uint64_t(leading) << 2)
+                  | (uint64_t(length - 1) << (2 + FIELD)),
+              2 + 2 * FIELD);
+          writer.put(x >> trailing, length);
+          state.leading = leading;
+          state.trailing = trailing;
+        }
+      }
+    }
+  }
+
+  template <typename U>
+  static bool decode(
+      const uint64_t* const words,
+      const uint32_t* const word_counts,
+      const size_t num_words,
+      const size_t num_lanes,
+      const FloatPredictor predictor,
+      uint8_t* const dst,
+      const size_t num_elements)
+  {
+    constexpr int BITS = 8 * sizeof(U);
+    constexpr int FIELD = field_bits<U>();
+
+    detail::FloatLaneState<U> lanes[detail::FLOAT_MAX_LANES];
+    detail::FloatBitReader readers[detail::FLOAT_MAX_LANES];
+    size_t starts[detail::FLOAT_MAX_LANES];
+    size_t offset = 0;
+    for (size_t lane = 0; lane < num_lanes; ++lane) {
+      readers[lane]
+          = detail::FloatBitReader(words + offset, num_words - offset);
+      starts[lane] = detail::float_segment_start(num_elements, num_lanes, lane);
+      offset += word_counts[lane];
+    }
+
+    const size_t base = num_elements / num_lanes;
+    for (size_t t = 0; t <= base; ++t) {
+      const size_t active = t < base ? num_lanes : num_elements % num_lanes;
+      for (size_t lane = 0; lane < active; ++lane) {
+        detail::FloatLaneState<U>& state = lanes[lane];
+        detail::FloatBitReader& reader = readers[lane];
+        const uint64_t control = reader.peek();
+        uint64_t x = 0;
+        if ((control & 1) == 0) {
+          reader.skip(1);
+        } else if ((control & 2) == 0) {
+          if (state.leading > BITS) {
+            return false;
+          }
+          reader.skip(2);
+          x = detail::float_low_bits(
+                  reader.peek(), BITS - state.leading - state.trailing)
+              << state.trailing;
+          reader.skip(BITS - state.leading - state.trailing);
+        } else {
+          const int leading = static_cast<int>((control >> 2) & (BITS - 1));
+          const int length
+              = static_cast<int>((control >> (2 + FIELD)) & (BITS - 1)) + 1;
+          if (leading + length > BITS) {
+            return false;
+          }
+          reader.skip(2 + 2 * FIELD);
+          state.leading = leading;
+          state.trailing = BITS - leading - length;
+          x = detail::float_low_bits(reader.peek(), length) << state.trailing;
+          reader.skip(length);
+        }
+        const U value = state.restore(predictor, static_cast<U>(x));
+        state.push(value);
+        std::memcpy(dst + (starts[lane] + t) * sizeof(U), &value, sizeof(U));
+      }
+    }
+
+    // Every lane must have used exactly its words.
+    for (size_t lane = 0; lane < num_lanes; ++lane) {
+      if (readers[lane].used_words() != word_counts[lane]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  HostFloatOptions m_options;
+};
+
+} // namespace host
+} // namespace nvcomp
@@ -0,0 +1,716 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/checksum.h"
+#include "host/host_codecs.h"
+#include "host/thread_pool.h"
+#include "host/trace.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace nvcomp
+{
+namespace host
+{
+
+// The same checksum modes as the GPU managers.
+enum ChecksumPolicy
+{
+  NoComputeNoVerify,
+  ComputeAndNoVerify,
+  NoComputeAndVerifyIfPresent,
+  ComputeAndVerifyIfPresent,
+  ComputeAndVerify
+};
+
+// "NVHF" in memory.
+constexpr uint32_t HOST_FRAME_MAGIC = 0x4648564e;
+constexpr uint16_t HOST_FRAME_MAJOR_VERSION = 1;
+constexpr uint16_t HOST_FRAME_MINOR_VERSION = 0;
+constexpr size_t HOST_FRAME_ALIGNMENT = 8;
+
+// Set in HostFrameHeader::flags when per-chunk CRC-32 tables are present.
+constexpr uint8_t HOST_FRAME_HAS_CHECKSUMS = 1;
+
+/**
+ * @brief Header at the start of a host compressed buffer.
+ *
+ * A frame is laid out like the buffers of the GPU managers: this header,
+ * then the chunk offset and size tables (uint64_t each, offsets relative to
+ * the payload), then, with checksums, the CRC-32 of every compressed chunk
+ * followed by the CRC-32 of every uncompressed chunk, then the compressed
+ * chunks, each starting at a multiple of 8 bytes. All fields are in host
+ * byte order.
+ */
+struct HostFrameHeader
+{
+  uint32_t magic;
+  uint16_t major_version;
+  uint16_t minor_version;
+  uint8_t codec;
+  uint8_t flags;
+  uint16_t reserved0;
+  uint32_t reserved1;
+  uint64_t uncompressed_size;
+  // Size of the whole frame, including this header.
+  uint64_t compressed_size;
+  uint64_t num_chunks;
+  uint64_t chunk_size;
+  uint64_t payload_offset;
+  uint64_t reserved2;
+};
+
+static_assert(sizeof(HostFrameHeader) == 64, "Host frame header must be 64 B");
+
+namespace detail
+{
+
+inline size_t frame_align(const size_t bytes)
+{
+  return (bytes + HOST_FRAME_ALIGNMENT - 1) / HOST_FRAME_ALIGNMENT
+         * HOST_FRAME_ALIGNMENT;
+}
+
+inline size_t frame_payload_offset(const size_t num_chunks, const bool checksums)
+{
+  const size_t tables
+      = num_chunks * 2 * sizeof(uint64_t)
+        + (checksums ? num_chunks * 2 * sizeof(uint32_t) : 0);
+  return frame_align(sizeof(HostFrameHeader) + tables);
+}
+
+inline HostFrameHeader read_frame_header(const uint8_t* const comp_buffer)
+{
+  HostFrameHeader header;
+  std::memcpy(&header, comp_buffer, sizeof(header));
+  if (header.magic != HOST_FRAME_MAGIC) {
+    throw std::runtime_error("Buffer is not a host compressed frame.");
+  }
+  if (header.major_version != HOST_FRAME_MAJOR_VERSION) {
+    throw std::runtime_error(
+        "Unsupported host frame version "
+        + std::to_string(header.major_version) + ".");
+  }
+  const bool checksums = (header.flags & HOST_FRAME_HAS_CHECKSUMS) != 0;
+  if (header.chunk_size == 0
+      || header.num_chunks
+             != (header.uncompressed_size + header.chunk_size - 1)
+                    / header.chunk_size
+      || header.payload_offset
+             != frame_payload_offset(header.num_chunks, checksums)
+      || header.compressed_size < header.payload_offset) {
+    throw std::runtime_error("Corrupt host frame header.");
+  }
+  return header;
+}
+
+// Keeps the first error reported by the chunks of one call.
+class StatusCollector
+{
+public:
+  StatusCollector() : m_mutex(), m_status(nvcompSuccess)
+  {
+  }
+
+  void report(const nvcompStatus_t status)
+  {
+    if (status != nvcompSuccess) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_status == nvcompSuccess) {
+        m_status = status;
+      }
+    }
+  }
+
+  nvcompStatus_t status() const
+  {
+    return m_status;
+  }
+
+private:
+  std::mutex m_mutex;
+  nvcompStatus_t m_status;
+};
+
+} // namespace detail
+
+/**
+ * @brief Configuration for a compression, from
+ * HostManager::configure_compression().
+ */
+struct CompressionConfig
+{
+  size_t uncompressed_buffer_size;
+  size_t max_compressed_buffer_size;
+  size_t num_chunks;
+  bool compute_checksums;
+
+  CompressionConfig(
+      const size_t uncompressed_buffer_size,
+      const size_t max_compressed_buffer_size,
+      const size_t num_chunks,
+      const bool compute_checksums) :
+      uncompressed_buffer_size(uncompressed_buffer_size),
+      max_compressed_buffer_size(max_compressed_buffer_size),
+      num_chunks(num_chunks),
+      compute_checksums(compute_checksums),
+      m_status(std::make_shared<nvcompStatus_t>(nvcompSuccess))
+  {
+  }
+
+  // Result of the last compress() with this config. Copies share it.
+  nvcompStatus_t* get_status() const
+  {
+    return m_status.get();
+  }
+
+private:
+  std::shared_ptr<nvcompStatus_t> m_status;
+};
+
+/**
+ * @brief Configuration for a decompression, from
+ * HostManager::configure_decompression().
+ */
+struct DecompressionConfig
+{
+  size_t decomp_data_size;
+  size_t num_chunks;
+  bool checksums_present;
+
+  DecompressionConfig(
+      const size_t decomp_data_size,
+      const size_t num_chunks,
+      const bool checksums_present) :
+      decomp_data_size(decomp_data_size),
+      num_chunks(num_chunks),
+      checksums_present(checksums_present),
+      m_status(std::make_shared<nvcompStatus_t>(nvcompSuccess))
+  {
+  }
+
+  // Result of the last decompress() with this config, e.g.
+  // nvcompErrorBadChecksum. Copies share it.
+  nvcompStatus_t* get_status() const
+  {
+    return m_status.get();
+  }
+
+private:
+  std::shared_ptr<nvcompStatus_t> m_status;
+};
+
+/**
+ * @brief CPU counterpart of the nvcomp high-level managers.
+ *
+ * The configure_compression() / compress() / configure_decompression() /
+ * decompress() flow is the same as for nvcompManagerBase, but the buffers
+ * are in host memory and the chunks are compressed by a host codec on a
+ * thread pool. The calls return once the work is done, so there is no
+ * stream to synchronize, and the status in the config can be read
+ * immediately.
+ */
+class HostManager
+{
+public:
+  HostManager(
+      std::shared_ptr<const HostCodec> codec,
+      const size_t chunk_size,
+      const ChecksumPolicy checksum_policy = NoComputeNoVerify,
+      ThreadPool& pool = default_thread_pool()) :
+      m_codec(std::move(codec)),
+      m_chunk_size(chunk_size),
+      m_checksum_policy(checksum_policy),
+      m_pool(pool)
+  {
+    if (!m_codec) {
+      throw std::runtime_error("Host manager requires a codec.");
+    }
+    if (m_chunk_size == 0) {
+      throw std::runtime_error("Chunk size must be positive.");
+    }
+    // Fails early for chunk sizes the codec can't handle.
+    m_codec->max_compressed_size(m_chunk_size);
+  }
+
+  // disable copying
+  HostManager(const HostManager& other) = delete;
+  HostManager& operator=(const HostManager& other) = delete;
+
+  const HostCodec& codec() const
+  {
+    return *m_codec;
+  }
+
+  size_t get_chunk_size() const
+  {
+    return m_chunk_size;
+  }
+
+  // No scratch space is needed; these exist for parity with the GPU
+  // managers.
+  size_t get_required_scratch_buffer_size()
+  {
+    return 0;
+  }
+
+  void set_scratch_buffer(uint8_t* /*new_scratch_buffer*/)
+  {
+  }
+
+  CompressionConfig configure_compression(const size_t uncomp_buffer_size)
+  {
+    const bool checksums = compute_checksums();
+    const size_t num_chunks
+        = (uncomp_buffer_size + m_chunk_size - 1) / m_chunk_size;
+    return CompressionConfig(
+        uncomp_buffer_size,
+        detail::frame_payload_offset(num_chunks, checksums)
+            + num_chunks * slot_size(),
+        num_chunks,
+        checksums);
+  }
+
+  /**
+   * @brief Compress `uncomp_buffer` into `comp_buffer`, which must hold
+   * `config.max_compressed_buffer_size` bytes.
+   *
+   * The chunks are compressed in parallel into fixed-size slots, and then
+   * moved down to remove the gaps. The frame size is written to `comp_size`
+   * if given, and is also available from get_compressed_output_size().
+   */
+  void compress(
+      const uint8_t* const uncomp_buffer,
+      uint8_t* const comp_buffer,
+      const CompressionConfig& config,
+      size_t* const comp_size = nullptr)
+  {
+    NVCOMP_TRACE_SCOPE("compress");
+    const size_t num_chunks = config.num_chunks;
+    const bool checksums = config.compute_checksums;
+    const size_t payload_offset
+        = detail::frame_payload_offset(num_chunks, checksums);
+    const size_t slot_bytes = slot_size();
+    if (config.max_compressed_buffer_size
+        != payload_offset + num_chunks * slot_bytes) {
+      throw std::runtime_error(
+          "Compression config was not created by this manager.");
+    }
+
+    std::vector<uint64_t> offsets(num_chunks);
+    std::vector<uint64_t> sizes(num_chunks);
+    std::vector<uint32_t> comp_crcs(checksums ? num_chunks : 0);
+    std::vector<uint32_t> uncomp_crcs(checksums ? num_chunks : 0);
+    uint8_t* const payload = comp_buffer + payload_offset;
+
+    detail::StatusCollector status;
+    m_pool.parallel_for(num_chunks, [&](const size_t i) {
+      NVCOMP_TRACE_SCOPE("compress chunk");
+      const uint8_t* const in = uncomp_buffer + i * m_chunk_size;
+      const size_t in_bytes = chunk_bytes(config.uncompressed_buffer_size, i);
+      uint8_t* const out = payload + i * slot_bytes;
+      try {
+        sizes[i] = m_codec->compress(in, in_bytes, out, slot_bytes);
+      } catch (const std::exception&) {
+        sizes[i] = 0;
+        status.report(nvcompErrorInternal);
+        return;
+      }
+      if (checksums) {
+        uncomp_crcs[i] = crc32(in, in_bytes);
+        comp_crcs[i] = crc32(out, sizes[i]);
+      }
+    });
+
+    // Moving front to back never overwrites a slot that is still to be
+    // moved, since every chunk fits in its slot.
+    uint64_t offset = 0;
+    for (size_t i = 0; i < num_chunks; ++i) {
+      offsets[i] = offset;
+      if (offset != i * slot_bytes) {
+        std::memmove(payload + offset, payload + i * slot_bytes, sizes[i]);
+      }
+      offset = detail::frame_align(offset + sizes[i]);
+    }
+    const size_t frame_size = payload_offset + offset;
+
+    HostFrameHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = HOST_FRAME_MAGIC;
+    header.major_version = HOST_FRAME_MAJOR_VERSION;
+    header.minor_version = HOST_FRAME_MINOR_VERSION;
+    header.codec = static_cast<uint8_t>(m_codec->id());
+    header.flags = checksums ? HOST_FRAME_HAS_CHECKSUMS : 0;
+    header.uncompressed_size = config.uncompressed_buffer_size;
+    header.compressed_size = frame_size;
+    header.num_chunks = num_chunks;
+    header.chunk_size = m_chunk_size;
+    header.payload_offset = payload_offset;
+    std::memcpy(comp_buffer, &header, sizeof(header));
+
+    uint8_t* table = comp_buffer + sizeof(header);
+    table = write_table(table, offsets);
+    table = write_table(table, sizes);
+    if (checksums) {
+      table = write_table(table, comp_crcs);
+      table = write_table(table, uncomp_crcs);
+    }
+    // Zero the alignment padding, so equal inputs give equal frames.
+    std::memset(table, 0, payload - table);
+
+    *config.get_status() = status.status();
+    if (comp_size != nullptr) {
+      *comp_size = frame_size;
+    }
+  }
+
+  /**
+   * @brief Read the frame header of `comp_buffer`.
+   *
+   * Throws if the buffer is not a frame of this manager's codec, if
+   * `comp_size` is given and smaller than the frame, or if the checksum
+   * policy is ComputeAndVerify and the frame has no checksums.
+   */
+  DecompressionConfig configure_decompression(
+      const uint8_t* const comp_buffer, const size_t* const comp_size = nullptr)
+  {
+    const HostFrameHeader header = detail::read_frame_header(comp_buffer);
+    if (header.codec != static_cast<uint8_t>(m_codec->id())) {
+      throw std::runtime_error(
+          std::string("Frame was not compressed with ") + m_codec->name()
+          + ".");
+    }
+    if (comp_size != nullptr && *comp_size < header.compressed_size) {
+      throw std::runtime_error("Compressed buffer is truncated.");
+    }
+    const bool checksums = (header.flags & HOST_FRAME_HAS_CHECKSUMS) != 0;
+    if (m_checksum_policy == ComputeAndVerify && !checksums) {
+      throw std::runtime_error(
+          "Checksum verification requested, but the compressed buffer has "
+          "no checksums.");
+    }
+    return DecompressionConfig(
+        header.uncompressed_size, header.num_chunks, checksums);
+  }
+
+  DecompressionConfig configure_decompression(const CompressionConfig& config)
+  {
+    if (m_checksum_policy == ComputeAndVerify && !config.compute_checksums) {
+      throw std::runtime_error(
+          "Checksum verification requested, but the compression config "
+          "has no checksums.");
+    }
+    return DecompressionConfig(
+        config.uncompressed_buffer_size,
+        config.num_chunks,
+        config.compute_checksums);
+  }
+
+  /**
+   * @brief Decompress the frame in `comp_buffer` into `decomp_buffer`, which
+   * must hold `config.decomp_data_size` bytes.
+   *
+   * Corrupt chunks and checksum mismatches are reported through
+   * `config.get_status()`.
+   */
+  void decompress(
+      uint8_t* const decomp_buffer,
+      const uint8_t* const comp_buffer,
+      const DecompressionConfig& config,
+      const size_t* const comp_size = nullptr)
+  {
+    NVCOMP_TRACE_SCOPE("decompress");
+    const HostFrameHeader header = detail::read_frame_header(comp_buffer);
+    if (header.uncompressed_size != config.decomp_data_size
+        || header.num_chunks != config.num_chunks) {
+      throw std::runtime_error(
+          "Decompression config does not match the compressed buffer.");
+    }
+    if (comp_size != nullptr && *comp_size < header.compressed_size) {
+      throw std::runtime_error("Compressed buffer is truncated.");
+    }
+    const size_t num_chunks = header.num_chunks;
+    const bool checksums = (header.flags & HOST_FRAME_HAS_CHECKSUMS) != 0;
+    const bool verify = checksums && verify_checksums();
+
+    const uint8_t* table = comp_buffer + sizeof(header);
+    std::vector<uint64_t> offsets(num_chunks);
+    std::vector<uint64_t> sizes(num_chunks);
+    std::vector<uint32_t> comp_crcs(checksums ? num_chunks : 0);
+    std::vector<uint32_t> uncomp_crcs(checksums ? num_chunks : 0);
+    table = read_table(table, offsets);
+    table = read_table(table, sizes);
+    if (checksums) {
+      table = read_table(table, comp_crcs);
+      table = read_table(table, uncomp_crcs);
+    }
+    const uint8_t* const payload = comp_buffer + header.payload_offset;
+    const size_t payload_bytes
+        = header.compressed_size - header.payload_offset;
+
+    detail::StatusCollector status;
+    m_pool.parallel_for(num_chunks, [&](const size_t i) {
+      NVCOMP_TRACE_SCOPE("decompress chunk");
+      if (offsets[i] > payload_bytes || sizes[i] > payload_bytes - offsets[i]) {
+        status.report(nvcompErrorCannotDecompress);
+        return;
+      }
+      const uint8_t* const in = payload + offsets[i];
+      uint8_t* const out = decomp_buffer + i * header.chunk_size;
+      const size_t expected = chunk_bytes(header.uncompressed_size, i);
+      if (verify && crc32(in, sizes[i]) != comp_crcs[i]) {
+        status.report(nvcompErrorBadChecksum);
+        return;
+      }
+      size_t out_bytes = 0;
+      const nvcompStatus_t chunk_status
+          = m_codec->decompress(in, sizes[i], out, expected, &out_bytes);
+      if (chunk_status != nvcompSuccess) {
+        status.report(chunk_status);
+      } else if (out_bytes != expected) {
+        status.report(nvcompErrorCannotDecompress);
+      } else if (verify && crc32(out, out_bytes) != uncomp_crcs[i]) {
+        status.report(nvcompErrorBadChecksum);
+      }
+    });
+
+    *config.get_status() = status.status();
+  }
+
+  size_t get_compressed_output_size(const uint8_t* const comp_buffer)
+  {
+    return detail::read_frame_header(comp_buffer).compressed_size;
+  }
+
+private:
+  bool compute_checksums() const
+  {
+    return m_checksum_policy == ComputeAndNoVerify
+           || m_checksum_policy == ComputeAndVerifyIfPresent
+           || m_checksum_policy == ComputeAndVerify;
+  }
+
+  bool verify_checksums() const
+  {
+    return m_checksum_policy == NoComputeAndVerifyIfPresent
+           || m_checksum_policy == ComputeAndVerifyIfPresent
+           || m_checksum_policy == ComputeAndVerify;
+  }
+
+  size_t slot_size() const
+  {
+    return detail::frame_align(m_codec->max_compressed_size(m_chunk_size));
+  }
+
+  size_t chunk_bytes(const size_t total_bytes, const size_t index) const
+  {
+    return std::min(m_chunk_size, total_bytes - index * m_chunk_size);
+  }
+
+  template <typename T>
+  static uint8_t* write_table(uint8_t* const dst, const std::vector<T>& values)
+  {
+    if (!values.empty()) {
+      std::memcpy(dst, values.data(), values.size() * sizeof(T));
+    }
+    return dst + values.size() * sizeof(T);
+  }
+
+  template <typename T>
+  static const uint8_t*
+  read_table(const uint8_t* const src, std::vector<T>& values)
+  {
+    if (!values.empty()) {
+      std::memcpy(values.data(), src, values.size() * sizeof(T));
+    }
+    return src + values.size() * sizeof(T);
+  }
+
+  std::shared_ptr<const HostCodec> m_codec;
+  size_t m_chunk_size;
+  ChecksumPolicy m_checksum_policy;
+  ThreadPool& m_pool;
+};
+
+#ifdef NVCOMP_HOST_HAVE_LZ4
+class LZ4Manager : public HostManager
+{
+public:
+  explicit LZ4Manager(
+      const size_t chunk_size,
+      const ChecksumPolicy checksum_policy = NoComputeNoVerify,
+      ThreadPool& pool = default_thread_pool()) :
+      HostManager(
+          std::make_shared<LZ4Codec>(), chunk_size, checksum_policy, pool)
+  {
+  }
+};
+#endif
+
+#ifdef NVCOMP_HOST_HAVE_ZLIB
+class DeflateManager : public HostManager
+{
+public:
+  explicit DeflateManager(
+      const size_t chunk_size,
+      const ChecksumPolicy checksum_policy = NoComputeNoVerify,
+      ThreadPool& pool = default_thread_pool()) :
+      HostManager(
+          std::make_shared<DeflateCodec>(), chunk_size, checksum_policy, pool)
+  {
+  }
+};
+#endif
+
+class CascadedManager : public HostManager
+{
+public:
+  explicit CascadedManager(
+      const size_t chunk_size,
+      const HostCascadedOptions& options = HostCascadedDefaultOpts,
+      const ChecksumPolicy checksum_policy = NoComputeNoVerify,
+      ThreadPool& pool = default_thread_pool()) :
+      HostManager(
+          std::make_shared<CascadedCodec>(options),
+          chunk_size,
+          checksum_policy,
+          pool)
+  {
+  }
+};
+
+class ANSManager : public HostManager
+{
+public:
+  explicit ANSManager(
+      const size_t chunk_size,
+      const HostANSOptions& options = HostANSDefaultOpts,
+      const ChecksumPolicy checksum_policy = NoComputeNoVerify,
+      ThreadPool& pool = default_thread_pool()) :
+      HostManager(
+          std::make_shared<ANSCodec>(options),
+          chunk_size,
+          checksum_policy,
+          pool)
+  {
+  }
+};
+
+class FloatManager : public HostManager
+{
+public:
+  explicit FloatManager(
+      const size_t chunk_size,
+      const HostFloatOptions& options = HostFloatDefaultOpts,
+      const ChecksumPolicy checksum_policy = NoComputeNoVerify,
+      ThreadPool& pool = default_thread_pool()) :
+      HostManager(
+          std::make_shared<FloatCodec>(options),
+          chunk_size,
+          checksum_policy,
+          pool)
+  {
+  }
+};
+
+class RleManager : public HostManager
+{
+public:
+  explicit RleManager(
+      const size_t chunk_size,
+      const HostRleOptions& options = HostRleDefaultOpts,
+      const ChecksumPolicy checksum_policy = NoComputeNoVerify,
+      ThreadPool& pool = default_thread_pool()) :
+      HostManager(
+          std::make_shared<RleCodec>(options),
+          chunk_size,
+          checksum_policy,
+          pool)
+  {
+  }
+};
+
+class DictionaryManager : public HostManager
+{
+public:
+  explicit DictionaryManager(
+      const size_t chunk_size,
+      const HostDictionaryOptions& options = HostDictionaryDefaultOpts,
+      const ChecksumPolicy checksum_policy = NoComputeNoVerify,
+      ThreadPool& pool = default_thread_pool()) :
+      HostManager(
+          std::make_shared<DictionaryCodec>(options),
+          chunk_size,
+          checksum_policy,
+          pool)
+  {
+  }
+};
+
+class PforManager : public HostManager
+{
+public:
+  explicit PforManager(
+      const size_t chunk_size,
+      const HostPforOptions& options = HostPforDefaultOpts,
+      const ChecksumPolicy checksum_policy = NoComputeNoVerify,
+      ThreadPool& pool = default_thread_pool()) :
+      HostManager(
+          std::make_shared<PforCodec>(options),
+          chunk_size,
+          checksum_policy,
+          pool)
+  {
+  }
+};
+
+// Manager for a buffer of unknown origin, configured from its frame header.
+inline std::shared_ptr<HostManager> create_manager(
+    const uint8_t* const comp_buffer,
+    const ChecksumPolicy checksum_policy = NoComputeNoVerify,
+    ThreadPool& pool = default_thread_pool())
+{
+  const HostFrameHeader header = detail::read_frame_header(comp_buffer);
+  return std::make_shared<HostManager>(
+      make_host_codec(static_cast<HostCodecId>(header.codec)),
+      header.chunk_size,
+      checksum_policy,
+      pool);
+}
+
+} // namespace host
+} // namespace nvcomp
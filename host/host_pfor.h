@@ -0,0 +1,519 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/bitpack.h"
+#include "host/host_codec.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace nvcomp
+{
+namespace host
+{
+
+// Options of the host PFOR codec.
+struct HostPforOptions
+{
+  // Size of the integer elements: 1, 2, 4 or 8 bytes.
+  size_t type_size;
+  // Values per miniblock, each with its own reference and width: 128 or
+  // 256.
+  size_t miniblock;
+};
+
+constexpr HostPforOptions HostPforDefaultOpts = {4, 128};
+
+namespace detail
+{
+
+// Chunk header of the host PFOR format. It is followed by the reference of
+// every miniblock (`type_size` bytes each), a PforMiniblock per miniblock,
+// `num_words` 64-bit words holding first the packed values of every
+// miniblock and then the packed high bits of the exceptions of every
+// miniblock, the position of every exception within its miniblock (one
+// byte each), and the bytes after the last whole element. A chunk that
+// doesn't shrink is stored as it is, with `mode` 0.
+struct PforChunkHeader
+{
+  uint8_t mode;
+  uint8_t type_size;
+  uint16_t miniblock;
+  uint32_t num_elements;
+  uint32_t num_words;
+  uint32_t num_exceptions;
+};
+
+static_assert(sizeof(PforChunkHeader) == 16, "Header must be 16 B");
+
+// Every value of a miniblock is stored as its difference from the
+// reference, in `width` bits. Differences that need more, the exceptions,
+// keep their low `width` bits there, and their high bits are packed
+// separately into `exception_width` bits each.
+struct PforMiniblock
+{
+  uint8_t width;
+  uint8_t exception_width;
+  uint16_t num_exceptions;
+};
+
+static_assert(sizeof(PforMiniblock) == 4, "Miniblock must be 4 B");
+
+inline size_t pfor_bit_length(const uint64_t x)
+{
+#if defined(__GNUC__)
+  return x == 0 ? 0 : 64 - __builtin_clzll(x);
+#else
+  size_t n = 0;
+  for (uint64_t v = x; v != 0; v >>= 1) {
+    ++n;
+  }
+  return n;
+#endif
+}
+
+// The width that minimizes the bits of a miniblock of `count` values, given
+// how many of its differences have each bit length. Every exception costs
+// a position byte and its high bits.
+inline size_t pfor_best_width(
+    const size_t* const lengths, const size_t max_bits, const size_t count)
+{
+  size_t best = max_bits;
+  size_t best_bits = count * max_bits;
+  size_t exceptions = 0;
+  for (size_t width = max_bits; width-- > 0;) {
+    exceptions += lengths[width + 1];
+    const size_t bits = count * width + exceptions * (8 + max_bits - width);
+    if (bits < best_bits) {
+      best = width;
+      best_bits = bits;
+    }
+  }
+  return best;
+}
+
+} // namespace detail
+
+/**
+ * @brief A CPU patched frame-of-reference (PFOR) codec for integer
+ * elements.
+ *
+ * Each miniblock of 128 or 256 values has its own reference, its minimum,
+ * and its own bit width, so an outlier only widens its miniblock. Within a
+ * miniblock the width may also be narrower than the widest difference: the
+ * few values that don't fit are patched in from an exception list after
+ * the miniblock is unpacked with the host bit packing kernels.
+ */
+class PforCodec : public HostCodec
+{
+public:
+  explicit PforCodec(const HostPforOptions options = HostPforDefaultOpts) :
+      m_options(options)
+  {
+    if (options.type_size != 1 && options.type_size != 2
+        && options.type_size != 4 && options.type_size != 8) {
+      throw std::runtime_error("PFOR type size must be 1, 2, 4 or 8.");
+    }
+    if (options.miniblock != 128 && options.miniblock != 256) {
+      throw std::runtime_error("PFOR miniblocks must be 128 or 256 values.");
+    }
+  }
+
+  HostCodecId id() const override
+  {
+    return HostCodecId::PFOR;
+  }
+
+  const char* name() const override
+  {
+    return "pfor";
+  }
+
+  const HostPforOptions& options() const
+  {
+    return m_options;
+  }
+
+  size_t max_compressed_size(const size_t uncompressed_bytes) const override
+  {
+    check_size(uncompressed_bytes);
+    return sizeof(detail::PforChunkHeader) + uncompressed_bytes;
+  }
+
+  size_t compress(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity) const override
+  {
+    check_size(in_bytes);
+    switch (m_options.type_size) {
+    case 1:
+      return compress_typed<uint8_t>(in, in_bytes, out, out_capacity);
+    case 2:
+      return compress_typed<uint16_t>(in, in_bytes, out, out_capacity);
+    case 4:
+      return compress_typed<uint32_t>(in, in_bytes, out, out_capacity);
+    default:
+      return compress_typed<uint64_t>(in, in_bytes, out, out_capacity);
+    }
+  }
+
+  nvcompStatus_t decompress(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity,
+      size_t* const out_bytes) const override
+  {
+    const uint8_t* const src = static_cast<const uint8_t*>(in);
+    uint8_t* const dst = static_cast<uint8_t*>(out);
+    detail::PforChunkHeader header;
+    if (in_bytes < sizeof(header)) {
+      return nvcompErrorCannotDecompress;
+    }
+    std::memcpy(&header, src, sizeof(header));
+
+    if (header.mode == 0) {
+      const size_t bytes = in_bytes - sizeof(header);
+      if (bytes > out_capacity) {
+        return nvcompErrorCannotDecompress;
+      }
+      if (bytes > 0) {
+        std::memcpy(dst, src + sizeof(header), bytes);
+      }
+      *out_bytes = bytes;
+      return nvcompSuccess;
+    }
+
+    const size_t type_size = header.type_size;
+    if (header.mode != 1
+        || (type_size != 1 && type_size != 2 && type_size != 4
+            && type_size != 8)
+        || (header.miniblock != 128 && header.miniblock != 256)) {
+      return nvcompErrorCannotDecompress;
+    }
+    // Everything but the tail has a known size; what is left must be a
+    // partial element.
+    const size_t num_elements = header.num_elements;
+    const size_t num_miniblocks
+        = (num_elements + header.miniblock - 1) / header.miniblock;
+    const uint64_t body_bytes
+        = num_miniblocks * (type_size + sizeof(detail::PforMiniblock))
+          + uint64_t(header.num_words) * sizeof(uint64_t)
+          + header.num_exceptions;
+    if (in_bytes - sizeof(header) < body_bytes
+        || in_bytes - sizeof(header) - body_bytes >= type_size) {
+      return nvcompErrorCannotDecompress;
+    }
+    const size_t tail_bytes = in_bytes - sizeof(header) - body_bytes;
+    const size_t total_bytes = num_elements * type_size + tail_bytes;
+    if (total_bytes > out_capacity) {
+      return nvcompErrorCannotDecompress;
+    }
+
+    bool ok;
+    switch (type_size) {
+    case 1:
+      ok = decompress_typed<uint8_t>(header, src, dst);
+      break;
+    case 2:
+      ok = decompress_typed<uint16_t>(header, src, dst);
+      break;
+    case 4:
+      ok = decompress_typed<uint32_t>(header, src, dst);
+      break;
+    default:
+      ok = decompress_typed<uint64_t>(header, src, dst);
+      break;
+    }
+    if (!ok) {
+      return nvcompErrorCannotDecompress;
+    }
+    if (tail_bytes > 0) {
+      std::memcpy(
+          dst + num_elements * type_size,
+          src + in_bytes - tail_bytes,
+          tail_bytes);
+    }
+    *out_bytes = total_bytes;
+    return nvcompSuccess;
+  }
+
+private:
+  static void check_size(const size_t bytes)
+  {
+    if (bytes > UINT32_MAX) {
+      throw std::runtime_error("PFOR chunk too large.");
+    }
+  }
+
+  template <typename U>
+  size_t compress_typed(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity) const
+  {
+    typedef typename std::make_signed<U>::type S;
+    const uint8_t* const src = static_cast<const uint8_t*>(in);
+    uint8_t* const dst = static_cast<uint8_t*>(out);
+    const size_t miniblock = m_options.miniblock;
+    const size_t num_elements = in_bytes / sizeof(U);
+    const size_t tail_bytes = in_bytes % sizeof(U);
+    const size_t num_miniblocks = (num_elements + miniblock - 1) / miniblock;
+
+    std::vector<U> elements(num_elements);
+    if (num_elements > 0) {
+      std::memcpy(elements.data(), src, num_elements * sizeof(U));
+    }
+
+    std::vector<U> refs(num_miniblocks);
+    std::vector<detail::PforMiniblock> infos(num_miniblocks);
+    std::vector<uint64_t> words;
+    std::vector<uint64_t> exception_words;
+    std::vector<uint8_t> positions;
+    std::vector<U> diffs(miniblock);
+    std::vector<U> highs;
+    for (size_t m = 0; m < num_miniblocks; ++m) {
+      const size_t begin = m * miniblock;
+      const size_t count = std::min(miniblock, num_elements - begin);
+      const U* const values = elements.data() + begin;
+
+      // The minimum as a signed value, so that small negative and positive
+      // values share a narrow range.
+      S min = static_cast<S>(values[0]);
+      for (size_t i = 1; i < count; ++i) {
+        min = std::min(min, static_cast<S>(values[i]));
+      }
+      const U ref = static_cast<U>(min);
+      size_t lengths[8 * sizeof(U) + 1] = {};
+      size_t max_bits = 0;
+      for (size_t i = 0; i < count; ++i) {
+        diffs[i] = static_cast<U>(values[i] - ref);
+        const size_t length = detail::pfor_bit_length(diffs[i]);
+        ++lengths[length];
+        max_bits = std::max(max_bits, length);
+      }
+      const size_t width = detail::pfor_best_width(lengths, max_bits, count);
+
+      highs.clear();
+      for (size_t i = 0; i < count; ++i) {
+        if (detail::pfor_bit_length(diffs[i]) > width) {
+          positions.push_back(static_cast<uint8_t>(i));
+          highs.push_back(static_cast<U>(diffs[i] >> width));
+        }
+      }
+      refs[m] = ref;
+      infos[m].width = static_cast<uint8_t>(width);
+      infos[m].exception_width
+          = static_cast<uint8_t>(highs.empty() ? 0 : max_bits - width);
+      infos[m].num_exceptions = static_cast<uint16_t>(highs.size());
+
+      // Bit packing keeps the low `width` bits of the exceptions.
+      const size_t offset = words.size();
+      words.resize(offset + bitpack_words(count, width));
+      bitpack(diffs.data(), count, width, U(0), words.data() + offset);
+      const size_t exception_offset = exception_words.size();
+      exception_words.resize(
+          exception_offset
+          + bitpack_words(highs.size(), infos[m].exception_width));
+      bitpack(
+          highs.data(),
+          highs.size(),
+          infos[m].exception_width,
+          U(0),
+          exception_words.data() + exception_offset);
+    }
+    words.insert(words.end(), exception_words.begin(), exception_words.end());
+
+    const size_t encoded_bytes
+        = sizeof(detail::PforChunkHeader)
+          + num_miniblocks * (sizeof(U) + sizeof(detail::PforMiniblock))
+          + words.size() * sizeof(uint64_t) + positions.size() + tail_bytes;
+    if (encoded_bytes >= sizeof(detail::PforChunkHeader) + in_bytes) {
+      // Store the chunk as it is instead.
+      if (sizeof(detail::PforChunkHeader) + in_bytes > out_capacity) {
+        throw std::runtime_error("Output buffer too small for PFOR chunk.");
+      }
+      std::memset(dst, 0, sizeof(detail::PforChunkHeader));
+      if (in_bytes > 0) {
+        std::memcpy(dst + sizeof(detail::PforChunkHeader), src, in_bytes);
+      }
+      return sizeof(detail::PforChunkHeader) + in_bytes;
+    }
+    if (encoded_bytes > out_capacity) {
+      throw std::runtime_error("Output buffer too small for PFOR chunk.");
+    }
+
+    detail::PforChunkHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.mode = 1;
+    header.type_size = sizeof(U);
+    header.miniblock = static_cast<uint16_t>(miniblock);
+    header.num_elements = static_cast<uint32_t>(num_elements);
+    header.num_words = static_cast<uint32_t>(words.size());
+    header.num_exceptions = static_cast<uint32_t>(positions.size());
+
+    size_t pos = 0;
+    std::memcpy(dst, &header, sizeof(header));
+    pos += sizeof(header);
+    append(dst, pos, refs.data(), refs.size() * sizeof(U));
+    append(
+        dst,
+        pos,
+        infos.data(),
+        infos.size() * sizeof(detail::PforMiniblock));
+    append(dst, pos, words.data(), words.size() * sizeof(uint64_t));
+    append(dst, pos, positions.data(), positions.size());
+    append(dst, pos, src + num_elements * sizeof(U), tail_bytes);
+    return encoded_bytes;
+  }
+
+  template <typename U>
+  static bool decompress_typed(
+      const detail::PforChunkHeader& header,
+      const uint8_t* const src,
+      uint8_t* const dst)
+  {
+    const size_t miniblock = header.miniblock;
+    const size_t num_elements = header.num_elements;
+    const size_t num_miniblocks = (num_elements + miniblock - 1) / miniblock;
+    const size_t num_words = header.num_words;
+    const size_t num_exceptions = header.num_exceptions;
+
+    size_t pos = sizeof(header);
+    std::vector<U> refs(num_miniblocks);
+    std::vector<detail::PforMiniblock> infos(num_miniblocks);
+    read(src, pos, refs.data(), refs.size() * sizeof(U));
+    read(
+        src,
+        pos,
+        infos.data(),
+        infos.size() * sizeof(detail::PforMiniblock));
+    // Copied into aligned words for the unpacking kernels.
+    std::vector<uint64_t> words(num_words);
+    read(src, pos, words.data(), num_words * sizeof(uint64_t));
+    const uint8_t* const positions = src + pos;
+
+    // First pass: check the widths and find where the exception bits start.
+    size_t value_words = 0;
+    size_t total_exceptions = 0;
+    for (size_t m = 0; m < num_miniblocks; ++m) {
+      const detail::PforMiniblock& info = infos[m];
+      const size_t count = std::min(miniblock, num_elements - m * miniblock);
+      if (info.width + info.exception_width > 8 * sizeof(U)
+          || info.num_exceptions > count
+          || (info.num_exceptions > 0) != (info.exception_width > 0)) {
+        return false;
+      }
+      value_words += bitpack_words(count, info.width);
+      total_exceptions += info.num_exceptions;
+    }
+    if (value_words > num_words || total_exceptions != num_exceptions) {
+      return false;
+    }
+
+    // The output may not be aligned for U, in which case the miniblocks are
+    // unpacked into a buffer first.
+    const bool aligned = reinterpret_cast<uintptr_t>(dst) % sizeof(U) == 0;
+    std::vector<U> buffer(aligned ? 0 : num_elements);
+    U* const elements = aligned ? reinterpret_cast<U*>(dst) : buffer.data();
+
+    std::vector<U> highs(miniblock);
+    size_t word = 0;
+    size_t exception_word = value_words;
+    size_t exception = 0;
+    for (size_t m = 0; m < num_miniblocks; ++m) {
+      const detail::PforMiniblock& info = infos[m];
+      const size_t count = std::min(miniblock, num_elements - m * miniblock);
+      U* const values = elements + m * miniblock;
+      bitunpack(words.data() + word, count, info.width, refs[m], values);
+      word += bitpack_words(count, info.width);
+
+      if (info.num_exceptions > 0) {
+        const size_t exception_words
+            = bitpack_words(info.num_exceptions, info.exception_width);
+        if (exception_words > num_words - exception_word) {
+          return false;
+        }
+        bitunpack(
+            words.data() + exception_word,
+            info.num_exceptions,
+            info.exception_width,
+            U(0),
+            highs.data());
+        exception_word += exception_words;
+        for (size_t e = 0; e < info.num_exceptions; ++e) {
+          const size_t i = positions[exception + e];
+          if (i >= count) {
+            return false;
+          }
+          values[i] = static_cast<U>(values[i] + (highs[e] << info.width));
+        }
+        exception += info.num_exceptions;
+      }
+    }
+    if (exception_word != num_words) {
+      return false;
+    }
+    if (!aligned && num_elements > 0) {
+      std::memcpy(dst, buffer.data(), num_elements * sizeof(U));
+    }
+    return true;
+  }
+
+  static void append(
+      uint8_t* const dst, size_t& pos, const void* const data, size_t bytes)
+  {
+    if (bytes > 0) {
+      std::memcpy(dst + pos, data, bytes);
+    }
+    pos += bytes;
+  }
+
+  static void read(
+      const uint8_t* const src, size_t& pos, void* const data, size_t bytes)
+  {
+    if (bytes > 0) {
+      std::memcpy(data, src + pos, bytes);
+    }
+    pos += bytes;
+  }
+
+  HostPforOptions m_options;
+};
+
+} // namespace host
+} // namespace nvcomp
@@ -0,0 +1,372 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/host_codec.h"
+#include "host/rle.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace nvcomp
+{
+namespace host
+{
+
+// Options of the host RLE codec.
+struct HostRleOptions
+{
+  // Size of the integer elements: 1, 2, 4 or 8 bytes.
+  size_t type_size;
+};
+
+constexpr HostRleOptions HostRleDefaultOpts = {4};
+
+namespace detail
+{
+
+// Chunk header of the host RLE format. It is followed by the value of every
+// run (`type_size` bytes each), the length of every run minus one
+// (`counter_bytes` each), and the bytes after the last whole element. A
+// chunk that doesn't shrink is stored as it is, with `mode` 0.
+struct RleChunkHeader
+{
+  uint8_t mode;
+  uint8_t type_size;
+  uint8_t counter_bytes;
+  uint8_t num_tail_bytes;
+  uint32_t num_elements;
+  uint32_t num_runs;
+  uint32_t reserved;
+};
+
+static_assert(sizeof(RleChunkHeader) == 16, "Header must be 16 B");
+
+// Longest run a counter of `counter_bytes` holds; longer runs are split.
+inline uint64_t rle_max_run(const size_t counter_bytes)
+{
+  return uint64_t(1) << (8 * counter_bytes);
+}
+
+// Runs stored with `counter_bytes` counters, splitting the long ones.
+inline size_t rle_stored_runs(
+    const std::vector<uint32_t>& lengths, const size_t counter_bytes)
+{
+  const uint64_t max_run = rle_max_run(counter_bytes);
+  size_t runs = 0;
+  for (const uint32_t length : lengths) {
+    runs += static_cast<size_t>((length + max_run - 1) / max_run);
+  }
+  return runs;
+}
+
+} // namespace detail
+
+/**
+ * @brief A CPU run-length codec for integer elements.
+ *
+ * Each chunk holds the run values and the run lengths as two separate
+ * streams. The counters are 1, 2 or 4 bytes wide, whichever gives the
+ * smallest chunk once the runs too long for them are split. The runs are
+ * counted before anything is encoded, and chunks whose runs are too short
+ * to pay for even 1-byte counters are stored as they are straight away.
+ */
+class RleCodec : public HostCodec
+{
+public:
+  explicit RleCodec(const HostRleOptions options = HostRleDefaultOpts) :
+      m_options(options)
+  {
+    if (options.type_size != 1 && options.type_size != 2
+        && options.type_size != 4 && options.type_size != 8) {
+      throw std::runtime_error("RLE type size must be 1, 2, 4 or 8.");
+    }
+  }
+
+  HostCodecId id() const override
+  {
+    return HostCodecId::RLE;
+  }
+
+  const char* name() const override
+  {
+    return "rle";
+  }
+
+  const HostRleOptions& options() const
+  {
+    return m_options;
+  }
+
+  size_t max_compressed_size(const size_t uncompressed_bytes) const override
+  {
+    check_size(uncompressed_bytes);
+    return sizeof(detail::RleChunkHeader) + uncompressed_bytes;
+  }
+
+  size_t compress(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity) const override
+  {
+    check_size(in_bytes);
+    switch (m_options.type_size) {
+    case 1:
+      return compress_typed<uint8_t>(in, in_bytes, out, out_capacity);
+    case 2:
+      return compress_typed<uint16_t>(in, in_bytes, out, out_capacity);
+    case 4:
+      return compress_typed<uint32_t>(in, in_bytes, out, out_capacity);
+    default:
+      return compress_typed<uint64_t>(in, in_bytes, out, out_capacity);
+    }
+  }
+
+  nvcompStatus_t decompress(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity,
+      size_t* const out_bytes) const override
+  {
+    const uint8_t* const src = static_cast<const uint8_t*>(in);
+    uint8_t* const dst = static_cast<uint8_t*>(out);
+    detail::RleChunkHeader header;
+    if (in_bytes < sizeof(header)) {
+      return nvcompErrorCannotDecompress;
+    }
+    std::memcpy(&header, src, sizeof(header));
+
+    if (header.mode == 0) {
+      const size_t bytes = in_bytes - sizeof(header);
+      if (bytes > out_capacity) {
+        return nvcompErrorCannotDecompress;
+      }
+      if (bytes > 0) {
+        std::memcpy(dst, src + sizeof(header), bytes);
+      }
+      *out_bytes = bytes;
+      return nvcompSuccess;
+    }
+
+    const size_t type_size = header.type_size;
+    const size_t counter_bytes = header.counter_bytes;
+    if (header.mode != 1
+        || (type_size != 1 && type_size != 2 && type_size != 4
+            && type_size != 8)
+        || (counter_bytes != 1 && counter_bytes != 2 && counter_bytes != 4)
+        || header.num_tail_bytes >= type_size) {
+      return nvcompErrorCannotDecompress;
+    }
+    const size_t num_elements = header.num_elements;
+    const size_t num_runs = header.num_runs;
+    const size_t total_bytes = num_elements * type_size + header.num_tail_bytes;
+    if (total_bytes > out_capacity || num_runs > num_elements
+        || in_bytes - sizeof(header)
+               != num_runs * (type_size + counter_bytes)
+                      + header.num_tail_bytes) {
+      return nvcompErrorCannotDecompress;
+    }
+
+    bool ok;
+    switch (type_size) {
+    case 1:
+      ok = decompress_typed<uint8_t>(header, src, dst);
+      break;
+    case 2:
+      ok = decompress_typed<uint16_t>(header, src, dst);
+      break;
+    case 4:
+      ok = decompress_typed<uint32_t>(header, src, dst);
+      break;
+    default:
+      ok = decompress_typed<uint64_t>(header, src, dst);
+      break;
+    }
+    if (!ok) {
+      return nvcompErrorCannotDecompress;
+    }
+    *out_bytes = total_bytes;
+    return nvcompSuccess;
+  }
+
+private:
+  static void check_size(const size_t bytes)
+  {
+    if (bytes > UINT32_MAX) {
+      throw std::runtime_error("RLE chunk too large.");
+    }
+  }
+
+  static size_t store(
+      const uint8_t* const src,
+      const size_t in_bytes,
+      uint8_t* const dst,
+      const size_t out_capacity)
+  {
+    if (sizeof(detail::RleChunkHeader) + in_bytes > out_capacity) {
+      throw std::runtime_error("Output buffer too small for RLE chunk.");
+    }
+    std::memset(dst, 0, sizeof(detail::RleChunkHeader));
+    if (in_bytes > 0) {
+      std::memcpy(dst + sizeof(detail::RleChunkHeader), src, in_bytes);
+    }
+    return sizeof(detail::RleChunkHeader) + in_bytes;
+  }
+
+  template <typename U>
+  static size_t compress_typed(
+      const void* const in,
+      const size_t in_bytes,
+      void* const out,
+      const size_t out_capacity)
+  {
+    const uint8_t* const src = static_cast<const uint8_t*>(in);
+    uint8_t* const dst = static_cast<uint8_t*>(out);
+    const size_t num_elements = in_bytes / sizeof(U);
+    const size_t tail_bytes = in_bytes % sizeof(U);
+
+    std::vector<U> elements(num_elements);
+    if (num_elements > 0) {
+      std::memcpy(elements.data(), src, num_elements * sizeof(U));
+    }
+    const size_t num_runs = rle_count_runs(elements.data(), num_elements);
+    if (num_runs * (sizeof(U) + 1) >= num_elements * sizeof(U)) {
+      return store(src, in_bytes, dst, out_capacity);
+    }
+
+    std::vector<U> values(num_runs);
+    std::vector<uint32_t> lengths(num_runs);
+    rle_encode(elements.data(), num_elements, values.data(), lengths.data());
+
+    size_t counter_bytes = 4;
+    size_t stored_runs = num_runs;
+    for (const size_t bytes : {2, 1}) {
+      const size_t runs = detail::rle_stored_runs(lengths, bytes);
+      if (runs * (sizeof(U) + bytes)
+          < stored_runs * (sizeof(U) + counter_bytes)) {
+        counter_bytes = bytes;
+        stored_runs = runs;
+      }
+    }
+    const size_t encoded_bytes = sizeof(detail::RleChunkHeader)
+                                 + stored_runs * (sizeof(U) + counter_bytes)
+                                 + tail_bytes;
+    if (encoded_bytes >= sizeof(detail::RleChunkHeader) + in_bytes) {
+      return store(src, in_bytes, dst, out_capacity);
+    }
+    if (encoded_bytes > out_capacity) {
+      throw std::runtime_error("Output buffer too small for RLE chunk.");
+    }
+
+    detail::RleChunkHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.mode = 1;
+    header.type_size = sizeof(U);
+    header.counter_bytes = static_cast<uint8_t>(counter_bytes);
+    header.num_tail_bytes = static_cast<uint8_t>(tail_bytes);
+    header.num_elements = static_cast<uint32_t>(num_elements);
+    header.num_runs = static_cast<uint32_t>(stored_runs);
+    std::memcpy(dst, &header, sizeof(header));
+
+    uint8_t* value_out = dst + sizeof(header);
+    uint8_t* counter_out = value_out + stored_runs * sizeof(U);
+    const uint64_t max_run = detail::rle_max_run(counter_bytes);
+    for (size_t r = 0; r < num_runs; ++r) {
+      uint64_t remaining = lengths[r];
+      while (remaining > 0) {
+        const uint64_t length = std::min(remaining, max_run);
+        // Counters are little-endian, as is the rest of the chunk.
+        const uint32_t counter = static_cast<uint32_t>(length - 1);
+        std::memcpy(value_out, &values[r], sizeof(U));
+        std::memcpy(counter_out, &counter, counter_bytes);
+        value_out += sizeof(U);
+        counter_out += counter_bytes;
+        remaining -= length;
+      }
+    }
+    if (tail_bytes > 0) {
+      std::memcpy(counter_out, src + num_elements * sizeof(U), tail_bytes);
+    }
+    return encoded_bytes;
+  }
+
+  template <typename U>
+  static bool decompress_typed(
+      const detail::RleChunkHeader& header,
+      const uint8_t* const src,
+      uint8_t* const dst)
+  {
+    const size_t num_elements = header.num_elements;
+    const size_t num_runs = header.num_runs;
+    const size_t counter_bytes = header.counter_bytes;
+
+    const uint8_t* const value_in = src + sizeof(header);
+    const uint8_t* const counter_in = value_in + num_runs * sizeof(U);
+    std::vector<U> values(num_runs);
+    std::vector<uint32_t> lengths(num_runs);
+    if (num_runs > 0) {
+      std::memcpy(values.data(), value_in, num_runs * sizeof(U));
+    }
+    for (size_t r = 0; r < num_runs; ++r) {
+      uint32_t counter = 0;
+      std::memcpy(&counter, counter_in + r * counter_bytes, counter_bytes);
+      lengths[r] = counter + 1;
+    }
+
+    // The output may not be aligned for U, in which case the runs are
+    // expanded into a buffer first.
+    const bool aligned = reinterpret_cast<uintptr_t>(dst) % sizeof(U) == 0;
+    std::vector<U> buffer(aligned ? 0 : num_elements);
+    U* const elements = aligned ? reinterpret_cast<U*>(dst) : buffer.data();
+    if (!rle_decode(
+            values.data(), lengths.data(), num_runs, elements, num_elements)) {
+      return false;
+    }
+    if (!aligned && num_elements > 0) {
+      std::memcpy(dst, buffer.data(), num_elements * sizeof(U));
+    }
+    if (header.num_tail_bytes > 0) {
+      std::memcpy(
+          dst + num_elements * sizeof(U),
+          counter_in + num_runs * counter_bytes,
+          header.num_tail_bytes);
+    }
+    return true;
+  }
+
+  HostRleOptions m_options;
+};
+
+} // namespace host
+} // namespace nvcomp
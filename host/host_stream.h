@@ -0,0 +1,362 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace nvcomp
+{
+namespace host
+{
+
+typedef std::chrono::steady_clock HostClock;
+
+namespace detail
+{
+
+struct HostEventState
+{
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool complete;
+  HostClock::time_point time;
+
+  HostEventState() : mutex(), cv(), complete(false), time()
+  {
+  }
+};
+
+} // namespace detail
+
+/**
+ * @brief A marker in a HostStream, like a cudaEvent_t.
+ *
+ * An event completes once the stream reaches the point where it was
+ * recorded. Recording it again starts a new completion, and waits that were
+ * already issued keep waiting for the previous one. An event that was never
+ * recorded counts as complete.
+ */
+class HostEvent
+{
+public:
+  HostEvent() : m_state(std::make_shared<detail::HostEventState>())
+  {
+    m_state->complete = true;
+  }
+
+  bool query() const
+  {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->complete;
+  }
+
+  void synchronize() const
+  {
+    wait_for(m_state);
+  }
+
+  // When the stream reached the event. Only valid once it completed.
+  HostClock::time_point time() const
+  {
+    std::lock_guard<std::mutex> lock(m_state->mutex);
+    return m_state->time;
+  }
+
+private:
+  friend class HostStream;
+
+  static void wait_for(const std::shared_ptr<detail::HostEventState>& state)
+  {
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&state]() { return state->complete; });
+  }
+
+  std::shared_ptr<detail::HostEventState> m_state;
+};
+
+// Seconds between two completed events, like cudaEventElapsedTime().
+inline double elapsed_seconds(const HostEvent& start, const HostEvent& end)
+{
+  return std::chrono::duration<double>(end.time() - start.time()).count();
+}
+
+// When a stream ran one of its tasks.
+struct StreamInterval
+{
+  // The tag passed to HostStream::enqueue().
+  size_t tag;
+  HostClock::time_point begin;
+  HostClock::time_point end;
+
+  StreamInterval() : tag(0), begin(), end()
+  {
+  }
+};
+
+/**
+ * @brief An in-order queue of host work, the CPU counterpart of a
+ * cudaStream_t.
+ *
+ * A dedicated thread runs the tasks one after another, in the order they
+ * were enqueued, while the caller goes on. Streams synchronize with each
+ * other through events, so work on several streams overlaps the way
+ * kernels and copies on several CUDA streams do. When the stream was
+ * created with `record_timeline`, it keeps the interval of every task,
+ * which shows how much the streams actually overlapped.
+ *
+ * If a task throws, the rest of the queue still runs, events still complete,
+ * and the first exception is rethrown by synchronize(), like a sticky CUDA
+ * error. The destructor waits for the queue.
+ */
+class HostStream
+{
+public:
+  explicit HostStream(const bool record_timeline = false) :
+      m_mutex(),
+      m_cv(),
+      m_idle_cv(),
+      m_tasks(),
+      m_busy(false),
+      m_stop(false),
+      m_record_timeline(record_timeline),
+      m_timeline(),
+      m_error(),
+      m_thread()
+  {
+    m_thread = std::thread(&HostStream::worker_loop, this);
+  }
+
+  ~HostStream()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+  }
+
+  // disable copying
+  HostStream(const HostStream& other) = delete;
+  HostStream& operator=(const HostStream& other) = delete;
+
+  // Run `task` after everything enqueued before it. `tag` labels its
+  // interval in the timeline.
+  void enqueue(std::function<void()> task, const size_t tag = 0)
+  {
+    push(Task(std::move(task), tag, true));
+  }
+
+  // Complete `event` once the stream gets here.
+  void record(HostEvent& event)
+  {
+    std::shared_ptr<detail::HostEventState> state
+        = std::make_shared<detail::HostEventState>();
+    event.m_state = state;
+    push(Task(
+        [state]() {
+          {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->complete = true;
+            state->time = HostClock::now();
+          }
+          state->cv.notify_all();
+        },
+        0,
+        false));
+  }
+
+  // Hold back the tasks enqueued after this until `event` completes, like
+  // cudaStreamWaitEvent(). The event may be recorded on any stream.
+  void wait(const HostEvent& event)
+  {
+    std::shared_ptr<detail::HostEventState> state = event.m_state;
+    push(Task([state]() { HostEvent::wait_for(state); }, 0, false));
+  }
+
+  // Block until every enqueued task ran, and rethrow the first exception
+  // one of them threw.
+  void synchronize()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle_cv.wait(lock, [this]() { return m_tasks.empty() && !m_busy; });
+    if (m_error) {
+      std::exception_ptr error = m_error;
+      m_error = nullptr;
+      std::rethrow_exception(error);
+    }
+  }
+
+  // The intervals of the tasks run so far, in order. Call after
+  // synchronize().
+  std::vector<StreamInterval> timeline() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_timeline;
+  }
+
+  void clear_timeline()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_timeline.clear();
+  }
+
+private:
+  struct Task
+  {
+    std::function<void()> fn;
+    size_t tag;
+    // Waits and records don't show in the timeline.
+    bool timed;
+
+    Task(std::function<void()> fn, const size_t tag, const bool timed) :
+        fn(std::move(fn)), tag(tag), timed(timed)
+    {
+    }
+  };
+
+  void push(Task task)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_tasks.push_back(std::move(task));
+    }
+    m_cv.notify_one();
+  }
+
+  void worker_loop()
+  {
+    NVCOMP_TRACE_THREAD_NAME("host stream");
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+      m_cv.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+      if (m_tasks.empty()) {
+        return;
+      }
+      Task task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+      m_busy = true;
+      lock.unlock();
+
+      StreamInterval interval;
+      interval.tag = task.tag;
+      interval.begin = HostClock::now();
+      std::exception_ptr error;
+      try {
+        task.fn();
+      } catch (...) {
+        error = std::current_exception();
+      }
+      interval.end = HostClock::now();
+
+      lock.lock();
+      if (error && !m_error) {
+        m_error = error;
+      }
+      if (task.timed && m_record_timeline) {
+        m_timeline.push_back(interval);
+      }
+      m_busy = false;
+      if (m_tasks.empty()) {
+        m_idle_cv.notify_all();
+      }
+    }
+  }
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::condition_variable m_idle_cv;
+  std::deque<Task> m_tasks;
+  bool m_busy;
+  bool m_stop;
+  bool m_record_timeline;
+  std::vector<StreamInterval> m_timeline;
+  std::exception_ptr m_error;
+  std::thread m_thread;
+};
+
+/**
+ * @brief Fraction of the busy time during which at least two of the
+ * timelines were busy at once.
+ *
+ * Each timeline is one stage, e.g. one stream, and its intervals must not
+ * overlap each other. 0 means the stages ran strictly one after another,
+ * and values close to 1 mean they almost always ran together.
+ */
+inline double
+overlap_fraction(const std::vector<std::vector<StreamInterval>>& timelines)
+{
+  // +1 when a stage starts, -1 when it stops. Ends sort before begins at the
+  // same time, so touching intervals don't count as overlapping.
+  std::vector<std::pair<HostClock::time_point, int>> edges;
+  for (const std::vector<StreamInterval>& timeline : timelines) {
+    for (const StreamInterval& interval : timeline) {
+      if (interval.end > interval.begin) {
+        edges.push_back(std::make_pair(interval.begin, 1));
+        edges.push_back(std::make_pair(interval.end, -1));
+      }
+    }
+  }
+  std::sort(edges.begin(), edges.end());
+
+  HostClock::duration busy(0);
+  HostClock::duration overlapped(0);
+  int active = 0;
+  for (size_t i = 0; i < edges.size(); ++i) {
+    if (i > 0) {
+      const HostClock::duration span = edges[i].first - edges[i - 1].first;
+      if (active >= 1) {
+        busy += span;
+      }
+      if (active >= 2) {
+        overlapped += span;
+      }
+    }
+    active += edges[i].second;
+  }
+  return busy.count() > 0 ? static_cast<double>(overlapped.count())
+                                / static_cast<double>(busy.count())
+                          : 0.0;
+}
+
+} // namespace host
+} // namespace nvcomp
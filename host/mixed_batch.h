@@ -0,0 +1,388 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/data_profiler.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace nvcomp
+{
+namespace host
+{
+
+// Codec name of chunks that are kept uncompressed in a mixed batch.
+static const char* const MIXED_STORED_CODEC = "stored";
+
+constexpr uint32_t MIXED_BATCH_MAGIC = 0x584d564e; // "NVMX"
+constexpr uint32_t MIXED_BATCH_VERSION = 1;
+constexpr size_t MIXED_BATCH_CODEC_NAME_SIZE = 32;
+constexpr size_t MIXED_BATCH_MAX_CODECS = 256;
+// Chunk payloads start at multiples of this, which satisfies the input
+// alignment of all batched decompressors.
+constexpr size_t MIXED_BATCH_ALIGNMENT = 8;
+
+// A codec is identified by the format name, followed by the options that
+// change the batched format options, e.g. "lz4", "bitcomp:longlong" or
+// "cascaded:int:1:0:1" (type, RLEs, deltas, bitpacking).
+struct CodecKey
+{
+  std::string format;
+  std::string data_type;
+  int num_RLEs;
+  int num_deltas;
+  int use_bp;
+
+  CodecKey() :
+      format(), data_type("char"), num_RLEs(0), num_deltas(0), use_bp(0)
+  {
+  }
+};
+
+inline std::string codec_key(const FormatRecommendation& rec)
+{
+  if (rec.format == "none") {
+    return MIXED_STORED_CODEC;
+  }
+  std::string key = rec.format;
+  if (rec.format == "cascaded") {
+    key += ":" + rec.data_type + ":" + std::to_string(rec.num_RLEs) + ":"
+           + std::to_string(rec.num_deltas) + ":" + std::to_string(rec.use_bp);
+  } else if (rec.format == "bitcomp") {
+    key += ":" + rec.data_type;
+  }
+  return key;
+}
+
+inline CodecKey parse_codec_key(const std::string& key)
+{
+  std::vector<std::string> fields;
+  size_t begin = 0;
+  while (true) {
+    const size_t end = key.find(':', begin);
+    fields.push_back(key.substr(begin, end - begin));
+    if (end == std::string::npos) {
+      break;
+    }
+    begin = end + 1;
+  }
+
+  CodecKey result;
+  result.format = fields[0];
+  result.data_type = fields.size() > 1 ? fields[1] : "char";
+  result.num_RLEs = fields.size() > 2 ? std::atoi(fields[2].c_str()) : 0;
+  result.num_deltas = fields.size() > 3 ? std::atoi(fields[3].c_str()) : 0;
+  result.use_bp = fields.size() > 4 ? std::atoi(fields[4].c_str()) : 0;
+
+  const size_t expected = result.format == "cascaded"  ? 5
+                          : result.format == "bitcomp" ? 2
+                                                       : 1;
+  if (fields.size() != expected && fields.size() != 1) {
+    throw std::runtime_error("Malformed codec key '" + key + "'.");
+  }
+  return result;
+}
+
+// Pick a codec for every chunk of a profiled batch, restricted to the
+// `allowed` formats (all formats if empty). Chunks whose estimated ratio is
+// below `min_ratio` are stored.
+inline std::vector<std::string> select_chunk_codecs(
+    const BatchProfile& profile,
+    const std::vector<std::string>& allowed = std::vector<std::string>(),
+    const double min_ratio = 1.05)
+{
+  std::vector<std::string> codecs(profile.chunks.size());
+  for (size_t i = 0; i < profile.chunks.size(); ++i) {
+    const FormatRecommendation rec
+        = recommend_format(profile.chunks[i], allowed);
+    codecs[i] = rec.estimated_ratio < min_ratio ? MIXED_STORED_CODEC
+                                                : codec_key(rec);
+  }
+  return codecs;
+}
+
+/**
+ * @brief Describes a batch of chunks that were each compressed with their
+ * own codec.
+ *
+ * The serialized container is the header followed by the chunk payloads:
+ *
+ *   uint32 magic, uint32 version, uint32 num_codecs, uint32 reserved,
+ *   uint64 num_chunks,
+ *   num_codecs NUL padded names of MIXED_BATCH_CODEC_NAME_SIZE bytes,
+ *   num_chunks pairs of uint64 uncompressed and compressed sizes,
+ *   num_chunks uint8 codec indices, padded to MIXED_BATCH_ALIGNMENT.
+ *
+ * All values are little-endian. Each payload starts at a multiple of
+ * MIXED_BATCH_ALIGNMENT.
+ */
+class MixedBatchLayout
+{
+public:
+  MixedBatchLayout() :
+      m_codecs(),
+      m_chunk_codecs(),
+      m_uncompressed_sizes(),
+      m_compressed_sizes()
+  {
+  }
+
+  // Add a codec, or find it if it was added before, and return its index.
+  uint8_t add_codec(const std::string& name)
+  {
+    for (size_t i = 0; i < m_codecs.size(); ++i) {
+      if (m_codecs[i] == name) {
+        return static_cast<uint8_t>(i);
+      }
+    }
+    if (name.empty() || name.size() >= MIXED_BATCH_CODEC_NAME_SIZE) {
+      throw std::runtime_error("Invalid codec name '" + name + "'.");
+    }
+    if (m_codecs.size() == MIXED_BATCH_MAX_CODECS) {
+      throw std::runtime_error("Too many codecs in mixed batch.");
+    }
+    m_codecs.push_back(name);
+    return static_cast<uint8_t>(m_codecs.size() - 1);
+  }
+
+  void add_chunk(
+      const uint8_t codec,
+      const size_t uncompressed_bytes,
+      const size_t compressed_bytes = 0)
+  {
+    if (codec >= m_codecs.size()) {
+      throw std::runtime_error("Invalid codec index for chunk.");
+    }
+    m_chunk_codecs.push_back(codec);
+    m_uncompressed_sizes.push_back(uncompressed_bytes);
+    m_compressed_sizes.push_back(compressed_bytes);
+  }
+
+  void set_compressed_size(const size_t chunk, const size_t bytes)
+  {
+    m_compressed_sizes[chunk] = bytes;
+  }
+
+  size_t num_codecs() const
+  {
+    return m_codecs.size();
+  }
+
+  size_t num_chunks() const
+  {
+    return m_chunk_codecs.size();
+  }
+
+  const std::string& codec_name(const size_t codec) const
+  {
+    return m_codecs[codec];
+  }
+
+  uint8_t chunk_codec(const size_t chunk) const
+  {
+    return m_chunk_codecs[chunk];
+  }
+
+  size_t uncompressed_size(const size_t chunk) const
+  {
+    return m_uncompressed_sizes[chunk];
+  }
+
+  size_t compressed_size(const size_t chunk) const
+  {
+    return m_compressed_sizes[chunk];
+  }
+
+  // The chunk indices of each codec, in increasing order. These are the
+  // sub-batches a decoder dispatches together.
+  std::vector<std::vector<size_t>> chunks_by_codec() const
+  {
+    std::vector<std::vector<size_t>> groups(m_codecs.size());
+    for (size_t i = 0; i < m_chunk_codecs.size(); ++i) {
+      groups[m_chunk_codecs[i]].push_back(i);
+    }
+    return groups;
+  }
+
+  size_t header_size() const
+  {
+    const size_t bytes = 6 * sizeof(uint32_t)
+                         + m_codecs.size() * MIXED_BATCH_CODEC_NAME_SIZE
+                         + m_chunk_codecs.size() * (2 * sizeof(uint64_t) + 1);
+    return align(bytes);
+  }
+
+  // Offsets of the chunk payloads from the start of the container.
+  std::vector<size_t> payload_offsets() const
+  {
+    std::vector<size_t> offsets(m_compressed_sizes.size());
+    size_t offset = header_size();
+    for (size_t i = 0; i < offsets.size(); ++i) {
+      offsets[i] = offset;
+      offset = align(offset + m_compressed_sizes[i]);
+    }
+    return offsets;
+  }
+
+  size_t total_size() const
+  {
+    size_t offset = header_size();
+    for (const size_t bytes : m_compressed_sizes) {
+      offset = align(offset + bytes);
+    }
+    return offset;
+  }
+
+  size_t total_uncompressed_size() const
+  {
+    size_t total = 0;
+    for (const size_t bytes : m_uncompressed_sizes) {
+      total += bytes;
+    }
+    return total;
+  }
+
+  // Write the header_size() bytes of header to `out`.
+  void write_header(void* const out) const
+  {
+    uint8_t* ptr = static_cast<uint8_t*>(out);
+    std::memset(ptr, 0, header_size());
+    ptr = put<uint32_t>(ptr, MIXED_BATCH_MAGIC);
+    ptr = put<uint32_t>(ptr, MIXED_BATCH_VERSION);
+    ptr = put<uint32_t>(ptr, static_cast<uint32_t>(m_codecs.size()));
+    ptr = put<uint32_t>(ptr, 0);
+    ptr = put<uint64_t>(ptr, m_chunk_codecs.size());
+    for (const std::string& name : m_codecs) {
+      std::memcpy(ptr, name.data(), name.size());
+      ptr += MIXED_BATCH_CODEC_NAME_SIZE;
+    }
+    for (size_t i = 0; i < m_chunk_codecs.size(); ++i) {
+      ptr = put<uint64_t>(ptr, m_uncompressed_sizes[i]);
+      ptr = put<uint64_t>(ptr, m_compressed_sizes[i]);
+    }
+    std::memcpy(ptr, m_chunk_codecs.data(), m_chunk_codecs.size());
+  }
+
+  // Parse a header written by write_header(), where `bytes` is the size of
+  // the buffer `in` points to.
+  static MixedBatchLayout read_header(const void* const in, const size_t bytes)
+  {
+    const uint8_t* ptr = static_cast<const uint8_t*>(in);
+    const uint8_t* const end = ptr + bytes;
+    if (bytes < 6 * sizeof(uint32_t)) {
+      throw std::runtime_error("Mixed batch header is truncated.");
+    }
+    if (get<uint32_t>(ptr) != MIXED_BATCH_MAGIC) {
+      throw std::runtime_error("Not a mixed batch container.");
+    }
+    if (get<uint32_t>(ptr) != MIXED_BATCH_VERSION) {
+      throw std::runtime_error("Unsupported mixed batch version.");
+    }
+    const size_t num_codecs = get<uint32_t>(ptr);
+    get<uint32_t>(ptr);
+    const uint64_t num_chunks = get<uint64_t>(ptr);
+    if (num_codecs > MIXED_BATCH_MAX_CODECS
+        || num_chunks > static_cast<uint64_t>(end - ptr)
+        || static_cast<size_t>(end - ptr)
+               < num_codecs * MIXED_BATCH_CODEC_NAME_SIZE
+                     + num_chunks * (2 * sizeof(uint64_t) + 1)) {
+      throw std::runtime_error("Mixed batch header is truncated.");
+    }
+
+    MixedBatchLayout layout;
+    for (size_t i = 0; i < num_codecs; ++i) {
+      const char* const name = reinterpret_cast<const char*>(ptr);
+      layout.m_codecs.push_back(
+          std::string(name, strnlen(name, MIXED_BATCH_CODEC_NAME_SIZE)));
+      ptr += MIXED_BATCH_CODEC_NAME_SIZE;
+    }
+    layout.m_uncompressed_sizes.resize(num_chunks);
+    layout.m_compressed_sizes.resize(num_chunks);
+    for (size_t i = 0; i < num_chunks; ++i) {
+      layout.m_uncompressed_sizes[i] = get<uint64_t>(ptr);
+      layout.m_compressed_sizes[i] = get<uint64_t>(ptr);
+    }
+    layout.m_chunk_codecs.assign(ptr, ptr + num_chunks);
+    for (const uint8_t codec : layout.m_chunk_codecs) {
+      if (codec >= num_codecs) {
+        throw std::runtime_error("Invalid codec index in mixed batch.");
+      }
+    }
+    return layout;
+  }
+
+private:
+  static size_t align(const size_t offset)
+  {
+    return (offset + MIXED_BATCH_ALIGNMENT - 1) / MIXED_BATCH_ALIGNMENT
+           * MIXED_BATCH_ALIGNMENT;
+  }
+
+  template <typename T>
+  static uint8_t* put(uint8_t* const ptr, const T value)
+  {
+    std::memcpy(ptr, &value, sizeof(T));
+    return ptr + sizeof(T);
+  }
+
+  template <typename T>
+  static T get(const uint8_t*& ptr)
+  {
+    T value;
+    std::memcpy(&value, ptr, sizeof(T));
+    ptr += sizeof(T);
+    return value;
+  }
+
+  std::vector<std::string> m_codecs;
+  std::vector<uint8_t> m_chunk_codecs;
+  std::vector<size_t> m_uncompressed_sizes;
+  std::vector<size_t> m_compressed_sizes;
+};
+
+// Build the layout for a batch with the given codec key per chunk. The
+// compressed sizes are left at zero, to be filled in after compression.
+inline MixedBatchLayout make_mixed_layout(
+    const std::vector<std::string>& chunk_codecs,
+    const std::vector<size_t>& uncompressed_sizes)
+{
+  MixedBatchLayout layout;
+  for (size_t i = 0; i < chunk_codecs.size(); ++i) {
+    layout.add_chunk(layout.add_codec(chunk_codecs[i]), uncompressed_sizes[i]);
+  }
+  return layout;
+}
+
+} // namespace host
+} // namespace nvcomp
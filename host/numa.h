@@ -0,0 +1,558 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+namespace nvcomp
+{
+namespace host
+{
+
+/**
+ * @brief The NUMA nodes of the machine and the CPUs of each that this
+ * process may run on.
+ *
+ * Nodes without usable CPUs (e.g. memory-only nodes, or nodes excluded by
+ * the affinity mask of a container) are left out. Without NUMA information
+ * the machine is one node, whose CPU list is empty, meaning any CPU.
+ */
+struct NumaTopology
+{
+  std::vector<int> node_ids;
+  std::vector<std::vector<int>> node_cpus;
+
+  NumaTopology() : node_ids(), node_cpus()
+  {
+  }
+
+  size_t num_nodes() const
+  {
+    return node_cpus.size();
+  }
+};
+
+// Parse a sysfs CPU list, such as "0-3,8-11".
+inline std::vector<int> parse_cpu_list(const std::string& text)
+{
+  std::vector<int> cpus;
+  std::istringstream list(text);
+  std::string range;
+  while (std::getline(list, range, ',')) {
+    if (range.empty() || range == "\n") {
+      continue;
+    }
+    const size_t dash = range.find('-');
+    const int first = atoi(range.substr(0, dash).c_str());
+    const int last = dash == std::string::npos
+                         ? first
+                         : atoi(range.substr(dash + 1).c_str());
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+inline NumaTopology single_node_topology()
+{
+  NumaTopology topology;
+  topology.node_ids.push_back(0);
+  topology.node_cpus.push_back(std::vector<int>());
+  return topology;
+}
+
+inline NumaTopology detect_numa_topology()
+{
+#ifdef __linux__
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  const bool have_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+  std::vector<int> ids;
+  const char* const node_dir = "/sys/devices/system/node";
+  if (DIR* const dir = opendir(node_dir)) {
+    while (const dirent* const entry = readdir(dir)) {
+      const char* const name = entry->d_name;
+      if (std::strncmp(name, "node", 4) == 0 && name[4] >= '0'
+          && name[4] <= '9') {
+        ids.push_back(atoi(name + 4));
+      }
+    }
+    closedir(dir);
+  }
+  std::sort(ids.begin(), ids.end());
+
+  NumaTopology topology;
+  for (const int id : ids) {
+    std::ifstream fin(
+        std::string(node_dir) + "/node" + std::to_string(id) + "/cpulist");
+    std::string text;
+    if (!std::getline(fin, text)) {
+      continue;
+    }
+    std::vector<int> cpus;
+    for (const int cpu : parse_cpu_list(text)) {
+      if (!have_mask || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))) {
+        cpus.push_back(cpu);
+      }
+    }
+    if (!cpus.empty()) {
+      topology.node_ids.push_back(id);
+      topology.node_cpus.push_back(cpus);
+    }
+  }
+  if (topology.num_nodes() > 0) {
+    return topology;
+  }
+#endif
+  return single_node_topology();
+}
+
+// Restrict the calling thread to `cpus`. Returns false if that is not
+// supported or failed; an empty list is a no-op.
+inline bool pin_current_thread(const std::vector<int>& cpus)
+{
+  if (cpus.empty()) {
+    return true;
+  }
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (const int cpu : cpus) {
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+/**
+ * @brief Where chunk memory lives relative to the threads that process it.
+ *
+ * - None: chunks stay where the loading thread touched them and any worker
+ *   processes any chunk, as without NUMA support.
+ * - Local: the chunks are split into one contiguous range per node, each
+ *   first touched and processed by that node's pinned workers.
+ * - Interleave: slabs of consecutive chunks are assigned to the nodes
+ *   round-robin, and each is first touched and processed on its node.
+ */
+enum class NumaPolicy
+{
+  None,
+  Local,
+  Interleave
+};
+
+inline const char* numa_policy_name(const NumaPolicy policy)
+{
+  switch (policy) {
+  case NumaPolicy::None:
+    return "none";
+  case NumaPolicy::Local:
+    return "local";
+  case NumaPolicy::Interleave:
+    return "interleave";
+  }
+  return "unknown";
+}
+
+inline NumaPolicy numa_policy_from_name(const std::string& name)
+{
+  if (name == "none") {
+    return NumaPolicy::None;
+  } else if (name == "local") {
+    return NumaPolicy::Local;
+  } else if (name == "interleave") {
+    return NumaPolicy::Interleave;
+  }
+  throw std::runtime_error("Unknown NUMA policy \"" + name + "\".");
+}
+
+/**
+ * @brief One ThreadPool per NUMA node, whose workers are pinned to the
+ * node's CPUs, so that tasks only move between workers of the same node.
+ *
+ * With `pin` false the workers are not pinned, which gives the same thread
+ * layout without any placement, for comparison.
+ */
+class NumaThreadPool
+{
+public:
+  // A `threads_per_node` of 0 uses one worker per CPU of each node.
+  explicit NumaThreadPool(
+      const NumaTopology& topology = detect_numa_topology(),
+      const size_t threads_per_node = 0,
+      const bool pin = true) :
+      m_topology(topology),
+      m_pinned(pin),
+      m_pools()
+  {
+    m_pools.reserve(m_topology.num_nodes());
+    for (size_t node = 0; node < m_topology.num_nodes(); ++node) {
+      const std::vector<int>& cpus = m_topology.node_cpus[node];
+      size_t threads = threads_per_node;
+      if (threads == 0) {
+        threads = cpus.empty()
+                      ? std::max(1u, std::thread::hardware_concurrency())
+                      : cpus.size();
+      }
+      std::function<void(size_t)> on_start;
+      if (pin) {
+        std::atomic<bool>* const pinned = &m_pinned;
+        on_start = [cpus, pinned](size_t) {
+          if (!pin_current_thread(cpus)) {
+            *pinned = false;
+          }
+        };
+      }
+      m_pools.emplace_back(new ThreadPool(threads, on_start));
+    }
+  }
+
+  // disable copying
+  NumaThreadPool(const NumaThreadPool&) = delete;
+  NumaThreadPool& operator=(const NumaThreadPool&) = delete;
+
+  const NumaTopology& topology() const
+  {
+    return m_topology;
+  }
+
+  size_t num_nodes() const
+  {
+    return m_pools.size();
+  }
+
+  ThreadPool& node_pool(const size_t node)
+  {
+    return *m_pools[node];
+  }
+
+  // Whether all workers that started so far were pinned successfully.
+  bool pinned() const
+  {
+    return m_pinned;
+  }
+
+  // Call `fn(i)` for every i in [0, n) on a worker of node `node_of(i)`
+  // and block until all calls returned. Unlike ThreadPool::parallel_for,
+  // the calling thread does not participate, as it may run on any node. The
+  // first exception thrown by `fn` is rethrown here.
+  template <typename G, typename F>
+  void parallel_for(const size_t n, G node_of, F fn)
+  {
+    if (n == 0) {
+      return;
+    }
+
+    struct LoopState
+    {
+      std::vector<std::vector<size_t>> items;
+      std::unique_ptr<std::atomic<size_t>[]> next;
+      std::atomic<size_t> done;
+      std::mutex mutex;
+      std::condition_variable cv;
+      std::exception_ptr error;
+
+      explicit LoopState(const size_t num_nodes) :
+          items(num_nodes),
+          next(new std::atomic<size_t>[num_nodes]),
+          done(0),
+          mutex(),
+          cv(),
+          error()
+      {
+      }
+    };
+    std::shared_ptr<LoopState> state
+        = std::make_shared<LoopState>(num_nodes());
+    for (size_t node = 0; node < num_nodes(); ++node) {
+      state->next[node] = 0;
+    }
+    for (size_t i = 0; i < n; ++i) {
+      state->items[node_of(i) % num_nodes()].push_back(i);
+    }
+
+    // As in ThreadPool::parallel_for, `fn` is only used while an index is
+    // unclaimed, so it does not outlive this frame.
+    for (size_t node = 0; node < num_nodes(); ++node) {
+      const size_t count = state->items[node].size();
+      std::function<void()> body = [state, node, count, n, &fn]() {
+        for (size_t k = state->next[node]++; k < count;
+             k = state->next[node]++) {
+          try {
+            fn(state->items[node][k]);
+          } catch (...) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!state->error) {
+              state->error = std::current_exception();
+            }
+          }
+          if (++state->done == n) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->cv.notify_all();
+          }
+        }
+      };
+      const size_t helpers = std::min(count, m_pools[node]->num_threads());
+      for (size_t h = 0; h < helpers; ++h) {
+        m_pools[node]->enqueue(body);
+      }
+    }
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&state, n]() { return state->done == n; });
+    if (state->error) {
+      std::rethrow_exception(state->error);
+    }
+  }
+
+private:
+  NumaTopology m_topology;
+  // Declared before the pools, whose workers write it.
+  std::atomic<bool> m_pinned;
+  std::vector<std::unique_ptr<ThreadPool>> m_pools;
+};
+
+namespace detail
+{
+
+/**
+ * @brief Memory whose pages are not touched on allocation, so that the
+ * first thread to write each page decides its node.
+ */
+class UntouchedBuffer
+{
+public:
+  explicit UntouchedBuffer(const size_t bytes) :
+      m_data(nullptr), m_bytes(std::max<size_t>(bytes, 1)), m_mapped(false)
+  {
+#ifdef __linux__
+    void* const ptr = mmap(
+        nullptr,
+        m_bytes,
+        PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS,
+        -1,
+        0);
+    if (ptr != MAP_FAILED) {
+      m_data = static_cast<uint8_t*>(ptr);
+      m_mapped = true;
+      return;
+    }
+#endif
+    m_data = new uint8_t[m_bytes];
+  }
+
+  ~UntouchedBuffer()
+  {
+#ifdef __linux__
+    if (m_mapped) {
+      munmap(m_data, m_bytes);
+      return;
+    }
+#endif
+    delete[] m_data;
+  }
+
+  // disable copying
+  UntouchedBuffer(const UntouchedBuffer&) = delete;
+  UntouchedBuffer& operator=(const UntouchedBuffer&) = delete;
+
+  uint8_t* data()
+  {
+    return m_data;
+  }
+
+private:
+  uint8_t* m_data;
+  size_t m_bytes;
+  bool m_mapped;
+};
+
+} // namespace detail
+
+/**
+ * @brief A batch of chunks placed on NUMA nodes according to a NumaPolicy.
+ *
+ * Each node's chunks are packed into their own buffer, which the node's
+ * pinned workers fill, so its pages are first touched, and thus allocated,
+ * on that node. Chunks are then processed with `pool.parallel_for(n,
+ * [&](size_t i) { return batch.node_of(i); }, ...)` to keep every chunk on
+ * the node that holds it. With NumaPolicy::None all chunks share one buffer
+ * filled by the calling thread, and are only spread over the nodes for
+ * processing.
+ */
+class NumaChunkBuffer
+{
+public:
+  NumaChunkBuffer(
+      NumaThreadPool& pool,
+      const std::vector<std::vector<char>>& chunks,
+      const NumaPolicy policy,
+      const size_t slab_chunks = 16) :
+      m_policy(policy),
+      m_nodes(chunks.size()),
+      m_ptrs(chunks.size()),
+      m_sizes(chunks.size()),
+      m_node_bytes(pool.num_nodes(), 0),
+      m_buffers()
+  {
+    const size_t n = chunks.size();
+    const size_t num_nodes = pool.num_nodes();
+    for (size_t i = 0; i < n; ++i) {
+      switch (policy) {
+      case NumaPolicy::Local:
+        m_nodes[i] = i * num_nodes / n;
+        break;
+      case NumaPolicy::Interleave:
+        m_nodes[i] = (i / std::max<size_t>(slab_chunks, 1)) % num_nodes;
+        break;
+      case NumaPolicy::None:
+        m_nodes[i] = i % num_nodes;
+        break;
+      }
+      m_sizes[i] = chunks[i].size();
+      m_node_bytes[m_nodes[i]] += chunks[i].size();
+    }
+
+    // Pack the chunks of each buffer at cache line aligned offsets.
+    const size_t num_buffers = policy == NumaPolicy::None ? 1 : num_nodes;
+    std::vector<size_t> buffer_bytes(num_buffers, 0);
+    std::vector<size_t> offsets(n);
+    for (size_t i = 0; i < n; ++i) {
+      const size_t b = num_buffers == 1 ? 0 : m_nodes[i];
+      offsets[i] = buffer_bytes[b];
+      buffer_bytes[b] = (buffer_bytes[b] + m_sizes[i] + 63) / 64 * 64;
+    }
+    for (size_t b = 0; b < num_buffers; ++b) {
+      m_buffers.emplace_back(new detail::UntouchedBuffer(buffer_bytes[b]));
+    }
+    for (size_t i = 0; i < n; ++i) {
+      const size_t b = num_buffers == 1 ? 0 : m_nodes[i];
+      m_ptrs[i] = m_buffers[b]->data() + offsets[i];
+    }
+
+    if (policy == NumaPolicy::None) {
+      for (size_t i = 0; i < n; ++i) {
+        copy_chunk(chunks, i);
+      }
+    } else {
+      pool.parallel_for(
+          n,
+          [this](const size_t i) { return m_nodes[i]; },
+          [this, &chunks](const size_t i) { copy_chunk(chunks, i); });
+    }
+  }
+
+  // disable copying
+  NumaChunkBuffer(const NumaChunkBuffer&) = delete;
+  NumaChunkBuffer& operator=(const NumaChunkBuffer&) = delete;
+
+  NumaPolicy policy() const
+  {
+    return m_policy;
+  }
+
+  size_t size() const
+  {
+    return m_ptrs.size();
+  }
+
+  const uint8_t* data(const size_t i) const
+  {
+    return m_ptrs[i];
+  }
+
+  uint8_t* data(const size_t i)
+  {
+    return m_ptrs[i];
+  }
+
+  size_t chunk_bytes(const size_t i) const
+  {
+    return m_sizes[i];
+  }
+
+  // The node whose workers should process chunk `i`.
+  size_t node_of(const size_t i) const
+  {
+    return m_nodes[i];
+  }
+
+  // Total bytes of the chunks assigned to `node`.
+  size_t node_bytes(const size_t node) const
+  {
+    return m_node_bytes[node];
+  }
+
+private:
+  void copy_chunk(const std::vector<std::vector<char>>& chunks, const size_t i)
+  {
+    if (m_sizes[i] > 0) {
+      std::memcpy(m_ptrs[i], chunks[i].data(), m_sizes[i]);
+    }
+  }
+
+  NumaPolicy m_policy;
+  std::vector<size_t> m_nodes;
+  std::vector<uint8_t*> m_ptrs;
+  std::vector<size_t> m_sizes;
+  std::vector<size_t> m_node_bytes;
+  std::vector<std::unique_ptr<detail::UntouchedBuffer>> m_buffers;
+};
+
+} // namespace host
+} // namespace nvcomp
@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace nvcomp
+{
+namespace host
+{
+
+enum class PerfCounterId
+{
+  Cycles = 0,
+  Instructions = 1,
+  LLCMisses = 2,
+  BranchMisses = 3
+};
+
+static constexpr size_t NUM_PERF_COUNTERS = 4;
+
+inline const char* perf_counter_name(const PerfCounterId id)
+{
+  switch (id) {
+  case PerfCounterId::Cycles:
+    return "cycles";
+  case PerfCounterId::Instructions:
+    return "instructions";
+  case PerfCounterId::LLCMisses:
+    return "LLC misses";
+  case PerfCounterId::BranchMisses:
+    return "branch misses";
+  }
+  return "unknown";
+}
+
+/**
+ * @brief Counter values over one measured region. A counter that could not
+ * be opened is marked unavailable, and its value is 0.
+ */
+struct PerfSample
+{
+  uint64_t values[NUM_PERF_COUNTERS];
+  bool available[NUM_PERF_COUNTERS];
+
+  PerfSample()
+  {
+    for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+      values[i] = 0;
+      available[i] = false;
+    }
+  }
+
+  bool has(const PerfCounterId id) const
+  {
+    return available[static_cast<size_t>(id)];
+  }
+
+  uint64_t get(const PerfCounterId id) const
+  {
+    return values[static_cast<size_t>(id)];
+  }
+
+  // Instructions per cycle, or 0 if either counter is unavailable.
+  double ipc() const
+  {
+    if (!has(PerfCounterId::Cycles) || !has(PerfCounterId::Instructions)
+        || get(PerfCounterId::Cycles) == 0) {
+      return 0.0;
+    }
+    return static_cast<double>(get(PerfCounterId::Instructions))
+           / get(PerfCounterId::Cycles);
+  }
+
+  // Bytes processed per cycle, or 0 if cycles are unavailable.
+  double bytes_per_cycle(const size_t bytes) const
+  {
+    if (!has(PerfCounterId::Cycles) || get(PerfCounterId::Cycles) == 0) {
+      return 0.0;
+    }
+    return static_cast<double>(bytes) / get(PerfCounterId::Cycles);
+  }
+
+  // Events of counter `id` per kB processed, or 0 if it is unavailable.
+  double per_kb(const PerfCounterId id, const size_t bytes) const
+  {
+    if (!has(id) || bytes == 0) {
+      return 0.0;
+    }
+    return 1024.0 * get(id) / bytes;
+  }
+
+  PerfSample& operator+=(const PerfSample& other)
+  {
+    for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+      values[i] += other.values[i];
+      available[i] = available[i] && other.available[i];
+    }
+    return *this;
+  }
+};
+
+/**
+ * @brief Hardware counters for the calling thread, read with
+ * perf_event_open.
+ *
+ * Each counter is opened on its own, user space only, so that a counter the
+ * CPU, the kernel or the container does not allow just reads as unavailable
+ * while the others still work. When the kernel multiplexes counters, values
+ * are scaled by the fraction of the region each was running. On other
+ * platforms every counter is unavailable.
+ *
+ * Only work done by the thread that created the object is counted.
+ */
+class PerfCounters
+{
+public:
+  PerfCounters() : m_error()
+  {
+    for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+      m_fds[i] = -1;
+    }
+#ifdef __linux__
+    static const uint64_t configs[NUM_PERF_COUNTERS]
+        = {PERF_COUNT_HW_CPU_CYCLES,
+           PERF_COUNT_HW_INSTRUCTIONS,
+           PERF_COUNT_HW_CACHE_MISSES,
+           PERF_COUNT_HW_BRANCH_MISSES};
+    for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = configs[i];
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format
+          = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      const long fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+      if (fd < 0) {
+        if (m_error.empty()) {
+          m_error = std::string("perf_event_open failed for ")
+                    + perf_counter_name(static_cast<PerfCounterId>(i))
+                    + ": " + std::strerror(errno);
+        }
+        continue;
+      }
+      m_fds[i] = static_cast<int>(fd);
+    }
+#else
+    m_error = "hardware counters are only supported on Linux";
+#endif
+  }
+
+  ~PerfCounters()
+  {
+#ifdef __linux__
+    for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+      if (m_fds[i] >= 0) {
+        close(m_fds[i]);
+      }
+    }
+#endif
+  }
+
+  // disable copying
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  // Whether any counter could be opened.
+  bool available() const
+  {
+    for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+      if (m_fds[i] >= 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Why the first unavailable counter could not be opened, or empty.
+  const std::string& error() const
+  {
+    return m_error;
+  }
+
+  void start()
+  {
+#ifdef __linux__
+    for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+      if (m_fds[i] >= 0) {
+        ioctl(m_fds[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(m_fds[i], PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+#endif
+  }
+
+  PerfSample stop()
+  {
+    PerfSample sample;
+#ifdef __linux__
+    for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+      if (m_fds[i] >= 0) {
+        ioctl(m_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+      }
+    }
+    for (size_t i = 0; i < NUM_PERF_COUNTERS; ++i) {
+      // value, time enabled, time running
+      uint64_t data[3] = {0, 0, 0};
+      if (m_fds[i] < 0 || read(m_fds[i], data, sizeof(data))
+                              != static_cast<ssize_t>(sizeof(data))) {
+        continue;
+      }
+      // A counter that never got scheduled has no meaningful value.
+      if (data[2] == 0) {
+        continue;
+      }
+      sample.values[i] = data[2] < data[1]
+                             ? static_cast<uint64_t>(
+                                 static_cast<double>(data[0]) * data[1]
+                                 / data[2])
+                             : data[0];
+      sample.available[i] = true;
+    }
+#endif
+    return sample;
+  }
+
+private:
+  int m_fds[NUM_PERF_COUNTERS];
+  std::string m_error;
+};
+
+/**
+ * @brief Print the available counters of a region that processed `bytes`
+ * as one "<phase> IPC: ..." line, in the style of the example output.
+ * Nothing is printed if no counter was available.
+ */
+inline void print_perf_sample(
+    std::ostream& out,
+    const char* const phase,
+    const PerfSample& sample,
+    const size_t bytes)
+{
+  bool first = true;
+  const auto field = [&](const char* const name, const double value) {
+    out << (first ? std::string(phase) + " " : std::string(", ")) << name
+        << ": " << value;
+    first = false;
+  };
+  if (sample.has(PerfCounterId::Cycles)
+      && sample.has(PerfCounterId::Instructions)) {
+    field("IPC", sample.ipc());
+  }
+  if (sample.has(PerfCounterId::Cycles)) {
+    field("bytes per cycle", sample.bytes_per_cycle(bytes));
+  }
+  if (sample.has(PerfCounterId::LLCMisses)) {
+    field(
+        "LLC misses per kB", sample.per_kb(PerfCounterId::LLCMisses, bytes));
+  }
+  if (sample.has(PerfCounterId::BranchMisses)) {
+    field(
+        "branch misses per kB",
+        sample.per_kb(PerfCounterId::BranchMisses, bytes));
+  }
+  if (!first) {
+    out << std::endl;
+  }
+}
+
+} // namespace host
+} // namespace nvcomp
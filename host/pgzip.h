@@ -0,0 +1,385 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/checksum.h"
+#include "host/thread_pool.h"
+#include "nvcomp/shared_types.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+
+namespace nvcomp
+{
+namespace host
+{
+
+// Options of the parallel gzip writer.
+struct PgzipOptions
+{
+  // zlib compression level, 0 to 9.
+  int level;
+  // Uncompressed bytes per member, or per block with `prime`.
+  size_t chunk_size;
+  // Write a single gzip member whose blocks are each compressed with the
+  // last 32 KB of the previous block's input as a dictionary, as pigz does.
+  // This compresses better, but the blocks can only be decoded in order.
+  bool prime;
+};
+
+constexpr PgzipOptions PgzipDefaultOpts = {6, 1 << 16, false};
+
+// One member of the output, or one block of the single member with
+// `prime`, and the range of the input it holds.
+struct PgzipEntry
+{
+  uint64_t compressed_offset;
+  uint64_t compressed_bytes;
+  uint64_t uncompressed_offset;
+  uint64_t uncompressed_bytes;
+  uint32_t crc;
+  uint32_t reserved;
+};
+
+static_assert(sizeof(PgzipEntry) == 40, "Entry must be 40 B");
+
+// Side index of a file written by pgzip_compress().
+struct PgzipIndex
+{
+  // Whether every entry is a gzip member of its own.
+  bool independent;
+  // CRC-32 of the whole input, combined from the CRCs of the entries.
+  uint32_t crc;
+  uint64_t uncompressed_bytes;
+  std::vector<PgzipEntry> entries;
+
+  PgzipIndex() : independent(true), crc(0), uncompressed_bytes(0), entries()
+  {
+  }
+};
+
+namespace detail
+{
+
+static constexpr size_t PGZIP_WINDOW = 32 * 1024;
+static constexpr size_t PGZIP_HEADER_BYTES = 10;
+static constexpr char PGZIP_INDEX_MAGIC[8]
+    = {'N', 'V', 'P', 'G', 'Z', 'I', 'X', '1'};
+
+// Header of an index file, followed by its entries.
+struct PgzipIndexHeader
+{
+  char magic[8];
+  uint32_t flags;
+  uint32_t crc;
+  uint64_t uncompressed_bytes;
+  uint64_t num_entries;
+};
+
+static_assert(sizeof(PgzipIndexHeader) == 32, "Header must be 32 B");
+
+// Compress one chunk, as a whole gzip member, or with `raw` as raw deflate
+// blocks primed with `dictionary` and ending on a byte boundary unless
+// `last`, so that the blocks of all chunks can be concatenated.
+inline std::vector<uint8_t> pgzip_deflate(
+    const uint8_t* const in,
+    const size_t bytes,
+    const int level,
+    const bool raw,
+    const uint8_t* const dictionary,
+    const size_t dictionary_bytes,
+    const bool last)
+{
+  z_stream zs;
+  std::memset(&zs, 0, sizeof(zs));
+  if (deflateInit2(
+          &zs, level, Z_DEFLATED, raw ? -15 : 15 | 16, 8, Z_DEFAULT_STRATEGY)
+      != Z_OK) {
+    throw std::runtime_error("deflateInit2() failed.");
+  }
+  if (dictionary_bytes > 0
+      && deflateSetDictionary(
+             &zs, dictionary, static_cast<uInt>(dictionary_bytes))
+             != Z_OK) {
+    deflateEnd(&zs);
+    throw std::runtime_error("deflateSetDictionary() failed.");
+  }
+  // Room for the empty stored block of a sync flush, too.
+  std::vector<uint8_t> out(deflateBound(&zs, static_cast<uLong>(bytes)) + 16);
+  zs.next_in = const_cast<Bytef*>(in);
+  zs.avail_in = static_cast<uInt>(bytes);
+  zs.next_out = out.data();
+  zs.avail_out = static_cast<uInt>(out.size());
+  const int ret = deflate(&zs, last ? Z_FINISH : Z_SYNC_FLUSH);
+  const bool ok = last ? ret == Z_STREAM_END : ret == Z_OK && zs.avail_in == 0;
+  out.resize(zs.total_out);
+  deflateEnd(&zs);
+  if (!ok) {
+    throw std::runtime_error("Deflate compression failed.");
+  }
+  return out;
+}
+
+inline void pgzip_put32(std::vector<uint8_t>& out, const uint32_t value)
+{
+  for (int i = 0; i < 4; ++i) {
+    out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+} // namespace detail
+
+/**
+ * @brief Gzip `bytes` of `in`, compressing chunks of `options.chunk_size` in
+ * parallel on `pool`, and fill `index`, if given, with where each chunk
+ * went.
+ *
+ * By default every chunk is a gzip member of its own, and the output is
+ * their concatenation, which gzip and zlib read as one file, and which the
+ * batched gzip decompressors can take member by member. With
+ * `options.prime`, the output is one member, as with pigz.
+ */
+inline std::vector<uint8_t> pgzip_compress(
+    ThreadPool& pool,
+    const void* const in,
+    const size_t bytes,
+    const PgzipOptions& options = PgzipDefaultOpts,
+    PgzipIndex* const index = nullptr)
+{
+  if (options.chunk_size == 0 || options.chunk_size > UINT32_MAX / 2) {
+    throw std::runtime_error("Invalid gzip chunk size.");
+  }
+  const uint8_t* const src = static_cast<const uint8_t*>(in);
+  const size_t chunk_size = options.chunk_size;
+  // An empty input still needs one (empty) member.
+  const size_t num_chunks
+      = std::max<size_t>(1, (bytes + chunk_size - 1) / chunk_size);
+
+  std::vector<std::vector<uint8_t>> pieces(num_chunks);
+  std::vector<uint32_t> crcs(num_chunks);
+  pool.parallel_for(num_chunks, [&](const size_t c) {
+    const size_t offset = c * chunk_size;
+    const size_t chunk_bytes = std::min(chunk_size, bytes - offset);
+    const size_t dictionary_bytes
+        = options.prime ? std::min(offset, detail::PGZIP_WINDOW) : 0;
+    pieces[c] = detail::pgzip_deflate(
+        src + offset,
+        chunk_bytes,
+        options.level,
+        options.prime,
+        src + offset - dictionary_bytes,
+        dictionary_bytes,
+        !options.prime || c + 1 == num_chunks);
+    crcs[c] = crc32(src + offset, chunk_bytes);
+  });
+
+  PgzipIndex local_index;
+  PgzipIndex& idx = index != nullptr ? *index : local_index;
+  idx.independent = !options.prime;
+  idx.uncompressed_bytes = bytes;
+  idx.entries.assign(num_chunks, PgzipEntry());
+
+  size_t out_bytes = detail::PGZIP_HEADER_BYTES + 8;
+  for (const std::vector<uint8_t>& piece : pieces) {
+    out_bytes += piece.size();
+  }
+  std::vector<uint8_t> out;
+  out.reserve(out_bytes);
+  if (options.prime) {
+    // The header of a member with no name, time or extra fields.
+    const uint8_t header[detail::PGZIP_HEADER_BYTES]
+        = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 255};
+    out.insert(out.end(), header, header + sizeof(header));
+  }
+  uint32_t crc = 0;
+  for (size_t c = 0; c < num_chunks; ++c) {
+    const size_t offset = c * chunk_size;
+    const size_t chunk_bytes = std::min(chunk_size, bytes - offset);
+    PgzipEntry& entry = idx.entries[c];
+    entry.compressed_offset = out.size();
+    entry.compressed_bytes = pieces[c].size();
+    entry.uncompressed_offset = offset;
+    entry.uncompressed_bytes = chunk_bytes;
+    entry.crc = crcs[c];
+    crc = static_cast<uint32_t>(
+        ::crc32_combine(crc, crcs[c], static_cast<z_off_t>(chunk_bytes)));
+    out.insert(out.end(), pieces[c].begin(), pieces[c].end());
+    std::vector<uint8_t>().swap(pieces[c]);
+  }
+  if (options.prime) {
+    detail::pgzip_put32(out, crc);
+    detail::pgzip_put32(out, static_cast<uint32_t>(bytes));
+  }
+  idx.crc = crc;
+  return out;
+}
+
+/**
+ * @brief Decompress a file written by pgzip_compress() into `out`, which
+ * must hold `index.uncompressed_bytes`.
+ *
+ * Independent members are inflated in parallel, each checked against its
+ * CRC, and a primed member is inflated on the calling thread. Returns
+ * nvcompErrorCannotDecompress if the data doesn't match the index.
+ */
+inline nvcompStatus_t pgzip_decompress(
+    ThreadPool& pool,
+    const void* const in,
+    const size_t in_bytes,
+    const PgzipIndex& index,
+    void* const out,
+    const size_t out_capacity)
+{
+  const uint8_t* const src = static_cast<const uint8_t*>(in);
+  // zlib refuses a null output even when there is nothing to write.
+  uint8_t empty = 0;
+  uint8_t* const dst = out != nullptr ? static_cast<uint8_t*>(out) : &empty;
+  if (index.uncompressed_bytes > out_capacity) {
+    return nvcompErrorCannotDecompress;
+  }
+  for (const PgzipEntry& entry : index.entries) {
+    if (entry.compressed_offset > in_bytes
+        || entry.compressed_bytes > in_bytes - entry.compressed_offset
+        || entry.uncompressed_offset > index.uncompressed_bytes
+        || entry.uncompressed_bytes
+               > index.uncompressed_bytes - entry.uncompressed_offset) {
+      return nvcompErrorCannotDecompress;
+    }
+  }
+
+  if (!index.independent) {
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, 15 | 16) != Z_OK) {
+      return nvcompErrorInternal;
+    }
+    zs.next_in = const_cast<Bytef*>(src);
+    zs.avail_in = static_cast<uInt>(
+        std::min<size_t>(in_bytes, std::numeric_limits<uInt>::max()));
+    zs.next_out = dst;
+    zs.avail_out = static_cast<uInt>(std::min<size_t>(
+        index.uncompressed_bytes, std::numeric_limits<uInt>::max()));
+    const int ret = inflate(&zs, Z_FINISH);
+    const bool ok
+        = ret == Z_STREAM_END && zs.total_out == index.uncompressed_bytes;
+    inflateEnd(&zs);
+    return ok ? nvcompSuccess : nvcompErrorCannotDecompress;
+  }
+
+  std::atomic<bool> ok(true);
+  pool.parallel_for(index.entries.size(), [&](const size_t e) {
+    const PgzipEntry& entry = index.entries[e];
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, 15 | 16) != Z_OK) {
+      ok = false;
+      return;
+    }
+    zs.next_in = const_cast<Bytef*>(src + entry.compressed_offset);
+    zs.avail_in = static_cast<uInt>(entry.compressed_bytes);
+    zs.next_out = dst + entry.uncompressed_offset;
+    zs.avail_out = static_cast<uInt>(entry.uncompressed_bytes);
+    // The trailer of every member is checked by zlib.
+    const int ret = inflate(&zs, Z_FINISH);
+    if (ret != Z_STREAM_END || zs.total_out != entry.uncompressed_bytes) {
+      ok = false;
+    }
+    inflateEnd(&zs);
+  });
+  return ok ? nvcompSuccess : nvcompErrorCannotDecompress;
+}
+
+// Write `index` to the side file `filename`, e.g. "data.gz.idx".
+inline void write_pgzip_index(
+    const std::string& filename, const PgzipIndex& index)
+{
+  detail::PgzipIndexHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, detail::PGZIP_INDEX_MAGIC, sizeof(header.magic));
+  header.flags = index.independent ? 1 : 0;
+  header.crc = index.crc;
+  header.uncompressed_bytes = index.uncompressed_bytes;
+  header.num_entries = index.entries.size();
+
+  std::ofstream fout(filename, std::ofstream::binary);
+  fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  fout.write(
+      reinterpret_cast<const char*>(index.entries.data()),
+      index.entries.size() * sizeof(PgzipEntry));
+  if (!fout) {
+    throw std::runtime_error("Error writing gzip index " + filename + ".");
+  }
+}
+
+// Read an index written by write_pgzip_index().
+inline PgzipIndex read_pgzip_index(const std::string& filename)
+{
+  std::ifstream fin(filename, std::ifstream::binary);
+  detail::PgzipIndexHeader header;
+  fin.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!fin
+      || std::memcmp(
+             header.magic, detail::PGZIP_INDEX_MAGIC, sizeof(header.magic))
+             != 0
+      || header.flags > 1) {
+    throw std::runtime_error("Invalid gzip index " + filename + ".");
+  }
+  fin.seekg(0, std::ios_base::end);
+  const uint64_t file_bytes = static_cast<uint64_t>(fin.tellg());
+  if ((file_bytes - sizeof(header)) / sizeof(PgzipEntry)
+      != header.num_entries) {
+    throw std::runtime_error("Truncated gzip index " + filename + ".");
+  }
+  fin.seekg(sizeof(header), std::ios_base::beg);
+
+  PgzipIndex index;
+  index.independent = header.flags == 1;
+  index.crc = header.crc;
+  index.uncompressed_bytes = header.uncompressed_bytes;
+  index.entries.resize(header.num_entries);
+  fin.read(
+      reinterpret_cast<char*>(index.entries.data()),
+      index.entries.size() * sizeof(PgzipEntry));
+  if (!fin) {
+    throw std::runtime_error("Error reading gzip index " + filename + ".");
+  }
+  return index;
+}
+
+} // namespace host
+} // namespace nvcomp
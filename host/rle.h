@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace nvcomp
+{
+namespace host
+{
+
+namespace detail
+{
+
+inline int rle_trailing_zeros(const unsigned mask)
+{
+#if defined(__GNUC__)
+  return __builtin_ctz(mask);
+#else
+  int n = 0;
+  while ((mask >> n & 1) == 0) {
+    ++n;
+  }
+  return n;
+#endif
+}
+
+inline int rle_popcount(unsigned mask)
+{
+#if defined(__GNUC__)
+  return __builtin_popcount(mask);
+#else
+  int n = 0;
+  for (; mask != 0; mask &= mask - 1) {
+    ++n;
+  }
+  return n;
+#endif
+}
+
+#if defined(__SSE2__)
+// Compare masks over 128-bit vectors of SIZE-byte values. differ(p) has bit
+// k set when p[k] != p[k + 1], for every lane k, so it reads one value past
+// the vector. fill(v) broadcasts v to every lane.
+template <size_t SIZE>
+struct RleLanes;
+
+template <>
+struct RleLanes<1>
+{
+  static unsigned differ(const uint8_t* const p)
+  {
+    const __m128i eq = _mm_cmpeq_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1)));
+    return ~static_cast<unsigned>(_mm_movemask_epi8(eq)) & 0xFFFF;
+  }
+  static __m128i fill(const uint8_t v)
+  {
+    return _mm_set1_epi8(static_cast<char>(v));
+  }
+};
+
+template <>
+struct RleLanes<2>
+{
+  static unsigned differ(const uint16_t* const p)
+  {
+    const __m128i eq = _mm_cmpeq_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1)));
+    const __m128i bytes = _mm_packs_epi16(eq, eq);
+    return ~static_cast<unsigned>(_mm_movemask_epi8(bytes)) & 0xFF;
+  }
+  static __m128i fill(const uint16_t v)
+  {
+    return _mm_set1_epi16(static_cast<short>(v));
+  }
+};
+
+template <>
+struct RleLanes<4>
+{
+  static unsigned differ(const uint32_t* const p)
+  {
+    const __m128i eq = _mm_cmpeq_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1)));
+    return ~static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(eq)))
+           & 0xF;
+  }
+  static __m128i fill(const uint32_t v)
+  {
+    return _mm_set1_epi32(static_cast<int>(v));
+  }
+};
+
+template <>
+struct RleLanes<8>
+{
+  static unsigned differ(const uint64_t* const p)
+  {
+    // SSE2 has no 64-bit compare: both 32-bit halves must match.
+    const __m128i eq32 = _mm_cmpeq_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1)));
+    const __m128i eq = _mm_and_si128(eq32, _mm_shuffle_epi32(eq32, 0xB1));
+    return ~static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(eq)))
+           & 0x3;
+  }
+  static __m128i fill(const uint64_t v)
+  {
+    return _mm_set1_epi64x(static_cast<long long>(v));
+  }
+};
+#endif
+
+} // namespace detail
+
+/**
+ * @brief Number of runs of equal consecutive values in `in`.
+ *
+ * This is one compare per vector of values and touches no output, so it is
+ * a cheap way to tell in advance whether run-length encoding will help.
+ */
+template <typename T>
+size_t rle_count_runs(const T* const in, const size_t n)
+{
+  static_assert(std::is_integral<T>::value, "RLE needs integers.");
+  typedef typename std::make_unsigned<T>::type U;
+  const U* const src = reinterpret_cast<const U*>(in);
+  if (n == 0) {
+    return 0;
+  }
+  size_t runs = 1;
+  size_t i = 0;
+#if defined(__SSE2__)
+  constexpr size_t LANES = 16 / sizeof(U);
+  for (; i + LANES < n; i += LANES) {
+    runs += detail::rle_popcount(detail::RleLanes<sizeof(U)>::differ(src + i));
+  }
+#endif
+  for (; i + 1 < n; ++i) {
+    runs += src[i] != src[i + 1];
+  }
+  return runs;
+}
+
+/**
+ * @brief Split `in` into runs of equal values, writing the value of each
+ * run to `values` and its length to `lengths`, and return the number of
+ * runs.
+ *
+ * Both outputs must hold rle_count_runs(in, n) entries (at most `n`). The
+ * run boundaries are found a vector at a time from compare masks, so long
+ * runs cost one compare per vector and short ones one step per boundary.
+ */
+template <typename T, typename L>
+size_t rle_encode(
+    const T* const in, const size_t n, T* const values, L* const lengths)
+{
+  static_assert(std::is_integral<T>::value, "RLE needs integers.");
+  typedef typename std::make_unsigned<T>::type U;
+  const U* const src = reinterpret_cast<const U*>(in);
+  if (n == 0) {
+    return 0;
+  }
+  size_t runs = 0;
+  size_t start = 0;
+  size_t i = 0;
+#if defined(__SSE2__)
+  constexpr size_t LANES = 16 / sizeof(U);
+  for (; i + LANES < n; i += LANES) {
+    unsigned mask = detail::RleLanes<sizeof(U)>::differ(src + i);
+    while (mask != 0) {
+      const size_t end = i + detail::rle_trailing_zeros(mask);
+      mask &= mask - 1;
+      values[runs] = in[end];
+      lengths[runs] = static_cast<L>(end + 1 - start);
+      ++runs;
+      start = end + 1;
+    }
+  }
+#endif
+  for (; i + 1 < n; ++i) {
+    if (src[i] != src[i + 1]) {
+      values[runs] = in[i];
+      lengths[runs] = static_cast<L>(i + 1 - start);
+      ++runs;
+      start = i + 1;
+    }
+  }
+  values[runs] = in[n - 1];
+  lengths[runs] = static_cast<L>(n - start);
+  return runs + 1;
+}
+
+/**
+ * @brief Write `num_runs` runs back out to the `n` values at `out`.
+ *
+ * Returns false, with `out` partly written, unless the lengths add up to
+ * exactly `n`. Runs are filled with broadcast vector stores; a store may run
+ * past the end of its run, as long as it stays within `out`, since the next
+ * runs overwrite it.
+ */
+template <typename T, typename L>
+bool rle_decode(
+    const T* const values,
+    const L* const lengths,
+    const size_t num_runs,
+    T* const out,
+    const size_t n)
+{
+  static_assert(std::is_integral<T>::value, "RLE needs integers.");
+  typedef typename std::make_unsigned<T>::type U;
+  U* const dst = reinterpret_cast<U*>(out);
+  size_t pos = 0;
+  for (size_t r = 0; r < num_runs; ++r) {
+    const uint64_t length = lengths[r];
+    if (length > n - pos) {
+      return false;
+    }
+    const U value = static_cast<U>(values[r]);
+#if defined(__SSE2__)
+    constexpr size_t LANES = 16 / sizeof(U);
+    if (n - pos >= LANES) {
+      const __m128i fill = detail::RleLanes<sizeof(U)>::fill(value);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + pos), fill);
+      for (size_t k = LANES; k < length; k += LANES) {
+        // The last store is moved back to end with the run.
+        const size_t at = pos + (k + LANES <= length ? k : length - LANES);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + at), fill);
+      }
+      pos += length;
+      continue;
+    }
+#endif
+    for (size_t k = 0; k < length; ++k) {
+      dst[pos + k] = value;
+    }
+    pos += length;
+  }
+  return pos == n;
+}
+
+} // namespace host
+} // namespace nvcomp
@@ -0,0 +1,567 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NVCOMP_HOST_SHUFFLE_X86
+#include <immintrin.h>
+#endif
+
+namespace nvcomp
+{
+namespace host
+{
+
+/**
+ * @brief Reversible transforms that regroup typed data so that byte codecs
+ * see the similar bytes of neighbouring elements next to each other.
+ *
+ * - None: the data is passed through unchanged.
+ * - Byte: byte j of every element is gathered into plane j, so the planes
+ *   of the high-order bytes of small integers become long runs.
+ * - Bit: the bytes are shuffled as above, and then bit b of each byte of a
+ *   plane is gathered into a row of its own.
+ *
+ * Both shuffles keep the size of the data. Bytes past the last whole
+ * element, and for the bit shuffle past the last whole group of 8
+ * elements, are appended unchanged.
+ */
+enum class ShuffleFilter
+{
+  None,
+  Byte,
+  Bit
+};
+
+inline const char* shuffle_filter_name(const ShuffleFilter filter)
+{
+  switch (filter) {
+  case ShuffleFilter::None:
+    return "none";
+  case ShuffleFilter::Byte:
+    return "byte";
+  case ShuffleFilter::Bit:
+    return "bit";
+  }
+  return "unknown";
+}
+
+inline ShuffleFilter shuffle_filter_from_name(const std::string& name)
+{
+  if (name == "none") {
+    return ShuffleFilter::None;
+  } else if (name == "byte") {
+    return ShuffleFilter::Byte;
+  } else if (name == "bit") {
+    return ShuffleFilter::Bit;
+  }
+  throw std::runtime_error("Unknown shuffle filter \"" + name + "\".");
+}
+
+namespace detail
+{
+
+#ifdef NVCOMP_HOST_SHUFFLE_X86
+
+// Whether the AVX2 kernels below can run, detected once.
+inline bool shuffle_use_avx2()
+{
+  static const bool supported = __builtin_cpu_supports("avx2");
+  return supported;
+}
+
+// Each kernel handles a block of 32 elements (16 for 8-byte elements), and
+// returns the number of elements done, leaving the rest to the scalar loop.
+
+__attribute__((target("avx2"))) inline size_t
+byte_shuffle_avx2(const uint8_t* in, uint8_t* out, size_t n, size_t width)
+{
+  size_t i = 0;
+  if (width == 2) {
+    // Within each 128-bit lane: the 8 low bytes, then the 8 high bytes.
+    const __m256i gather = _mm256_setr_epi8(
+        0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+        0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+    for (; i + 32 <= n; i += 32) {
+      const uint8_t* src = in + 2 * i;
+      __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+      __m256i b
+          = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 32));
+      a = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(a, gather), 0xD8);
+      b = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(b, gather), 0xD8);
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i*>(out + i),
+          _mm256_permute2x128_si256(a, b, 0x20));
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i*>(out + n + i),
+          _mm256_permute2x128_si256(a, b, 0x31));
+    }
+  } else if (width == 4) {
+    // Within each 128-bit lane: byte 0 of the 4 elements, then byte 1...
+    const __m256i gather = _mm256_setr_epi8(
+        0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+        0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    // ...and then the 8 bytes of each plane together.
+    const __m256i pair = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    for (; i + 32 <= n; i += 32) {
+      __m256i v[4];
+      for (int k = 0; k < 4; ++k) {
+        v[k] = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(in + 4 * i + 32 * k));
+        v[k] = _mm256_permutevar8x32_epi32(
+            _mm256_shuffle_epi8(v[k], gather), pair);
+      }
+      // Transpose the 4x4 matrix of 64-bit words.
+      const __m256i t0 = _mm256_unpacklo_epi64(v[0], v[1]);
+      const __m256i t1 = _mm256_unpackhi_epi64(v[0], v[1]);
+      const __m256i t2 = _mm256_unpacklo_epi64(v[2], v[3]);
+      const __m256i t3 = _mm256_unpackhi_epi64(v[2], v[3]);
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i*>(out + i),
+          _mm256_permute2x128_si256(t0, t2, 0x20));
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i*>(out + n + i),
+          _mm256_permute2x128_si256(t1, t3, 0x20));
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i*>(out + 2 * n + i),
+          _mm256_permute2x128_si256(t0, t2, 0x31));
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i*>(out + 3 * n + i),
+          _mm256_permute2x128_si256(t1, t3, 0x31));
+    }
+  } else if (width == 8) {
+    // Within each 128-bit lane: byte 0 of the 2 elements, then byte 1...
+    const __m256i gather = _mm256_setr_epi8(
+        0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15,
+        0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15);
+    for (; i + 16 <= n; i += 16) {
+      __m256i v[4];
+      for (int k = 0; k < 4; ++k) {
+        v[k] = _mm256_shuffle_epi8(
+            _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(in + 8 * i + 32 * k)),
+            gather);
+      }
+      // Put elements 0-7 in the low lanes and 8-15 in the high lanes, and
+      // transpose the two 4x8 matrices of 16-bit words.
+      const __m256i p = _mm256_permute2x128_si256(v[0], v[2], 0x20);
+      const __m256i q = _mm256_permute2x128_si256(v[0], v[2], 0x31);
+      const __m256i r = _mm256_permute2x128_si256(v[1], v[3], 0x20);
+      const __m256i s = _mm256_permute2x128_si256(v[1], v[3], 0x31);
+      const __m256i pq[2]
+          = {_mm256_unpacklo_epi16(p, q), _mm256_unpackhi_epi16(p, q)};
+      const __m256i rs[2]
+          = {_mm256_unpacklo_epi16(r, s), _mm256_unpackhi_epi16(r, s)};
+      for (int h = 0; h < 2; ++h) {
+        // Planes 4h and 4h+1, then 4h+2 and 4h+3.
+        const __m256i w[2]
+            = {_mm256_unpacklo_epi32(pq[h], rs[h]),
+               _mm256_unpackhi_epi32(pq[h], rs[h])};
+        for (int k = 0; k < 2; ++k) {
+          const __m256i planes = _mm256_permute4x64_epi64(w[k], 0xD8);
+          const size_t plane = 4 * h + 2 * k;
+          _mm_storeu_si128(
+              reinterpret_cast<__m128i*>(out + plane * n + i),
+              _mm256_castsi256_si128(planes));
+          _mm_storeu_si128(
+              reinterpret_cast<__m128i*>(out + (plane + 1) * n + i),
+              _mm256_extracti128_si256(planes, 1));
+        }
+      }
+    }
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) inline size_t
+byte_unshuffle_avx2(const uint8_t* in, uint8_t* out, size_t n, size_t width)
+{
+  size_t i = 0;
+  if (width == 2) {
+    for (; i + 32 <= n; i += 32) {
+      const __m256i p0
+          = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+      const __m256i p1
+          = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + n + i));
+      const __m256i lo = _mm256_unpacklo_epi8(p0, p1);
+      const __m256i hi = _mm256_unpackhi_epi8(p0, p1);
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i*>(out + 2 * i),
+          _mm256_permute2x128_si256(lo, hi, 0x20));
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i*>(out + 2 * i + 32),
+          _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+  } else if (width == 4) {
+    for (; i + 32 <= n; i += 32) {
+      __m256i p[4];
+      for (int k = 0; k < 4; ++k) {
+        p[k] = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(in + k * n + i));
+      }
+      // The low lanes hold elements 0-15 and the high lanes 16-31.
+      const __m256i a = _mm256_unpacklo_epi8(p[0], p[1]);
+      const __m256i b = _mm256_unpackhi_epi8(p[0], p[1]);
+      const __m256i c = _mm256_unpacklo_epi8(p[2], p[3]);
+      const __m256i d = _mm256_unpackhi_epi8(p[2], p[3]);
+      const __m256i e0 = _mm256_unpacklo_epi16(a, c);
+      const __m256i e1 = _mm256_unpackhi_epi16(a, c);
+      const __m256i e2 = _mm256_unpacklo_epi16(b, d);
+      const __m256i e3 = _mm256_unpackhi_epi16(b, d);
+      __m256i* const dst = reinterpret_cast<__m256i*>(out + 4 * i);
+      _mm256_storeu_si256(dst, _mm256_permute2x128_si256(e0, e1, 0x20));
+      _mm256_storeu_si256(dst + 1, _mm256_permute2x128_si256(e2, e3, 0x20));
+      _mm256_storeu_si256(dst + 2, _mm256_permute2x128_si256(e0, e1, 0x31));
+      _mm256_storeu_si256(dst + 3, _mm256_permute2x128_si256(e2, e3, 0x31));
+    }
+  } else if (width == 8) {
+    for (; i + 32 <= n; i += 32) {
+      __m256i p[8];
+      for (int k = 0; k < 8; ++k) {
+        p[k] = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(in + k * n + i));
+      }
+      __m256i* const dst = reinterpret_cast<__m256i*>(out + 8 * i);
+      // h = 0 gives elements 0-7 and 16-23, h = 1 gives 8-15 and 24-31.
+      for (int h = 0; h < 2; ++h) {
+        __m256i a[4];
+        for (int k = 0; k < 4; ++k) {
+          a[k] = h == 0 ? _mm256_unpacklo_epi8(p[2 * k], p[2 * k + 1])
+                        : _mm256_unpackhi_epi8(p[2 * k], p[2 * k + 1]);
+        }
+        const __m256i b0 = _mm256_unpacklo_epi16(a[0], a[1]);
+        const __m256i b1 = _mm256_unpackhi_epi16(a[0], a[1]);
+        const __m256i c0 = _mm256_unpacklo_epi16(a[2], a[3]);
+        const __m256i c1 = _mm256_unpackhi_epi16(a[2], a[3]);
+        const __m256i d0 = _mm256_unpacklo_epi32(b0, c0);
+        const __m256i d1 = _mm256_unpackhi_epi32(b0, c0);
+        const __m256i d2 = _mm256_unpacklo_epi32(b1, c1);
+        const __m256i d3 = _mm256_unpackhi_epi32(b1, c1);
+        _mm256_storeu_si256(
+            dst + 2 * h, _mm256_permute2x128_si256(d0, d1, 0x20));
+        _mm256_storeu_si256(
+            dst + 2 * h + 1, _mm256_permute2x128_si256(d2, d3, 0x20));
+        _mm256_storeu_si256(
+            dst + 2 * h + 4, _mm256_permute2x128_si256(d0, d1, 0x31));
+        _mm256_storeu_si256(
+            dst + 2 * h + 5, _mm256_permute2x128_si256(d2, d3, 0x31));
+      }
+    }
+  }
+  return i;
+}
+
+// Bit b of the 32 bytes at `in` goes to the 4 bytes at rows[b].
+__attribute__((target("avx2"))) inline size_t
+bit_transpose_avx2(const uint8_t* in, uint8_t* out, size_t row_bytes)
+{
+  size_t i = 0;
+  for (; i + 32 <= 8 * row_bytes; i += 32) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    for (int b = 7; b >= 0; --b) {
+      const uint32_t bits = static_cast<uint32_t>(_mm256_movemask_epi8(x));
+      std::memcpy(out + b * row_bytes + i / 8, &bits, sizeof(bits));
+      x = _mm256_add_epi8(x, x);
+    }
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) inline size_t
+bit_untranspose_avx2(const uint8_t* in, uint8_t* out, size_t row_bytes)
+{
+  // Spread byte j / 8 of a row word to byte j, and select its bit j % 8.
+  const __m256i spread = _mm256_setr_epi8(
+      0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+      2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+  const __m256i select = _mm256_set1_epi64x(
+      static_cast<long long>(0x8040201008040201ULL));
+  size_t i = 0;
+  for (; i + 32 <= 8 * row_bytes; i += 32) {
+    __m256i x = _mm256_setzero_si256();
+    for (int b = 7; b >= 0; --b) {
+      uint32_t bits;
+      std::memcpy(&bits, in + b * row_bytes + i / 8, sizeof(bits));
+      const __m256i row = _mm256_shuffle_epi8(
+          _mm256_set1_epi32(static_cast<int>(bits)), spread);
+      // Each set bit gives -1: shift in a 1 for it.
+      const __m256i set
+          = _mm256_cmpeq_epi8(_mm256_and_si256(row, select), select);
+      x = _mm256_sub_epi8(_mm256_add_epi8(x, x), set);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), x);
+  }
+  return i;
+}
+
+#endif
+
+// Transposes the 8x8 bit matrix whose row j is byte j of `x`, so that bit b
+// of byte j moves to bit j of byte b. It is its own inverse.
+inline uint64_t transpose_bits8x8(uint64_t x)
+{
+  uint64_t t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+  x ^= t ^ (t << 7);
+  t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+  x ^= t ^ (t << 14);
+  t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+  x ^= t ^ (t << 28);
+  return x;
+}
+
+inline uint64_t load_le64(const uint8_t* const p)
+{
+  uint64_t x = 0;
+  for (int j = 0; j < 8; ++j) {
+    x |= uint64_t(p[j]) << (8 * j);
+  }
+  return x;
+}
+
+// Splits the 8 * row_bytes bytes at `in` into 8 rows of row_bytes, row b
+// holding bit b of every byte.
+inline void
+bit_transpose(const uint8_t* const in, uint8_t* const out, size_t row_bytes)
+{
+  size_t i = 0;
+#ifdef NVCOMP_HOST_SHUFFLE_X86
+  if (shuffle_use_avx2()) {
+    i = bit_transpose_avx2(in, out, row_bytes);
+  }
+#endif
+  for (; i < 8 * row_bytes; i += 8) {
+    const uint64_t x = transpose_bits8x8(load_le64(in + i));
+    for (int b = 0; b < 8; ++b) {
+      out[b * row_bytes + i / 8] = static_cast<uint8_t>(x >> (8 * b));
+    }
+  }
+}
+
+inline void
+bit_untranspose(const uint8_t* const in, uint8_t* const out, size_t row_bytes)
+{
+  size_t i = 0;
+#ifdef NVCOMP_HOST_SHUFFLE_X86
+  if (shuffle_use_avx2()) {
+    i = bit_untranspose_avx2(in, out, row_bytes);
+  }
+#endif
+  for (; i < 8 * row_bytes; i += 8) {
+    uint64_t x = 0;
+    for (int b = 0; b < 8; ++b) {
+      x |= uint64_t(in[b * row_bytes + i / 8]) << (8 * b);
+    }
+    x = transpose_bits8x8(x);
+    for (int j = 0; j < 8; ++j) {
+      out[i + j] = static_cast<uint8_t>(x >> (8 * j));
+    }
+  }
+}
+
+// Bytes past the shuffled part are copied unchanged.
+inline void copy_tail(
+    const uint8_t* const src,
+    uint8_t* const dst,
+    const size_t offset,
+    const size_t bytes)
+{
+  if (bytes > offset) {
+    std::memcpy(dst + offset, src + offset, bytes - offset);
+  }
+}
+
+inline void check_width(const size_t width)
+{
+  if (width == 0) {
+    throw std::runtime_error("Shuffle element width must be positive.");
+  }
+}
+
+} // namespace detail
+
+/**
+ * @brief Gather byte j of each of the `bytes / width` elements at `in` into
+ * plane j at `out`. The buffers must not overlap.
+ *
+ * Element widths 2, 4 and 8 use AVX2 kernels where the CPU supports them.
+ */
+inline void byte_shuffle(
+    const void* const in,
+    void* const out,
+    const size_t bytes,
+    const size_t width)
+{
+  detail::check_width(width);
+  const uint8_t* const src = static_cast<const uint8_t*>(in);
+  uint8_t* const dst = static_cast<uint8_t*>(out);
+  const size_t n = bytes / width;
+
+  size_t i = 0;
+#ifdef NVCOMP_HOST_SHUFFLE_X86
+  if (detail::shuffle_use_avx2()) {
+    i = detail::byte_shuffle_avx2(src, dst, n, width);
+  }
+#endif
+  for (; i < n; ++i) {
+    for (size_t j = 0; j < width; ++j) {
+      dst[j * n + i] = src[i * width + j];
+    }
+  }
+  detail::copy_tail(src, dst, n * width, bytes);
+}
+
+/**
+ * @brief Undo byte_shuffle.
+ */
+inline void byte_unshuffle(
+    const void* const in,
+    void* const out,
+    const size_t bytes,
+    const size_t width)
+{
+  detail::check_width(width);
+  const uint8_t* const src = static_cast<const uint8_t*>(in);
+  uint8_t* const dst = static_cast<uint8_t*>(out);
+  const size_t n = bytes / width;
+
+  size_t i = 0;
+#ifdef NVCOMP_HOST_SHUFFLE_X86
+  if (detail::shuffle_use_avx2()) {
+    i = detail::byte_unshuffle_avx2(src, dst, n, width);
+  }
+#endif
+  for (; i < n; ++i) {
+    for (size_t j = 0; j < width; ++j) {
+      dst[i * width + j] = src[j * n + i];
+    }
+  }
+  detail::copy_tail(src, dst, n * width, bytes);
+}
+
+/**
+ * @brief Byte-shuffle the leading multiple of 8 elements at `in`, then split
+ * every byte plane into 8 bit rows of `elements / 8` bytes each, row b
+ * holding bit b of the plane's bytes. The buffers must not overlap.
+ */
+inline void bit_shuffle(
+    const void* const in,
+    void* const out,
+    const size_t bytes,
+    const size_t width)
+{
+  detail::check_width(width);
+  const uint8_t* const src = static_cast<const uint8_t*>(in);
+  uint8_t* const dst = static_cast<uint8_t*>(out);
+  const size_t n = bytes / width / 8 * 8;
+
+  std::vector<uint8_t> planes(n * width);
+  byte_shuffle(src, planes.data(), planes.size(), width);
+  for (size_t j = 0; j < width; ++j) {
+    detail::bit_transpose(planes.data() + j * n, dst + j * n, n / 8);
+  }
+  detail::copy_tail(src, dst, n * width, bytes);
+}
+
+/**
+ * @brief Undo bit_shuffle.
+ */
+inline void bit_unshuffle(
+    const void* const in,
+    void* const out,
+    const size_t bytes,
+    const size_t width)
+{
+  detail::check_width(width);
+  const uint8_t* const src = static_cast<const uint8_t*>(in);
+  uint8_t* const dst = static_cast<uint8_t*>(out);
+  const size_t n = bytes / width / 8 * 8;
+
+  std::vector<uint8_t> planes(n * width);
+  for (size_t j = 0; j < width; ++j) {
+    detail::bit_untranspose(src + j * n, planes.data() + j * n, n / 8);
+  }
+  byte_unshuffle(planes.data(), dst, planes.size(), width);
+  detail::copy_tail(src, dst, n * width, bytes);
+}
+
+/**
+ * @brief Apply `filter` to the `bytes` at `in`, writing as many to `out`.
+ */
+inline void shuffle(
+    const ShuffleFilter filter,
+    const void* const in,
+    void* const out,
+    const size_t bytes,
+    const size_t width)
+{
+  switch (filter) {
+  case ShuffleFilter::None:
+    std::memcpy(out, in, bytes);
+    return;
+  case ShuffleFilter::Byte:
+    byte_shuffle(in, out, bytes, width);
+    return;
+  case ShuffleFilter::Bit:
+    bit_shuffle(in, out, bytes, width);
+    return;
+  }
+}
+
+/**
+ * @brief Undo `filter` on the `bytes` at `in`, writing as many to `out`.
+ */
+inline void unshuffle(
+    const ShuffleFilter filter,
+    const void* const in,
+    void* const out,
+    const size_t bytes,
+    const size_t width)
+{
+  switch (filter) {
+  case ShuffleFilter::None:
+    std::memcpy(out, in, bytes);
+    return;
+  case ShuffleFilter::Byte:
+    byte_unshuffle(in, out, bytes, width);
+    return;
+  case ShuffleFilter::Bit:
+    bit_unshuffle(in, out, bytes, width);
+    return;
+  }
+}
+
+} // namespace host
+} // namespace nvcomp
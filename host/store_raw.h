@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/data_profiler.h"
+#include "host/thread_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace nvcomp
+{
+namespace host
+{
+
+struct StoreRawOptions
+{
+  // Number of evenly spaced samples taken from each chunk, and the size of
+  // each. Chunks smaller than all samples together are tested whole.
+  size_t num_samples;
+  size_t sample_bytes;
+  // A chunk is stored only if the order-0 entropy of the sampled bytes, and
+  // of the sampled deltas at each element width, is at least this many bits
+  // per byte...
+  double min_entropy;
+  // ...and at most this fraction of the sampled positions start a 4-byte
+  // repeat within the same sample.
+  double max_match_density;
+  // Chunks smaller than this are always compressed, since too few bytes
+  // give a biased entropy estimate.
+  size_t min_chunk_bytes;
+};
+
+static const StoreRawOptions StoreRawDefaultOpts = {4, 1024, 7.5, 0.02, 512};
+
+namespace detail
+{
+
+// Accumulate the byte and delta histograms and LZ match counts of one
+// sample into `hists`, which holds one 256 bin histogram for the bytes,
+// followed by one for the deltas of each multi-byte profile width.
+inline size_t add_raw_sample(
+    const uint8_t* const data,
+    const size_t bytes,
+    uint64_t* const hists,
+    std::vector<uint16_t>& table)
+{
+  for (size_t i = 0; i < bytes; ++i) {
+    ++hists[data[i]];
+  }
+
+  for (size_t w = 1; w < PROFILE_NUM_WIDTHS; ++w) {
+    const size_t width = PROFILE_WIDTHS[w];
+    uint64_t* const hist = hists + 256 * w;
+    uint64_t prev = 0;
+    for (size_t i = 0; i + width <= bytes; i += width) {
+      const uint64_t val = load_element(data + i, width);
+      uint64_t delta = val - prev;
+      prev = val;
+      for (size_t b = 0; b < width; ++b) {
+        ++hist[delta & 0xff];
+        delta >>= 8;
+      }
+    }
+  }
+
+  // Positions are stored off by one, so that zero marks an empty slot.
+  std::fill(table.begin(), table.end(), uint16_t(0));
+  size_t matches = 0;
+  for (size_t i = 0; i + 4 <= bytes; ++i) {
+    uint32_t seq;
+    std::memcpy(&seq, data + i, sizeof(seq));
+    const uint32_t hash = (seq * 2654435761u) >> 22;
+    const uint16_t candidate = table[hash];
+    table[hash] = static_cast<uint16_t>(i + 1);
+    if (candidate != 0) {
+      uint32_t prev;
+      std::memcpy(&prev, data + candidate - 1, sizeof(prev));
+      matches += prev == seq;
+    }
+  }
+  return matches;
+}
+
+} // namespace detail
+
+/**
+ * @brief Check whether a chunk is likely to expand when compressed.
+ *
+ * This looks at a few samples of the chunk: it is about an order of
+ * magnitude cheaper than profile_chunk(), at the cost of missing repeats
+ * that are further apart than a sample.
+ */
+inline bool is_incompressible(
+    const void* const ptr,
+    const size_t bytes,
+    const StoreRawOptions& opts = StoreRawDefaultOpts)
+{
+  if (bytes == 0 || bytes < opts.min_chunk_bytes) {
+    return false;
+  }
+  const uint8_t* const data = static_cast<const uint8_t*>(ptr);
+
+  uint64_t hists[256 * PROFILE_NUM_WIDTHS] = {};
+  std::vector<uint16_t> table(1024);
+  size_t sampled = 0;
+  size_t matches = 0;
+
+  const size_t num_samples = std::max<size_t>(opts.num_samples, 1);
+  if (num_samples * opts.sample_bytes >= bytes) {
+    // Table positions are 16 bit, so split large chunks into samples anyway.
+    for (size_t offset = 0; offset < bytes; offset += 1 << 15) {
+      const size_t n = std::min<size_t>(bytes - offset, 1 << 15);
+      matches += detail::add_raw_sample(data + offset, n, hists, table);
+      sampled += n;
+    }
+  } else {
+    // Align the samples to 8 bytes, so deltas see whole elements.
+    const size_t stride
+        = (bytes - opts.sample_bytes) / std::max<size_t>(num_samples - 1, 1);
+    for (size_t s = 0; s < num_samples; ++s) {
+      const size_t offset = (s * stride) & ~size_t(7);
+      matches += detail::add_raw_sample(
+          data + offset, opts.sample_bytes, hists, table);
+      sampled += opts.sample_bytes;
+    }
+  }
+
+  if (static_cast<double>(matches) / sampled > opts.max_match_density) {
+    return false;
+  }
+  for (size_t w = 0; w < PROFILE_NUM_WIDTHS; ++w) {
+    if (detail::entropy(hists + 256 * w, 256) < opts.min_entropy) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Flag each chunk of a batch that should be stored rather than compressed.
+inline std::vector<uint8_t> mark_raw_chunks(
+    const void* const* const ptrs,
+    const size_t* const sizes,
+    const size_t batch_size,
+    ThreadPool& pool = default_thread_pool(),
+    const StoreRawOptions& opts = StoreRawDefaultOpts)
+{
+  std::vector<uint8_t> flags(batch_size, 0);
+  pool.parallel_for(batch_size, [&](const size_t i) {
+    flags[i] = is_incompressible(ptrs[i], sizes[i], opts) ? 1 : 0;
+  });
+  return flags;
+}
+
+inline std::vector<uint8_t> mark_raw_chunks(
+    const std::vector<std::vector<char>>& data,
+    ThreadPool& pool = default_thread_pool(),
+    const StoreRawOptions& opts = StoreRawDefaultOpts)
+{
+  std::vector<const void*> ptrs(data.size());
+  std::vector<size_t> sizes(data.size());
+  for (size_t i = 0; i < data.size(); ++i) {
+    ptrs[i] = data[i].data();
+    sizes[i] = data[i].size();
+  }
+  return mark_raw_chunks(ptrs.data(), sizes.data(), data.size(), pool, opts);
+}
+
+/**
+ * @brief Build the table that precedes the payloads of a batch with stored
+ * chunks, so that a reader can tell them apart:
+ *
+ *   uint64 num_chunks,
+ *   num_chunks pairs of uint64 uncompressed and payload sizes,
+ *   num_chunks uint8 raw flags, padded to a multiple of 8 bytes.
+ *
+ * The payloads follow back to back, each a copy of the chunk if its flag is
+ * set and compressed otherwise. All values are little-endian.
+ */
+inline std::vector<uint8_t> raw_chunk_table(
+    const uint8_t* const raw_flags,
+    const size_t* const uncompressed_sizes,
+    const size_t* const payload_sizes,
+    const size_t batch_size)
+{
+  const size_t bytes = sizeof(uint64_t) * (1 + 2 * batch_size) + batch_size;
+  std::vector<uint8_t> table(
+      (bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t),
+      0);
+  uint8_t* ptr = table.data();
+  const uint64_t num_chunks = batch_size;
+  std::memcpy(ptr, &num_chunks, sizeof(num_chunks));
+  ptr += sizeof(num_chunks);
+  for (size_t i = 0; i < batch_size; ++i) {
+    const uint64_t sizes[2] = {uncompressed_sizes[i], payload_sizes[i]};
+    std::memcpy(ptr, sizes, sizeof(sizes));
+    ptr += sizeof(sizes);
+  }
+  std::copy(raw_flags, raw_flags + batch_size, ptr);
+  return table;
+}
+
+} // namespace host
+} // namespace nvcomp
@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace nvcomp
+{
+namespace host
+{
+
+/**
+ * @brief A fixed-size pool of worker threads for host-side batch processing.
+ *
+ * Every worker owns a task deque. Tasks enqueued by a worker go to the back
+ * of its own deque, and a worker runs its newest task first, which keeps
+ * nested work (e.g. a parallel_for inside a task) on the same core. Tasks
+ * enqueued by other threads are spread over the deques round-robin. An idle
+ * worker steals the oldest task from the other deques before sleeping.
+ *
+ * Each worker calls `on_start(index)`, if given, before taking any task,
+ * e.g. to pin itself to a set of cores. The destructor waits for all queued
+ * tasks.
+ */
+class ThreadPool
+{
+public:
+  // A `num_threads` of 0 uses one worker per hardware thread.
+  explicit ThreadPool(
+      size_t num_threads = 0,
+      std::function<void(size_t)> on_start = std::function<void(size_t)>()) :
+      m_queues(),
+      m_workers(),
+      m_mutex(),
+      m_task_cv(),
+      m_idle_cv(),
+      m_queued(0),
+      m_active(0),
+      m_next_queue(0),
+      m_stop(false),
+      m_on_start(std::move(on_start))
+  {
+    if (num_threads == 0) {
+      num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    m_queues.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+      m_queues.emplace_back(new WorkerQueue());
+    }
+    m_workers.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+      m_workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+  }
+
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_task_cv.notify_all();
+    for (std::thread& worker : m_workers) {
+      worker.join();
+    }
+  }
+
+  // disable copying
+  ThreadPool(const ThreadPool& other) = delete;
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+
+  size_t num_threads() const
+  {
+    return m_workers.size();
+  }
+
+  void enqueue(std::function<void()> task)
+  {
+    const WorkerId& self = current_worker();
+    const size_t index = self.pool == this
+                             ? self.index
+                             : m_next_queue++ % m_queues.size();
+    {
+      // Count the task under the lock of its deque, so that no worker can
+      // take it, and decrement the count, before it has been counted.
+      WorkerQueue& queue = *m_queues[index];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.tasks.emplace_back(std::move(task));
+      ++m_queued;
+    }
+    // Taking the lock orders the count above before a sleeping worker
+    // re-checks it, so the notification can't be lost.
+    { std::lock_guard<std::mutex> lock(m_mutex); }
+    m_task_cv.notify_one();
+  }
+
+  // Block until all deques are empty and no task is running.
+  void wait_idle()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle_cv.wait(lock, [this]() { return m_queued == 0 && m_active == 0; });
+  }
+
+  // Call `fn(i)` for every i in [0, n) and block until all calls returned.
+  // The calling thread participates, so this is safe to call from within a
+  // task. The first exception thrown by `fn` is rethrown here.
+  template <typename F>
+  void parallel_for(const size_t n, F fn)
+  {
+    if (n == 0) {
+      return;
+    }
+
+    struct LoopState
+    {
+      std::atomic<size_t> next;
+      std::atomic<size_t> done;
+      std::mutex mutex;
+      std::condition_variable cv;
+      std::exception_ptr error;
+
+      LoopState() : next(0), done(0), mutex(), cv(), error()
+      {
+      }
+    };
+    std::shared_ptr<LoopState> state = std::make_shared<LoopState>();
+
+    // The loop body outlives neither this frame nor `fn`: we only return
+    // once every index has been claimed and finished.
+    std::function<void()> body = [state, n, &fn]() {
+      for (size_t i = state->next++; i < n; i = state->next++) {
+        try {
+          fn(i);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(state->mutex);
+          if (!state->error) {
+            state->error = std::current_exception();
+          }
+        }
+        if (++state->done == n) {
+          std::lock_guard<std::mutex> lock(state->mutex);
+          state->cv.notify_all();
+        }
+      }
+    };
+
+    const size_t helpers = std::min(n, num_threads() + 1) - 1;
+    for (size_t i = 0; i < helpers; ++i) {
+      enqueue(body);
+    }
+    body();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&state, n]() { return state->done == n; });
+    if (state->error) {
+      std::rethrow_exception(state->error);
+    }
+  }
+
+private:
+  struct WorkerQueue
+  {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+
+    WorkerQueue() : mutex(), tasks()
+    {
+    }
+  };
+
+  struct WorkerId
+  {
+    const ThreadPool* pool;
+    size_t index;
+  };
+
+  static WorkerId& current_worker()
+  {
+    static thread_local WorkerId id = {nullptr, 0};
+    return id;
+  }
+
+  // Pop the newest task of our own deque, or else steal the oldest task of
+  // another one.
+  bool take_task(const size_t index, std::function<void()>& task)
+  {
+    const size_t num_queues = m_queues.size();
+    for (size_t k = 0; k < num_queues; ++k) {
+      WorkerQueue& queue = *m_queues[(index + k) % num_queues];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.tasks.empty()) {
+        continue;
+      }
+      if (k == 0) {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+      } else {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+      }
+      // Count the task as active before it stops being queued, so that
+      // wait_idle() never sees both counts at zero in between.
+      ++m_active;
+      --m_queued;
+      return true;
+    }
+    return false;
+  }
+
+  void worker_loop(const size_t index)
+  {
+    current_worker().pool = this;
+    current_worker().index = index;
+    NVCOMP_TRACE_THREAD_NAME("pool worker " + std::to_string(index));
+    if (m_on_start) {
+      m_on_start(index);
+    }
+
+    while (true) {
+      std::function<void()> task;
+      if (take_task(index, task)) {
+        task();
+        if (--m_active == 0 && m_queued == 0) {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          m_idle_cv.notify_all();
+        }
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_task_cv.wait(lock, [this]() { return m_stop || m_queued > 0; });
+      if (m_stop && m_queued == 0) {
+        return;
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+  std::vector<std::thread> m_workers;
+  std::mutex m_mutex;
+  std::condition_variable m_task_cv;
+  std::condition_variable m_idle_cv;
+  std::atomic<size_t> m_queued;
+  std::atomic<size_t> m_active;
+  std::atomic<size_t> m_next_queue;
+  bool m_stop;
+  std::function<void(size_t)> m_on_start;
+};
+
+// Process-wide pool shared by the host-side helpers, sized to the machine.
+inline ThreadPool& default_thread_pool()
+{
+  static ThreadPool pool;
+  return pool;
+}
+
+} // namespace host
+} // namespace nvcomp
@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+/**
+ * Host-side phase tracing.
+ *
+ * Code marks a phase with `NVCOMP_TRACE_SCOPE("compress")`, which records a
+ * range from that point to the end of the enclosing scope. Unless the build
+ * defines NVCOMP_ENABLE_TRACING, the macros expand to nothing and cost
+ * nothing.
+ *
+ * With tracing compiled in, each thread appends its ranges to its own
+ * fixed-size ring buffer without taking any lock, so the oldest ranges are
+ * overwritten if a thread records more than `TraceBuffer::CAPACITY` of them
+ * before they are written out. Recording only happens while a TraceSession is
+ * active; `NVCOMP_TRACE_SESSION()` at the top of `main()` starts one when the
+ * NVCOMP_TRACE_FILE environment variable names an output file, and writes the
+ * ranges there as Chrome trace-event JSON (viewable in chrome://tracing or
+ * Perfetto) when `main()` returns.
+ */
+
+#ifdef NVCOMP_ENABLE_TRACING
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace nvcomp
+{
+namespace host
+{
+
+/**
+ * @brief A completed range. `name` must have static storage duration, as
+ * only the pointer is recorded.
+ */
+struct TraceEvent
+{
+  const char* name;
+  uint64_t begin_ns;
+  uint64_t end_ns;
+};
+
+/**
+ * @brief The ring buffer of ranges recorded by one thread.
+ *
+ * Only the owning thread pushes. Readers may take a snapshot at any time;
+ * slots are individually atomic, and a slot the owner overwrote while it was
+ * being copied is dropped from the snapshot rather than returned torn.
+ */
+class TraceBuffer
+{
+public:
+  static constexpr size_t CAPACITY = 1 << 15;
+
+  TraceBuffer(const uint32_t tid, const std::string& thread_name) :
+      m_slots(new Slot[CAPACITY]),
+      m_head(0),
+      m_tid(tid),
+      m_thread_name(thread_name)
+  {
+  }
+
+  // disable copying
+  TraceBuffer(const TraceBuffer&) = delete;
+  TraceBuffer& operator=(const TraceBuffer&) = delete;
+
+  void push(const char* const name, const uint64_t begin_ns,
+      const uint64_t end_ns)
+  {
+    const uint64_t head = m_head.load(std::memory_order_relaxed);
+    Slot& slot = m_slots[head & (CAPACITY - 1)];
+    // Bump the sequence number to odd while the slot is being rewritten, so
+    // a concurrent snapshot can tell.
+    slot.seq.store(2 * head + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.begin_ns.store(begin_ns, std::memory_order_relaxed);
+    slot.end_ns.store(end_ns, std::memory_order_relaxed);
+    slot.seq.store(2 * head + 2, std::memory_order_release);
+    m_head.store(head + 1, std::memory_order_release);
+  }
+
+  // Append the ranges currently held, oldest first, and return the number of
+  // ranges recorded so far that are no longer available.
+  uint64_t snapshot(std::vector<TraceEvent>& events) const
+  {
+    const uint64_t head = m_head.load(std::memory_order_acquire);
+    const uint64_t first = head > CAPACITY ? head - CAPACITY : 0;
+    uint64_t dropped = first;
+    for (uint64_t i = first; i < head; ++i) {
+      const Slot& slot = m_slots[i & (CAPACITY - 1)];
+      const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+      TraceEvent event;
+      event.name = slot.name.load(std::memory_order_relaxed);
+      event.begin_ns = slot.begin_ns.load(std::memory_order_relaxed);
+      event.end_ns = slot.end_ns.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq != 2 * i + 2
+          || slot.seq.load(std::memory_order_relaxed) != seq) {
+        ++dropped;
+        continue;
+      }
+      events.push_back(event);
+    }
+    return dropped;
+  }
+
+  uint32_t tid() const
+  {
+    return m_tid;
+  }
+
+  // The thread name is guarded by the TraceRegistry mutex.
+  const std::string& thread_name() const
+  {
+    return m_thread_name;
+  }
+
+  void set_thread_name(const std::string& name)
+  {
+    m_thread_name = name;
+  }
+
+private:
+  struct Slot
+  {
+    std::atomic<uint64_t> seq;
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> begin_ns;
+    std::atomic<uint64_t> end_ns;
+
+    Slot() : seq(0), name(nullptr), begin_ns(0), end_ns(0)
+    {
+    }
+  };
+
+  std::unique_ptr<Slot[]> m_slots;
+  std::atomic<uint64_t> m_head;
+  uint32_t m_tid;
+  std::string m_thread_name;
+};
+
+/**
+ * @brief The process-wide list of per-thread buffers.
+ *
+ * The mutex is only taken when a thread records its first range, when a
+ * thread is named, and when the trace is written. Buffers are shared with
+ * the registry so that ranges from threads that already exited are kept.
+ */
+class TraceRegistry
+{
+public:
+  static TraceRegistry& instance()
+  {
+    static TraceRegistry registry;
+    return registry;
+  }
+
+  bool enabled() const
+  {
+    return m_enabled.load(std::memory_order_relaxed);
+  }
+
+  void set_enabled(const bool enabled)
+  {
+    m_enabled.store(enabled, std::memory_order_relaxed);
+  }
+
+  uint64_t now_ns() const
+  {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - m_epoch)
+            .count());
+  }
+
+  // The calling thread's buffer, created on first use.
+  TraceBuffer& thread_buffer()
+  {
+    std::shared_ptr<TraceBuffer>& buffer = local_buffer();
+    if (!buffer) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      const uint32_t tid = static_cast<uint32_t>(m_buffers.size());
+      std::string& name = local_thread_name();
+      buffer = std::make_shared<TraceBuffer>(
+          tid, name.empty() ? "thread " + std::to_string(tid) : name);
+      m_buffers.push_back(buffer);
+    }
+    return *buffer;
+  }
+
+  void set_thread_name(const std::string& name)
+  {
+    local_thread_name() = name;
+    std::shared_ptr<TraceBuffer>& buffer = local_buffer();
+    if (buffer) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      buffer->set_thread_name(name);
+    }
+  }
+
+  // Write every recorded range as a Chrome trace-event JSON object.
+  void write_chrome_trace(std::ostream& out)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    uint64_t dropped = 0;
+    std::vector<TraceEvent> events;
+    for (const std::shared_ptr<TraceBuffer>& buffer : m_buffers) {
+      out << (first ? "\n" : ",\n");
+      first = false;
+      out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+          << buffer->tid() << ",\"args\":{\"name\":";
+      write_json_string(out, buffer->thread_name().c_str());
+      out << "}}";
+
+      events.clear();
+      dropped += buffer->snapshot(events);
+      for (const TraceEvent& event : events) {
+        out << ",\n{\"name\":";
+        write_json_string(out, event.name);
+        char times[64];
+        std::snprintf(
+            times,
+            sizeof(times),
+            "\"ts\":%.3f,\"dur\":%.3f",
+            event.begin_ns * 1e-3,
+            (event.end_ns - event.begin_ns) * 1e-3);
+        out << ",\"cat\":\"nvcomp\",\"ph\":\"X\"," << times
+            << ",\"pid\":1,\"tid\":" << buffer->tid() << "}";
+      }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":"
+        << dropped << "}}\n";
+  }
+
+private:
+  TraceRegistry() :
+      m_mutex(),
+      m_buffers(),
+      m_enabled(false),
+      m_epoch(std::chrono::steady_clock::now())
+  {
+  }
+
+  static std::shared_ptr<TraceBuffer>& local_buffer()
+  {
+    static thread_local std::shared_ptr<TraceBuffer> buffer;
+    return buffer;
+  }
+
+  static std::string& local_thread_name()
+  {
+    static thread_local std::string name;
+    return name;
+  }
+
+  static void write_json_string(std::ostream& out, const char* str)
+  {
+    out << '"';
+    for (; str != nullptr && *str != '\0'; ++str) {
+      const unsigned char c = static_cast<unsigned char>(*str);
+      if (c == '"' || c == '\\') {
+        out << '\\' << *str;
+      } else if (c < 0x20) {
+        char escaped[8];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+        out << escaped;
+      } else {
+        out << *str;
+      }
+    }
+    out << '"';
+  }
+
+  std::mutex m_mutex;
+  std::vector<std::shared_ptr<TraceBuffer>> m_buffers;
+  std::atomic<bool> m_enabled;
+  std::chrono::steady_clock::time_point m_epoch;
+};
+
+/**
+ * @brief Records a range from construction to destruction on the calling
+ * thread, if tracing is enabled when it is constructed.
+ */
+class ScopedTraceRange
+{
+public:
+  explicit ScopedTraceRange(const char* const name) :
+      m_name(TraceRegistry::instance().enabled() ? name : nullptr),
+      m_begin_ns(m_name ? TraceRegistry::instance().now_ns() : 0)
+  {
+  }
+
+  ~ScopedTraceRange()
+  {
+    if (m_name) {
+      TraceRegistry& registry = TraceRegistry::instance();
+      const uint64_t end_ns = registry.now_ns();
+      registry.thread_buffer().push(m_name, m_begin_ns, end_ns);
+    }
+  }
+
+  // disable copying
+  ScopedTraceRange(const ScopedTraceRange&) = delete;
+  ScopedTraceRange& operator=(const ScopedTraceRange&) = delete;
+
+private:
+  const char* m_name;
+  uint64_t m_begin_ns;
+};
+
+/**
+ * @brief Enables recording for its lifetime and writes the trace to `path`
+ * when destroyed. An empty or null `path` leaves tracing disabled.
+ */
+class TraceSession
+{
+public:
+  explicit TraceSession(const char* const path) :
+      m_path(path != nullptr ? path : "")
+  {
+    if (!m_path.empty()) {
+      TraceRegistry::instance().set_enabled(true);
+    }
+  }
+
+  ~TraceSession()
+  {
+    if (m_path.empty()) {
+      return;
+    }
+    TraceRegistry::instance().set_enabled(false);
+    std::ofstream out(m_path);
+    if (!out) {
+      std::fprintf(
+          stderr,
+          "WARNING: Unable to open \"%s\" for writing the trace.\n",
+          m_path.c_str());
+      return;
+    }
+    TraceRegistry::instance().write_chrome_trace(out);
+  }
+
+  // disable copying
+  TraceSession(const TraceSession&) = delete;
+  TraceSession& operator=(const TraceSession&) = delete;
+
+private:
+  std::string m_path;
+};
+
+} // namespace host
+} // namespace nvcomp
+
+#define NVCOMP_TRACE_CONCAT_IMPL(a, b) a##b
+#define NVCOMP_TRACE_CONCAT(a, b) NVCOMP_TRACE_CONCAT_IMPL(a, b)
+
+#define NVCOMP_TRACE_SCOPE(name)                                               \
+  ::nvcomp::host::ScopedTraceRange NVCOMP_TRACE_CONCAT(                        \
+      nvcomp_trace_range_, __LINE__)(name)
+#define NVCOMP_TRACE_THREAD_NAME(name)                                         \
+  ::nvcomp::host::TraceRegistry::instance().set_thread_name(name)
+#define NVCOMP_TRACE_SESSION()                                                 \
+  ::nvcomp::host::TraceSession NVCOMP_TRACE_CONCAT(                            \
+      nvcomp_trace_session_, __LINE__)(std::getenv("NVCOMP_TRACE_FILE"))
+
+#else
+
+#define NVCOMP_TRACE_SCOPE(name) ((void)0)
+#define NVCOMP_TRACE_THREAD_NAME(name) ((void)0)
+#define NVCOMP_TRACE_SESSION() ((void)0)
+
+#endif
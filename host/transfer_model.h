@@ -0,0 +1,449 @@
+/*
+ * Copyright (c) 2023, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *  * Neither the name of NVIDIA CORPORATION nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "host/host_codecs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nvcomp
+{
+namespace host
+{
+
+// Measured behaviour of a codec on some data. Throughputs are in
+// uncompressed bytes per second.
+struct CodecMeasurement
+{
+  std::string name;
+  double ratio;
+  double compress_throughput;
+  double decompress_throughput;
+
+  CodecMeasurement() :
+      name(), ratio(1), compress_throughput(0), decompress_throughput(0)
+  {
+  }
+};
+
+/**
+ * @brief Predicted rates of moving data over a link, in uncompressed bytes
+ * per second.
+ *
+ * Serial: compress everything, send it, then decompress it, so the times
+ * add up: 1 / rate = 1 / C + 1 / (R * B) + 1 / D.
+ * Pipelined: chunks are compressed, sent and decompressed concurrently by
+ * separate resources, so the slowest stage sets the rate:
+ * rate = min(C, R * B, D).
+ */
+struct TransferPrediction
+{
+  double uncompressed_rate;
+  double serial_rate;
+  double pipelined_rate;
+};
+
+inline double serial_rate(const CodecMeasurement& m, const double bandwidth)
+{
+  return 1.0
+         / (1.0 / m.compress_throughput + 1.0 / (m.ratio * bandwidth)
+            + 1.0 / m.decompress_throughput);
+}
+
+inline double pipelined_rate(const CodecMeasurement& m, const double bandwidth)
+{
+  return std::min(
+      std::min(m.compress_throughput, m.ratio * bandwidth),
+      m.decompress_throughput);
+}
+
+inline TransferPrediction
+predict_transfer(const CodecMeasurement& m, const double bandwidth)
+{
+  TransferPrediction prediction;
+  prediction.uncompressed_rate = bandwidth;
+  prediction.serial_rate = serial_rate(m, bandwidth);
+  prediction.pipelined_rate = pipelined_rate(m, bandwidth);
+  return prediction;
+}
+
+// Link bandwidth below which compressing serially beats sending the data
+// as it is: solving 1 / B = 1 / C + 1 / (R * B) + 1 / D for B gives
+// B = (1 - 1 / R) / (1 / C + 1 / D). Zero if the data doesn't compress.
+inline double serial_crossover_bandwidth(const CodecMeasurement& m)
+{
+  if (m.ratio <= 1.0) {
+    return 0;
+  }
+  return (1.0 - 1.0 / m.ratio)
+         / (1.0 / m.compress_throughput + 1.0 / m.decompress_throughput);
+}
+
+// The same for a pipelined transfer, which wins while the link is slower
+// than both codec stages.
+inline double pipelined_crossover_bandwidth(const CodecMeasurement& m)
+{
+  if (m.ratio <= 1.0) {
+    return 0;
+  }
+  return std::min(m.compress_throughput, m.decompress_throughput);
+}
+
+/**
+ * @brief Measure the ratio and single-threaded throughputs of `codec` on
+ * `chunks`, keeping the fastest of `iterations` runs.
+ */
+inline CodecMeasurement measure_codec(
+    const HostCodec& codec,
+    const std::vector<std::vector<uint8_t>>& chunks,
+    const int iterations = 3)
+{
+  typedef std::chrono::steady_clock clock;
+
+  size_t max_chunk = 0;
+  size_t uncompressed_bytes = 0;
+  for (const std::vector<uint8_t>& chunk : chunks) {
+    max_chunk = std::max(max_chunk, chunk.size());
+    uncompressed_bytes += chunk.size();
+  }
+  std::vector<std::vector<uint8_t>> compressed(chunks.size());
+  for (std::vector<uint8_t>& out : compressed) {
+    out.resize(codec.max_compressed_size(max_chunk));
+  }
+  std::vector<uint8_t> decompressed(max_chunk);
+  std::vector<size_t> sizes(chunks.size());
+
+  double compress_seconds = std::numeric_limits<double>::max();
+  double decompress_seconds = std::numeric_limits<double>::max();
+  for (int it = 0; it < std::max(iterations, 1); ++it) {
+    clock::time_point start = clock::now();
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      sizes[i] = codec.compress(
+          chunks[i].data(),
+          chunks[i].size(),
+          compressed[i].data(),
+          compressed[i].size());
+    }
+    compress_seconds = std::min(
+        compress_seconds,
+        std::chrono::duration<double>(clock::now() - start).count());
+
+    start = clock::now();
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      size_t out_bytes = 0;
+      if (codec.decompress(
+              compressed[i].data(),
+              sizes[i],
+              decompressed.data(),
+              decompressed.size(),
+              &out_bytes)
+              != nvcompSuccess
+          || out_bytes != chunks[i].size()) {
+        throw std::runtime_error(
+            std::string("Failed to decompress a ") + codec.name()
+            + " chunk.");
+      }
+    }
+    decompress_seconds = std::min(
+        decompress_seconds,
+        std::chrono::duration<double>(clock::now() - start).count());
+  }
+
+  size_t compressed_bytes = 0;
+  for (const size_t size : sizes) {
+    compressed_bytes += size;
+  }
+
+  CodecMeasurement m;
+  m.name = codec.name();
+  m.ratio = compressed_bytes > 0
+                ? static_cast<double>(uncompressed_bytes) / compressed_bytes
+                : 1.0;
+  m.compress_throughput = uncompressed_bytes / compress_seconds;
+  m.decompress_throughput = uncompressed_bytes / decompress_seconds;
+  return m;
+}
+
+/**
+ * @brief A link simulated by memcpy, throttled to a bandwidth.
+ *
+ * The link is busy for bytes / bandwidth per transfer, back to back.
+ * transfer() only sleeps once the link is more than a millisecond behind,
+ * since sleeping is too coarse to pace small transfers one at a time, and
+ * drain() waits for the rest, so the total time is accurate.
+ */
+class ThrottledLink
+{
+public:
+  typedef std::chrono::steady_clock clock;
+
+  explicit ThrottledLink(const double bandwidth) :
+      m_bandwidth(bandwidth), m_free_at(clock::now())
+  {
+    if (!(bandwidth > 0)) {
+      throw std::runtime_error("Link bandwidth must be positive.");
+    }
+  }
+
+  void transfer(void* const dst, const void* const src, const size_t bytes)
+  {
+    const clock::time_point start = std::max(clock::now(), m_free_at);
+    std::memcpy(dst, src, bytes);
+    m_free_at = start
+                + std::chrono::duration_cast<clock::duration>(
+                    std::chrono::duration<double>(bytes / m_bandwidth));
+    if (m_free_at - clock::now() > std::chrono::milliseconds(1)) {
+      std::this_thread::sleep_until(m_free_at);
+    }
+  }
+
+  void drain()
+  {
+    std::this_thread::sleep_until(m_free_at);
+  }
+
+private:
+  double m_bandwidth;
+  clock::time_point m_free_at;
+};
+
+namespace detail
+{
+
+// Hands chunks from one pipeline stage to the next.
+class ChunkQueue
+{
+public:
+  explicit ChunkQueue(const size_t capacity) :
+      m_mutex(), m_cv(), m_items(), m_capacity(capacity), m_closed(false)
+  {
+  }
+
+  void push(std::vector<uint8_t> item)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this]() { return m_items.size() < m_capacity; });
+    m_items.push_back(std::move(item));
+    m_cv.notify_all();
+  }
+
+  void close()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_closed = true;
+    m_cv.notify_all();
+  }
+
+  // False once the queue is closed and empty.
+  bool pop(std::vector<uint8_t>& item)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this]() { return !m_items.empty() || m_closed; });
+    if (m_items.empty()) {
+      return false;
+    }
+    item = std::move(m_items.front());
+    m_items.pop_front();
+    m_cv.notify_all();
+    return true;
+  }
+
+private:
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::deque<std::vector<uint8_t>> m_items;
+  size_t m_capacity;
+  bool m_closed;
+};
+
+inline size_t compress_into(
+    const HostCodec& codec,
+    const std::vector<uint8_t>& chunk,
+    std::vector<uint8_t>& out)
+{
+  out.resize(codec.max_compressed_size(chunk.size()));
+  out.resize(codec.compress(chunk.data(), chunk.size(), out.data(), out.size()));
+  return out.size();
+}
+
+inline void decompress_into(
+    const HostCodec& codec,
+    const std::vector<uint8_t>& in,
+    const size_t uncompressed_size,
+    uint8_t* const out)
+{
+  size_t out_bytes = 0;
+  if (codec.decompress(in.data(), in.size(), out, uncompressed_size, &out_bytes)
+          != nvcompSuccess
+      || out_bytes != uncompressed_size) {
+    throw std::runtime_error(
+        std::string("Failed to decompress a ") + codec.name() + " chunk.");
+  }
+}
+
+} // namespace detail
+
+/**
+ * @brief Move `chunks` over a throttled link of `bandwidth` bytes per
+ * second, and return the elapsed seconds.
+ *
+ * Without a codec, the chunks are sent as they are. Otherwise they are all
+ * compressed, then sent, then decompressed, or with `pipelined`, each
+ * chunk moves on as soon as it is ready, with one thread per stage.
+ */
+inline double simulate_transfer(
+    const HostCodec* const codec,
+    const std::vector<std::vector<uint8_t>>& chunks,
+    const double bandwidth,
+    const bool pipelined)
+{
+  typedef std::chrono::steady_clock clock;
+
+  size_t total_bytes = 0;
+  for (const std::vector<uint8_t>& chunk : chunks) {
+    total_bytes += chunk.size();
+  }
+  std::vector<uint8_t> output(total_bytes);
+
+  const clock::time_point start = clock::now();
+  ThrottledLink link(bandwidth);
+
+  if (codec == nullptr) {
+    size_t offset = 0;
+    for (const std::vector<uint8_t>& chunk : chunks) {
+      link.transfer(output.data() + offset, chunk.data(), chunk.size());
+      offset += chunk.size();
+    }
+    link.drain();
+  } else if (!pipelined) {
+    std::vector<std::vector<uint8_t>> sent(chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      detail::compress_into(*codec, chunks[i], sent[i]);
+    }
+    std::vector<std::vector<uint8_t>> received(chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      received[i].resize(sent[i].size());
+      link.transfer(received[i].data(), sent[i].data(), sent[i].size());
+    }
+    link.drain();
+    size_t offset = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      detail::decompress_into(
+          *codec, received[i], chunks[i].size(), output.data() + offset);
+      offset += chunks[i].size();
+    }
+  } else {
+    detail::ChunkQueue to_link(8);
+    detail::ChunkQueue to_receiver(8);
+    std::exception_ptr link_error;
+    std::exception_ptr receiver_error;
+
+    std::thread link_thread([&]() {
+      try {
+        std::vector<uint8_t> sent;
+        while (to_link.pop(sent)) {
+          std::vector<uint8_t> received(sent.size());
+          link.transfer(received.data(), sent.data(), sent.size());
+          to_receiver.push(std::move(received));
+        }
+        link.drain();
+      } catch (...) {
+        link_error = std::current_exception();
+        std::vector<uint8_t> ignored;
+        while (to_link.pop(ignored)) {
+        }
+      }
+      to_receiver.close();
+    });
+    std::thread receiver_thread([&]() {
+      try {
+        std::vector<uint8_t> received;
+        size_t offset = 0;
+        for (size_t i = 0; to_receiver.pop(received); ++i) {
+          detail::decompress_into(
+              *codec, received, chunks[i].size(), output.data() + offset);
+          offset += chunks[i].size();
+        }
+      } catch (...) {
+        receiver_error = std::current_exception();
+        // Keep draining, so that the link thread can finish.
+        std::vector<uint8_t> ignored;
+        while (to_receiver.pop(ignored)) {
+        }
+      }
+    });
+
+    std::exception_ptr sender_error;
+    try {
+      for (const std::vector<uint8_t>& chunk : chunks) {
+        std::vector<uint8_t> sent;
+        detail::compress_into(*codec, chunk, sent);
+        to_link.push(std::move(sent));
+      }
+    } catch (...) {
+      sender_error = std::current_exception();
+    }
+    to_link.close();
+    link_thread.join();
+    receiver_thread.join();
+    for (const std::exception_ptr& error :
+         {sender_error, link_error, receiver_error}) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+  }
+
+  const double seconds
+      = std::chrono::duration<double>(clock::now() - start).count();
+
+  size_t offset = 0;
+  for (const std::vector<uint8_t>& chunk : chunks) {
+    if (!std::equal(chunk.begin(), chunk.end(), output.begin() + offset)) {
+      throw std::runtime_error("Data was corrupted in simulated transfer.");
+    }
+    offset += chunk.size();
+  }
+  return seconds;
+}
+
+} // namespace host
+} // namespace nvcomp